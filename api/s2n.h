@@ -251,6 +251,105 @@ extern int s2n_config_send_max_fragment_length(struct s2n_config *config, s2n_ma
 S2N_API
 extern int s2n_config_accept_max_fragment_length(struct s2n_config *config);
 
+/**
+ * Sets the size of the buffer used to write records to the network.
+ *
+ * By default, s2n_send writes and flushes each record individually. When a send buffer
+ * size is set, s2n_send encrypts as many records as fit into the buffer and writes them
+ * with a single call to the send callback, reducing the number of system calls for large writes.
+ *
+ * @param config The configuration object being updated
+ * @param size The size of the send buffer in bytes. Must be large enough to hold at least one maximum sized TLS record.
+ */
+S2N_API
+extern int s2n_config_set_send_buffer_size(struct s2n_config *config, uint32_t size);
+
+/**
+ * Configures whether s2n_recv may return the data of more than one record.
+ *
+ * By default, s2n_recv returns as soon as the data of a single record has been copied into the
+ * caller's buffer. When enabled, s2n_recv keeps decrypting records until the buffer is full or no
+ * complete record is left in the read-ahead buffer, so large transfers need fewer calls. Once some
+ * data has been copied, s2n_recv never goes back to the network, so it does not block even with a
+ * blocking socket. This has no effect unless read-ahead buffering is enabled with
+ * s2n_connection_set_recv_buffering().
+ *
+ * If a later record fails after data has already been copied, s2n_recv returns that data and the
+ * error is reported by the next call to s2n_recv.
+ *
+ * @param config The configuration object being updated
+ * @param enabled Set to true to allow s2n_recv to return multiple records
+ */
+S2N_API
+extern int s2n_config_set_recv_multi_record(struct s2n_config *config, bool enabled);
+
+/**
+ * Configures whether connections give up their record buffers while idle.
+ *
+ * By default, each connection keeps the buffers it reads and writes records with until it is
+ * freed or s2n_connection_release_buffers() is called. When dynamic buffers are enabled, a
+ * connection borrows its buffers from a pool shared by the connections on the calling thread,
+ * and returns them as soon as no record is partially read or written. Memory then scales with
+ * the number of active connections rather than the total number of connections.
+ *
+ * Each thread keeps a few buffers for reuse; call s2n_cleanup() before a thread exits to free them.
+ *
+ * @param config The configuration object being updated
+ * @param enabled Set to true to return record buffers to the pool when they are not in use
+ */
+S2N_API
+extern int s2n_config_set_dynamic_buffers(struct s2n_config *config, bool enabled);
+
+typedef enum {
+    S2N_KTLS_MODE_DISABLED = 0,
+    S2N_KTLS_MODE_SEND = 1,
+    S2N_KTLS_MODE_RECV = 2,
+    S2N_KTLS_MODE_DUPLEX = S2N_KTLS_MODE_SEND | S2N_KTLS_MODE_RECV,
+} s2n_ktls_mode;
+
+/**
+ * Configures whether record encryption and decryption are offloaded to the kernel (kTLS).
+ *
+ * When enabled, s2n tries to hand the negotiated keys to the Linux kernel as soon as the handshake
+ * completes. s2n_send() and s2n_recv() then read and write plaintext directly on the socket, and
+ * the kernel frames, encrypts and decrypts the records.
+ *
+ * Offload is only attempted for TLS1.2 and TLS1.3 connections negotiating AES-GCM or ChaCha20-Poly1305
+ * whose I/O is managed by s2n via s2n_connection_set_fd(). If the kernel does not support kTLS or the
+ * connection does not qualify, the connection silently keeps using the userspace record layer.
+ * TLS1.3 connections are only offloaded on kernels that can replace the keys of an offloaded socket
+ * (Linux 6.14 and later), since either peer may send a KeyUpdate at any time.
+ * Use s2n_connection_is_ktls_enabled() to find out which directions were offloaded.
+ *
+ * @param config The configuration object being updated
+ * @param mode The directions to offload
+ */
+S2N_API
+extern int s2n_config_set_ktls_mode(struct s2n_config *config, s2n_ktls_mode mode);
+
+/**
+ * Generates ephemeral ECDHE keys ahead of time, on background threads.
+ *
+ * Every handshake normally generates a new ephemeral key for its key share or ServerKeyExchange.
+ * When a pool is configured, `worker_count` threads keep up to `keys_per_curve` keys ready for
+ * every supported curve, and handshakes take one of those keys instead. Each key is used by
+ * exactly one handshake. If no key is ready for the negotiated curve, the handshake generates its
+ * own key as usual.
+ *
+ * The pool can only be configured once per config, because connections using the config may be
+ * taking keys from it. The worker threads are stopped when the config is freed.
+ *
+ * The pool is fork-safe: a child process discards the keys it inherited from its parent and
+ * starts its own worker threads the first time it needs a key.
+ *
+ * @param config The configuration object being updated
+ * @param keys_per_curve The number of keys to keep ready for each curve. Set to 0 to disable the pool.
+ * @param worker_count The number of threads generating keys. Must be at least 1 if the pool is enabled.
+ * @returns S2N_SUCCESS on success. S2N_FAILURE with S2N_ERR_INVALID_STATE if a pool is already configured.
+ */
+S2N_API
+extern int s2n_config_set_key_share_pool(struct s2n_config *config, uint32_t keys_per_curve, uint8_t worker_count);
+
 S2N_API
 extern int s2n_config_set_session_state_lifetime(struct s2n_config *config, uint64_t lifetime_in_secs);
 
@@ -258,6 +357,74 @@ S2N_API
 extern int s2n_config_set_session_tickets_onoff(struct s2n_config *config, uint8_t enabled);
 S2N_API
 extern int s2n_config_set_session_cache_onoff(struct s2n_config *config, uint8_t enabled);
+
+struct s2n_session_cache;
+
+struct s2n_session_cache_stats {
+    /* Lookups that found a live session */
+    uint64_t hits;
+    /* Lookups that found no session, or only an expired one */
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t deletes;
+    /* Live sessions dropped to make room for new ones */
+    uint64_t evictions;
+    /* Sessions dropped because they outlived the session state lifetime */
+    uint64_t expirations;
+    /* Sessions currently held, including expired sessions not yet reclaimed */
+    uint64_t entries;
+};
+
+/**
+ * Creates an in-memory server cache for TLS1.2 session id resumption.
+ *
+ * All of the cache's memory is allocated up front and never grows. Sessions are spread across
+ * independently locked shards by a keyed hash of their session id, so the cache can be shared
+ * by many threads and many configs. When the cache is full, storing a session evicts an older one.
+ *
+ * @param max_memory_in_bytes The memory budget of the cache. Each session takes about 160 bytes.
+ * The budget is split across at most 16 shards, each of which must be smaller than 4 GB.
+ * @returns The new cache, or NULL on error. Fails with S2N_ERR_INVALID_ARGUMENT if the budget is
+ * too small for a single bucket of sessions or too large for the shards.
+ */
+S2N_API
+extern struct s2n_session_cache *s2n_session_cache_new(uint64_t max_memory_in_bytes);
+
+/**
+ * Wipes and frees a session cache.
+ *
+ * The cache must not be set on any config when it is freed.
+ *
+ * @param cache The cache to free
+ */
+S2N_API
+extern int s2n_session_cache_free(struct s2n_session_cache *cache);
+
+/**
+ * Reads the counters of a session cache, summed across all of its shards.
+ *
+ * @param cache The cache to read
+ * @param stats Set to the current counters
+ */
+S2N_API
+extern int s2n_session_cache_get_stats(struct s2n_session_cache *cache, struct s2n_session_cache_stats *stats);
+
+/**
+ * Uses a built-in session cache for session id resumption and enables session caching.
+ *
+ * Sessions expire after the config's session state lifetime (see s2n_config_set_session_state_lifetime()).
+ * If the cache callbacks are also set, the built-in cache becomes a local tier in front of them:
+ * sessions are stored and deleted in both, and the callbacks are only asked for sessions
+ * missing from the built-in cache.
+ *
+ * As with the callbacks, at least one session ticket key must be added with
+ * s2n_config_add_ticket_crypto_key() to encrypt the cached sessions.
+ *
+ * @param config The configuration object being updated
+ * @param cache The cache to use, which must outlive the config. Set to NULL to stop using a built-in cache.
+ */
+S2N_API
+extern int s2n_config_set_session_cache(struct s2n_config *config, struct s2n_session_cache *cache);
 S2N_API
 extern int s2n_config_set_ticket_encrypt_decrypt_key_lifetime(struct s2n_config *config, uint64_t lifetime_in_secs);
 S2N_API
@@ -330,6 +497,36 @@ extern int s2n_connection_prefer_low_latency(struct s2n_connection *conn);
 S2N_API
 extern int s2n_connection_set_dynamic_record_threshold(struct s2n_connection *conn, uint32_t resize_threshold, uint16_t timeout_threshold);
 
+/**
+ * Enables read-ahead buffering of received records.
+ *
+ * By default, s2n reads the header and the body of each record from the network separately.
+ * With read-ahead buffering, s2n reads up to `buffer_size` bytes whenever it needs more data and
+ * parses as many records as possible out of them, reducing the number of calls to the recv callback.
+ *
+ * Because more data than a single record may be read from the network, applications that wait for
+ * the underlying socket to become readable should first check s2n_peek_buffered().
+ *
+ * The buffer is released by s2n_connection_release_buffers() and the setting is reset by s2n_connection_wipe().
+ *
+ * @param conn The connection object being updated
+ * @param buffer_size The maximum number of bytes to read ahead. 0 disables read-ahead buffering.
+ */
+S2N_API
+extern int s2n_connection_set_recv_buffering(struct s2n_connection *conn, uint32_t buffer_size);
+
+/**
+ * Reports whether record processing in the given direction has been offloaded to the kernel.
+ *
+ * See s2n_config_set_ktls_mode().
+ *
+ * @param conn The connection object being queried
+ * @param mode S2N_KTLS_MODE_SEND, S2N_KTLS_MODE_RECV or S2N_KTLS_MODE_DUPLEX
+ * @returns 1 if every requested direction is offloaded, 0 if not, or S2N_FAILURE on error
+ */
+S2N_API
+extern int s2n_connection_is_ktls_enabled(struct s2n_connection *conn, s2n_ktls_mode mode);
+
 /* If you don't want to use the configuration wide callback, you can set this per connection and it will be honored. */
 S2N_API
 extern int s2n_connection_set_verify_host_callback(struct s2n_connection *config, s2n_verify_host_fn host_fn, void *data);
@@ -340,6 +537,70 @@ extern int s2n_connection_set_blinding(struct s2n_connection *conn, s2n_blinding
 S2N_API
 extern uint64_t s2n_connection_get_delay(struct s2n_connection *conn);
 
+struct s2n_blinding_timer;
+
+/**
+ * Creates a timer that tracks killed connections until their blinding delay has passed.
+ *
+ * Without a timer, S2N_BUILT_IN_BLINDING makes s2n_connection_kill() sleep for the whole
+ * 10 to 30 second delay, which ties up the calling thread. When a config has a timer,
+ * s2n_connection_kill() returns immediately and the connection waits on the timer instead.
+ * The application then polls the timer, usually from its event loop, and closes each
+ * connection that the timer hands back.
+ *
+ * A timer can be shared by many configs and threads. Deadlines are measured with the
+ * system monotonic clock.
+ *
+ * @returns The new timer, or NULL on error
+ */
+S2N_API
+extern struct s2n_blinding_timer *s2n_blinding_timer_new(void);
+
+/**
+ * Frees a blinding timer. Connections still waiting on the timer are dropped from it.
+ *
+ * The timer must not be set on any config when it is freed.
+ *
+ * @param timer The timer to free
+ */
+S2N_API
+extern int s2n_blinding_timer_free(struct s2n_blinding_timer *timer);
+
+/**
+ * Makes connections that use S2N_BUILT_IN_BLINDING wait on a timer instead of sleeping.
+ *
+ * s2n_connection_get_delay() still reports the remaining delay of a killed connection.
+ *
+ * @param config The configuration object being updated
+ * @param timer The timer to use, which must outlive the config. Set to NULL to sleep again.
+ */
+S2N_API
+extern int s2n_config_set_blinding_timer(struct s2n_config *config, struct s2n_blinding_timer *timer);
+
+/**
+ * Reports how long until the next connection on the timer may be closed.
+ *
+ * Suitable as the timeout of an event loop's wait, such as the one passed to epoll_wait().
+ *
+ * @param timer The timer to check
+ * @param nanoseconds Set to the time until the earliest deadline, 0 if a connection may already
+ * be closed, or UINT64_MAX if no connections are waiting
+ */
+S2N_API
+extern int s2n_blinding_timer_get_next_expiry(struct s2n_blinding_timer *timer, uint64_t *nanoseconds);
+
+/**
+ * Takes a connection whose blinding delay has passed off the timer.
+ *
+ * Call repeatedly until `conn` is set to NULL. Each connection returned may be closed and freed.
+ * A connection that is wiped or freed while waiting is removed from the timer, and is never returned.
+ *
+ * @param timer The timer to poll
+ * @param conn Set to a connection that may be closed, or NULL if none are ready
+ */
+S2N_API
+extern int s2n_blinding_timer_pop_expired(struct s2n_blinding_timer *timer, struct s2n_connection **conn);
+
 S2N_API
 extern int s2n_connection_set_cipher_preferences(struct s2n_connection *conn, const char *version);
 
@@ -377,19 +638,191 @@ S2N_API
 extern ssize_t s2n_sendv(struct s2n_connection *conn, const struct iovec *bufs, ssize_t count, s2n_blocked_status *blocked);
 S2N_API
 extern ssize_t s2n_sendv_with_offset(struct s2n_connection *conn, const struct iovec *bufs, ssize_t count, ssize_t offs, s2n_blocked_status *blocked);
+
+/**
+ * Sends `count` bytes of the file `fd`, starting at `offset`, as application data.
+ *
+ * The file is read directly into the records being encrypted, so no intermediate buffer is needed.
+ * If record processing has been offloaded to the kernel (see s2n_config_set_ktls_mode()), the file
+ * is sent with sendfile(2) and its contents never reach userspace.
+ *
+ * Partial writes behave as with s2n_sendv_with_offset(): if fewer than `count` bytes are sent,
+ * the remaining data must be sent by calling s2n_sendfile() again with `offset` and `count`
+ * adjusted by the return value, and the file contents must not change in between.
+ *
+ * @param conn The connection to send the file on
+ * @param fd A file descriptor that supports pread(2)
+ * @param offset The position in the file to start reading from
+ * @param count The number of bytes to send
+ * @param blocked Set to the blocking status of the connection
+ * @returns The number of bytes sent, or S2N_FAILURE on error
+ */
+S2N_API
+extern ssize_t s2n_sendfile(struct s2n_connection *conn, int fd, off_t offset, size_t count, s2n_blocked_status *blocked);
+
+/**
+ * Borrows space for the plaintext of the next application data record from the connection.
+ *
+ * The application writes up to `size` bytes of plaintext to `buffer` and then calls s2n_send_seal(),
+ * which encrypts the record in place. This avoids copying the plaintext into the connection.
+ *
+ * Any output that is still pending, such as a partially sent record or a post-handshake message,
+ * is first flushed using the connection's send callback or file descriptor.
+ *
+ * The reservation is cancelled by any other call that writes to the connection, such as s2n_send().
+ * Not supported for TLS1.0 clients using CBC ciphers, which require s2n_send to split records.
+ *
+ * @param conn The connection to send on
+ * @param buffer Set to the location where the plaintext must be written
+ * @param size Set to the maximum number of bytes of plaintext the record can hold
+ * @param blocked Set to indicate whether flushing pending output blocked on I/O
+ */
+S2N_API
+extern int s2n_send_reserve(struct s2n_connection *conn, uint8_t **buffer, uint32_t *size, s2n_blocked_status *blocked);
+
+/**
+ * Encrypts the plaintext written to the buffer returned by s2n_send_reserve() and returns the record.
+ *
+ * The record is returned as `wire_size` bytes at `wire`, ready to be written to the network by the
+ * application. s2n does not send these bytes itself. The bytes are owned by the connection and
+ * remain valid until the next call that writes to the connection, such as s2n_send_reserve() or s2n_send().
+ *
+ * @param conn The connection to send on
+ * @param size The number of bytes of plaintext written to the reserved buffer
+ * @param wire Set to the start of the encrypted record
+ * @param wire_size Set to the length of the encrypted record
+ */
+S2N_API
+extern int s2n_send_seal(struct s2n_connection *conn, uint32_t size, const uint8_t **wire, uint32_t *wire_size);
+
 S2N_API
 extern ssize_t s2n_recv(struct s2n_connection *conn,  void *buf, ssize_t size, s2n_blocked_status *blocked);
 S2N_API
 extern uint32_t s2n_peek(struct s2n_connection *conn);
 
+/**
+ * Returns the number of bytes read ahead from the network that have not been processed yet.
+ *
+ * Only non-zero when read-ahead buffering is enabled with s2n_connection_set_recv_buffering().
+ * If non-zero, s2n_recv() may be able to make progress without the socket becoming readable.
+ *
+ * @param conn The connection object being queried
+ */
+S2N_API
+extern uint32_t s2n_peek_buffered(struct s2n_connection *conn);
+
+/**
+ * Provides read-only access to decrypted application data without copying it.
+ *
+ * Reads and decrypts records until application data is available, then sets `data` to point to the
+ * unread plaintext of the current record inside the connection and `size` to its length. A `size` of
+ * zero indicates that the connection was closed.
+ *
+ * The data remains owned by the connection and is only valid until the next call to s2n_recv_consume(),
+ * s2n_recv(), s2n_recv_view() or any call that wipes or frees the connection. Calling s2n_recv_view()
+ * again without consuming data returns the same view.
+ *
+ * @param conn The connection to read from
+ * @param data Set to the start of the unread plaintext
+ * @param size Set to the number of bytes available at `data`
+ * @param blocked Set to indicate whether the connection is blocked on I/O
+ */
+S2N_API
+extern int s2n_recv_view(struct s2n_connection *conn, const uint8_t **data, uint32_t *size, s2n_blocked_status *blocked);
+
+/**
+ * Marks `size` bytes of the view returned by s2n_recv_view() as read.
+ *
+ * Once the whole record has been consumed, its plaintext is wiped and the next call to
+ * s2n_recv_view() or s2n_recv() reads a new record.
+ *
+ * Fails with S2N_ERR_INVALID_STATE if no decrypted data is available, and with S2N_ERR_REENTRANCY
+ * if called from within a recv callback.
+ *
+ * @param conn The connection being read from
+ * @param size The number of bytes to consume. Must not exceed the size returned by s2n_recv_view().
+ */
+S2N_API
+extern int s2n_recv_consume(struct s2n_connection *conn, uint32_t size);
+
 S2N_API
 extern int s2n_connection_free_handshake(struct s2n_connection *conn);
 S2N_API
 extern int s2n_connection_release_buffers(struct s2n_connection *conn);
+/**
+ * Resets a connection so that it can be used for a new TLS session.
+ *
+ * All session state is erased. The hash and HMAC states, session keys and PRF working space stay
+ * allocated and are reused, while the record buffers are freed.
+ *
+ * @param conn The connection to wipe
+ */
 S2N_API
 extern int s2n_connection_wipe(struct s2n_connection *conn);
 S2N_API
 extern int s2n_connection_free(struct s2n_connection *conn);
+
+struct s2n_connection_pool;
+
+/**
+ * Creates a pool of connections that share a config and a mode.
+ *
+ * Creating a connection allocates its hash and HMAC states, session keys and PRF working space,
+ * which s2n_connection_wipe() preserves. The pool keeps up to `size` wiped connections ready
+ * so that they can be reused instead of being created and freed for every TLS session.
+ * The pool is filled when it is created.
+ *
+ * Record buffers are not kept: s2n_connection_wipe() frees them so that idle connections hold no
+ * buffer memory, and they are allocated again by the first read or write of the next session.
+ * Combine the pool with s2n_config_set_dynamic_buffers() to reuse buffers across connections too.
+ *
+ * The pool is safe to use from multiple threads. Idle connections are spread across several
+ * independently locked shards, and each thread prefers its own shard.
+ *
+ * The config must outlive the pool and every connection acquired from it.
+ *
+ * @param config The config used by every connection in the pool
+ * @param mode Whether the pooled connections are clients or servers
+ * @param size The maximum number of idle connections kept by the pool. Must be at least 1.
+ * @returns The new pool, or NULL on error
+ */
+S2N_API
+extern struct s2n_connection_pool *s2n_connection_pool_new(struct s2n_config *config, s2n_mode mode, uint32_t size);
+
+/**
+ * Frees a pool and every idle connection it holds.
+ *
+ * Connections that are still acquired are not affected and must be freed with s2n_connection_free().
+ *
+ * @param pool The pool to free
+ */
+S2N_API
+extern int s2n_connection_pool_free(struct s2n_connection_pool *pool);
+
+/**
+ * Takes a connection from the pool, creating a new one if the pool is empty.
+ *
+ * The connection is in the same state as a connection returned by s2n_connection_new() and
+ * configured with s2n_connection_set_config().
+ *
+ * @param pool The pool to take a connection from
+ * @returns A connection, or NULL on error
+ */
+S2N_API
+extern struct s2n_connection *s2n_connection_pool_acquire(struct s2n_connection_pool *pool);
+
+/**
+ * Wipes a connection and returns it to the pool for reuse.
+ *
+ * If the pool already holds as many idle connections as it can, the connection is freed instead.
+ * The connection must not be used after it is released, even if this call fails.
+ *
+ * @param pool The pool the connection was acquired from
+ * @param conn The connection to return. Must have the mode of the pool.
+ */
+S2N_API
+extern int s2n_connection_pool_release(struct s2n_connection_pool *pool, struct s2n_connection *conn);
+
 S2N_API
 extern int s2n_shutdown(struct s2n_connection *conn, s2n_blocked_status *blocked);
 
@@ -551,6 +984,90 @@ extern int s2n_async_pkey_op_apply(struct s2n_async_pkey_op *op, struct s2n_conn
 S2N_API
 extern int s2n_async_pkey_op_free(struct s2n_async_pkey_op *op);
 
+typedef enum { S2N_ASYNC_DECRYPT, S2N_ASYNC_SIGN } s2n_async_pkey_op_type;
+
+/* Signature algorithms, using the TLS SignatureAlgorithm registry values where they exist */
+typedef enum {
+    S2N_TLS_SIGNATURE_ANONYMOUS = 0,
+    S2N_TLS_SIGNATURE_RSA = 1,
+    S2N_TLS_SIGNATURE_ECDSA = 3,
+
+    /* Use the private range for RSA-PSS, which has no SignatureAlgorithm value */
+    S2N_TLS_SIGNATURE_RSA_PSS_RSAE = 224,
+    S2N_TLS_SIGNATURE_RSA_PSS_PSS,
+} s2n_tls_signature_algorithm;
+
+/* Hash algorithms, using the TLS HashAlgorithm registry values where they exist */
+typedef enum {
+    S2N_TLS_HASH_NONE = 0,
+    S2N_TLS_HASH_MD5 = 1,
+    S2N_TLS_HASH_SHA1 = 2,
+    S2N_TLS_HASH_SHA224 = 3,
+    S2N_TLS_HASH_SHA256 = 4,
+    S2N_TLS_HASH_SHA384 = 5,
+    S2N_TLS_HASH_SHA512 = 6,
+
+    /* The concatenated MD5 and SHA1 digests signed by RSA in TLS1.0 and TLS1.1, without a DigestInfo */
+    S2N_TLS_HASH_MD5_SHA1 = 224,
+} s2n_tls_hash_algorithm;
+
+/**
+ * Accessors for performing an async private key operation outside of s2n, for example in a signing service.
+ *
+ * For S2N_ASYNC_SIGN the input is the digest to sign; for S2N_ASYNC_DECRYPT it is the encrypted data.
+ * s2n_async_pkey_op_set_output() completes the operation in place of s2n_async_pkey_op_perform().
+ *
+ * A sign op must be signed as s2n would sign it. The signature algorithm and hash algorithm determine the
+ * padding: S2N_TLS_SIGNATURE_RSA uses PKCS#1 v1.5 with a DigestInfo for the hash algorithm (none for
+ * S2N_TLS_HASH_MD5_SHA1), the RSA-PSS algorithms use PSS with MGF1 and a salt as long as the digest, and
+ * S2N_TLS_SIGNATURE_ECDSA signs the digest directly. s2n_async_pkey_op_get_signature_algorithm() and
+ * s2n_async_pkey_op_get_hash_algorithm() fail with S2N_ERR_INVALID_STATE for decrypt ops.
+ */
+S2N_API
+extern int s2n_async_pkey_op_get_op_type(struct s2n_async_pkey_op *op, s2n_async_pkey_op_type *type);
+S2N_API
+extern int s2n_async_pkey_op_get_signature_algorithm(struct s2n_async_pkey_op *op, s2n_tls_signature_algorithm *sig_alg);
+S2N_API
+extern int s2n_async_pkey_op_get_hash_algorithm(struct s2n_async_pkey_op *op, s2n_tls_hash_algorithm *hash_alg);
+S2N_API
+extern int s2n_async_pkey_op_get_input_size(struct s2n_async_pkey_op *op, uint32_t *data_len);
+S2N_API
+extern int s2n_async_pkey_op_get_input(struct s2n_async_pkey_op *op, uint8_t *data, uint32_t data_len);
+S2N_API
+extern int s2n_async_pkey_op_set_output(struct s2n_async_pkey_op *op, const uint8_t *data, uint32_t data_len);
+
+/**
+ * Collects async private key operations from many connections so that they can be performed together.
+ *
+ * Add each op to the batch from the s2n_async_pkey_fn callback; the batch then owns the op.
+ * s2n_async_pkey_batch_flush() must be called outside of the callback. It hands every pending op to
+ * `perform` in a single call, applies the results, and then calls `ready` once with the connections
+ * that can resume negotiation.
+ *
+ * If `perform` fails, or an op was not completed or could not be applied, the connection is stuck: its
+ * handshake can't resume and it should be closed. `failed` is called once with every stuck connection,
+ * after `ready`, and the flush then fails. The ops are freed either way.
+ * A connection must not be freed while its op is in a batch.
+ */
+struct s2n_async_pkey_batch;
+
+typedef int (*s2n_async_pkey_batch_perform_fn)(struct s2n_async_pkey_op **ops, uint32_t ops_count, void *ctx);
+typedef int (*s2n_async_pkey_batch_ready_fn)(struct s2n_connection **conns, uint32_t conns_count, void *ctx);
+typedef int (*s2n_async_pkey_batch_failed_fn)(struct s2n_connection **conns, uint32_t conns_count, void *ctx);
+
+S2N_API
+extern struct s2n_async_pkey_batch *s2n_async_pkey_batch_new(void);
+S2N_API
+extern int s2n_async_pkey_batch_free(struct s2n_async_pkey_batch *batch);
+S2N_API
+extern int s2n_async_pkey_batch_add(struct s2n_async_pkey_batch *batch, struct s2n_async_pkey_op *op);
+S2N_API
+extern int s2n_async_pkey_batch_get_count(struct s2n_async_pkey_batch *batch, uint32_t *count);
+S2N_API
+extern int s2n_async_pkey_batch_flush(struct s2n_async_pkey_batch *batch, s2n_async_pkey_batch_perform_fn perform,
+                                      s2n_async_pkey_batch_ready_fn ready, s2n_async_pkey_batch_failed_fn failed,
+                                      void *ctx);
+
 /**
  * Callback function for handling key log events
  *
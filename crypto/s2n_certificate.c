@@ -39,6 +39,51 @@ int s2n_cert_set_cert_type(struct s2n_cert *cert, s2n_pkey_type pkey_type)
     return 0;
 }
 
+static int s2n_cert_chain_free_entries(struct s2n_cert_chain *cert_chain)
+{
+    POSIX_GUARD(s2n_free(&cert_chain->entries));
+    POSIX_GUARD(s2n_free(&cert_chain->tls13_tail_entries));
+    return S2N_SUCCESS;
+}
+
+/* The encoded certificates are identical for every handshake, so encode them once
+ * instead of walking the chain for every Certificate message.
+ */
+static int s2n_cert_chain_encode_entries(struct s2n_cert_chain *cert_chain)
+{
+    POSIX_ENSURE_REF(cert_chain->head);
+    POSIX_GUARD(s2n_cert_chain_free_entries(cert_chain));
+
+    struct s2n_stuffer entries = {0};
+    POSIX_GUARD(s2n_alloc(&cert_chain->entries, cert_chain->chain_size));
+    POSIX_GUARD(s2n_stuffer_init(&entries, &cert_chain->entries));
+
+    uint32_t tail_size = 0;
+    for (struct s2n_cert *cur_cert = cert_chain->head; cur_cert; cur_cert = cur_cert->next) {
+        POSIX_GUARD(s2n_stuffer_write_uint24(&entries, cur_cert->raw.size));
+        POSIX_GUARD(s2n_stuffer_write(&entries, &cur_cert->raw));
+        if (cur_cert != cert_chain->head) {
+            tail_size += SIZEOF_UINT24 + cur_cert->raw.size + sizeof(uint16_t);
+        }
+    }
+
+    if (tail_size == 0) {
+        return S2N_SUCCESS;
+    }
+
+    struct s2n_stuffer tls13_tail_entries = {0};
+    POSIX_GUARD(s2n_alloc(&cert_chain->tls13_tail_entries, tail_size));
+    POSIX_GUARD(s2n_stuffer_init(&tls13_tail_entries, &cert_chain->tls13_tail_entries));
+    for (struct s2n_cert *cur_cert = cert_chain->head->next; cur_cert; cur_cert = cur_cert->next) {
+        POSIX_GUARD(s2n_stuffer_write_uint24(&tls13_tail_entries, cur_cert->raw.size));
+        POSIX_GUARD(s2n_stuffer_write(&tls13_tail_entries, &cur_cert->raw));
+        /* Empty extension list */
+        POSIX_GUARD(s2n_stuffer_write_uint16(&tls13_tail_entries, 0));
+    }
+
+    return S2N_SUCCESS;
+}
+
 int s2n_create_cert_chain_from_stuffer(struct s2n_cert_chain *cert_chain_out, struct s2n_stuffer *chain_in_stuffer)
 {
     DEFER_CLEANUP(struct s2n_stuffer cert_out_stuffer = {0}, s2n_stuffer_free);
@@ -82,6 +127,7 @@ int s2n_create_cert_chain_from_stuffer(struct s2n_cert_chain *cert_chain_out, st
     S2N_ERROR_IF(s2n_stuffer_data_available(chain_in_stuffer) > 0, S2N_ERR_INVALID_PEM);
 
     cert_chain_out->chain_size = chain_size;
+    POSIX_GUARD(s2n_cert_chain_encode_entries(cert_chain_out));
 
     return 0;
 }
@@ -170,6 +216,8 @@ struct s2n_cert_chain_and_key *s2n_cert_chain_and_key_new(void)
     chain_and_key->private_key = (s2n_cert_private_key *)(void *)pkey_mem.data;
 
     chain_and_key->cert_chain->head = NULL;
+    memset(&chain_and_key->cert_chain->entries, 0, sizeof(chain_and_key->cert_chain->entries));
+    memset(&chain_and_key->cert_chain->tls13_tail_entries, 0, sizeof(chain_and_key->cert_chain->tls13_tail_entries));
     if (s2n_pkey_zero_init(chain_and_key->private_key) != S2N_SUCCESS) {
         goto cleanup;
     }
@@ -363,6 +411,7 @@ int s2n_cert_chain_and_key_free(struct s2n_cert_chain_and_key *cert_and_key)
             node = cert_and_key->cert_chain->head;
         }
 
+        POSIX_GUARD(s2n_cert_chain_free_entries(cert_and_key->cert_chain));
         POSIX_GUARD(s2n_free_object((uint8_t **)&cert_and_key->cert_chain, sizeof(struct s2n_cert_chain)));
     }
 
@@ -416,25 +465,16 @@ int s2n_cert_chain_free(struct s2n_cert_chain *cert_chain)
             POSIX_GUARD(s2n_free_object((uint8_t **)&node, sizeof(struct s2n_cert)));
             node = cert_chain->head;
         }
+        POSIX_GUARD(s2n_cert_chain_free_entries(cert_chain));
     }
 
     return S2N_SUCCESS;
 }
 
-int s2n_send_cert_chain(struct s2n_connection *conn, struct s2n_stuffer *out, struct s2n_cert_chain_and_key *chain_and_key)
+static int s2n_send_cert_chain_entries(struct s2n_connection *conn, struct s2n_stuffer *out, struct s2n_cert_chain *chain)
 {
-    POSIX_ENSURE_REF(conn);
-    POSIX_ENSURE_REF(out);
-    POSIX_ENSURE_REF(chain_and_key);
-    struct s2n_cert_chain *chain = chain_and_key->cert_chain;
-    POSIX_ENSURE_REF(chain);
-    struct s2n_cert *cur_cert = chain->head;
-    POSIX_ENSURE_REF(cur_cert);
-
-    struct s2n_stuffer_reservation cert_chain_size = {0};
-    POSIX_GUARD(s2n_stuffer_reserve_uint24(out, &cert_chain_size));
-
     /* Send certs and extensions (in TLS 1.3) */
+    struct s2n_cert *cur_cert = chain->head;
     bool first_entry = true;
     while (cur_cert) {
         POSIX_ENSURE_REF(cur_cert);
@@ -457,6 +497,37 @@ int s2n_send_cert_chain(struct s2n_connection *conn, struct s2n_stuffer *out, st
         cur_cert = cur_cert->next;
     }
 
+    return S2N_SUCCESS;
+}
+
+int s2n_send_cert_chain(struct s2n_connection *conn, struct s2n_stuffer *out, struct s2n_cert_chain_and_key *chain_and_key)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_REF(out);
+    POSIX_ENSURE_REF(chain_and_key);
+    struct s2n_cert_chain *chain = chain_and_key->cert_chain;
+    POSIX_ENSURE_REF(chain);
+    struct s2n_cert *leaf = chain->head;
+    POSIX_ENSURE_REF(leaf);
+
+    struct s2n_stuffer_reservation cert_chain_size = {0};
+    POSIX_GUARD(s2n_stuffer_reserve_uint24(out, &cert_chain_size));
+
+    if (chain->entries.size == 0) {
+        /* The chain was not built from PEM, so nothing was encoded ahead of time */
+        POSIX_GUARD(s2n_send_cert_chain_entries(conn, out, chain));
+    } else if (conn->actual_protocol_version < S2N_TLS13) {
+        POSIX_GUARD(s2n_stuffer_write(out, &chain->entries));
+    } else {
+        /* Only the leaf's extensions depend on the connection */
+        POSIX_GUARD(s2n_stuffer_write_uint24(out, leaf->raw.size));
+        POSIX_GUARD(s2n_stuffer_write(out, &leaf->raw));
+        POSIX_GUARD(s2n_extension_list_send(S2N_EXTENSION_LIST_CERTIFICATE, conn, out));
+        if (chain->tls13_tail_entries.size > 0) {
+            POSIX_GUARD(s2n_stuffer_write(out, &chain->tls13_tail_entries));
+        }
+    }
+
     POSIX_GUARD(s2n_stuffer_write_vector_size(&cert_chain_size));
 
     return 0;
@@ -35,6 +35,13 @@ struct s2n_cert {
 struct s2n_cert_chain {
     uint32_t chain_size;
     struct s2n_cert *head;
+    /* The CertificateEntry list for the chain, encoded once when the chain is loaded.
+     * entries holds every certificate without extensions, as sent before TLS1.3.
+     * tls13_tail_entries holds every certificate after the leaf with an empty extension list,
+     * since TLS1.3 only sends extensions for the leaf.
+     */
+    struct s2n_blob entries;
+    struct s2n_blob tls13_tail_entries;
 };
 
 struct s2n_cert_chain_and_key {
@@ -175,12 +175,19 @@ static int s2n_ecc_evp_compute_shared_secret(EVP_PKEY *own_key, EVP_PKEY *peer_p
     POSIX_GUARD_OSSL(EVP_PKEY_derive_init(ctx), S2N_ERR_ECDHE_SHARED_SECRET);
     POSIX_GUARD_OSSL(EVP_PKEY_derive_set_peer(ctx, peer_public), S2N_ERR_ECDHE_SHARED_SECRET);
     POSIX_GUARD_OSSL(EVP_PKEY_derive(ctx, NULL, &shared_secret_size), S2N_ERR_ECDHE_SHARED_SECRET);
-    POSIX_GUARD(s2n_alloc(shared_secret, shared_secret_size));
+
+    /* The caller may provide the memory for the shared secret, which is then shrunk to fit */
+    if (shared_secret->data == NULL) {
+        POSIX_GUARD(s2n_alloc(shared_secret, shared_secret_size));
+    } else {
+        POSIX_ENSURE(shared_secret_size <= shared_secret->size, S2N_ERR_ECDHE_SHARED_SECRET);
+    }
 
     if (EVP_PKEY_derive(ctx, shared_secret->data, &shared_secret_size) != 1) {
-        POSIX_GUARD(s2n_free(shared_secret));
+        POSIX_GUARD(s2n_blob_zeroize_free(shared_secret));
         POSIX_BAIL(S2N_ERR_ECDHE_SHARED_SECRET);
     }
+    shared_secret->size = shared_secret_size;
 
     return 0;
 }
@@ -30,6 +30,9 @@
 #define SECP521R1_SHARE_SIZE ((66 * 2 ) + 1)
 #define X25519_SHARE_SIZE (32)
 
+/* The shared secret is the x coordinate of the shared point, which is as long as a field element */
+#define S2N_ECC_EVP_MAX_SHARED_SECRET_SIZE 66
+
 struct s2n_ecc_named_curve {
     /* See https://www.iana.org/assignments/tls-parameters/tls-parameters.xhtml#tls-parameters-8 */
     uint16_t iana_id;
@@ -65,6 +68,8 @@ struct s2n_ecc_evp_params {
 };
 
 int s2n_ecc_evp_generate_ephemeral_key(struct s2n_ecc_evp_params *ecc_evp_params);
+/* The shared secret is allocated if shared_key is a zeroed blob. Otherwise shared_key must
+ * already point to at least as many bytes as the shared secret, and its size is set to fit. */
 int s2n_ecc_evp_compute_shared_secret_from_params(struct s2n_ecc_evp_params *private_ecc_evp_params,
                                                   struct s2n_ecc_evp_params *public_ecc_evp_params,
                                                   struct s2n_blob *shared_key);
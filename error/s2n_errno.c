@@ -255,6 +255,12 @@ static const char *no_such_error = "Internal s2n error";
     ERR_ENTRY(S2N_ERR_NO_CERT_FOUND, "Certificate not found") \
     ERR_ENTRY(S2N_ERR_CERT_NOT_VALIDATED, "Certificate not validated") \
     ERR_ENTRY(S2N_ERR_MAX_EARLY_DATA_SIZE, "Maximum early data bytes exceeded") \
+    ERR_ENTRY(S2N_ERR_SESSION_NOT_CACHED, "Session id not found in the session cache") \
+    ERR_ENTRY(S2N_ERR_KTLS_SET_KEYS, "The kernel rejected the kTLS keys") \
+    ERR_ENTRY(S2N_ERR_KTLS_KEY_UPDATE, "The kernel can't update the kTLS keys after a KeyUpdate") \
+    ERR_ENTRY(S2N_ERR_LOCK, "Error acquiring or releasing a lock") \
+    ERR_ENTRY(S2N_ERR_THREAD, "Error starting or stopping a thread") \
+    ERR_ENTRY(S2N_ERR_KTLS_UNSUPPORTED, "Operation not supported while records are offloaded to the kernel") \
 
 /* clang-format on */
 
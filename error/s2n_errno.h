@@ -120,6 +120,7 @@ typedef enum {
     S2N_ERR_UNSUPPORTED_EXTENSION,
     S2N_ERR_DUPLICATE_EXTENSION,
     S2N_ERR_MAX_EARLY_DATA_SIZE,
+    S2N_ERR_SESSION_NOT_CACHED,
     S2N_ERR_T_PROTO_END,
 
     /* S2N_ERR_T_INTERNAL */
@@ -202,6 +203,10 @@ typedef enum {
     S2N_ERR_PQ_DISABLED,
     S2N_ERR_INVALID_CERT_STATE,
     S2N_ERR_INVALID_EARLY_DATA_STATE,
+    S2N_ERR_KTLS_SET_KEYS,
+    S2N_ERR_KTLS_KEY_UPDATE,
+    S2N_ERR_LOCK,
+    S2N_ERR_THREAD,
     S2N_ERR_T_INTERNAL_END,
 
     /* S2N_ERR_T_USAGE */
@@ -270,6 +275,7 @@ typedef enum {
     S2N_ERR_EARLY_DATA_NOT_ALLOWED,
     S2N_ERR_NO_CERT_FOUND,
     S2N_ERR_CERT_NOT_VALIDATED,
+    S2N_ERR_KTLS_UNSUPPORTED,
     S2N_ERR_T_USAGE_END,
 } s2n_error;
 
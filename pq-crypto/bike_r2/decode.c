@@ -38,6 +38,7 @@
 #include "decode.h"
 #include "gf2x.h"
 #include "utilities.h"
+#include "pq-crypto/s2n_pq.h"
 #include <string.h>
 
 // Decoding (bit-flipping) parameter
@@ -152,6 +153,14 @@ bit_sliced_adder(OUT upc_t *upc,
                  IN OUT syndrome_t *rotated_syndrome,
                  IN const size_t    num_of_slices)
 {
+#if defined(S2N_BIKE1L1R2_X86_64_OPT)
+  if(s2n_bike1l1r2_x86_64_opt_is_enabled())
+  {
+    bit_sliced_adder_avx2(upc, rotated_syndrome, num_of_slices);
+    return;
+  }
+#endif
+
   // From cache-memory perspective this loop should be the outside loop
   for(size_t j = 0; j < num_of_slices; j++)
   {
@@ -167,6 +176,14 @@ bit_sliced_adder(OUT upc_t *upc,
 _INLINE_ void
 bit_slice_full_subtract(OUT upc_t *upc, IN uint8_t val)
 {
+#if defined(S2N_BIKE1L1R2_X86_64_OPT)
+  if(s2n_bike1l1r2_x86_64_opt_is_enabled())
+  {
+    bit_slice_full_subtract_avx2(upc, val);
+    return;
+  }
+#endif
+
   // Borrow
   uint64_t br[R_QW] = {0};
 
@@ -26,3 +26,18 @@ decode(OUT split_e_t *e,
 // (2 * R_BITS) bits are undefined.
 void
 rotate_right(OUT syndrome_t *out, IN const syndrome_t *in, IN uint32_t bitscount);
+
+// AVX2 versions of rotate_right and of the bit-sliced UPC arithmetic in decode.c,
+// in secure_decode_avx2.c. They process whole 256-bit lanes, so they may also
+// write the quadwords just past R_QW, which are padding in every caller.
+// Only built with S2N_BIKE1L1R2_X86_64_OPT.
+void
+rotate_right_avx2(OUT syndrome_t *out, IN const syndrome_t *in, IN uint32_t bitscount);
+
+void
+bit_sliced_adder_avx2(OUT upc_t *upc,
+                      IN OUT syndrome_t *rotated_syndrome,
+                      IN size_t          num_of_slices);
+
+void
+bit_slice_full_subtract_avx2(OUT upc_t *upc, IN uint8_t val);
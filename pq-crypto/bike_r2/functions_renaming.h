@@ -55,6 +55,11 @@
 #define red                    RENAME_FUNC_NAME(red)
 #define gf2x_mul_1x1           RENAME_FUNC_NAME(gf2x_mul_1x1)
 #define rotate_right           RENAME_FUNC_NAME(rotate_right)
+#define gf2x_mul_base_pclmul   RENAME_FUNC_NAME(gf2x_mul_base_pclmul)
+#define rotate_right_avx2      RENAME_FUNC_NAME(rotate_right_avx2)
+#define bit_sliced_adder_avx2  RENAME_FUNC_NAME(bit_sliced_adder_avx2)
+#define bit_slice_full_subtract_avx2 \
+  RENAME_FUNC_NAME(bit_slice_full_subtract_avx2)
 #define r_bits_vector_weight   RENAME_FUNC_NAME(r_bits_vector_weight)
 
 #endif //__FUNCTIONS_RENAMING_H_INCLUDED__
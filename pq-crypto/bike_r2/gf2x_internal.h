@@ -30,3 +30,11 @@ red(uint64_t *res);
 void
 
 gf2x_mul_1x1(OUT uint64_t *res, IN uint64_t a, IN uint64_t b);
+
+// Number of quadwords multiplied by gf2x_mul_base_pclmul.
+#define GF2X_PCLMUL_BASE_QW 4
+
+// res = a*b for a and b of GF2X_PCLMUL_BASE_QW quadwords, using PCLMULQDQ.
+// res is 2 * GF2X_PCLMUL_BASE_QW quadwords. Only built with S2N_BIKE1L1R2_X86_64_OPT.
+void
+gf2x_mul_base_pclmul(OUT uint64_t *res, IN const uint64_t *a, IN const uint64_t *b);
@@ -9,6 +9,7 @@
 #include "cleanup.h"
 #include "gf2x.h"
 #include "gf2x_internal.h"
+#include "pq-crypto/s2n_pq.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -37,6 +38,14 @@ karatzuba(OUT uint64_t *res,
     return;
   }
 
+#if defined(S2N_BIKE1L1R2_X86_64_OPT)
+  if((GF2X_PCLMUL_BASE_QW == n) && s2n_bike1l1r2_x86_64_opt_is_enabled())
+  {
+    gf2x_mul_base_pclmul(res, a, b);
+    return;
+  }
+#endif
+
   const uint64_t half_n = n >> 1;
 
   // Define pointers for the middle of each parameter
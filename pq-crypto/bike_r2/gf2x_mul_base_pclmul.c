@@ -0,0 +1,49 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * The Karatsuba recursion in gf2x_mul.c stops at GF2X_PCLMUL_BASE_QW
+ * quadwords when this code is enabled, and the base case is multiplied
+ * schoolbook style with one carry-less multiplication per pair of quadwords.
+ * This file is the only one built with -mpclmul.
+ */
+
+#include "gf2x_internal.h"
+#include <immintrin.h>
+
+void
+gf2x_mul_base_pclmul(OUT uint64_t *res, IN const uint64_t *a, IN const uint64_t *b)
+{
+  // acc[k] holds the 128-bit sum of a[i]*b[j] over all i + j = k
+  __m128i acc[(2 * GF2X_PCLMUL_BASE_QW) - 1];
+  __m128i va[GF2X_PCLMUL_BASE_QW];
+  __m128i vb[GF2X_PCLMUL_BASE_QW];
+
+  for(size_t i = 0; i < GF2X_PCLMUL_BASE_QW; i++)
+  {
+    va[i] = _mm_cvtsi64_si128((long long)a[i]);
+    vb[i] = _mm_cvtsi64_si128((long long)b[i]);
+  }
+
+  for(size_t k = 0; k < (2 * GF2X_PCLMUL_BASE_QW) - 1; k++)
+  {
+    acc[k] = _mm_setzero_si128();
+  }
+
+  for(size_t i = 0; i < GF2X_PCLMUL_BASE_QW; i++)
+  {
+    for(size_t j = 0; j < GF2X_PCLMUL_BASE_QW; j++)
+    {
+      acc[i + j] =
+          _mm_xor_si128(acc[i + j], _mm_clmulepi64_si128(va[i], vb[j], 0x00));
+    }
+  }
+
+  // Fold the overlapping 128-bit products into 64-bit words
+  uint64_t prev_high = 0;
+  for(size_t k = 0; k < (2 * GF2X_PCLMUL_BASE_QW) - 1; k++)
+  {
+    res[k]    = (uint64_t)_mm_cvtsi128_si64(acc[k]) ^ prev_high;
+    prev_high = (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc[k], acc[k]));
+  }
+  res[(2 * GF2X_PCLMUL_BASE_QW) - 1] = prev_high;
+}
@@ -0,0 +1,137 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * AVX2 versions of the constant-time rotate in secure_decode_portable.c and
+ * of the bit-sliced adder/subtractor in decode.c. Every loop processes four
+ * quadwords per step, with the same data-independent memory access pattern
+ * as the portable code. This file is the only one built with -mavx2.
+ */
+
+#include "decode.h"
+#include "utilities.h"
+#include <immintrin.h>
+#include <string.h>
+
+#define R_QW_HALF_LOG2 UPTOPOW2(R_QW / 2)
+
+// Quadwords in a 256-bit lane, and R_QW rounded up to whole lanes
+#define QW_PER_YMM   (YMM_SIZE / QW_SIZE)
+#define R_QW_YMM_PAD (R_YMM * QW_PER_YMM)
+
+_INLINE_ __m256i
+load_qw(IN const uint64_t *p)
+{
+  return _mm256_loadu_si256((const __m256i *)p);
+}
+
+_INLINE_ void
+store_qw(OUT uint64_t *p, IN const __m256i v)
+{
+  _mm256_storeu_si256((__m256i *)p, v);
+}
+
+_INLINE_ void
+rotr_big_avx2(OUT syndrome_t *out, IN const syndrome_t *in, IN size_t qw_num)
+{
+  // The last lane of the last round reads up to (R_QW + 2 * idx) rounded up
+  bike_static_assert(sizeof(*out) >=
+                         8 * (R_QW_YMM_PAD + (2 * R_QW_HALF_LOG2) + QW_PER_YMM),
+                     rotr_big_avx2_err);
+
+  memcpy(out, in, sizeof(*in));
+
+  for(uint32_t idx = R_QW_HALF_LOG2; idx >= 1; idx >>= 1)
+  {
+    // Convert 32 bit mask to 64 bit mask
+    const uint64_t mask = ((uint32_t)secure_l32_mask(qw_num, idx) + 1U) - 1ULL;
+    const __m256i  vmask = _mm256_set1_epi64x((long long)mask);
+    qw_num               = qw_num - (idx & mask);
+
+    // Lanes are read before they are written, and every read is at or after
+    // the lane being written, so rotating in place is safe.
+    for(size_t i = 0; i < (R_QW + idx); i += QW_PER_YMM)
+    {
+      const __m256i keep  = _mm256_andnot_si256(vmask, load_qw(&out->qw[i]));
+      const __m256i moved = _mm256_and_si256(vmask, load_qw(&out->qw[i + idx]));
+      store_qw(&out->qw[i], _mm256_or_si256(keep, moved));
+    }
+  }
+}
+
+_INLINE_ void
+rotr_small_avx2(OUT syndrome_t *out, IN const syndrome_t *in, IN const size_t bits)
+{
+  bike_static_assert(sizeof(*out) >= 8 * (R_QW_YMM_PAD + 1), rotr_small_avx2_err);
+
+  // A shift by 64 yields zero, so bits == 0 needs no special mask
+  const __m128i low_shift  = _mm_cvtsi32_si128((int)bits);
+  const __m128i high_shift = _mm_cvtsi32_si128((int)(64 - bits));
+
+  for(size_t i = 0; i < R_QW; i += QW_PER_YMM)
+  {
+    const __m256i low_part  = _mm256_srl_epi64(load_qw(&in->qw[i]), low_shift);
+    const __m256i high_part = _mm256_sll_epi64(load_qw(&in->qw[i + 1]), high_shift);
+    store_qw(&out->qw[i], _mm256_or_si256(low_part, high_part));
+  }
+}
+
+void
+rotate_right_avx2(OUT syndrome_t *out,
+                  IN const syndrome_t *in,
+                  IN const uint32_t    bitscount)
+{
+  // Rotate (64-bit) quad-words
+  rotr_big_avx2(out, in, (bitscount / 64));
+  // Rotate bits (less than 64)
+  rotr_small_avx2(out, out, (bitscount % 64));
+}
+
+void
+bit_sliced_adder_avx2(OUT upc_t *upc,
+                      IN OUT syndrome_t *rotated_syndrome,
+                      IN const size_t    num_of_slices)
+{
+  bike_static_assert(sizeof(upc->slice[0].u.qw) >= 8 * R_QW_YMM_PAD,
+                     upc_slice_is_not_ymm_padded);
+
+  for(size_t j = 0; j < num_of_slices; j++)
+  {
+    for(size_t i = 0; i < R_QW; i += QW_PER_YMM)
+    {
+      const __m256i upc_qw = load_qw(&upc->slice[j].u.qw[i]);
+      const __m256i syn_qw = load_qw(&rotated_syndrome->qw[i]);
+      store_qw(&upc->slice[j].u.qw[i], _mm256_xor_si256(upc_qw, syn_qw));
+      store_qw(&rotated_syndrome->qw[i], _mm256_and_si256(upc_qw, syn_qw));
+    }
+  }
+}
+
+void
+bit_slice_full_subtract_avx2(OUT upc_t *upc, IN uint8_t val)
+{
+  // Borrow
+  __m256i br[R_YMM];
+  for(size_t i = 0; i < R_YMM; i++)
+  {
+    br[i] = _mm256_setzero_si256();
+  }
+
+  for(size_t j = 0; j < SLICES; j++)
+  {
+    const __m256i b = _mm256_set1_epi64x(-(long long)(val & 0x1));
+    val >>= 1;
+
+    // Same borrow logic as bit_slice_full_subtract in decode.c:
+    // o = a^b^br, br' = (~a & b & ~br) | ((~a | b) & br)
+    for(size_t i = 0; i < R_YMM; i++)
+    {
+      const __m256i a     = load_qw(&upc->slice[j].u.qw[i * QW_PER_YMM]);
+      const __m256i not_a = _mm256_xor_si256(a, _mm256_set1_epi64x(-1));
+      const __m256i t0 = _mm256_andnot_si256(br[i], _mm256_and_si256(not_a, b));
+      const __m256i t1 = _mm256_and_si256(_mm256_or_si256(not_a, b), br[i]);
+      store_qw(&upc->slice[j].u.qw[i * QW_PER_YMM],
+               _mm256_xor_si256(_mm256_xor_si256(a, b), br[i]));
+      br[i] = _mm256_or_si256(t0, t1);
+    }
+  }
+}
@@ -8,6 +8,7 @@
 
 #include "decode.h"
 #include "utilities.h"
+#include "pq-crypto/s2n_pq.h"
 
 #define R_QW_HALF_LOG2 UPTOPOW2(R_QW / 2)
 
@@ -59,6 +60,14 @@ rotate_right(OUT syndrome_t *out,
              IN const syndrome_t *in,
              IN const uint32_t    bitscount)
 {
+#if defined(S2N_BIKE1L1R2_X86_64_OPT)
+  if(s2n_bike1l1r2_x86_64_opt_is_enabled())
+  {
+    rotate_right_avx2(out, in, bitscount);
+    return;
+  }
+#endif
+
   // Rotate (64-bit) quad-words
   rotr_big(out, in, (bitscount / 64));
   // Rotate bits (less than 64)
@@ -43,7 +43,7 @@ static void aes256_ctr_xof(unsigned char *out, size_t outlen, const unsigned cha
 *              - const uint8_t *key:   pointer to 32-byte key
 *              - uint8_t nonce:        1-byte nonce (will be zero-padded to 12 bytes)
 **************************************************/
-void PQCLEAN_KYBER51290S_CLEAN_aes256_prf(uint8_t *output, size_t outlen, const uint8_t *key, uint8_t nonce) {
+int PQCLEAN_KYBER51290S_CLEAN_aes256_prf(uint8_t *output, size_t outlen, const uint8_t *key, uint8_t nonce) {
     uint8_t iv[12];
     for (int i = 1; i < 12; i++) {
         iv[i] = 0;
@@ -54,6 +54,7 @@ void PQCLEAN_KYBER51290S_CLEAN_aes256_prf(uint8_t *output, size_t outlen, const
     aes256_ctr_keyexp(&ctx, key);
     aes256_ctr(output, outlen, iv, &ctx);
     aes256_ctx_release(&ctx);
+    return 0;
 }
 
 /*************************************************
@@ -68,7 +69,7 @@ void PQCLEAN_KYBER51290S_CLEAN_aes256_prf(uint8_t *output, size_t outlen, const
 *              - uint8_t x:           first additional byte to "absorb"
 *              - uint8_t y:           second additional byte to "absorb"
 **************************************************/
-void PQCLEAN_KYBER51290S_CLEAN_aes256xof_absorb(aes256xof_ctx *s, const uint8_t *key, uint8_t x, uint8_t y) {
+int PQCLEAN_KYBER51290S_CLEAN_aes256xof_absorb(aes256xof_ctx *s, const uint8_t *key, uint8_t x, uint8_t y) {
     aes256_ecb_keyexp(&s->sk_exp, key);
     for (int i = 2; i < 12; i++) {
         s->iv[i] = 0;
@@ -76,6 +77,7 @@ void PQCLEAN_KYBER51290S_CLEAN_aes256xof_absorb(aes256xof_ctx *s, const uint8_t
     s->iv[0] = x;
     s->iv[1] = y;
     s->ctr = 0;
+    return 0;
 }
 
 /*************************************************
@@ -88,12 +90,14 @@ void PQCLEAN_KYBER51290S_CLEAN_aes256xof_absorb(aes256xof_ctx *s, const uint8_t
 *              - size_t nblocks:        number of reqested 64-byte output blocks
 *              - aes256xof_ctx *s:      AES "state", i.e. expanded key and IV
 **************************************************/
-void PQCLEAN_KYBER51290S_CLEAN_aes256xof_squeezeblocks(uint8_t *out, size_t nblocks, aes256xof_ctx *s) {
+int PQCLEAN_KYBER51290S_CLEAN_aes256xof_squeezeblocks(uint8_t *out, size_t nblocks, aes256xof_ctx *s) {
     aes256_ctr_xof(out, nblocks * 64, s->iv, s->ctr, &s->sk_exp);
     s->ctr += (uint32_t) (4 * nblocks);
+    return 0;
 }
 
 /** Free the AES ctx **/
 void PQCLEAN_KYBER51290S_CLEAN_aes256xof_ctx_release(aes256xof_ctx *s) {
     aes256_ctx_release(&s->sk_exp);
+    s->sk_exp = NULL;
 }
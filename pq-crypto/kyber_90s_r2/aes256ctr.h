@@ -1,20 +1,29 @@
 #ifndef AES256CTR_H
 #define AES256CTR_H
 
-#include "aes.h"
-
 #include <stddef.h>
 #include <stdint.h>
 
+#if defined(S2N_KYBER90S_R2_PORTABLE_SYMMETRIC)
+#include "aes.h"
+
 typedef struct {
     aes256ctx sk_exp;
     uint8_t iv[12];
     uint32_t ctr;
 } aes256xof_ctx;
+#else
+#include <openssl/evp.h>
+
+/* The libcrypto CTR mode keeps the IV and the counter itself */
+typedef struct {
+    EVP_CIPHER_CTX *evp_ctx;
+} aes256xof_ctx;
+#endif
 
-void PQCLEAN_KYBER51290S_CLEAN_aes256_prf(uint8_t *output, size_t outlen, const uint8_t *key, uint8_t nonce);
-void PQCLEAN_KYBER51290S_CLEAN_aes256xof_absorb(aes256xof_ctx *s, const uint8_t *key, uint8_t x, uint8_t y);
-void PQCLEAN_KYBER51290S_CLEAN_aes256xof_squeezeblocks(uint8_t *out, size_t nblocks, aes256xof_ctx *s);
+int PQCLEAN_KYBER51290S_CLEAN_aes256_prf(uint8_t *output, size_t outlen, const uint8_t *key, uint8_t nonce);
+int PQCLEAN_KYBER51290S_CLEAN_aes256xof_absorb(aes256xof_ctx *s, const uint8_t *key, uint8_t x, uint8_t y);
+int PQCLEAN_KYBER51290S_CLEAN_aes256xof_squeezeblocks(uint8_t *out, size_t nblocks, aes256xof_ctx *s);
 void PQCLEAN_KYBER51290S_CLEAN_aes256xof_ctx_release(aes256xof_ctx *s);
 
 #endif
@@ -144,32 +144,35 @@ static size_t rej_uniform(int16_t *r, size_t len, const uint8_t *buf, size_t buf
 * Arguments:   - polyvec *a:                pointer to ouptput matrix A
 *              - const uint8_t *seed: pointer to input seed
 *              - int transposed:            boolean deciding whether A or A^T is generated
+*
+* Returns 0 on success, -1 if the XOF fails
 **************************************************/
 #define MAXNBLOCKS ((530+XOF_BLOCKBYTES)/XOF_BLOCKBYTES) /* 530 is expected number of required bytes */
-static void gen_matrix(polyvec *a, const uint8_t *seed, int transposed) {
+static int gen_matrix(polyvec *a, const uint8_t *seed, int transposed) {
     size_t ctr;
     uint8_t i, j;
     uint8_t buf[XOF_BLOCKBYTES * MAXNBLOCKS + 1];
-    xof_state state;
+    DEFER_CLEANUP(xof_state state = { 0 }, PQCLEAN_KYBER51290S_CLEAN_aes256xof_ctx_release);
 
     for (i = 0; i < KYBER_K; i++) {
         for (j = 0; j < KYBER_K; j++) {
             if (transposed) {
-                xof_absorb(&state, seed, i, j);
+                POSIX_GUARD(xof_absorb(&state, seed, i, j));
             } else {
-                xof_absorb(&state, seed, j, i);
+                POSIX_GUARD(xof_absorb(&state, seed, j, i));
             }
 
-            xof_squeezeblocks(buf, MAXNBLOCKS, &state);
+            POSIX_GUARD(xof_squeezeblocks(buf, MAXNBLOCKS, &state));
             ctr = rej_uniform(a[i].vec[j].coeffs, KYBER_N, buf, MAXNBLOCKS * XOF_BLOCKBYTES);
 
             while (ctr < KYBER_N) {
-                xof_squeezeblocks(buf, 1, &state);
+                POSIX_GUARD(xof_squeezeblocks(buf, 1, &state));
                 ctr += rej_uniform(a[i].vec[j].coeffs + ctr, KYBER_N - ctr, buf, XOF_BLOCKBYTES);
             }
             xof_ctx_release(&state);
         }
     }
+    return 0;
 }
 
 /*************************************************
@@ -189,15 +192,15 @@ int PQCLEAN_KYBER51290S_CLEAN_indcpa_keypair(uint8_t *pk, uint8_t *sk) {
     uint8_t nonce = 0;
 
     POSIX_GUARD_RESULT(s2n_get_random_bytes(buf, KYBER_SYMBYTES));
-    hash_g(buf, buf, KYBER_SYMBYTES);
+    POSIX_GUARD(hash_g(buf, buf, KYBER_SYMBYTES));
 
-    gen_a(a, publicseed);
+    POSIX_GUARD(gen_a(a, publicseed));
 
     for (size_t i = 0; i < KYBER_K; i++) {
-        PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(skpv.vec + i, noiseseed, nonce++);
+        POSIX_GUARD(PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(skpv.vec + i, noiseseed, nonce++));
     }
     for (size_t i = 0; i < KYBER_K; i++) {
-        PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(e.vec + i, noiseseed, nonce++);
+        POSIX_GUARD(PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(e.vec + i, noiseseed, nonce++));
     }
 
     PQCLEAN_KYBER51290S_CLEAN_polyvec_ntt(&skpv);
@@ -228,8 +231,10 @@ int PQCLEAN_KYBER51290S_CLEAN_indcpa_keypair(uint8_t *pk, uint8_t *sk) {
 *              - const uint8_t *pk:   pointer to input public key (of length KYBER_INDCPA_PUBLICKEYBYTES bytes)
 *              - const uint8_t *coin: pointer to input random coins used as seed (of length KYBER_SYMBYTES bytes)
 *                                           to deterministically generate all randomness
+*
+* Returns 0 on success, -1 if a symmetric primitive fails
 **************************************************/
-void PQCLEAN_KYBER51290S_CLEAN_indcpa_enc(uint8_t *c,
+int PQCLEAN_KYBER51290S_CLEAN_indcpa_enc(uint8_t *c,
         const uint8_t *m,
         const uint8_t *pk,
         const uint8_t *coins) {
@@ -240,15 +245,15 @@ void PQCLEAN_KYBER51290S_CLEAN_indcpa_enc(uint8_t *c,
 
     unpack_pk(&pkpv, seed, pk);
     PQCLEAN_KYBER51290S_CLEAN_poly_frommsg(&k, m);
-    gen_at(at, seed);
+    POSIX_GUARD(gen_at(at, seed));
 
     for (size_t i = 0; i < KYBER_K; i++) {
-        PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(sp.vec + i, coins, nonce++);
+        POSIX_GUARD(PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(sp.vec + i, coins, nonce++));
     }
     for (size_t i = 0; i < KYBER_K; i++) {
-        PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(ep.vec + i, coins, nonce++);
+        POSIX_GUARD(PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(ep.vec + i, coins, nonce++));
     }
-    PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(&epp, coins, nonce++);
+    POSIX_GUARD(PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(&epp, coins, nonce++));
 
     PQCLEAN_KYBER51290S_CLEAN_polyvec_ntt(&sp);
 
@@ -269,6 +274,7 @@ void PQCLEAN_KYBER51290S_CLEAN_indcpa_enc(uint8_t *c,
     PQCLEAN_KYBER51290S_CLEAN_poly_reduce(&v);
 
     pack_ciphertext(c, &bp, &v);
+    return 0;
 }
 
 /*************************************************
@@ -7,7 +7,7 @@ int PQCLEAN_KYBER51290S_CLEAN_indcpa_keypair(
     uint8_t *pk,
     uint8_t *sk);
 
-void PQCLEAN_KYBER51290S_CLEAN_indcpa_enc(
+int PQCLEAN_KYBER51290S_CLEAN_indcpa_enc(
     uint8_t *c,
     const uint8_t *m,
     const uint8_t *pk,
@@ -24,11 +24,11 @@
 int kyber_512_90s_r2_crypto_kem_keypair(uint8_t *pk, uint8_t *sk) {
     POSIX_ENSURE(s2n_pq_is_enabled(), S2N_ERR_PQ_DISABLED);
     size_t i;
-    PQCLEAN_KYBER51290S_CLEAN_indcpa_keypair(pk, sk);
+    POSIX_GUARD(PQCLEAN_KYBER51290S_CLEAN_indcpa_keypair(pk, sk));
     for (i = 0; i < KYBER_INDCPA_PUBLICKEYBYTES; i++) {
         sk[i + KYBER_INDCPA_SECRETKEYBYTES] = pk[i];
     }
-    hash_h(sk + KYBER_SECRETKEYBYTES - 2 * KYBER_SYMBYTES, pk, KYBER_PUBLICKEYBYTES);
+    POSIX_GUARD(hash_h(sk + KYBER_SECRETKEYBYTES - 2 * KYBER_SYMBYTES, pk, KYBER_PUBLICKEYBYTES));
     POSIX_GUARD_RESULT(s2n_get_random_bytes(sk + KYBER_SECRETKEYBYTES - KYBER_SYMBYTES, KYBER_SYMBYTES)); /* Value z for pseudo-random output on reject */
     return 0;
 }
@@ -51,15 +51,15 @@ int kyber_512_90s_r2_crypto_kem_enc(uint8_t *ct, uint8_t *ss, const uint8_t *pk)
     uint8_t buf[2 * KYBER_SYMBYTES];
 
     POSIX_GUARD_RESULT(s2n_get_random_bytes(buf, KYBER_SYMBYTES));
-    hash_h(buf, buf, KYBER_SYMBYTES);                                        /* Don't release system RNG output */
+    POSIX_GUARD(hash_h(buf, buf, KYBER_SYMBYTES));                           /* Don't release system RNG output */
 
-    hash_h(buf + KYBER_SYMBYTES, pk, KYBER_PUBLICKEYBYTES);                  /* Multitarget countermeasure for coins + contributory KEM */
-    hash_g(kr, buf, 2 * KYBER_SYMBYTES);
+    POSIX_GUARD(hash_h(buf + KYBER_SYMBYTES, pk, KYBER_PUBLICKEYBYTES));     /* Multitarget countermeasure for coins + contributory KEM */
+    POSIX_GUARD(hash_g(kr, buf, 2 * KYBER_SYMBYTES));
 
-    PQCLEAN_KYBER51290S_CLEAN_indcpa_enc(ct, buf, pk, kr + KYBER_SYMBYTES);                            /* coins are in kr+KYBER_SYMBYTES */
+    POSIX_GUARD(PQCLEAN_KYBER51290S_CLEAN_indcpa_enc(ct, buf, pk, kr + KYBER_SYMBYTES));               /* coins are in kr+KYBER_SYMBYTES */
 
-    hash_h(kr + KYBER_SYMBYTES, ct, KYBER_CIPHERTEXTBYTES);                  /* overwrite coins in kr with H(c) */
-    kdf(ss, kr, 2 * KYBER_SYMBYTES);                                         /* hash concatenation of pre-k and H(c) to k */
+    POSIX_GUARD(hash_h(kr + KYBER_SYMBYTES, ct, KYBER_CIPHERTEXTBYTES));     /* overwrite coins in kr with H(c) */
+    POSIX_GUARD(kdf(ss, kr, 2 * KYBER_SYMBYTES));                            /* hash concatenation of pre-k and H(c) to k */
     return 0;
 }
 
@@ -91,16 +91,16 @@ int kyber_512_90s_r2_crypto_kem_dec(uint8_t *ss, const uint8_t *ct, const uint8_
     for (i = 0; i < KYBER_SYMBYTES; i++) {                                   /* Multitarget countermeasure for coins + contributory KEM */
         buf[KYBER_SYMBYTES + i] = sk[KYBER_SECRETKEYBYTES - 2 * KYBER_SYMBYTES + i];    /* Save hash by storing H(pk) in sk */
     }
-    hash_g(kr, buf, 2 * KYBER_SYMBYTES);
+    POSIX_GUARD(hash_g(kr, buf, 2 * KYBER_SYMBYTES));
 
-    PQCLEAN_KYBER51290S_CLEAN_indcpa_enc(cmp, buf, pk, kr + KYBER_SYMBYTES);                           /* coins are in kr+KYBER_SYMBYTES */
+    POSIX_GUARD(PQCLEAN_KYBER51290S_CLEAN_indcpa_enc(cmp, buf, pk, kr + KYBER_SYMBYTES));              /* coins are in kr+KYBER_SYMBYTES */
 
     fail = PQCLEAN_KYBER51290S_CLEAN_verify(ct, cmp, KYBER_CIPHERTEXTBYTES);
 
-    hash_h(kr + KYBER_SYMBYTES, ct, KYBER_CIPHERTEXTBYTES);                  /* overwrite coins in kr with H(c)  */
+    POSIX_GUARD(hash_h(kr + KYBER_SYMBYTES, ct, KYBER_CIPHERTEXTBYTES));     /* overwrite coins in kr with H(c)  */
 
     PQCLEAN_KYBER51290S_CLEAN_cmov(kr, sk + KYBER_SECRETKEYBYTES - KYBER_SYMBYTES, KYBER_SYMBYTES, fail); /* Overwrite pre-k with z on re-encryption failure */
 
-    kdf(ss, kr, 2 * KYBER_SYMBYTES);                                         /* hash concatenation of pre-k and H(c) to k */
+    POSIX_GUARD(kdf(ss, kr, 2 * KYBER_SYMBYTES));                            /* hash concatenation of pre-k and H(c) to k */
     return 0;
 }
@@ -4,6 +4,7 @@
 #include "poly.h"
 #include "reduce.h"
 #include "symmetric.h"
+#include "utils/s2n_safety.h"
 
 #include <stdint.h>
 /*************************************************
@@ -101,12 +102,15 @@ void PQCLEAN_KYBER51290S_CLEAN_poly_frombytes(poly *r, const uint8_t *a) {
 * Arguments:   - poly *r:                   pointer to output polynomial
 *              - const uint8_t *seed: pointer to input seed (pointing to array of length KYBER_SYMBYTES bytes)
 *              - uint8_t nonce:       one-byte input nonce
+*
+* Returns 0 on success, -1 if the prf fails
 **************************************************/
-void PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(poly *r, const uint8_t *seed, uint8_t nonce) {
+int PQCLEAN_KYBER51290S_CLEAN_poly_getnoise(poly *r, const uint8_t *seed, uint8_t nonce) {
     uint8_t buf[KYBER_ETA * KYBER_N / 4];
 
-    prf(buf, KYBER_ETA * KYBER_N / 4, seed, nonce);
+    POSIX_GUARD(prf(buf, KYBER_ETA * KYBER_N / 4, seed, nonce));
     PQCLEAN_KYBER51290S_CLEAN_cbd(r, buf);
+    return 0;
 }
 
 /*************************************************
@@ -5,15 +5,23 @@
 
 
 #include "aes256ctr.h"
-#include "sha2.h"
 
-#define hash_h(OUT, IN, INBYTES) sha256(OUT, IN, INBYTES)
-#define hash_g(OUT, IN, INBYTES) sha512(OUT, IN, INBYTES)
+#include <stddef.h>
+#include <stdint.h>
+
+/* By default the symmetric primitives go through libcrypto (symmetric_libcrypto.c), so they
+ * pick up AES-NI and SHA extensions. Building with S2N_KYBER90S_R2_PORTABLE_SYMMETRIC swaps in
+ * the bundled table-based AES and SHA-2 from aes_c.c and sha2_c.c (symmetric_portable.c). */
+int PQCLEAN_KYBER51290S_CLEAN_sha256(uint8_t *out, const uint8_t *in, size_t inlen);
+int PQCLEAN_KYBER51290S_CLEAN_sha512(uint8_t *out, const uint8_t *in, size_t inlen);
+
+#define hash_h(OUT, IN, INBYTES) PQCLEAN_KYBER51290S_CLEAN_sha256(OUT, IN, INBYTES)
+#define hash_g(OUT, IN, INBYTES) PQCLEAN_KYBER51290S_CLEAN_sha512(OUT, IN, INBYTES)
 #define xof_absorb(STATE, IN, X, Y) PQCLEAN_KYBER51290S_CLEAN_aes256xof_absorb(STATE, IN, X, Y)
 #define xof_squeezeblocks(OUT, OUTBLOCKS, STATE) PQCLEAN_KYBER51290S_CLEAN_aes256xof_squeezeblocks(OUT, OUTBLOCKS, STATE)
 #define xof_ctx_release(STATE) PQCLEAN_KYBER51290S_CLEAN_aes256xof_ctx_release(STATE)
 #define prf(OUT, OUTBYTES, KEY, NONCE) PQCLEAN_KYBER51290S_CLEAN_aes256_prf(OUT, OUTBYTES, KEY, NONCE)
-#define kdf(OUT, IN, INBYTES) sha256(OUT, IN, INBYTES)
+#define kdf(OUT, IN, INBYTES) PQCLEAN_KYBER51290S_CLEAN_sha256(OUT, IN, INBYTES)
 
 #define XOF_BLOCKBYTES 64
 
@@ -0,0 +1,150 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "aes256ctr.h"
+#include "symmetric.h"
+
+#include "utils/s2n_safety.h"
+
+#include <limits.h>
+#include <openssl/evp.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define AES256CTR_NONCEBYTES 12
+#define AES256CTR_BLOCKBYTES 16
+
+DEFINE_POINTER_CLEANUP_FUNC(EVP_CIPHER_CTX *, EVP_CIPHER_CTX_free);
+
+/* AES-256-CTR with a 12-byte nonce and a 32-bit big-endian block counter starting at zero.
+ * libcrypto increments the whole 16-byte IV, which only differs once the counter wraps, and
+ * Kyber never asks for anywhere near 2^32 blocks from one nonce. */
+static int aes256ctr_init(EVP_CIPHER_CTX *ctx, const uint8_t *key, const uint8_t nonce[AES256CTR_NONCEBYTES]) {
+    uint8_t iv[AES256CTR_BLOCKBYTES] = { 0 };
+    memcpy(iv, nonce, AES256CTR_NONCEBYTES);
+
+    POSIX_GUARD_OSSL(EVP_EncryptInit_ex(ctx, EVP_aes_256_ctr(), NULL, key, iv), S2N_ERR_PQ_CRYPTO);
+    return 0;
+}
+
+/* CTR mode output is the keystream XORed into the input, so encrypting zeros yields the keystream */
+static int aes256ctr_keystream(EVP_CIPHER_CTX *ctx, uint8_t *out, size_t outlen) {
+    POSIX_ENSURE(outlen <= INT_MAX, S2N_ERR_PQ_CRYPTO);
+    memset(out, 0, outlen);
+
+    int written = 0;
+    POSIX_GUARD_OSSL(EVP_EncryptUpdate(ctx, out, &written, out, (int) outlen), S2N_ERR_PQ_CRYPTO);
+    POSIX_ENSURE((size_t) written == outlen, S2N_ERR_PQ_CRYPTO);
+    return 0;
+}
+
+/*************************************************
+* Name:        aes256_prf
+*
+* Description: AES256 stream generation in CTR mode using 32-bit counter,
+*              nonce is zero-padded to 12 bytes, counter starts at zero
+*
+* Arguments:   - uint8_t *output:      pointer to output
+*              - size_t outlen:        length of requested output in bytes
+*              - const uint8_t *key:   pointer to 32-byte key
+*              - uint8_t nonce:        1-byte nonce (will be zero-padded to 12 bytes)
+*
+* Returns 0 on success, -1 on a libcrypto failure
+**************************************************/
+int PQCLEAN_KYBER51290S_CLEAN_aes256_prf(uint8_t *output, size_t outlen, const uint8_t *key, uint8_t nonce) {
+    uint8_t iv[AES256CTR_NONCEBYTES] = { nonce };
+
+    DEFER_CLEANUP(EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free_pointer);
+    POSIX_ENSURE(ctx != NULL, S2N_ERR_ALLOC);
+
+    POSIX_GUARD(aes256ctr_init(ctx, key, iv));
+    POSIX_GUARD(aes256ctr_keystream(ctx, output, outlen));
+    return 0;
+}
+
+/*************************************************
+* Name:        aes256xof_absorb
+*
+* Description: AES256 CTR used as a replacement for a XOF; this function
+*              "absorbs" a 32-byte key and two additional bytes that are zero-padded
+*              to a 12-byte nonce
+*
+* Arguments:   - aes256xof_ctx *s:    pointer to state to "absorb" key and IV into
+*              - const uint8_t *key:  pointer to 32-byte key
+*              - uint8_t x:           first additional byte to "absorb"
+*              - uint8_t y:           second additional byte to "absorb"
+*
+* Returns 0 on success, -1 on a libcrypto failure
+**************************************************/
+int PQCLEAN_KYBER51290S_CLEAN_aes256xof_absorb(aes256xof_ctx *s, const uint8_t *key, uint8_t x, uint8_t y) {
+    uint8_t iv[AES256CTR_NONCEBYTES] = { x, y };
+
+    if (s->evp_ctx == NULL) {
+        s->evp_ctx = EVP_CIPHER_CTX_new();
+        POSIX_ENSURE(s->evp_ctx != NULL, S2N_ERR_ALLOC);
+    }
+
+    POSIX_GUARD(aes256ctr_init(s->evp_ctx, key, iv));
+    return 0;
+}
+
+/*************************************************
+* Name:        aes256xof_squeezeblocks
+*
+* Description: AES256 CTR used as a replacement for a XOF; this function
+*              generates 4 blocks out AES256-CTR output
+*
+* Arguments:   - uint8_t *out:          pointer to output
+*              - size_t nblocks:        number of reqested 64-byte output blocks
+*              - aes256xof_ctx *s:      AES "state", i.e. the libcrypto context
+*
+* Returns 0 on success, -1 on a libcrypto failure
+**************************************************/
+int PQCLEAN_KYBER51290S_CLEAN_aes256xof_squeezeblocks(uint8_t *out, size_t nblocks, aes256xof_ctx *s) {
+    POSIX_ENSURE_REF(s->evp_ctx);
+    POSIX_GUARD(aes256ctr_keystream(s->evp_ctx, out, nblocks * 64));
+    return 0;
+}
+
+/** Free the AES ctx; safe to call on a released or never absorbed ctx **/
+void PQCLEAN_KYBER51290S_CLEAN_aes256xof_ctx_release(aes256xof_ctx *s) {
+    EVP_CIPHER_CTX_free(s->evp_ctx);
+    s->evp_ctx = NULL;
+}
+
+/*************************************************
+* Name:        sha256
+*
+* Description: SHA-256 through libcrypto
+*
+* Returns 0 on success, -1 on a libcrypto failure
+**************************************************/
+int PQCLEAN_KYBER51290S_CLEAN_sha256(uint8_t *out, const uint8_t *in, size_t inlen) {
+    POSIX_GUARD_OSSL(EVP_Digest(in, inlen, out, NULL, EVP_sha256(), NULL), S2N_ERR_PQ_CRYPTO);
+    return 0;
+}
+
+/*************************************************
+* Name:        sha512
+*
+* Description: SHA-512 through libcrypto
+*
+* Returns 0 on success, -1 on a libcrypto failure
+**************************************************/
+int PQCLEAN_KYBER51290S_CLEAN_sha512(uint8_t *out, const uint8_t *in, size_t inlen) {
+    POSIX_GUARD_OSSL(EVP_Digest(in, inlen, out, NULL, EVP_sha512(), NULL), S2N_ERR_PQ_CRYPTO);
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "sha2.h"
+#include "symmetric.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*************************************************
+* Name:        sha256
+*
+* Description: SHA-256 from the bundled sha2_c.c, only built
+*              with S2N_KYBER90S_R2_PORTABLE_SYMMETRIC
+*
+* Returns 0 (success)
+**************************************************/
+int PQCLEAN_KYBER51290S_CLEAN_sha256(uint8_t *out, const uint8_t *in, size_t inlen) {
+    sha256(out, in, inlen);
+    return 0;
+}
+
+/*************************************************
+* Name:        sha512
+*
+* Description: SHA-512 from the bundled sha2_c.c, only built
+*              with S2N_KYBER90S_R2_PORTABLE_SYMMETRIC
+*
+* Returns 0 (success)
+**************************************************/
+int PQCLEAN_KYBER51290S_CLEAN_sha512(uint8_t *out, const uint8_t *in, size_t inlen) {
+    sha512(out, in, inlen);
+    return 0;
+}
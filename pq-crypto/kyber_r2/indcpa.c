@@ -1,8 +1,10 @@
 #include "indcpa.h"
+#include "kyber512r2_avx2.h"
 #include "ntt.h"
 #include "params.h"
 #include "poly.h"
 #include "polyvec.h"
+#include "../s2n_pq.h"
 #include "../s2n_pq_random.h"
 #include "utils/s2n_safety.h"
 #include "symmetric.h"
@@ -114,6 +116,12 @@ static void unpack_ciphertext(polyvec *b, poly *v, const uint8_t *c) {
 * Returns number of sampled 16-bit integers (at most len)
 **************************************************/
 static size_t rej_uniform(int16_t *r, size_t len, const uint8_t *buf, size_t buflen) {
+#if defined(S2N_KYBER512R2_AVX2)
+    if (s2n_kyber512r2_avx2_is_enabled()) {
+        return PQCLEAN_KYBER512_AVX2_rej_uniform(r, len, buf, buflen);
+    }
+#endif
+
     size_t ctr, pos;
 
     ctr = pos = 0;
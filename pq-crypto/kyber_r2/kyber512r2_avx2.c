@@ -0,0 +1,404 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "kyber512r2_avx2.h"
+#include "params.h"
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The NTT layers with len >= 16 pair whole vectors; the layers with len <= 8 pair
+ * lanes of two neighbouring vectors, which are shuffled so that the butterflies
+ * again line up vector against vector. The zeta tables below are laid out to
+ * match those shuffles, so every butterfly group is a single vector load. */
+
+/* PQCLEAN_KYBER512_CLEAN_zetas[1..127], one vector per butterfly group, in the order ntt() consumes them */
+static const int16_t zetas_avx2[39 * 16] = {
+    2571, 2571, 2571, 2571, 2571, 2571, 2571, 2571, 2571, 2571, 2571, 2571, 2571, 2571, 2571, 2571,
+    2970, 2970, 2970, 2970, 2970, 2970, 2970, 2970, 2970, 2970, 2970, 2970, 2970, 2970, 2970, 2970,
+    1812, 1812, 1812, 1812, 1812, 1812, 1812, 1812, 1812, 1812, 1812, 1812, 1812, 1812, 1812, 1812,
+    1493, 1493, 1493, 1493, 1493, 1493, 1493, 1493, 1493, 1493, 1493, 1493, 1493, 1493, 1493, 1493,
+    1422, 1422, 1422, 1422, 1422, 1422, 1422, 1422, 1422, 1422, 1422, 1422, 1422, 1422, 1422, 1422,
+    287, 287, 287, 287, 287, 287, 287, 287, 287, 287, 287, 287, 287, 287, 287, 287,
+    202, 202, 202, 202, 202, 202, 202, 202, 202, 202, 202, 202, 202, 202, 202, 202,
+    3158, 3158, 3158, 3158, 3158, 3158, 3158, 3158, 3158, 3158, 3158, 3158, 3158, 3158, 3158, 3158,
+    622, 622, 622, 622, 622, 622, 622, 622, 622, 622, 622, 622, 622, 622, 622, 622,
+    1577, 1577, 1577, 1577, 1577, 1577, 1577, 1577, 1577, 1577, 1577, 1577, 1577, 1577, 1577, 1577,
+    182, 182, 182, 182, 182, 182, 182, 182, 182, 182, 182, 182, 182, 182, 182, 182,
+    962, 962, 962, 962, 962, 962, 962, 962, 962, 962, 962, 962, 962, 962, 962, 962,
+    2127, 2127, 2127, 2127, 2127, 2127, 2127, 2127, 2127, 2127, 2127, 2127, 2127, 2127, 2127, 2127,
+    1855, 1855, 1855, 1855, 1855, 1855, 1855, 1855, 1855, 1855, 1855, 1855, 1855, 1855, 1855, 1855,
+    1468, 1468, 1468, 1468, 1468, 1468, 1468, 1468, 1468, 1468, 1468, 1468, 1468, 1468, 1468, 1468,
+    573, 573, 573, 573, 573, 573, 573, 573, 2004, 2004, 2004, 2004, 2004, 2004, 2004, 2004,
+    264, 264, 264, 264, 264, 264, 264, 264, 383, 383, 383, 383, 383, 383, 383, 383,
+    2500, 2500, 2500, 2500, 2500, 2500, 2500, 2500, 1458, 1458, 1458, 1458, 1458, 1458, 1458, 1458,
+    1727, 1727, 1727, 1727, 1727, 1727, 1727, 1727, 3199, 3199, 3199, 3199, 3199, 3199, 3199, 3199,
+    2648, 2648, 2648, 2648, 2648, 2648, 2648, 2648, 1017, 1017, 1017, 1017, 1017, 1017, 1017, 1017,
+    732, 732, 732, 732, 732, 732, 732, 732, 608, 608, 608, 608, 608, 608, 608, 608,
+    1787, 1787, 1787, 1787, 1787, 1787, 1787, 1787, 411, 411, 411, 411, 411, 411, 411, 411,
+    3124, 3124, 3124, 3124, 3124, 3124, 3124, 3124, 1758, 1758, 1758, 1758, 1758, 1758, 1758, 1758,
+    1223, 1223, 1223, 1223, 2777, 2777, 2777, 2777, 652, 652, 652, 652, 1015, 1015, 1015, 1015,
+    2036, 2036, 2036, 2036, 3047, 3047, 3047, 3047, 1491, 1491, 1491, 1491, 1785, 1785, 1785, 1785,
+    516, 516, 516, 516, 3009, 3009, 3009, 3009, 3321, 3321, 3321, 3321, 2663, 2663, 2663, 2663,
+    1711, 1711, 1711, 1711, 126, 126, 126, 126, 2167, 2167, 2167, 2167, 1469, 1469, 1469, 1469,
+    2476, 2476, 2476, 2476, 3058, 3058, 3058, 3058, 3239, 3239, 3239, 3239, 830, 830, 830, 830,
+    107, 107, 107, 107, 3082, 3082, 3082, 3082, 1908, 1908, 1908, 1908, 2378, 2378, 2378, 2378,
+    2931, 2931, 2931, 2931, 1821, 1821, 1821, 1821, 961, 961, 961, 961, 2604, 2604, 2604, 2604,
+    448, 448, 448, 448, 677, 677, 677, 677, 2264, 2264, 2264, 2264, 2054, 2054, 2054, 2054,
+    2226, 2226, 430, 430, 2078, 2078, 871, 871, 555, 555, 843, 843, 1550, 1550, 105, 105,
+    422, 422, 587, 587, 3038, 3038, 2869, 2869, 177, 177, 3094, 3094, 1574, 1574, 1653, 1653,
+    3083, 3083, 778, 778, 2552, 2552, 1483, 1483, 1159, 1159, 3182, 3182, 2727, 2727, 1119, 1119,
+    1739, 1739, 644, 644, 418, 418, 329, 329, 2457, 2457, 349, 349, 3173, 3173, 3254, 3254,
+    817, 817, 1097, 1097, 1322, 1322, 2044, 2044, 603, 603, 610, 610, 1864, 1864, 384, 384,
+    2114, 2114, 3193, 3193, 2455, 2455, 220, 220, 1218, 1218, 1994, 1994, 2142, 2142, 1670, 1670,
+    2144, 2144, 1799, 1799, 1819, 1819, 2475, 2475, 2051, 2051, 794, 794, 2459, 2459, 478, 478,
+    3221, 3221, 3021, 3021, 958, 958, 1869, 1869, 996, 996, 991, 991, 1522, 1522, 1628, 1628
+};
+
+/* PQCLEAN_KYBER512_CLEAN_zetas_inv[0..127], one vector per butterfly group, in the order invntt() consumes them */
+static const int16_t zetas_inv_avx2[40 * 16] = {
+    1701, 1701, 1807, 1807, 2338, 2338, 2333, 2333, 1460, 1460, 2371, 2371, 308, 308, 108, 108,
+    2851, 2851, 870, 870, 2535, 2535, 1278, 1278, 854, 854, 1510, 1510, 1530, 1530, 1185, 1185,
+    1659, 1659, 1187, 1187, 1335, 1335, 2111, 2111, 3109, 3109, 874, 874, 136, 136, 1215, 1215,
+    2945, 2945, 1465, 1465, 2719, 2719, 2726, 2726, 1285, 1285, 2007, 2007, 2232, 2232, 2512, 2512,
+    75, 75, 156, 156, 2980, 2980, 872, 872, 3000, 3000, 2911, 2911, 2685, 2685, 1590, 1590,
+    2210, 2210, 602, 602, 147, 147, 2170, 2170, 1846, 1846, 777, 777, 2551, 2551, 246, 246,
+    1676, 1676, 1755, 1755, 235, 235, 3152, 3152, 460, 460, 291, 291, 2742, 2742, 2907, 2907,
+    3224, 3224, 1779, 1779, 2486, 2486, 2774, 2774, 2458, 2458, 1251, 1251, 2899, 2899, 1103, 1103,
+    1275, 1275, 1275, 1275, 1065, 1065, 1065, 1065, 2652, 2652, 2652, 2652, 2881, 2881, 2881, 2881,
+    725, 725, 725, 725, 2368, 2368, 2368, 2368, 1508, 1508, 1508, 1508, 398, 398, 398, 398,
+    951, 951, 951, 951, 1421, 1421, 1421, 1421, 247, 247, 247, 247, 3222, 3222, 3222, 3222,
+    2499, 2499, 2499, 2499, 90, 90, 90, 90, 271, 271, 271, 271, 853, 853, 853, 853,
+    1860, 1860, 1860, 1860, 1162, 1162, 1162, 1162, 3203, 3203, 3203, 3203, 1618, 1618, 1618, 1618,
+    666, 666, 666, 666, 8, 8, 8, 8, 320, 320, 320, 320, 2813, 2813, 2813, 2813,
+    1544, 1544, 1544, 1544, 1838, 1838, 1838, 1838, 282, 282, 282, 282, 1293, 1293, 1293, 1293,
+    2314, 2314, 2314, 2314, 2677, 2677, 2677, 2677, 552, 552, 552, 552, 2106, 2106, 2106, 2106,
+    1571, 1571, 1571, 1571, 1571, 1571, 1571, 1571, 205, 205, 205, 205, 205, 205, 205, 205,
+    2918, 2918, 2918, 2918, 2918, 2918, 2918, 2918, 1542, 1542, 1542, 1542, 1542, 1542, 1542, 1542,
+    2721, 2721, 2721, 2721, 2721, 2721, 2721, 2721, 2597, 2597, 2597, 2597, 2597, 2597, 2597, 2597,
+    2312, 2312, 2312, 2312, 2312, 2312, 2312, 2312, 681, 681, 681, 681, 681, 681, 681, 681,
+    130, 130, 130, 130, 130, 130, 130, 130, 1602, 1602, 1602, 1602, 1602, 1602, 1602, 1602,
+    1871, 1871, 1871, 1871, 1871, 1871, 1871, 1871, 829, 829, 829, 829, 829, 829, 829, 829,
+    2946, 2946, 2946, 2946, 2946, 2946, 2946, 2946, 3065, 3065, 3065, 3065, 3065, 3065, 3065, 3065,
+    1325, 1325, 1325, 1325, 1325, 1325, 1325, 1325, 2756, 2756, 2756, 2756, 2756, 2756, 2756, 2756,
+    1861, 1861, 1861, 1861, 1861, 1861, 1861, 1861, 1861, 1861, 1861, 1861, 1861, 1861, 1861, 1861,
+    1474, 1474, 1474, 1474, 1474, 1474, 1474, 1474, 1474, 1474, 1474, 1474, 1474, 1474, 1474, 1474,
+    1202, 1202, 1202, 1202, 1202, 1202, 1202, 1202, 1202, 1202, 1202, 1202, 1202, 1202, 1202, 1202,
+    2367, 2367, 2367, 2367, 2367, 2367, 2367, 2367, 2367, 2367, 2367, 2367, 2367, 2367, 2367, 2367,
+    3147, 3147, 3147, 3147, 3147, 3147, 3147, 3147, 3147, 3147, 3147, 3147, 3147, 3147, 3147, 3147,
+    1752, 1752, 1752, 1752, 1752, 1752, 1752, 1752, 1752, 1752, 1752, 1752, 1752, 1752, 1752, 1752,
+    2707, 2707, 2707, 2707, 2707, 2707, 2707, 2707, 2707, 2707, 2707, 2707, 2707, 2707, 2707, 2707,
+    171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171, 171,
+    3127, 3127, 3127, 3127, 3127, 3127, 3127, 3127, 3127, 3127, 3127, 3127, 3127, 3127, 3127, 3127,
+    3042, 3042, 3042, 3042, 3042, 3042, 3042, 3042, 3042, 3042, 3042, 3042, 3042, 3042, 3042, 3042,
+    1907, 1907, 1907, 1907, 1907, 1907, 1907, 1907, 1907, 1907, 1907, 1907, 1907, 1907, 1907, 1907,
+    1836, 1836, 1836, 1836, 1836, 1836, 1836, 1836, 1836, 1836, 1836, 1836, 1836, 1836, 1836, 1836,
+    1517, 1517, 1517, 1517, 1517, 1517, 1517, 1517, 1517, 1517, 1517, 1517, 1517, 1517, 1517, 1517,
+    359, 359, 359, 359, 359, 359, 359, 359, 359, 359, 359, 359, 359, 359, 359, 359,
+    758, 758, 758, 758, 758, 758, 758, 758, 758, 758, 758, 758, 758, 758, 758, 758,
+    1441, 1441, 1441, 1441, 1441, 1441, 1441, 1441, 1441, 1441, 1441, 1441, 1441, 1441, 1441, 1441
+};
+
+/* +/-PQCLEAN_KYBER512_CLEAN_zetas[64..127] for each coefficient pair of poly_basemul() */
+static const int16_t basemul_zetas_avx2[8 * 16] = {
+    2226, -2226, 430, -430, 555, -555, 843, -843, 2078, -2078, 871, -871, 1550, -1550, 105, -105,
+    422, -422, 587, -587, 177, -177, 3094, -3094, 3038, -3038, 2869, -2869, 1574, -1574, 1653, -1653,
+    3083, -3083, 778, -778, 1159, -1159, 3182, -3182, 2552, -2552, 1483, -1483, 2727, -2727, 1119, -1119,
+    1739, -1739, 644, -644, 2457, -2457, 349, -349, 418, -418, 329, -329, 3173, -3173, 3254, -3254,
+    817, -817, 1097, -1097, 603, -603, 610, -610, 1322, -1322, 2044, -2044, 1864, -1864, 384, -384,
+    2114, -2114, 3193, -3193, 1218, -1218, 1994, -1994, 2455, -2455, 220, -220, 2142, -2142, 1670, -1670,
+    2144, -2144, 1799, -1799, 2051, -2051, 794, -794, 1819, -1819, 2475, -2475, 2459, -2459, 478, -478,
+    3221, -3221, 3021, -3021, 996, -996, 991, -991, 958, -958, 1869, -1869, 1522, -1522, 1628, -1628
+};
+
+#define KYBER_QINV_16 -3327 /* q^(-1) mod 2^16, as a signed 16-bit integer */
+#define KYBER_BARRETT_V 20159 /* (1 << 26) / q + 1, as in PQCLEAN_KYBER512_CLEAN_barrett_reduce */
+
+/*************************************************
+* Name:        fqmul_avx2
+*
+* Description: Lane-wise PQCLEAN_KYBER512_CLEAN_montgomery_reduce(a * b).
+*              The low halves of a * b and u * q are equal by construction of u,
+*              so the reduction only needs the high halves of both products.
+**************************************************/
+static inline __m256i fqmul_avx2(__m256i a, __m256i b) {
+    const __m256i q = _mm256_set1_epi16(KYBER_Q);
+    const __m256i qinv = _mm256_set1_epi16(KYBER_QINV_16);
+
+    __m256i lo = _mm256_mullo_epi16(a, b);
+    __m256i hi = _mm256_mulhi_epi16(a, b);
+    __m256i u = _mm256_mullo_epi16(lo, qinv);
+    return _mm256_sub_epi16(hi, _mm256_mulhi_epi16(u, q));
+}
+
+/*************************************************
+* Name:        barrett_reduce_avx2
+*
+* Description: Lane-wise PQCLEAN_KYBER512_CLEAN_barrett_reduce(a)
+**************************************************/
+static inline __m256i barrett_reduce_avx2(__m256i a) {
+    const __m256i q = _mm256_set1_epi16(KYBER_Q);
+    const __m256i v = _mm256_set1_epi16(KYBER_BARRETT_V);
+
+    __m256i t = _mm256_srai_epi16(_mm256_mulhi_epi16(a, v), 10);
+    return _mm256_sub_epi16(a, _mm256_mullo_epi16(t, q));
+}
+
+static inline void ntt_butterfly_avx2(__m256i *a, __m256i *b, __m256i zeta) {
+    __m256i t = fqmul_avx2(zeta, *b);
+    *b = _mm256_sub_epi16(*a, t);
+    *a = _mm256_add_epi16(*a, t);
+}
+
+static inline void invntt_butterfly_avx2(__m256i *a, __m256i *b, __m256i zeta) {
+    __m256i t = *a;
+    *a = barrett_reduce_avx2(_mm256_add_epi16(t, *b));
+    *b = fqmul_avx2(zeta, _mm256_sub_epi16(t, *b));
+}
+
+/*************************************************
+* Name:        split_avx2
+*
+* Description: For a layer with len in {2, 4, 8}, gathers the first halves of
+*              the butterflies in the vectors v0 and v1 into *a and the second
+*              halves into *b. merge_avx2() undoes it.
+**************************************************/
+static inline void split_avx2(size_t len, __m256i v0, __m256i v1, __m256i *a, __m256i *b) {
+    switch (len) {
+        case 8:
+            *a = _mm256_permute2x128_si256(v0, v1, 0x20);
+            *b = _mm256_permute2x128_si256(v0, v1, 0x31);
+            break;
+        case 4:
+            *a = _mm256_unpacklo_epi64(v0, v1);
+            *b = _mm256_unpackhi_epi64(v0, v1);
+            break;
+        default:
+            v0 = _mm256_shuffle_epi32(v0, 0xd8);
+            v1 = _mm256_shuffle_epi32(v1, 0xd8);
+            *a = _mm256_unpacklo_epi64(v0, v1);
+            *b = _mm256_unpackhi_epi64(v0, v1);
+            break;
+    }
+}
+
+static inline void merge_avx2(size_t len, __m256i a, __m256i b, __m256i *v0, __m256i *v1) {
+    switch (len) {
+        case 8:
+            *v0 = _mm256_permute2x128_si256(a, b, 0x20);
+            *v1 = _mm256_permute2x128_si256(a, b, 0x31);
+            break;
+        case 4:
+            *v0 = _mm256_unpacklo_epi64(a, b);
+            *v1 = _mm256_unpackhi_epi64(a, b);
+            break;
+        default:
+            *v0 = _mm256_shuffle_epi32(_mm256_unpacklo_epi64(a, b), 0xd8);
+            *v1 = _mm256_shuffle_epi32(_mm256_unpackhi_epi64(a, b), 0xd8);
+            break;
+    }
+}
+
+/*************************************************
+* Name:        PQCLEAN_KYBER512_AVX2_ntt
+*
+* Description: Same as PQCLEAN_KYBER512_CLEAN_ntt
+*
+* Arguments:   - int16_t poly[256]: pointer to input/output vector of elements of Zq
+**************************************************/
+void PQCLEAN_KYBER512_AVX2_ntt(int16_t poly[256]) {
+    const int16_t *zeta = zetas_avx2;
+    __m256i v[16];
+    size_t i, j, len;
+
+    for (i = 0; i < 16; i++) {
+        v[i] = _mm256_loadu_si256((const __m256i *)&poly[16 * i]);
+    }
+
+    for (len = 128; len >= 16; len >>= 1) {
+        size_t half = len / 16;
+        for (i = 0; i < 16; i += 2 * half) {
+            __m256i z = _mm256_loadu_si256((const __m256i *)zeta);
+            zeta += 16;
+            for (j = i; j < i + half; j++) {
+                ntt_butterfly_avx2(&v[j], &v[j + half], z);
+            }
+        }
+    }
+
+    for (len = 8; len >= 2; len >>= 1) {
+        for (i = 0; i < 16; i += 2) {
+            __m256i z = _mm256_loadu_si256((const __m256i *)zeta);
+            __m256i a, b;
+            zeta += 16;
+            split_avx2(len, v[i], v[i + 1], &a, &b);
+            ntt_butterfly_avx2(&a, &b, z);
+            merge_avx2(len, a, b, &v[i], &v[i + 1]);
+        }
+    }
+
+    for (i = 0; i < 16; i++) {
+        _mm256_storeu_si256((__m256i *)&poly[16 * i], v[i]);
+    }
+}
+
+/*************************************************
+* Name:        PQCLEAN_KYBER512_AVX2_invntt
+*
+* Description: Same as PQCLEAN_KYBER512_CLEAN_invntt
+*
+* Arguments:   - int16_t poly[256]: pointer to input/output vector of elements of Zq
+**************************************************/
+void PQCLEAN_KYBER512_AVX2_invntt(int16_t poly[256]) {
+    const int16_t *zeta = zetas_inv_avx2;
+    __m256i v[16];
+    size_t i, j, len;
+
+    for (i = 0; i < 16; i++) {
+        v[i] = _mm256_loadu_si256((const __m256i *)&poly[16 * i]);
+    }
+
+    for (len = 2; len <= 8; len <<= 1) {
+        for (i = 0; i < 16; i += 2) {
+            __m256i z = _mm256_loadu_si256((const __m256i *)zeta);
+            __m256i a, b;
+            zeta += 16;
+            split_avx2(len, v[i], v[i + 1], &a, &b);
+            invntt_butterfly_avx2(&a, &b, z);
+            merge_avx2(len, a, b, &v[i], &v[i + 1]);
+        }
+    }
+
+    for (len = 16; len <= 128; len <<= 1) {
+        size_t half = len / 16;
+        for (i = 0; i < 16; i += 2 * half) {
+            __m256i z = _mm256_loadu_si256((const __m256i *)zeta);
+            zeta += 16;
+            for (j = i; j < i + half; j++) {
+                invntt_butterfly_avx2(&v[j], &v[j + half], z);
+            }
+        }
+    }
+
+    /* The last vector of the table is zetas_inv[127], which also scales by 1/128 */
+    __m256i f = _mm256_loadu_si256((const __m256i *)zeta);
+    for (i = 0; i < 16; i++) {
+        _mm256_storeu_si256((__m256i *)&poly[16 * i], fqmul_avx2(v[i], f));
+    }
+}
+
+/*************************************************
+* Name:        deinterleave_avx2
+*
+* Description: Splits the 16 coefficient pairs held in x and y into a vector
+*              of their first and a vector of their second coefficients
+**************************************************/
+static inline void deinterleave_avx2(__m256i x, __m256i y, __m256i *even, __m256i *odd) {
+    const __m256i mask = _mm256_setr_epi8(
+        0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+        0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+
+    x = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, mask), 0xd8);
+    y = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(y, mask), 0xd8);
+    *even = _mm256_permute2x128_si256(x, y, 0x20);
+    *odd = _mm256_permute2x128_si256(x, y, 0x31);
+}
+
+static inline void interleave_avx2(__m256i even, __m256i odd, __m256i *x, __m256i *y) {
+    __m256i lo = _mm256_unpacklo_epi16(even, odd);
+    __m256i hi = _mm256_unpackhi_epi16(even, odd);
+    *x = _mm256_permute2x128_si256(lo, hi, 0x20);
+    *y = _mm256_permute2x128_si256(lo, hi, 0x31);
+}
+
+/*************************************************
+* Name:        PQCLEAN_KYBER512_AVX2_poly_basemul
+*
+* Description: Same as PQCLEAN_KYBER512_CLEAN_poly_basemul
+*
+* Arguments:   - int16_t r[256]:       pointer to output polynomial
+*              - const int16_t a[256]: pointer to first input polynomial
+*              - const int16_t b[256]: pointer to second input polynomial
+**************************************************/
+void PQCLEAN_KYBER512_AVX2_poly_basemul(int16_t r[256], const int16_t a[256], const int16_t b[256]) {
+    for (size_t i = 0; i < 8; i++) {
+        __m256i a0, a1, b0, b1, r0, r1;
+        __m256i zeta = _mm256_loadu_si256((const __m256i *)&basemul_zetas_avx2[16 * i]);
+
+        deinterleave_avx2(_mm256_loadu_si256((const __m256i *)&a[32 * i]),
+                          _mm256_loadu_si256((const __m256i *)&a[32 * i + 16]), &a0, &a1);
+        deinterleave_avx2(_mm256_loadu_si256((const __m256i *)&b[32 * i]),
+                          _mm256_loadu_si256((const __m256i *)&b[32 * i + 16]), &b0, &b1);
+
+        r0 = fqmul_avx2(fqmul_avx2(a1, b1), zeta);
+        r0 = _mm256_add_epi16(r0, fqmul_avx2(a0, b0));
+        r1 = _mm256_add_epi16(fqmul_avx2(a0, b1), fqmul_avx2(a1, b0));
+
+        interleave_avx2(r0, r1, &r0, &r1);
+        _mm256_storeu_si256((__m256i *)&r[32 * i], r0);
+        _mm256_storeu_si256((__m256i *)&r[32 * i + 16], r1);
+    }
+}
+
+/*************************************************
+* Name:        PQCLEAN_KYBER512_AVX2_rej_uniform
+*
+* Description: Same as rej_uniform in indcpa.c. Checks and reduces 16 candidates
+*              at a time, and falls back to the scalar loop for the tail of buf.
+*
+* Arguments:   - int16_t *r:          pointer to output buffer
+*              - size_t len:          requested number of 16-bit integers (uniform mod q)
+*              - const uint8_t *buf:  pointer to input buffer (assumed to be uniform random bytes)
+*              - size_t buflen:       length of input buffer in bytes
+*
+* Returns number of sampled 16-bit integers (at most len)
+**************************************************/
+size_t PQCLEAN_KYBER512_AVX2_rej_uniform(int16_t *r, size_t len, const uint8_t *buf, size_t buflen) {
+    const __m256i q = _mm256_set1_epi16(KYBER_Q);
+    const __m256i bound = _mm256_set1_epi16((int16_t)(19 * KYBER_Q - 1));
+    int16_t vals[16];
+    size_t ctr, pos;
+
+    ctr = pos = 0;
+    while (ctr < len && pos + 32 <= buflen) {
+        /* x86 is little-endian, so this matches buf[pos] | (buf[pos + 1] << 8) */
+        __m256i val = _mm256_loadu_si256((const __m256i *)&buf[pos]);
+        pos += 32;
+
+        __m256i good = _mm256_cmpeq_epi16(_mm256_min_epu16(val, bound), val);
+        val = _mm256_sub_epi16(val, _mm256_mullo_epi16(_mm256_srli_epi16(val, 12), q)); // Barrett reduction
+        _mm256_storeu_si256((__m256i *)vals, val);
+
+        /* One bit per lane: movemask sets both bits of each accepted 16-bit lane */
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(good) & 0x55555555;
+        while (mask != 0 && ctr < len) {
+            r[ctr++] = vals[__builtin_ctz(mask) / 2];
+            mask &= mask - 1;
+        }
+    }
+
+    while (ctr < len && pos + 2 <= buflen) {
+        uint16_t val = (uint16_t)(buf[pos] | ((uint16_t)buf[pos + 1] << 8));
+        pos += 2;
+
+        if (val < 19 * KYBER_Q) {
+            val -= (uint16_t)((val >> 12) * KYBER_Q); // Barrett reduction
+            r[ctr++] = (int16_t)val;
+        }
+    }
+
+    return ctr;
+}
@@ -0,0 +1,15 @@
+#ifndef KYBER512R2_AVX2_H
+#define KYBER512R2_AVX2_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* AVX2 versions of the hot loops in ntt.c, poly.c and indcpa.c. Each one produces
+ * bit-for-bit the same output as the portable code it replaces; callers select them
+ * at runtime with s2n_kyber512r2_avx2_is_enabled(). */
+void PQCLEAN_KYBER512_AVX2_ntt(int16_t poly[256]);
+void PQCLEAN_KYBER512_AVX2_invntt(int16_t poly[256]);
+void PQCLEAN_KYBER512_AVX2_poly_basemul(int16_t r[256], const int16_t a[256], const int16_t b[256]);
+size_t PQCLEAN_KYBER512_AVX2_rej_uniform(int16_t *r, size_t len, const uint8_t *buf, size_t buflen);
+
+#endif
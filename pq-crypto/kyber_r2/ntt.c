@@ -1,6 +1,8 @@
+#include "kyber512r2_avx2.h"
 #include "ntt.h"
 #include "params.h"
 #include "reduce.h"
+#include "../s2n_pq.h"
 
 #include <stddef.h>
 #include <stdint.h>
@@ -90,6 +92,13 @@ static int16_t fqmul(int16_t a, int16_t b) {
 * Arguments:   - int16_t poly[256]: pointer to input/output vector of elements of Zq
 **************************************************/
 void PQCLEAN_KYBER512_CLEAN_ntt(int16_t poly[256]) {
+#if defined(S2N_KYBER512R2_AVX2)
+    if (s2n_kyber512r2_avx2_is_enabled()) {
+        PQCLEAN_KYBER512_AVX2_ntt(poly);
+        return;
+    }
+#endif
+
     size_t j, k = 1;
     int16_t t, zeta;
 
@@ -114,6 +123,13 @@ void PQCLEAN_KYBER512_CLEAN_ntt(int16_t poly[256]) {
 * Arguments:   - int16_t poly[256]: pointer to input/output vector of elements of Zq
 **************************************************/
 void PQCLEAN_KYBER512_CLEAN_invntt(int16_t poly[256]) {
+#if defined(S2N_KYBER512R2_AVX2)
+    if (s2n_kyber512r2_avx2_is_enabled()) {
+        PQCLEAN_KYBER512_AVX2_invntt(poly);
+        return;
+    }
+#endif
+
     size_t j, k = 0;
     int16_t t, zeta;
 
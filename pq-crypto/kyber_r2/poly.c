@@ -1,9 +1,11 @@
 #include "cbd.h"
+#include "kyber512r2_avx2.h"
 #include "ntt.h"
 #include "params.h"
 #include "poly.h"
 #include "reduce.h"
 #include "symmetric.h"
+#include "../s2n_pq.h"
 
 #include <stdint.h>
 /*************************************************
@@ -146,6 +148,13 @@ void PQCLEAN_KYBER512_CLEAN_poly_invntt(poly *r) {
 *              - const poly *b: pointer to second input polynomial
 **************************************************/
 void PQCLEAN_KYBER512_CLEAN_poly_basemul(poly *r, const poly *a, const poly *b) {
+#if defined(S2N_KYBER512R2_AVX2)
+    if (s2n_kyber512r2_avx2_is_enabled()) {
+        PQCLEAN_KYBER512_AVX2_poly_basemul(r->coeffs, a->coeffs, b->coeffs);
+        return;
+    }
+#endif
+
     for (size_t i = 0; i < KYBER_N / 4; ++i) {
         PQCLEAN_KYBER512_CLEAN_basemul(
             r->coeffs + 4 * i,
@@ -16,11 +16,14 @@
 #include "s2n_pq.h"
 
 static bool sikep434r2_asm_enabled = false;
+static bool kyber512r2_avx2_enabled = false;
+static bool bike1l1r2_x86_64_opt_enabled = false;
 
 #if defined(S2N_CPUID_AVAILABLE)
 /* https://en.wikipedia.org/wiki/CPUID */
 #include <cpuid.h>
 
+#define PROCESSOR_INFO_AND_FEATURES    1
 #define EXTENDED_FEATURES_LEAF         7
 #define EXTENDED_FEATURES_SUBLEAF_ZERO 0
 
@@ -35,6 +38,25 @@ static bool sikep434r2_asm_enabled = false;
     #define bit_BMI2 (1 << 8)
 #endif
 
+#if !defined(bit_AVX2)
+    #define bit_AVX2 (1 << 5)
+#endif
+
+#if !defined(bit_OSXSAVE)
+    #define bit_OSXSAVE (1 << 27)
+#endif
+
+#if !defined(bit_AVX)
+    #define bit_AVX (1 << 28)
+#endif
+
+#if !defined(bit_PCLMUL)
+    #define bit_PCLMUL (1 << 1)
+#endif
+
+/* XCR0 bits for the XMM and YMM register state */
+#define XCR0_SSE_AND_AVX_STATE 0x6
+
 bool s2n_get_cpuid_count(uint32_t leaf, uint32_t sub_leaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
     /* 0x80000000 probes for extended cpuid info */
     uint32_t max_level = __get_cpuid_max(leaf & 0x80000000, 0);
@@ -67,6 +89,41 @@ bool s2n_cpu_supports_adx() {
     return (ebx & bit_ADX);
 }
 
+/* https://en.wikipedia.org/wiki/Advanced_Vector_Extensions#Advanced_Vector_Extensions_2
+ * Besides the CPU, the OS has to save and restore the YMM registers, which it
+ * advertises through OSXSAVE and XCR0. */
+bool s2n_cpu_supports_avx2() {
+    uint32_t eax, ebx, ecx, edx;
+    if (!s2n_get_cpuid_count(PROCESSOR_INFO_AND_FEATURES, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return false;
+    }
+
+    uint32_t xcr0, xcr0_high;
+    __asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(xcr0_high) : "c"(0));
+    if ((xcr0 & XCR0_SSE_AND_AVX_STATE) != XCR0_SSE_AND_AVX_STATE) {
+        return false;
+    }
+
+    if (!s2n_get_cpuid_count(EXTENDED_FEATURES_LEAF, EXTENDED_FEATURES_SUBLEAF_ZERO, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+
+    return (ebx & bit_AVX2);
+}
+
+/* https://en.wikipedia.org/wiki/CLMUL_instruction_set */
+bool s2n_cpu_supports_pclmul() {
+    uint32_t eax, ebx, ecx, edx;
+    if (!s2n_get_cpuid_count(PROCESSOR_INFO_AND_FEATURES, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+
+    return (ecx & bit_PCLMUL);
+}
+
 bool s2n_cpu_supports_sikep434r2_asm() {
 #if defined(S2N_SIKEP434R2_ASM)
     /* The sikep434r2 assembly code always requires BMI2. If the assembly
@@ -82,6 +139,25 @@ bool s2n_cpu_supports_sikep434r2_asm() {
 #endif /* defined(S2N_SIKEP434R2_ASM) */
 }
 
+bool s2n_cpu_supports_kyber512r2_avx2() {
+#if defined(S2N_KYBER512R2_AVX2)
+    return s2n_cpu_supports_avx2();
+#else
+    /* kyber512r2 AVX2 code was not supported at compile time */
+    return false;
+#endif /* defined(S2N_KYBER512R2_AVX2) */
+}
+
+bool s2n_cpu_supports_bike1l1r2_x86_64_opt() {
+#if defined(S2N_BIKE1L1R2_X86_64_OPT)
+    /* The multiplication needs PCLMULQDQ and the decoder needs AVX2 */
+    return s2n_cpu_supports_pclmul() && s2n_cpu_supports_avx2();
+#else
+    /* bike1l1r2 x86_64 optimizations were not supported at compile time */
+    return false;
+#endif /* defined(S2N_BIKE1L1R2_X86_64_OPT) */
+}
+
 #else /* defined(S2N_CPUID_AVAILABLE) */
 
 /* If CPUID is not available, we cannot perform necessary run-time checks. */
@@ -89,12 +165,28 @@ bool s2n_cpu_supports_sikep434r2_asm() {
     return false;
 }
 
+bool s2n_cpu_supports_kyber512r2_avx2() {
+    return false;
+}
+
+bool s2n_cpu_supports_bike1l1r2_x86_64_opt() {
+    return false;
+}
+
 #endif /* defined(S2N_CPUID_AVAILABLE) */
 
 bool s2n_sikep434r2_asm_is_enabled() {
     return sikep434r2_asm_enabled;
 }
 
+bool s2n_kyber512r2_avx2_is_enabled() {
+    return kyber512r2_avx2_enabled;
+}
+
+bool s2n_bike1l1r2_x86_64_opt_is_enabled() {
+    return bike1l1r2_x86_64_opt_enabled;
+}
+
 bool s2n_pq_is_enabled() {
 #if defined(S2N_NO_PQ)
     return false;
@@ -115,8 +207,34 @@ S2N_RESULT s2n_try_enable_sikep434r2_asm() {
     return S2N_RESULT_OK;
 }
 
+S2N_RESULT s2n_disable_kyber512r2_avx2() {
+    kyber512r2_avx2_enabled = false;
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_try_enable_kyber512r2_avx2() {
+    if (s2n_pq_is_enabled() && s2n_cpu_supports_kyber512r2_avx2()) {
+        kyber512r2_avx2_enabled = true;
+    }
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_disable_bike1l1r2_x86_64_opt() {
+    bike1l1r2_x86_64_opt_enabled = false;
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_try_enable_bike1l1r2_x86_64_opt() {
+    if (s2n_pq_is_enabled() && s2n_cpu_supports_bike1l1r2_x86_64_opt()) {
+        bike1l1r2_x86_64_opt_enabled = true;
+    }
+    return S2N_RESULT_OK;
+}
+
 S2N_RESULT s2n_pq_init() {
     RESULT_ENSURE_OK(s2n_try_enable_sikep434r2_asm(), S2N_ERR_SAFETY);
+    RESULT_ENSURE_OK(s2n_try_enable_kyber512r2_avx2(), S2N_ERR_SAFETY);
+    RESULT_ENSURE_OK(s2n_try_enable_bike1l1r2_x86_64_opt(), S2N_ERR_SAFETY);
 
     return S2N_RESULT_OK;
 }
@@ -24,4 +24,10 @@ bool s2n_sikep434r2_asm_is_enabled(void);
 bool s2n_pq_is_enabled(void);
 S2N_RESULT s2n_disable_sikep434r2_asm(void);
 S2N_RESULT s2n_try_enable_sikep434r2_asm(void);
+bool s2n_kyber512r2_avx2_is_enabled(void);
+S2N_RESULT s2n_disable_kyber512r2_avx2(void);
+S2N_RESULT s2n_try_enable_kyber512r2_avx2(void);
+bool s2n_bike1l1r2_x86_64_opt_is_enabled(void);
+S2N_RESULT s2n_disable_bike1l1r2_x86_64_opt(void);
+S2N_RESULT s2n_try_enable_bike1l1r2_x86_64_opt(void);
 S2N_RESULT s2n_pq_init(void);
@@ -15,6 +15,8 @@
 
 # To ensure CPU compatibility, try to compile all ASM code before including it in the build.
 TRY_COMPILE_SIKEP434R2_ASM = -1
+TRY_COMPILE_KYBER512R2_AVX2 = -1
+TRY_COMPILE_BIKE1L1R2_X86_64_OPT = -1
 
 ifndef S2N_NO_PQ_ASM
 	# sikep434r2
@@ -34,4 +36,29 @@ ifndef S2N_NO_PQ_ASM
 
 		SIKEP434R2_ASM_OBJ=$(SIKEP434R2_ASM_SRC:.S=.o)
 	endif
+
+	# kyber512r2 AVX2 code is written with intrinsics; only that one file is built with -mavx2.
+	KYBER512R2_AVX2_SRC := $(shell find . -name "kyber512r2_avx2.c")
+	KYBER512R2_AVX2_TEST_OUT := "test_kyber512r2_avx2.o"
+	TRY_COMPILE_KYBER512R2_AVX2 := $(shell $(CC) -mavx2 -c -o $(KYBER512R2_AVX2_TEST_OUT) $(KYBER512R2_AVX2_SRC) > /dev/null 2>&1; echo $$?; rm $(KYBER512R2_AVX2_TEST_OUT) > /dev/null 2>&1)
+	ifeq ($(TRY_COMPILE_KYBER512R2_AVX2), 0)
+		CFLAGS += -DS2N_KYBER512R2_AVX2
+		CFLAGS_LLVM += -DS2N_KYBER512R2_AVX2
+
+		KYBER512R2_AVX2_OBJ=$(KYBER512R2_AVX2_SRC:.c=.o)
+	endif
+
+	# bike1l1r2 multiplies with PCLMULQDQ and decodes with AVX2; each file gets only its own flag.
+	BIKE1L1R2_PCLMUL_SRC := $(shell find . -name "gf2x_mul_base_pclmul.c")
+	BIKE1L1R2_AVX2_SRC := $(shell find . -name "secure_decode_avx2.c")
+	BIKE1L1R2_X86_64_OPT_TEST_OUT := "test_bike1l1r2_x86_64_opt.o"
+	BIKE1L1R2_X86_64_OPT_TEST_FLAGS := -I$(S2N_ROOT) -I$(S2N_ROOT)/api -I$(LIBCRYPTO_ROOT)/include -c -o $(BIKE1L1R2_X86_64_OPT_TEST_OUT)
+	TRY_COMPILE_BIKE1L1R2_X86_64_OPT := $(shell { $(CC) -mpclmul $(BIKE1L1R2_X86_64_OPT_TEST_FLAGS) $(BIKE1L1R2_PCLMUL_SRC) && $(CC) -mavx2 $(BIKE1L1R2_X86_64_OPT_TEST_FLAGS) $(BIKE1L1R2_AVX2_SRC); } > /dev/null 2>&1; echo $$?; rm $(BIKE1L1R2_X86_64_OPT_TEST_OUT) > /dev/null 2>&1)
+	ifeq ($(TRY_COMPILE_BIKE1L1R2_X86_64_OPT), 0)
+		CFLAGS += -DS2N_BIKE1L1R2_X86_64_OPT
+		CFLAGS_LLVM += -DS2N_BIKE1L1R2_X86_64_OPT
+
+		BIKE1L1R2_PCLMUL_OBJ=$(BIKE1L1R2_PCLMUL_SRC:.c=.o)
+		BIKE1L1R2_AVX2_OBJ=$(BIKE1L1R2_AVX2_SRC:.c=.o)
+	endif
 endif
@@ -88,6 +88,11 @@ ifdef S2N_NO_PQ
 	DEFAULT_CFLAGS += -DS2N_NO_PQ
 endif
 
+# Build Kyber-90s with its bundled AES and SHA-2 instead of the libcrypto ones
+ifdef S2N_KYBER90S_R2_PORTABLE_SYMMETRIC
+	DEFAULT_CFLAGS += -DS2N_KYBER90S_R2_PORTABLE_SYMMETRIC
+endif
+
 CFLAGS += ${DEFAULT_CFLAGS}
 
 ifdef GCC_VERSION
@@ -172,6 +177,12 @@ ifeq ($(TRY_COMPILE_CPUID), 0)
 	DEFAULT_CFLAGS += -DS2N_CPUID_AVAILABLE
 endif
 
+# Determine if the kernel TLS (kTLS) headers are available
+TRY_COMPILE_KTLS := $(call try_compile,$(S2N_ROOT)/tests/features/ktls.c)
+ifeq ($(TRY_COMPILE_KTLS), 0)
+	DEFAULT_CFLAGS += -DS2N_KTLS_SUPPORTED
+endif
+
 # Determine if __attribute__((fallthrough)) is available
 TRY_COMPILE_FALL_THROUGH := $(call try_compile,$(S2N_ROOT)/tests/features/fallthrough.c)
 ifeq ($(TRY_COMPILE_FALL_THROUGH), 0)
@@ -0,0 +1,316 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+#include <s2n.h>
+
+extern "C" {
+#include "utils/s2n_safety.h"
+#include "testlib/s2n_testlib.h"
+}
+
+/* Stands in for a signing service on the other end of a UNIX socket.
+ * Every request is a count of digests, each preceded by its signature and hash algorithms,
+ * and is answered with as many signatures. */
+struct stand_in_signer {
+    EVP_PKEY *key;
+    int fds[2];
+    pthread_t thread;
+};
+
+static bool read_full(int fd, void *data, size_t len)
+{
+    uint8_t *ptr = (uint8_t *) data;
+    while (len > 0) {
+        ssize_t r = read(fd, ptr, len);
+        if (r <= 0) {
+            return false;
+        }
+        ptr += r;
+        len -= r;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const void *data, size_t len)
+{
+    const uint8_t *ptr = (const uint8_t *) data;
+    while (len > 0) {
+        ssize_t w = write(fd, ptr, len);
+        if (w <= 0) {
+            return false;
+        }
+        ptr += w;
+        len -= w;
+    }
+    return true;
+}
+
+static void *stand_in_signer_run(void *arg)
+{
+    struct stand_in_signer *signer = (struct stand_in_signer *) arg;
+    int fd = signer->fds[1];
+
+    uint32_t count = 0;
+    while (read_full(fd, &count, sizeof(count))) {
+        std::vector<uint8_t> response;
+        for (uint32_t i = 0; i < count; i++) {
+            s2n_tls_signature_algorithm sig_alg;
+            s2n_tls_hash_algorithm hash_alg;
+            uint32_t digest_len = 0;
+            uint8_t digest[EVP_MAX_MD_SIZE];
+            if (!read_full(fd, &sig_alg, sizeof(sig_alg)) || !read_full(fd, &hash_alg, sizeof(hash_alg))
+                    || !read_full(fd, &digest_len, sizeof(digest_len)) || digest_len > sizeof(digest)
+                    || !read_full(fd, digest, digest_len)) {
+                return NULL;
+            }
+
+            uint8_t signature[S2N_TEST_MAX_SIGNATURE_LEN];
+            uint32_t signature_len = sizeof(signature);
+            if (s2n_test_evp_sign(signer->key, sig_alg, hash_alg, digest, digest_len, signature, &signature_len) != 0) {
+                return NULL;
+            }
+
+            uint32_t len = signature_len;
+            response.insert(response.end(), (uint8_t *) &len, (uint8_t *) &len + sizeof(len));
+            response.insert(response.end(), signature, signature + signature_len);
+        }
+        if (!write_full(fd, response.data(), response.size())) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+/* One round-trip to the signer for all of ops */
+static int stand_in_signer_sign(struct stand_in_signer *signer, struct s2n_async_pkey_op **ops, uint32_t ops_count)
+{
+    std::vector<uint8_t> request((uint8_t *) &ops_count, (uint8_t *) &ops_count + sizeof(ops_count));
+    for (uint32_t i = 0; i < ops_count; i++) {
+        s2n_tls_signature_algorithm sig_alg;
+        s2n_tls_hash_algorithm hash_alg;
+        uint32_t digest_len = 0;
+        uint8_t digest[EVP_MAX_MD_SIZE];
+        POSIX_GUARD(s2n_async_pkey_op_get_signature_algorithm(ops[i], &sig_alg));
+        POSIX_GUARD(s2n_async_pkey_op_get_hash_algorithm(ops[i], &hash_alg));
+        POSIX_GUARD(s2n_async_pkey_op_get_input_size(ops[i], &digest_len));
+        POSIX_GUARD(s2n_async_pkey_op_get_input(ops[i], digest, sizeof(digest)));
+        request.insert(request.end(), (uint8_t *) &sig_alg, (uint8_t *) &sig_alg + sizeof(sig_alg));
+        request.insert(request.end(), (uint8_t *) &hash_alg, (uint8_t *) &hash_alg + sizeof(hash_alg));
+        request.insert(request.end(), (uint8_t *) &digest_len, (uint8_t *) &digest_len + sizeof(digest_len));
+        request.insert(request.end(), digest, digest + digest_len);
+    }
+    POSIX_ENSURE(write_full(signer->fds[0], request.data(), request.size()), S2N_ERR_IO);
+
+    for (uint32_t i = 0; i < ops_count; i++) {
+        uint32_t signature_len = 0;
+        uint8_t signature[S2N_TEST_MAX_SIGNATURE_LEN];
+        POSIX_ENSURE(read_full(signer->fds[0], &signature_len, sizeof(signature_len)), S2N_ERR_IO);
+        POSIX_ENSURE(signature_len <= sizeof(signature), S2N_ERR_SAFETY);
+        POSIX_ENSURE(read_full(signer->fds[0], signature, signature_len), S2N_ERR_IO);
+        POSIX_GUARD(s2n_async_pkey_op_set_output(ops[i], signature, signature_len));
+    }
+    return S2N_SUCCESS;
+}
+
+static int perform_batched(struct s2n_async_pkey_op **ops, uint32_t ops_count, void *ctx)
+{
+    return stand_in_signer_sign((struct stand_in_signer *) ctx, ops, ops_count);
+}
+
+static int perform_one_by_one(struct s2n_async_pkey_op **ops, uint32_t ops_count, void *ctx)
+{
+    for (uint32_t i = 0; i < ops_count; i++) {
+        POSIX_GUARD(stand_in_signer_sign((struct stand_in_signer *) ctx, &ops[i], 1));
+    }
+    return S2N_SUCCESS;
+}
+
+static int ready(struct s2n_connection **conns, uint32_t conns_count, void *ctx)
+{
+    return S2N_SUCCESS;
+}
+
+static int failed(struct s2n_connection **conns, uint32_t conns_count, void *ctx)
+{
+    /* Every handshake in the benchmark is expected to resume */
+    fprintf(stderr, "%u handshakes could not resume\n", conns_count);
+    return S2N_FAILURE;
+}
+
+static struct s2n_async_pkey_batch *pending_ops = NULL;
+
+static int collect_op(struct s2n_connection *conn, struct s2n_async_pkey_op *op)
+{
+    return s2n_async_pkey_batch_add(pending_ops, op);
+}
+
+/* Many servers, each waiting on the signature for its ServerKeyExchange */
+class TestFixture : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state) {
+        int rc = s2n_test_cert_chain_and_key_new(&chain_and_key,
+                S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY);
+        assert(rc == 0);
+
+        FILE *key_file = fopen(S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY, "r");
+        assert(key_file != NULL);
+        signer.key = PEM_read_PrivateKey(key_file, NULL, NULL, NULL);
+        fclose(key_file);
+        assert(signer.key != NULL);
+
+        rc = socketpair(AF_UNIX, SOCK_STREAM, 0, signer.fds);
+        assert(rc == 0);
+        rc = pthread_create(&signer.thread, NULL, stand_in_signer_run, &signer);
+        assert(rc == 0);
+
+        pending_ops = s2n_async_pkey_batch_new();
+        assert(pending_ops != NULL);
+
+        server_config = s2n_config_new();
+        assert(server_config != NULL);
+        rc = s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key);
+        assert(rc == 0);
+        rc = s2n_config_set_cipher_preferences(server_config, "20190801");
+        assert(rc == 0);
+        rc = s2n_config_set_async_pkey_callback(server_config, collect_op);
+        assert(rc == 0);
+
+        client_config = s2n_config_new();
+        assert(client_config != NULL);
+        rc = s2n_config_set_cipher_preferences(client_config, "20190801");
+        assert(rc == 0);
+        rc = s2n_config_disable_x509_verification(client_config);
+        assert(rc == 0);
+    }
+
+    void TearDown(const ::benchmark::State& state) {
+        int rc = s2n_async_pkey_batch_free(pending_ops);
+        assert(rc == 0);
+        pending_ops = NULL;
+
+        close(signer.fds[0]);
+        pthread_join(signer.thread, NULL);
+        close(signer.fds[1]);
+        EVP_PKEY_free(signer.key);
+
+        s2n_config_free(server_config);
+        s2n_config_free(client_config);
+        s2n_cert_chain_and_key_free(chain_and_key);
+    }
+
+    void StartHandshakes(int64_t count) {
+        servers.resize(count);
+        clients.resize(count);
+        io_pairs.resize(count);
+        for (int64_t i = 0; i < count; i++) {
+            servers[i] = s2n_connection_new(S2N_SERVER);
+            clients[i] = s2n_connection_new(S2N_CLIENT);
+            assert(servers[i] != NULL && clients[i] != NULL);
+            s2n_connection_set_config(servers[i], server_config);
+            s2n_connection_set_config(clients[i], client_config);
+            s2n_io_pair_init_non_blocking(&io_pairs[i]);
+            s2n_connections_set_io_pair(clients[i], servers[i], &io_pairs[i]);
+
+            /* ClientHello, then the server blocks on its signature */
+            s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+            s2n_negotiate(clients[i], &blocked);
+            s2n_negotiate(servers[i], &blocked);
+        }
+
+        uint32_t pending = 0;
+        s2n_async_pkey_batch_get_count(pending_ops, &pending);
+        assert(pending == count);
+    }
+
+    void FreeHandshakes() {
+        for (size_t i = 0; i < servers.size(); i++) {
+            s2n_connection_free(servers[i]);
+            s2n_connection_free(clients[i]);
+            s2n_io_pair_close(&io_pairs[i]);
+        }
+        servers.clear();
+        clients.clear();
+        io_pairs.clear();
+    }
+
+    struct stand_in_signer signer;
+    struct s2n_cert_chain_and_key *chain_and_key;
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+    std::vector<struct s2n_connection *> servers;
+    std::vector<struct s2n_connection *> clients;
+    std::vector<struct s2n_test_io_pair> io_pairs;
+};
+
+BENCHMARK_DEFINE_F(TestFixture, SignOneByOne)(benchmark::State& state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        StartHandshakes(state.range(0));
+        state.ResumeTiming();
+
+        int rc = s2n_async_pkey_batch_flush(pending_ops, perform_one_by_one, ready, failed, &signer);
+        benchmark::DoNotOptimize(rc);
+
+        state.PauseTiming();
+        FreeHandshakes();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(TestFixture, SignBatched)(benchmark::State& state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        StartHandshakes(state.range(0));
+        state.ResumeTiming();
+
+        int rc = s2n_async_pkey_batch_flush(pending_ops, perform_batched, ready, failed, &signer);
+        benchmark::DoNotOptimize(rc);
+
+        state.PauseTiming();
+        FreeHandshakes();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_REGISTER_F(TestFixture, SignOneByOne)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+BENCHMARK_REGISTER_F(TestFixture, SignBatched)->RangeMultiplier(2)->Range(1, 64)->UseRealTime();
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+
+    int rc = s2n_init();
+    assert(rc == 0);
+
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    ::benchmark::RunSpecifiedBenchmarks();
+
+    rc = s2n_cleanup();
+    assert(rc == 0);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <s2n.h>
+
+extern "C" {
+#include "testlib/s2n_testlib.h"
+}
+
+/* Allocation heavy paths. Small allocations come from the mlock'd slab by default;
+ * run with S2N_MLOCK_PER_PAGE=1 to compare against locking a page per allocation,
+ * or with S2N_DONT_MLOCK=1 to compare against plain malloc. */
+class TestFixture : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state) {
+        int rc = s2n_test_cert_chain_and_key_new(&chain_and_key,
+                S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY);
+        assert(rc == 0);
+
+        server_config = s2n_config_new();
+        assert(server_config != NULL);
+        rc = s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key);
+        assert(rc == 0);
+        rc = s2n_config_set_cipher_preferences(server_config, "20190801");
+        assert(rc == 0);
+
+        client_config = s2n_config_new();
+        assert(client_config != NULL);
+        rc = s2n_config_set_cipher_preferences(client_config, "20190801");
+        assert(rc == 0);
+        rc = s2n_config_disable_x509_verification(client_config);
+        assert(rc == 0);
+    }
+
+    void TearDown(const ::benchmark::State& state) {
+        s2n_config_free(server_config);
+        s2n_config_free(client_config);
+        s2n_cert_chain_and_key_free(chain_and_key);
+    }
+
+    struct s2n_cert_chain_and_key *chain_and_key;
+    struct s2n_config *server_config;
+    struct s2n_config *client_config;
+};
+
+BENCHMARK_DEFINE_F(TestFixture, ConnectionNewFree)(benchmark::State& state) {
+    for (auto _ : state) {
+        struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+        assert(conn != NULL);
+        int rc = s2n_connection_set_config(conn, server_config);
+        benchmark::DoNotOptimize(rc);
+        s2n_connection_free(conn);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DEFINE_F(TestFixture, Handshake)(benchmark::State& state) {
+    for (auto _ : state) {
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        assert(server_conn != NULL && client_conn != NULL);
+        s2n_connection_set_config(server_conn, server_config);
+        s2n_connection_set_config(client_conn, client_config);
+
+        struct s2n_test_io_pair io_pair;
+        s2n_io_pair_init_non_blocking(&io_pair);
+        s2n_connections_set_io_pair(client_conn, server_conn, &io_pair);
+
+        int rc = s2n_negotiate_test_server_and_client(server_conn, client_conn);
+        assert(rc == 0);
+        benchmark::DoNotOptimize(rc);
+
+        s2n_connection_free(server_conn);
+        s2n_connection_free(client_conn);
+        s2n_io_pair_close(&io_pair);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(TestFixture, ConnectionNewFree);
+BENCHMARK_REGISTER_F(TestFixture, Handshake)->UseRealTime();
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+
+    int rc = s2n_init();
+    assert(rc == 0);
+
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    ::benchmark::RunSpecifiedBenchmarks();
+
+    rc = s2n_cleanup();
+    assert(rc == 0);
+}
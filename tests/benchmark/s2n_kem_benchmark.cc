@@ -0,0 +1,106 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include <s2n.h>
+
+extern "C" {
+#include "pq-crypto/s2n_pq.h"
+#include "tls/s2n_kem.h"
+}
+
+/* Kyber-90s draws its AES and SHA-2 from libcrypto unless s2n is built with
+ * S2N_KYBER90S_R2_PORTABLE_SYMMETRIC; compare one build of each to see the difference. */
+/* BIKE1-L1-R2 uses the PCLMUL/AVX2 code whenever the build and the CPU support it. */
+static const struct s2n_kem *kems[] = {
+    &s2n_bike1_l1_r2,
+    &s2n_kyber_512_r2,
+    &s2n_kyber_512_90s_r2,
+};
+
+class KemFixture : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state) {
+        kem = kems[state.range(0)];
+        public_key.resize(kem->public_key_length);
+        private_key.resize(kem->private_key_length);
+        ciphertext.resize(kem->ciphertext_length);
+        shared_secret.resize(kem->shared_secret_key_length);
+
+        int rc = kem->generate_keypair(public_key.data(), private_key.data());
+        assert(rc == 0);
+        rc = kem->encapsulate(ciphertext.data(), shared_secret.data(), public_key.data());
+        assert(rc == 0);
+    }
+
+    const struct s2n_kem *kem;
+    std::vector<uint8_t> public_key;
+    std::vector<uint8_t> private_key;
+    std::vector<uint8_t> ciphertext;
+    std::vector<uint8_t> shared_secret;
+};
+
+BENCHMARK_DEFINE_F(KemFixture, Keygen)(benchmark::State& state) {
+    state.SetLabel(kem->name);
+    for (auto _ : state) {
+        int rc = kem->generate_keypair(public_key.data(), private_key.data());
+        benchmark::DoNotOptimize(rc);
+    }
+}
+
+BENCHMARK_DEFINE_F(KemFixture, Encaps)(benchmark::State& state) {
+    state.SetLabel(kem->name);
+    for (auto _ : state) {
+        int rc = kem->encapsulate(ciphertext.data(), shared_secret.data(), public_key.data());
+        benchmark::DoNotOptimize(rc);
+    }
+}
+
+BENCHMARK_DEFINE_F(KemFixture, Decaps)(benchmark::State& state) {
+    state.SetLabel(kem->name);
+    for (auto _ : state) {
+        int rc = kem->decapsulate(shared_secret.data(), ciphertext.data(), private_key.data());
+        benchmark::DoNotOptimize(rc);
+    }
+}
+
+BENCHMARK_REGISTER_F(KemFixture, Keygen)->DenseRange(0, sizeof(kems) / sizeof(kems[0]) - 1);
+BENCHMARK_REGISTER_F(KemFixture, Encaps)->DenseRange(0, sizeof(kems) / sizeof(kems[0]) - 1);
+BENCHMARK_REGISTER_F(KemFixture, Decaps)->DenseRange(0, sizeof(kems) / sizeof(kems[0]) - 1);
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+
+    int rc = s2n_init();
+    assert(rc == 0);
+
+    if (!s2n_pq_is_enabled()) {
+        fprintf(stderr, "PQ crypto is disabled in this build; skipping the KEM benchmarks\n");
+        return 0;
+    }
+
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    ::benchmark::RunSpecifiedBenchmarks();
+
+    rc = s2n_cleanup();
+    assert(rc == 0);
+}
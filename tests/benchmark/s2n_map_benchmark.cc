@@ -0,0 +1,116 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <s2n.h>
+
+extern "C" {
+#include "utils/s2n_map.h"
+}
+
+
+/* Simulates cert selection against a config with many SNI names */
+class TestFixture : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state) {
+        s2n_result result;
+        uint64_t value = 0;
+
+        map = s2n_map_new();
+        assert(map != NULL);
+
+        names.clear();
+        for (int64_t i = 0; i < state.range(0); i++) {
+            char name[64];
+            snprintf(name, sizeof(name), "host-%ld.service.example.com", (long) i);
+            names.push_back(name);
+
+            struct s2n_blob key = { 0 };
+            struct s2n_blob val = { 0 };
+            key.data = (uint8_t *) names.back().data();
+            key.size = names.back().size();
+            val.data = (uint8_t *) &value;
+            val.size = sizeof(value);
+            result = s2n_map_add(map, &key, &val);
+            assert(s2n_result_is_ok(result));
+        }
+
+        result = s2n_map_complete(map);
+        assert(s2n_result_is_ok(result));
+    }
+
+    void TearDown(const ::benchmark::State& state) {
+        s2n_result result = s2n_map_free(map);
+        assert(s2n_result_is_ok(result));
+        map = NULL;
+    }
+
+    struct s2n_map *map;
+    std::vector<std::string> names;
+};
+
+BENCHMARK_DEFINE_F(TestFixture, MapLookupHit)(benchmark::State& state) {
+    size_t i = 0;
+    for (auto _ : state) {
+        struct s2n_blob key = { 0 };
+        struct s2n_blob val = { 0 };
+        bool key_found = false;
+        key.data = (uint8_t *) names[i].data();
+        key.size = names[i].size();
+        s2n_result result = s2n_map_lookup(map, &key, &val, &key_found);
+        benchmark::DoNotOptimize(result);
+        benchmark::DoNotOptimize(key_found);
+        i = (i + 1) % names.size();
+    }
+}
+
+BENCHMARK_DEFINE_F(TestFixture, MapLookupMiss)(benchmark::State& state) {
+    /* Wildcard lookups for names that are not in the map */
+    uint8_t miss[] = "*.service.example.com";
+    for (auto _ : state) {
+        struct s2n_blob key = { 0 };
+        struct s2n_blob val = { 0 };
+        bool key_found = false;
+        key.data = miss;
+        key.size = sizeof(miss) - 1;
+        s2n_result result = s2n_map_lookup(map, &key, &val, &key_found);
+        benchmark::DoNotOptimize(result);
+        benchmark::DoNotOptimize(key_found);
+    }
+}
+
+BENCHMARK_REGISTER_F(TestFixture, MapLookupHit)->RangeMultiplier(8)->Range(8, 64 * 1024);
+BENCHMARK_REGISTER_F(TestFixture, MapLookupMiss)->RangeMultiplier(8)->Range(8, 64 * 1024);
+
+int main(int argc, char** argv) {
+    ::benchmark::Initialize(&argc, argv);
+
+    int rc = s2n_init();
+    assert(rc == 0);
+
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    ::benchmark::RunSpecifiedBenchmarks();
+
+    rc = s2n_cleanup();
+    assert(rc == 0);
+}
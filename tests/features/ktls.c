@@ -0,0 +1,28 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+int main() {
+    struct tls12_crypto_info_aes_gcm_128 aes_gcm_128 = { 0 };
+    struct tls12_crypto_info_aes_gcm_256 aes_gcm_256 = { 0 };
+    struct tls12_crypto_info_chacha20_poly1305 chacha20_poly1305 = { 0 };
+    aes_gcm_128.info.version = TLS_1_3_VERSION;
+    aes_gcm_256.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+    chacha20_poly1305.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+    return TLS_TX + TLS_RX + TLS_SET_RECORD_TYPE + TLS_GET_RECORD_TYPE;
+}
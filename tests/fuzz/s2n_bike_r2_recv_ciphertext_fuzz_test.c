@@ -19,6 +19,7 @@
 #include "tests/testlib/s2n_testlib.h"
 #include "tls/s2n_kem.h"
 #include "utils/s2n_safety.h"
+#include "pq-crypto/s2n_pq.h"
 
 #define KAT_FILE_NAME "../unit/kats/bike_r2.kat"
 
@@ -36,7 +37,15 @@ int s2n_fuzz_init(int *argc, char **argv[])
 
 int s2n_fuzz_test(const uint8_t *buf, size_t len)
 {
+    /* Test the portable C code */
+    POSIX_GUARD_RESULT(s2n_disable_bike1l1r2_x86_64_opt());
     POSIX_GUARD(s2n_kem_recv_ciphertext_fuzz_test(buf, len, &kem_params));
+
+    /* Test the PCLMUL/AVX2 code, if available; if not, don't bother testing the C again */
+    POSIX_GUARD_RESULT(s2n_try_enable_bike1l1r2_x86_64_opt());
+    if (s2n_bike1l1r2_x86_64_opt_is_enabled()) {
+        POSIX_GUARD(s2n_kem_recv_ciphertext_fuzz_test(buf, len, &kem_params));
+    }
     return S2N_SUCCESS;
 }
 
@@ -19,6 +19,7 @@
 #include "tests/testlib/s2n_testlib.h"
 #include "tls/s2n_kem.h"
 #include "utils/s2n_safety.h"
+#include "pq-crypto/s2n_pq.h"
 
 /* The valid_public_key in the corpus directory was generated by taking the first public
  * key (count = 0) from bike_r2.kat and prepending BIKE1_L1_R2_PUBLIC_KEY_BYTES as two
@@ -26,7 +27,15 @@
 static struct s2n_kem_params kem_params = { .kem = &s2n_bike1_l1_r2 };
 
 int s2n_fuzz_test(const uint8_t *buf, size_t len) {
+    /* Test the portable C code */
+    POSIX_GUARD_RESULT(s2n_disable_bike1l1r2_x86_64_opt());
     POSIX_GUARD(s2n_kem_recv_public_key_fuzz_test(buf, len, &kem_params));
+
+    /* Test the PCLMUL/AVX2 code, if available; if not, don't bother testing the C again */
+    POSIX_GUARD_RESULT(s2n_try_enable_bike1l1r2_x86_64_opt());
+    if (s2n_bike1l1r2_x86_64_opt_is_enabled()) {
+        POSIX_GUARD(s2n_kem_recv_public_key_fuzz_test(buf, len, &kem_params));
+    }
     return S2N_SUCCESS;
 }
 
@@ -0,0 +1,116 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+
+#include "testlib/s2n_testlib.h"
+
+#include "error/s2n_errno.h"
+#include "utils/s2n_safety.h"
+
+static const EVP_MD *s2n_test_hash_algorithm_to_md(s2n_tls_hash_algorithm hash_alg)
+{
+    switch (hash_alg) {
+        case S2N_TLS_HASH_MD5:
+            return EVP_md5();
+        case S2N_TLS_HASH_SHA1:
+            return EVP_sha1();
+        case S2N_TLS_HASH_SHA224:
+            return EVP_sha224();
+        case S2N_TLS_HASH_SHA256:
+            return EVP_sha256();
+        case S2N_TLS_HASH_SHA384:
+            return EVP_sha384();
+        case S2N_TLS_HASH_SHA512:
+            return EVP_sha512();
+        case S2N_TLS_HASH_MD5_SHA1:
+            return EVP_md5_sha1();
+        case S2N_TLS_HASH_NONE:
+            break;
+    }
+    return NULL;
+}
+
+static int s2n_test_evp_sign_with_ctx(EVP_PKEY_CTX *ctx, s2n_tls_signature_algorithm sig_alg, const EVP_MD *md,
+        const uint8_t *digest, uint32_t digest_len, uint8_t *signature, uint32_t *signature_len)
+{
+    POSIX_GUARD_OSSL(EVP_PKEY_sign_init(ctx), S2N_ERR_SIGN);
+
+    switch (sig_alg) {
+        case S2N_TLS_SIGNATURE_RSA:
+            POSIX_GUARD_OSSL(EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING), S2N_ERR_SIGN);
+            POSIX_GUARD_OSSL(EVP_PKEY_CTX_set_signature_md(ctx, md), S2N_ERR_SIGN);
+            break;
+        case S2N_TLS_SIGNATURE_RSA_PSS_RSAE:
+        case S2N_TLS_SIGNATURE_RSA_PSS_PSS:
+            POSIX_GUARD_OSSL(EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PSS_PADDING), S2N_ERR_SIGN);
+            POSIX_GUARD_OSSL(EVP_PKEY_CTX_set_rsa_pss_saltlen(ctx, RSA_PSS_SALTLEN_DIGEST), S2N_ERR_SIGN);
+            POSIX_GUARD_OSSL(EVP_PKEY_CTX_set_rsa_mgf1_md(ctx, md), S2N_ERR_SIGN);
+            POSIX_GUARD_OSSL(EVP_PKEY_CTX_set_signature_md(ctx, md), S2N_ERR_SIGN);
+            break;
+        case S2N_TLS_SIGNATURE_ECDSA:
+            /* ECDSA signs the digest as is */
+            break;
+        case S2N_TLS_SIGNATURE_ANONYMOUS:
+            POSIX_BAIL(S2N_ERR_INVALID_SIGNATURE_ALGORITHM);
+    }
+
+    size_t len = *signature_len;
+    POSIX_GUARD_OSSL(EVP_PKEY_sign(ctx, signature, &len, digest, digest_len), S2N_ERR_SIGN);
+    *signature_len = len;
+    return S2N_SUCCESS;
+}
+
+int s2n_test_evp_sign(EVP_PKEY *key, s2n_tls_signature_algorithm sig_alg, s2n_tls_hash_algorithm hash_alg,
+        const uint8_t *digest, uint32_t digest_len, uint8_t *signature, uint32_t *signature_len)
+{
+    POSIX_ENSURE_REF(key);
+    POSIX_ENSURE_REF(digest);
+    POSIX_ENSURE_REF(signature);
+    POSIX_ENSURE_REF(signature_len);
+
+    const EVP_MD *md = s2n_test_hash_algorithm_to_md(hash_alg);
+    POSIX_ENSURE(md != NULL, S2N_ERR_HASH_INVALID_ALGORITHM);
+    POSIX_ENSURE_EQ(digest_len, EVP_MD_size(md));
+
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(key, NULL);
+    POSIX_ENSURE_REF(ctx);
+    int result = s2n_test_evp_sign_with_ctx(ctx, sig_alg, md, digest, digest_len, signature, signature_len);
+    EVP_PKEY_CTX_free(ctx);
+    return result;
+}
+
+int s2n_test_async_pkey_op_sign_externally(struct s2n_async_pkey_op *op, EVP_PKEY *key)
+{
+    POSIX_ENSURE_REF(op);
+
+    s2n_tls_signature_algorithm sig_alg = 0;
+    POSIX_GUARD(s2n_async_pkey_op_get_signature_algorithm(op, &sig_alg));
+    s2n_tls_hash_algorithm hash_alg = 0;
+    POSIX_GUARD(s2n_async_pkey_op_get_hash_algorithm(op, &hash_alg));
+
+    uint8_t digest[EVP_MAX_MD_SIZE] = { 0 };
+    uint32_t digest_len = 0;
+    POSIX_GUARD(s2n_async_pkey_op_get_input_size(op, &digest_len));
+    POSIX_GUARD(s2n_async_pkey_op_get_input(op, digest, sizeof(digest)));
+
+    uint8_t signature[S2N_TEST_MAX_SIGNATURE_LEN] = { 0 };
+    uint32_t signature_len = sizeof(signature);
+    POSIX_GUARD(s2n_test_evp_sign(key, sig_alg, hash_alg, digest, digest_len, signature, &signature_len));
+
+    POSIX_GUARD(s2n_async_pkey_op_set_output(op, signature, signature_len));
+    return S2N_SUCCESS;
+}
@@ -185,6 +185,12 @@ bool s2n_pq_no_asm_available();
 
 int s2n_public_ecc_keys_are_equal(struct s2n_ecc_evp_params *params_1, struct s2n_ecc_evp_params *params_2);
 
+/* Sign the way an external signing service would, following the async pkey op's signature and hash algorithms */
+#define S2N_TEST_MAX_SIGNATURE_LEN 512
+int s2n_test_evp_sign(EVP_PKEY *key, s2n_tls_signature_algorithm sig_alg, s2n_tls_hash_algorithm hash_alg,
+        const uint8_t *digest, uint32_t digest_len, uint8_t *signature, uint32_t *signature_len);
+int s2n_test_async_pkey_op_sign_externally(struct s2n_async_pkey_op *op, EVP_PKEY *key);
+
 extern const s2n_parsed_extension EMPTY_PARSED_EXTENSIONS[S2N_PARSED_EXTENSIONS_COUNT];
 #define EXPECT_PARSED_EXTENSION_LIST_EMPTY(list) EXPECT_BYTEARRAY_EQUAL(list.parsed_extensions, EMPTY_PARSED_EXTENSIONS, sizeof(EMPTY_PARSED_EXTENSIONS))
 #define EXPECT_PARSED_EXTENSION_LIST_NOT_EMPTY(list) EXPECT_BYTEARRAY_NOT_EQUAL(list.parsed_extensions, EMPTY_PARSED_EXTENSIONS, sizeof(EMPTY_PARSED_EXTENSIONS))
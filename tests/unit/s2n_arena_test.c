@@ -0,0 +1,153 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include "tls/s2n_connection.h"
+#include "utils/s2n_arena.h"
+
+static bool s2n_test_is_zero(const struct s2n_blob *blob)
+{
+    for (uint32_t i = 0; i < blob->size; i++) {
+        if (blob->data[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    /* Safety checks */
+    {
+        struct s2n_arena arena = { 0 };
+        struct s2n_blob blob = { 0 };
+        EXPECT_ERROR_WITH_ERRNO(s2n_arena_alloc(NULL, &blob, 1), S2N_ERR_NULL);
+        EXPECT_ERROR_WITH_ERRNO(s2n_arena_alloc(&arena, NULL, 1), S2N_ERR_NULL);
+        EXPECT_ERROR_WITH_ERRNO(s2n_arena_alloc(&arena, &blob, 0), S2N_ERR_SAFETY);
+        EXPECT_ERROR_WITH_ERRNO(s2n_arena_free(NULL), S2N_ERR_NULL);
+
+        /* Freeing an empty arena is a no-op */
+        EXPECT_OK(s2n_arena_free(&arena));
+        EXPECT_NULL(arena.blocks);
+    }
+
+    /* Allocations are zeroed, aligned and carved from the same block */
+    {
+        struct s2n_arena arena = { 0 };
+
+        struct s2n_blob first = { 0 };
+        EXPECT_OK(s2n_arena_alloc(&arena, &first, 5));
+        EXPECT_EQUAL(first.size, 5);
+        EXPECT_FALSE(s2n_blob_is_growable(&first));
+        EXPECT_TRUE(s2n_test_is_zero(&first));
+        EXPECT_EQUAL((uintptr_t) first.data % S2N_ARENA_ALIGNMENT, 0);
+        memset(first.data, 0xAB, first.size);
+
+        struct s2n_blob second = { 0 };
+        EXPECT_OK(s2n_arena_alloc(&arena, &second, 100));
+        EXPECT_EQUAL(second.data, first.data + S2N_ARENA_ALIGNMENT);
+        EXPECT_TRUE(s2n_test_is_zero(&second));
+        EXPECT_EQUAL(first.data[4], 0xAB);
+
+        /* Arena memory can't be released on its own */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_free(&second), S2N_ERR_FREE_STATIC_BLOB);
+
+        EXPECT_OK(s2n_arena_free(&arena));
+        EXPECT_NULL(arena.blocks);
+    }
+
+    /* Requests that don't fit the current block start a new one */
+    {
+        struct s2n_arena arena = { 0 };
+
+        struct s2n_blob small = { 0 };
+        EXPECT_OK(s2n_arena_alloc(&arena, &small, 16));
+        struct s2n_arena_block *first_block = arena.blocks;
+
+        struct s2n_blob large = { 0 };
+        EXPECT_OK(s2n_arena_alloc(&arena, &large, S2N_ARENA_BLOCK_SIZE * 2));
+        EXPECT_EQUAL(large.size, S2N_ARENA_BLOCK_SIZE * 2);
+        EXPECT_TRUE(s2n_test_is_zero(&large));
+        EXPECT_NOT_EQUAL(arena.blocks, first_block);
+        memset(large.data, 0xCD, large.size);
+
+        struct s2n_blob after = { 0 };
+        EXPECT_OK(s2n_arena_alloc(&arena, &after, S2N_ARENA_BLOCK_SIZE / 2));
+        EXPECT_TRUE(s2n_test_is_zero(&after));
+
+        EXPECT_OK(s2n_arena_free(&arena));
+        EXPECT_NULL(arena.blocks);
+    }
+
+    /* The handshake arena is released once the handshake completes */
+    {
+        EXPECT_SUCCESS(s2n_enable_tls13());
+
+        struct s2n_cert_chain_and_key *chain_and_key = NULL;
+        EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+                S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+        struct s2n_config *config = NULL;
+        EXPECT_NOT_NULL(config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_set_cipher_preferences(config, "default_tls13"));
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(config, chain_and_key));
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(config));
+
+        struct s2n_connection *server_conn = NULL, *client_conn = NULL;
+        EXPECT_NOT_NULL(server_conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_NOT_NULL(client_conn = s2n_connection_new(S2N_CLIENT));
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, config));
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, config));
+
+        struct s2n_test_io_pair io_pair = { 0 };
+        EXPECT_SUCCESS(s2n_io_pair_init_non_blocking(&io_pair));
+        EXPECT_SUCCESS(s2n_connections_set_io_pair(client_conn, server_conn, &io_pair));
+
+        /* The server signed its CertificateVerify with arena memory, which is kept until the end of the handshake */
+        EXPECT_OK(s2n_negotiate_test_server_and_client_until_message(server_conn, client_conn, SERVER_FINISHED));
+        EXPECT_EQUAL(server_conn->actual_protocol_version, S2N_TLS13);
+        EXPECT_NOT_NULL(server_conn->handshake_arena.blocks);
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_NULL(server_conn->handshake_arena.blocks);
+        EXPECT_NULL(client_conn->handshake_arena.blocks);
+
+        /* Wiping or freeing the handshake also releases the arena */
+        struct s2n_blob blob = { 0 };
+        EXPECT_OK(s2n_arena_alloc(&server_conn->handshake_arena, &blob, 10));
+        EXPECT_SUCCESS(s2n_connection_free_handshake(server_conn));
+        EXPECT_NULL(server_conn->handshake_arena.blocks);
+
+        EXPECT_OK(s2n_arena_alloc(&server_conn->handshake_arena, &blob, 10));
+        EXPECT_SUCCESS(s2n_connection_wipe(server_conn));
+        EXPECT_NULL(server_conn->handshake_arena.blocks);
+
+        /* Freeing a connection with arena memory doesn't leak */
+        EXPECT_OK(s2n_arena_alloc(&client_conn->handshake_arena, &blob, 10));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+        EXPECT_SUCCESS(s2n_config_free(config));
+        EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+        EXPECT_SUCCESS(s2n_disable_tls13());
+    }
+
+    END_TEST();
+}
@@ -0,0 +1,566 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "testlib/s2n_testlib.h"
+
+#include <s2n.h>
+
+#include "crypto/s2n_pkey.h"
+#include "crypto/s2n_rsa_pss.h"
+#include "crypto/s2n_rsa_signing.h"
+#include "error/s2n_errno.h"
+#include "tls/s2n_cipher_suites.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_security_policies.h"
+#include "utils/s2n_safety.h"
+
+#define TEST_CONN_COUNT 4
+
+struct s2n_async_pkey_batch *batch = NULL;
+s2n_cert_private_key *test_pkey = NULL;
+
+struct test_batch_ctx {
+    uint32_t perform_calls;
+    uint32_t ready_calls;
+    uint32_t ready_conns;
+    uint32_t failed_calls;
+    struct s2n_connection *failed_conns[TEST_CONN_COUNT];
+    uint32_t failed_conns_count;
+};
+
+static int async_pkey_batch_callback(struct s2n_connection *conn, struct s2n_async_pkey_op *op)
+{
+    return s2n_async_pkey_batch_add(batch, op);
+}
+
+/* Completes ops the way an external service would, through the input and output accessors */
+static int test_perform_externally(struct s2n_async_pkey_op *op)
+{
+    s2n_async_pkey_op_type type = 0;
+    POSIX_GUARD(s2n_async_pkey_op_get_op_type(op, &type));
+    if (type == S2N_ASYNC_SIGN) {
+        uint32_t digest_len = 0;
+        POSIX_GUARD(s2n_async_pkey_op_get_input_size(op, &digest_len));
+        EXPECT_NOT_EQUAL(digest_len, 0);
+
+        uint8_t digest[S2N_MAX_DIGEST_LEN] = { 0 };
+        EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_op_get_input(op, digest, digest_len - 1), S2N_ERR_SIZE_MISMATCH);
+
+        return s2n_test_async_pkey_op_sign_externally(op, test_pkey->pkey);
+    }
+
+    s2n_tls_signature_algorithm sig_alg = 0;
+    EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_op_get_signature_algorithm(op, &sig_alg), S2N_ERR_INVALID_STATE);
+    s2n_tls_hash_algorithm hash_alg = 0;
+    EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_op_get_hash_algorithm(op, &hash_alg), S2N_ERR_INVALID_STATE);
+
+    uint32_t encrypted_len = 0;
+    POSIX_GUARD(s2n_async_pkey_op_get_input_size(op, &encrypted_len));
+
+    DEFER_CLEANUP(struct s2n_blob encrypted = { 0 }, s2n_free);
+    POSIX_GUARD(s2n_alloc(&encrypted, encrypted_len));
+    POSIX_GUARD(s2n_async_pkey_op_get_input(op, encrypted.data, encrypted.size));
+
+    uint8_t premaster[S2N_TLS_SECRET_LEN] = { 0 };
+    struct s2n_blob decrypted = { 0 };
+    POSIX_GUARD(s2n_blob_init(&decrypted, premaster, sizeof(premaster)));
+    POSIX_GUARD(s2n_pkey_decrypt(test_pkey, &encrypted, &decrypted));
+
+    POSIX_GUARD(s2n_async_pkey_op_set_output(op, decrypted.data, decrypted.size));
+    EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_op_set_output(op, decrypted.data, decrypted.size),
+            S2N_ERR_ASYNC_ALREADY_PERFORMED);
+    return S2N_SUCCESS;
+}
+
+static int test_batch_perform(struct s2n_async_pkey_op **ops, uint32_t ops_count, void *ctx)
+{
+    struct test_batch_ctx *test_ctx = ctx;
+    test_ctx->perform_calls++;
+
+    for (uint32_t i = 0; i < ops_count; i++) {
+        /* Mix local and external completion within one batch */
+        if (i % 2) {
+            POSIX_GUARD(s2n_async_pkey_op_perform(ops[i], test_pkey));
+        } else {
+            POSIX_GUARD(test_perform_externally(ops[i]));
+        }
+    }
+    return S2N_SUCCESS;
+}
+
+static int test_batch_perform_first_only(struct s2n_async_pkey_op **ops, uint32_t ops_count, void *ctx)
+{
+    struct test_batch_ctx *test_ctx = ctx;
+    test_ctx->perform_calls++;
+    return s2n_async_pkey_op_perform(ops[0], test_pkey);
+}
+
+static int test_batch_perform_fail(struct s2n_async_pkey_op **ops, uint32_t ops_count, void *ctx)
+{
+    struct test_batch_ctx *test_ctx = ctx;
+    test_ctx->perform_calls++;
+    return S2N_FAILURE;
+}
+
+static int test_batch_ready(struct s2n_connection **conns, uint32_t conns_count, void *ctx)
+{
+    struct test_batch_ctx *test_ctx = ctx;
+    test_ctx->ready_calls++;
+    test_ctx->ready_conns += conns_count;
+    return S2N_SUCCESS;
+}
+
+static int test_batch_failed(struct s2n_connection **conns, uint32_t conns_count, void *ctx)
+{
+    struct test_batch_ctx *test_ctx = ctx;
+    test_ctx->failed_calls++;
+    POSIX_ENSURE_LTE(conns_count, TEST_CONN_COUNT);
+    for (uint32_t i = 0; i < conns_count; i++) {
+        test_ctx->failed_conns[i] = conns[i];
+    }
+    test_ctx->failed_conns_count = conns_count;
+    return S2N_SUCCESS;
+}
+
+static EVP_PKEY *test_external_key = NULL;
+static s2n_tls_signature_algorithm test_external_sig_alg = 0;
+static s2n_tls_hash_algorithm test_external_hash_alg = 0;
+
+static int test_batch_perform_sign_externally(struct s2n_async_pkey_op **ops, uint32_t ops_count, void *ctx)
+{
+    for (uint32_t i = 0; i < ops_count; i++) {
+        POSIX_GUARD(s2n_async_pkey_op_get_signature_algorithm(ops[i], &test_external_sig_alg));
+        POSIX_GUARD(s2n_async_pkey_op_get_hash_algorithm(ops[i], &test_external_hash_alg));
+        POSIX_GUARD(s2n_test_async_pkey_op_sign_externally(ops[i], test_external_key));
+    }
+    return S2N_SUCCESS;
+}
+
+static bool test_negotiate_blocked(struct s2n_connection *conn, s2n_blocked_status *blocked)
+{
+    int rc = s2n_negotiate(conn, blocked);
+    return rc == S2N_SUCCESS || (*blocked && s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED);
+}
+
+/* Drives every handshake until it is done or waiting on a private key operation */
+static int test_negotiate_all(struct s2n_connection **servers, struct s2n_connection **clients, bool *done)
+{
+    for (int round = 0; round < 10; round++) {
+        *done = true;
+        for (size_t i = 0; i < TEST_CONN_COUNT; i++) {
+            s2n_blocked_status client_blocked = S2N_NOT_BLOCKED;
+            s2n_blocked_status server_blocked = S2N_NOT_BLOCKED;
+            POSIX_ENSURE(test_negotiate_blocked(clients[i], &client_blocked), S2N_ERR_SAFETY);
+            POSIX_ENSURE(test_negotiate_blocked(servers[i], &server_blocked), S2N_ERR_SAFETY);
+            if (client_blocked || server_blocked) {
+                *done = false;
+            }
+        }
+    }
+    return S2N_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+    EXPECT_SUCCESS(s2n_disable_tls13());
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_TEST_CERT_CHAIN, S2N_DEFAULT_TEST_PRIVATE_KEY));
+    test_pkey = s2n_cert_chain_and_key_get_private_key(chain_and_key);
+    EXPECT_NOT_NULL(test_pkey);
+
+    /* Safety */
+    {
+        EXPECT_NOT_NULL(batch = s2n_async_pkey_batch_new());
+
+        uint32_t count = 1;
+        EXPECT_SUCCESS(s2n_async_pkey_batch_get_count(batch, &count));
+        EXPECT_EQUAL(count, 0);
+
+        struct test_batch_ctx ctx = { 0 };
+        EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_batch_add(NULL, NULL), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_batch_add(batch, NULL), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_batch_flush(batch, NULL, test_batch_ready, test_batch_failed, &ctx),
+                S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_batch_flush(batch, test_batch_perform, NULL, test_batch_failed, &ctx),
+                S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_batch_flush(batch, test_batch_perform, test_batch_ready, NULL, &ctx),
+                S2N_ERR_NULL);
+
+        /* Flushing an empty batch calls nothing */
+        EXPECT_SUCCESS(s2n_async_pkey_batch_flush(batch, test_batch_perform, test_batch_ready, test_batch_failed, &ctx));
+        EXPECT_EQUAL(ctx.perform_calls, 0);
+        EXPECT_EQUAL(ctx.ready_calls, 0);
+        EXPECT_EQUAL(ctx.failed_calls, 0);
+
+        EXPECT_SUCCESS(s2n_async_pkey_batch_free(batch));
+        batch = NULL;
+    }
+
+    /* Run all tests for 2 cipher suites to test both sign and decrypt operations */
+    struct s2n_cipher_suite *test_cipher_suites[] = {
+        &s2n_rsa_with_aes_128_gcm_sha256,
+        &s2n_ecdhe_rsa_with_aes_128_gcm_sha256,
+    };
+
+    for (size_t i = 0; i < s2n_array_len(test_cipher_suites); i++) {
+        struct s2n_cipher_preferences server_cipher_preferences = {
+            .count = 1,
+            .suites = &test_cipher_suites[i],
+        };
+
+        struct s2n_security_policy server_security_policy = {
+            .minimum_protocol_version = S2N_TLS12,
+            .cipher_preferences = &server_cipher_preferences,
+            .kem_preferences = &kem_preferences_null,
+            .signature_preferences = &s2n_signature_preferences_20200207,
+            .ecc_preferences = &s2n_ecc_preferences_20200310,
+        };
+
+        struct s2n_config *server_config = s2n_config_new();
+        EXPECT_NOT_NULL(server_config);
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+        EXPECT_SUCCESS(s2n_config_set_async_pkey_callback(server_config, async_pkey_batch_callback));
+        server_config->security_policy = &server_security_policy;
+
+        struct s2n_config *client_config = s2n_config_new();
+        EXPECT_NOT_NULL(client_config);
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+        /* Test: ops from many connections are performed and applied together */
+        {
+            EXPECT_NOT_NULL(batch = s2n_async_pkey_batch_new());
+
+            struct s2n_connection *servers[TEST_CONN_COUNT] = { 0 };
+            struct s2n_connection *clients[TEST_CONN_COUNT] = { 0 };
+            struct s2n_test_io_pair io_pairs[TEST_CONN_COUNT] = { 0 };
+            for (size_t j = 0; j < TEST_CONN_COUNT; j++) {
+                EXPECT_NOT_NULL(servers[j] = s2n_connection_new(S2N_SERVER));
+                EXPECT_SUCCESS(s2n_connection_set_config(servers[j], server_config));
+                EXPECT_NOT_NULL(clients[j] = s2n_connection_new(S2N_CLIENT));
+                EXPECT_SUCCESS(s2n_connection_set_config(clients[j], client_config));
+                EXPECT_SUCCESS(s2n_io_pair_init_non_blocking(&io_pairs[j]));
+                EXPECT_SUCCESS(s2n_connections_set_io_pair(clients[j], servers[j], &io_pairs[j]));
+            }
+
+            bool done = false;
+            EXPECT_SUCCESS(test_negotiate_all(servers, clients, &done));
+            EXPECT_FALSE(done);
+
+            uint32_t count = 0;
+            EXPECT_SUCCESS(s2n_async_pkey_batch_get_count(batch, &count));
+            EXPECT_EQUAL(count, TEST_CONN_COUNT);
+
+            struct test_batch_ctx ctx = { 0 };
+            EXPECT_SUCCESS(s2n_async_pkey_batch_flush(batch, test_batch_perform, test_batch_ready, test_batch_failed, &ctx));
+            EXPECT_EQUAL(ctx.perform_calls, 1);
+            EXPECT_EQUAL(ctx.ready_calls, 1);
+            EXPECT_EQUAL(ctx.ready_conns, TEST_CONN_COUNT);
+            EXPECT_EQUAL(ctx.failed_calls, 0);
+            EXPECT_SUCCESS(s2n_async_pkey_batch_get_count(batch, &count));
+            EXPECT_EQUAL(count, 0);
+
+            EXPECT_SUCCESS(test_negotiate_all(servers, clients, &done));
+            EXPECT_TRUE(done);
+
+            for (size_t j = 0; j < TEST_CONN_COUNT; j++) {
+                EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(servers[j], clients[j]));
+                EXPECT_SUCCESS(s2n_connection_free(servers[j]));
+                EXPECT_SUCCESS(s2n_connection_free(clients[j]));
+                EXPECT_SUCCESS(s2n_io_pair_close(&io_pairs[j]));
+            }
+            EXPECT_SUCCESS(s2n_async_pkey_batch_free(batch));
+            batch = NULL;
+        }
+
+        /* Test: connections whose op was not performed are reported as failed */
+        {
+            EXPECT_NOT_NULL(batch = s2n_async_pkey_batch_new());
+
+            struct s2n_connection *servers[TEST_CONN_COUNT] = { 0 };
+            struct s2n_connection *clients[TEST_CONN_COUNT] = { 0 };
+            struct s2n_test_io_pair io_pairs[TEST_CONN_COUNT] = { 0 };
+            for (size_t j = 0; j < TEST_CONN_COUNT; j++) {
+                EXPECT_NOT_NULL(servers[j] = s2n_connection_new(S2N_SERVER));
+                EXPECT_SUCCESS(s2n_connection_set_config(servers[j], server_config));
+                EXPECT_NOT_NULL(clients[j] = s2n_connection_new(S2N_CLIENT));
+                EXPECT_SUCCESS(s2n_connection_set_config(clients[j], client_config));
+                EXPECT_SUCCESS(s2n_io_pair_init_non_blocking(&io_pairs[j]));
+                EXPECT_SUCCESS(s2n_connections_set_io_pair(clients[j], servers[j], &io_pairs[j]));
+            }
+
+            bool done = false;
+            EXPECT_SUCCESS(test_negotiate_all(servers, clients, &done));
+
+            struct test_batch_ctx ctx = { 0 };
+            EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_batch_flush(batch, test_batch_perform_first_only, test_batch_ready,
+                                              test_batch_failed, &ctx),
+                    S2N_ERR_ASYNC_NOT_PERFORMED);
+            EXPECT_EQUAL(ctx.ready_calls, 1);
+            EXPECT_EQUAL(ctx.ready_conns, 1);
+            EXPECT_EQUAL(ctx.failed_calls, 1);
+            EXPECT_EQUAL(ctx.failed_conns_count, TEST_CONN_COUNT - 1);
+            for (size_t j = 1; j < TEST_CONN_COUNT; j++) {
+                EXPECT_EQUAL(ctx.failed_conns[j - 1], servers[j]);
+            }
+
+            uint32_t count = 0;
+            EXPECT_SUCCESS(s2n_async_pkey_batch_get_count(batch, &count));
+            EXPECT_EQUAL(count, 0);
+
+            /* The remaining connections are never resumed */
+            s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+            EXPECT_FAILURE_WITH_ERRNO(s2n_negotiate(servers[1], &blocked), S2N_ERR_ASYNC_BLOCKED);
+
+            for (size_t j = 0; j < TEST_CONN_COUNT; j++) {
+                EXPECT_SUCCESS(s2n_connection_free(servers[j]));
+                EXPECT_SUCCESS(s2n_connection_free(clients[j]));
+                EXPECT_SUCCESS(s2n_io_pair_close(&io_pairs[j]));
+            }
+            EXPECT_SUCCESS(s2n_async_pkey_batch_free(batch));
+            batch = NULL;
+        }
+
+        /* Test: a failed perform reports every connection in the batch as failed */
+        {
+            EXPECT_NOT_NULL(batch = s2n_async_pkey_batch_new());
+
+            struct s2n_connection *servers[TEST_CONN_COUNT] = { 0 };
+            struct s2n_connection *clients[TEST_CONN_COUNT] = { 0 };
+            struct s2n_test_io_pair io_pairs[TEST_CONN_COUNT] = { 0 };
+            for (size_t j = 0; j < TEST_CONN_COUNT; j++) {
+                EXPECT_NOT_NULL(servers[j] = s2n_connection_new(S2N_SERVER));
+                EXPECT_SUCCESS(s2n_connection_set_config(servers[j], server_config));
+                EXPECT_NOT_NULL(clients[j] = s2n_connection_new(S2N_CLIENT));
+                EXPECT_SUCCESS(s2n_connection_set_config(clients[j], client_config));
+                EXPECT_SUCCESS(s2n_io_pair_init_non_blocking(&io_pairs[j]));
+                EXPECT_SUCCESS(s2n_connections_set_io_pair(clients[j], servers[j], &io_pairs[j]));
+            }
+
+            bool done = false;
+            EXPECT_SUCCESS(test_negotiate_all(servers, clients, &done));
+
+            struct test_batch_ctx ctx = { 0 };
+            EXPECT_FAILURE_WITH_ERRNO(s2n_async_pkey_batch_flush(batch, test_batch_perform_fail, test_batch_ready,
+                                              test_batch_failed, &ctx),
+                    S2N_ERR_ASYNC_CALLBACK_FAILED);
+            EXPECT_EQUAL(ctx.perform_calls, 1);
+            EXPECT_EQUAL(ctx.ready_calls, 0);
+            EXPECT_EQUAL(ctx.failed_calls, 1);
+            EXPECT_EQUAL(ctx.failed_conns_count, TEST_CONN_COUNT);
+            for (size_t j = 0; j < TEST_CONN_COUNT; j++) {
+                EXPECT_EQUAL(ctx.failed_conns[j], servers[j]);
+            }
+
+            /* The failed connections are never resumed */
+            s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+            EXPECT_FAILURE_WITH_ERRNO(s2n_negotiate(servers[0], &blocked), S2N_ERR_ASYNC_BLOCKED);
+
+            uint32_t count = 0;
+            EXPECT_SUCCESS(s2n_async_pkey_batch_get_count(batch, &count));
+            EXPECT_EQUAL(count, 0);
+
+            for (size_t j = 0; j < TEST_CONN_COUNT; j++) {
+                EXPECT_SUCCESS(s2n_connection_free(servers[j]));
+                EXPECT_SUCCESS(s2n_connection_free(clients[j]));
+                EXPECT_SUCCESS(s2n_io_pair_close(&io_pairs[j]));
+            }
+            EXPECT_SUCCESS(s2n_async_pkey_batch_free(batch));
+            batch = NULL;
+        }
+
+        /* Test: freeing a batch frees its pending ops */
+        {
+            EXPECT_NOT_NULL(batch = s2n_async_pkey_batch_new());
+
+            struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+            EXPECT_NOT_NULL(server_conn);
+            EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+            struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+            EXPECT_NOT_NULL(client_conn);
+            EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+            struct s2n_test_io_pair io_pair = { 0 };
+            EXPECT_SUCCESS(s2n_io_pair_init_non_blocking(&io_pair));
+            EXPECT_SUCCESS(s2n_connections_set_io_pair(client_conn, server_conn, &io_pair));
+
+            for (int round = 0; round < 10; round++) {
+                s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+                EXPECT_TRUE(test_negotiate_blocked(client_conn, &blocked));
+                EXPECT_TRUE(test_negotiate_blocked(server_conn, &blocked));
+            }
+
+            uint32_t count = 0;
+            EXPECT_SUCCESS(s2n_async_pkey_batch_get_count(batch, &count));
+            EXPECT_EQUAL(count, 1);
+
+            EXPECT_SUCCESS(s2n_async_pkey_batch_free(batch));
+            batch = NULL;
+
+            EXPECT_SUCCESS(s2n_connection_free(server_conn));
+            EXPECT_SUCCESS(s2n_connection_free(client_conn));
+            EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+        }
+
+        EXPECT_SUCCESS(s2n_config_free(server_config));
+        EXPECT_SUCCESS(s2n_config_free(client_config));
+    }
+
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+
+    /* Test: signatures produced outside of s2n complete the handshake for every signature algorithm */
+    {
+        struct {
+            const char *cert;
+            const char *key;
+            const struct s2n_signature_scheme *scheme;
+            struct s2n_cipher_suite *cipher_suite;
+            uint8_t protocol_version;
+            bool supported;
+        } test_cases[] = {
+            {
+                    .cert = S2N_DEFAULT_TEST_CERT_CHAIN,
+                    .key = S2N_DEFAULT_TEST_PRIVATE_KEY,
+                    .scheme = &s2n_rsa_pkcs1_sha256,
+                    .cipher_suite = &s2n_ecdhe_rsa_with_aes_128_gcm_sha256,
+                    .protocol_version = S2N_TLS12,
+                    .supported = true,
+            },
+            {
+                    .cert = S2N_DEFAULT_TEST_CERT_CHAIN,
+                    .key = S2N_DEFAULT_TEST_PRIVATE_KEY,
+                    .scheme = &s2n_rsa_pss_rsae_sha256,
+                    .cipher_suite = &s2n_ecdhe_rsa_with_aes_128_gcm_sha256,
+                    .protocol_version = S2N_TLS12,
+                    .supported = s2n_is_rsa_pss_signing_supported(),
+            },
+            {
+                    .cert = S2N_RSA_PSS_2048_SHA256_LEAF_CERT,
+                    .key = S2N_RSA_PSS_2048_SHA256_LEAF_KEY,
+                    .scheme = &s2n_rsa_pss_pss_sha256,
+                    .cipher_suite = &s2n_tls13_aes_128_gcm_sha256,
+                    .protocol_version = S2N_TLS13,
+                    .supported = s2n_is_rsa_pss_certs_supported(),
+            },
+            {
+                    .cert = S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN,
+                    .key = S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY,
+                    .scheme = &s2n_ecdsa_sha256,
+                    .cipher_suite = &s2n_ecdhe_ecdsa_with_aes_128_gcm_sha256,
+                    .protocol_version = S2N_TLS12,
+                    .supported = true,
+            },
+            {
+                    .cert = S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN,
+                    .key = S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY,
+                    .scheme = &s2n_ecdsa_secp384r1_sha384,
+                    .cipher_suite = &s2n_tls13_aes_128_gcm_sha256,
+                    .protocol_version = S2N_TLS13,
+                    .supported = true,
+            },
+        };
+
+        EXPECT_SUCCESS(s2n_enable_tls13());
+        for (size_t i = 0; i < s2n_array_len(test_cases); i++) {
+            if (!test_cases[i].supported) {
+                continue;
+            }
+
+            struct s2n_cert_chain_and_key *sign_chain_and_key = NULL;
+            EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&sign_chain_and_key, test_cases[i].cert, test_cases[i].key));
+            test_external_key = s2n_cert_chain_and_key_get_private_key(sign_chain_and_key)->pkey;
+            EXPECT_NOT_NULL(test_external_key);
+
+            const struct s2n_signature_scheme *const schemes[] = { test_cases[i].scheme };
+            struct s2n_signature_preferences signature_preferences = {
+                .count = 1,
+                .signature_schemes = schemes,
+            };
+            struct s2n_cipher_preferences cipher_preferences = {
+                .count = 1,
+                .suites = &test_cases[i].cipher_suite,
+            };
+            struct s2n_security_policy security_policy = {
+                .minimum_protocol_version = S2N_TLS12,
+                .cipher_preferences = &cipher_preferences,
+                .kem_preferences = &kem_preferences_null,
+                .signature_preferences = &signature_preferences,
+                .ecc_preferences = &s2n_ecc_preferences_20200310,
+            };
+
+            struct s2n_config *server_config = s2n_config_new();
+            EXPECT_NOT_NULL(server_config);
+            EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, sign_chain_and_key));
+            EXPECT_SUCCESS(s2n_config_set_async_pkey_callback(server_config, async_pkey_batch_callback));
+            server_config->security_policy = &security_policy;
+
+            struct s2n_config *client_config = s2n_config_new();
+            EXPECT_NOT_NULL(client_config);
+            EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+            client_config->security_policy = &security_policy;
+
+            EXPECT_NOT_NULL(batch = s2n_async_pkey_batch_new());
+
+            struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+            EXPECT_NOT_NULL(server_conn);
+            EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+            struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+            EXPECT_NOT_NULL(client_conn);
+            EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+            struct s2n_test_io_pair io_pair = { 0 };
+            EXPECT_SUCCESS(s2n_io_pair_init_non_blocking(&io_pair));
+            EXPECT_SUCCESS(s2n_connections_set_io_pair(client_conn, server_conn, &io_pair));
+
+            uint32_t count = 0;
+            for (int round = 0; round < 10 && count == 0; round++) {
+                s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+                EXPECT_TRUE(test_negotiate_blocked(client_conn, &blocked));
+                EXPECT_TRUE(test_negotiate_blocked(server_conn, &blocked));
+                EXPECT_SUCCESS(s2n_async_pkey_batch_get_count(batch, &count));
+            }
+            EXPECT_EQUAL(count, 1);
+
+            struct test_batch_ctx ctx = { 0 };
+            EXPECT_SUCCESS(s2n_async_pkey_batch_flush(batch, test_batch_perform_sign_externally, test_batch_ready,
+                    test_batch_failed, &ctx));
+            EXPECT_EQUAL(ctx.ready_conns, 1);
+            EXPECT_EQUAL(ctx.failed_calls, 0);
+            EXPECT_EQUAL(test_external_sig_alg, (s2n_tls_signature_algorithm) test_cases[i].scheme->sig_alg);
+            EXPECT_EQUAL(test_external_hash_alg, (s2n_tls_hash_algorithm) test_cases[i].scheme->hash_alg);
+
+            /* The client verifies the externally produced signature */
+            EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+            EXPECT_EQUAL(server_conn->actual_protocol_version, test_cases[i].protocol_version);
+            EXPECT_EQUAL(server_conn->secure.conn_sig_scheme.iana_value, test_cases[i].scheme->iana_value);
+
+            EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+            EXPECT_SUCCESS(s2n_connection_free(server_conn));
+            EXPECT_SUCCESS(s2n_connection_free(client_conn));
+            EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+            EXPECT_SUCCESS(s2n_async_pkey_batch_free(batch));
+            batch = NULL;
+
+            EXPECT_SUCCESS(s2n_config_free(server_config));
+            EXPECT_SUCCESS(s2n_config_free(client_config));
+            EXPECT_SUCCESS(s2n_cert_chain_and_key_free(sign_chain_and_key));
+        }
+        EXPECT_SUCCESS(s2n_disable_tls13());
+    }
+
+    END_TEST();
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include <s2n.h>
+
+#include "tls/s2n_blinding_timer.h"
+#include "tls/s2n_connection.h"
+
+#define ONE_S_IN_NANOS  INT64_C(1000000000)
+#define MIN_DELAY       (10 * ONE_S_IN_NANOS)
+#define MAX_DELAY       (30 * ONE_S_IN_NANOS)
+#define S2N_TEST_CONN_COUNT 10
+
+static int mock_clock(void *data, uint64_t *nanoseconds)
+{
+    *nanoseconds = *(uint64_t *) data;
+    return S2N_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    uint64_t now = 1000 * ONE_S_IN_NANOS;
+
+    struct s2n_config *config = s2n_config_new();
+    EXPECT_NOT_NULL(config);
+    EXPECT_SUCCESS(s2n_config_set_monotonic_clock(config, mock_clock, &now));
+
+    /* Safety */
+    {
+        struct s2n_connection *conn = NULL;
+        uint64_t expiry = 0;
+        EXPECT_FAILURE_WITH_ERRNO(s2n_blinding_timer_free(NULL), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_blinding_timer(NULL, NULL), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_blinding_timer_get_next_expiry(NULL, &expiry), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_blinding_timer_pop_expired(NULL, &conn), S2N_ERR_NULL);
+
+        struct s2n_blinding_timer *timer = s2n_blinding_timer_new();
+        EXPECT_NOT_NULL(timer);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_blinding_timer_get_next_expiry(timer, NULL), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_blinding_timer_pop_expired(timer, NULL), S2N_ERR_NULL);
+
+        /* An empty timer has nothing to report */
+        EXPECT_SUCCESS(s2n_blinding_timer_get_next_expiry(timer, &expiry));
+        EXPECT_EQUAL(expiry, UINT64_MAX);
+        EXPECT_SUCCESS(s2n_blinding_timer_pop_expired(timer, &conn));
+        EXPECT_NULL(conn);
+
+        EXPECT_SUCCESS(s2n_blinding_timer_free(timer));
+    }
+
+    /* Killing a connection with a timer doesn't block, and the timer returns it once its delay passes */
+    {
+        struct s2n_blinding_timer *timer = s2n_blinding_timer_new();
+        EXPECT_NOT_NULL(timer);
+        timer->monotonic_clock = mock_clock;
+        timer->monotonic_clock_ctx = &now;
+        EXPECT_SUCCESS(s2n_config_set_blinding_timer(config, timer));
+
+        struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(conn, config));
+        EXPECT_EQUAL(conn->blinding, S2N_BUILT_IN_BLINDING);
+
+        EXPECT_SUCCESS(s2n_connection_kill(conn));
+        const uint64_t delay = s2n_connection_get_delay(conn);
+        EXPECT_TRUE(delay >= MIN_DELAY && delay < MAX_DELAY);
+        EXPECT_EQUAL(conn->blinding_timer, timer);
+
+        uint64_t expiry = 0;
+        EXPECT_SUCCESS(s2n_blinding_timer_get_next_expiry(timer, &expiry));
+        EXPECT_EQUAL(expiry, delay);
+
+        struct s2n_connection *expired = NULL;
+        now += delay - 1;
+        EXPECT_SUCCESS(s2n_blinding_timer_pop_expired(timer, &expired));
+        EXPECT_NULL(expired);
+        EXPECT_EQUAL(s2n_connection_get_delay(conn), 1);
+        EXPECT_SUCCESS(s2n_blinding_timer_get_next_expiry(timer, &expiry));
+        EXPECT_EQUAL(expiry, 1);
+
+        now += 1;
+        EXPECT_SUCCESS(s2n_blinding_timer_pop_expired(timer, &expired));
+        EXPECT_EQUAL(expired, conn);
+        EXPECT_NULL(conn->blinding_timer);
+        EXPECT_EQUAL(s2n_connection_get_delay(conn), 0);
+
+        EXPECT_SUCCESS(s2n_blinding_timer_pop_expired(timer, &expired));
+        EXPECT_NULL(expired);
+        EXPECT_SUCCESS(s2n_blinding_timer_get_next_expiry(timer, &expiry));
+        EXPECT_EQUAL(expiry, UINT64_MAX);
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+        EXPECT_SUCCESS(s2n_config_set_blinding_timer(config, NULL));
+        EXPECT_SUCCESS(s2n_blinding_timer_free(timer));
+    }
+
+    /* Connections are returned in deadline order, and wiped or freed connections are never returned */
+    {
+        struct s2n_blinding_timer *timer = s2n_blinding_timer_new();
+        EXPECT_NOT_NULL(timer);
+        timer->monotonic_clock = mock_clock;
+        timer->monotonic_clock_ctx = &now;
+        EXPECT_SUCCESS(s2n_config_set_blinding_timer(config, timer));
+
+        struct s2n_connection *conns[S2N_TEST_CONN_COUNT] = { 0 };
+        for (size_t i = 0; i < S2N_TEST_CONN_COUNT; i++) {
+            EXPECT_NOT_NULL(conns[i] = s2n_connection_new(S2N_SERVER));
+            EXPECT_SUCCESS(s2n_connection_set_config(conns[i], config));
+            EXPECT_SUCCESS(s2n_connection_kill(conns[i]));
+            now += ONE_S_IN_NANOS / 2;
+        }
+        EXPECT_EQUAL(timer->count, S2N_TEST_CONN_COUNT);
+
+        /* Killing a connection again restarts its delay rather than adding it twice */
+        EXPECT_SUCCESS(s2n_connection_kill(conns[0]));
+        EXPECT_EQUAL(timer->count, S2N_TEST_CONN_COUNT);
+
+        EXPECT_SUCCESS(s2n_connection_wipe(conns[1]));
+        EXPECT_NULL(conns[1]->blinding_timer);
+        EXPECT_SUCCESS(s2n_connection_free(conns[2]));
+        conns[2] = NULL;
+        EXPECT_EQUAL(timer->count, S2N_TEST_CONN_COUNT - 2);
+
+        /* Poll once a second, like an event loop would, until every delay has passed */
+        uint64_t last_deadline = 0;
+        uint32_t popped = 0;
+        for (size_t tick = 0; tick <= MAX_DELAY / ONE_S_IN_NANOS + S2N_TEST_CONN_COUNT; tick++) {
+            now += ONE_S_IN_NANOS;
+
+            struct s2n_connection *expired = NULL;
+            EXPECT_SUCCESS(s2n_blinding_timer_pop_expired(timer, &expired));
+            while (expired) {
+                EXPECT_TRUE(expired != conns[1]);
+                EXPECT_TRUE(expired->blinding_deadline <= now);
+                EXPECT_TRUE(expired->blinding_deadline / ONE_S_IN_NANOS >= last_deadline / ONE_S_IN_NANOS);
+                EXPECT_EQUAL(s2n_connection_get_delay(expired), 0);
+                last_deadline = expired->blinding_deadline;
+                popped++;
+                EXPECT_SUCCESS(s2n_blinding_timer_pop_expired(timer, &expired));
+            }
+        }
+        EXPECT_EQUAL(popped, S2N_TEST_CONN_COUNT - 2);
+        EXPECT_EQUAL(timer->count, 0);
+
+        /* A timer that isn't polled for longer than a rotation still returns every connection */
+        for (size_t i = 0; i < S2N_TEST_CONN_COUNT; i++) {
+            if (conns[i]) {
+                EXPECT_SUCCESS(s2n_connection_kill(conns[i]));
+            }
+        }
+        now += 10 * S2N_BLINDING_TIMER_SLOTS * ONE_S_IN_NANOS;
+        uint64_t expiry = UINT64_MAX;
+        EXPECT_SUCCESS(s2n_blinding_timer_get_next_expiry(timer, &expiry));
+        EXPECT_EQUAL(expiry, 0);
+
+        popped = 0;
+        struct s2n_connection *expired = NULL;
+        EXPECT_SUCCESS(s2n_blinding_timer_pop_expired(timer, &expired));
+        while (expired) {
+            popped++;
+            EXPECT_SUCCESS(s2n_blinding_timer_pop_expired(timer, &expired));
+        }
+        EXPECT_EQUAL(popped, S2N_TEST_CONN_COUNT - 1);
+
+        /* Freeing the timer drops the connections still waiting on it */
+        EXPECT_SUCCESS(s2n_connection_kill(conns[0]));
+        EXPECT_SUCCESS(s2n_config_set_blinding_timer(config, NULL));
+        EXPECT_SUCCESS(s2n_blinding_timer_free(timer));
+        EXPECT_NULL(conns[0]->blinding_timer);
+
+        for (size_t i = 0; i < S2N_TEST_CONN_COUNT; i++) {
+            if (conns[i]) {
+                EXPECT_SUCCESS(s2n_connection_free(conns[i]));
+            }
+        }
+    }
+
+    /* Self-service blinding ignores the timer */
+    {
+        struct s2n_blinding_timer *timer = s2n_blinding_timer_new();
+        EXPECT_NOT_NULL(timer);
+        EXPECT_SUCCESS(s2n_config_set_blinding_timer(config, timer));
+
+        struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(conn, config));
+        EXPECT_SUCCESS(s2n_connection_set_blinding(conn, S2N_SELF_SERVICE_BLINDING));
+
+        EXPECT_SUCCESS(s2n_connection_kill(conn));
+        EXPECT_NULL(conn->blinding_timer);
+        EXPECT_EQUAL(timer->count, 0);
+        EXPECT_TRUE(s2n_connection_get_delay(conn) >= MIN_DELAY);
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+        EXPECT_SUCCESS(s2n_config_set_blinding_timer(config, NULL));
+        EXPECT_SUCCESS(s2n_blinding_timer_free(timer));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(config));
+
+    END_TEST();
+}
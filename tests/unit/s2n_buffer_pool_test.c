@@ -0,0 +1,199 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include "tls/s2n_buffer_pool.h"
+#include "tls/s2n_connection.h"
+
+static int s2n_test_new_connections(struct s2n_config *config, struct s2n_connection **server_conn,
+        struct s2n_connection **client_conn, struct s2n_test_io_pair *io_pair)
+{
+    POSIX_ENSURE_REF(*server_conn = s2n_connection_new(S2N_SERVER));
+    POSIX_ENSURE_REF(*client_conn = s2n_connection_new(S2N_CLIENT));
+    POSIX_GUARD(s2n_connection_set_config(*server_conn, config));
+    POSIX_GUARD(s2n_connection_set_config(*client_conn, config));
+
+    POSIX_GUARD(s2n_io_pair_init_non_blocking(io_pair));
+    POSIX_GUARD(s2n_connections_set_io_pair(*client_conn, *server_conn, io_pair));
+    return S2N_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    /* Safety checks */
+    {
+        EXPECT_ERROR_WITH_ERRNO(s2n_buffer_pool_acquire(NULL), S2N_ERR_NULL);
+        EXPECT_ERROR_WITH_ERRNO(s2n_buffer_pool_release(NULL), S2N_ERR_NULL);
+
+        uint8_t data[10] = { 0 };
+        struct s2n_blob blob = { 0 };
+        EXPECT_SUCCESS(s2n_blob_init(&blob, data, sizeof(data)));
+        struct s2n_stuffer static_stuffer = { 0 };
+        EXPECT_SUCCESS(s2n_stuffer_init(&static_stuffer, &blob));
+
+        /* A stuffer that already has memory is left alone */
+        EXPECT_OK(s2n_buffer_pool_acquire(&static_stuffer));
+        EXPECT_EQUAL(static_stuffer.blob.data, data);
+
+        /* Static memory can't be pooled */
+        EXPECT_ERROR_WITH_ERRNO(s2n_buffer_pool_release(&static_stuffer), S2N_ERR_RESIZE_STATIC_STUFFER);
+    }
+
+    /* Buffers are borrowed and returned */
+    {
+        DEFER_CLEANUP(struct s2n_stuffer stuffer = { 0 }, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&stuffer, 0));
+
+        EXPECT_OK(s2n_buffer_pool_acquire(&stuffer));
+        EXPECT_NOT_NULL(stuffer.blob.data);
+        EXPECT_EQUAL(stuffer.blob.size, S2N_BUFFER_POOL_BUFFER_SIZE);
+        uint8_t *buffer = stuffer.blob.data;
+
+        /* Buffers still holding data are kept */
+        EXPECT_SUCCESS(s2n_stuffer_write_uint32(&stuffer, 0xDEADBEEF));
+        EXPECT_OK(s2n_buffer_pool_release(&stuffer));
+        EXPECT_EQUAL(stuffer.blob.data, buffer);
+
+        /* Drained buffers are wiped and returned */
+        EXPECT_SUCCESS(s2n_stuffer_skip_read(&stuffer, sizeof(uint32_t)));
+        EXPECT_OK(s2n_buffer_pool_release(&stuffer));
+        EXPECT_NULL(stuffer.blob.data);
+        EXPECT_EQUAL(s2n_stuffer_data_available(&stuffer), 0);
+        EXPECT_EQUAL(buffer[0], S2N_WIPE_PATTERN);
+
+        /* The returned buffer is handed out again */
+        EXPECT_OK(s2n_buffer_pool_acquire(&stuffer));
+        EXPECT_EQUAL(stuffer.blob.data, buffer);
+        EXPECT_OK(s2n_buffer_pool_release(&stuffer));
+
+        /* Releasing an empty stuffer is a no-op */
+        EXPECT_OK(s2n_buffer_pool_release(&stuffer));
+        EXPECT_NULL(stuffer.blob.data);
+    }
+
+    /* Resized buffers and buffers beyond the pool limit are freed */
+    {
+        struct s2n_stuffer stuffers[S2N_BUFFER_POOL_MAX_BUFFERS + 1] = { 0 };
+        for (size_t i = 0; i < s2n_array_len(stuffers); i++) {
+            EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&stuffers[i], 0));
+            EXPECT_OK(s2n_buffer_pool_acquire(&stuffers[i]));
+        }
+        for (size_t i = 0; i < s2n_array_len(stuffers); i++) {
+            EXPECT_OK(s2n_buffer_pool_release(&stuffers[i]));
+            EXPECT_NULL(stuffers[i].blob.data);
+        }
+
+        DEFER_CLEANUP(struct s2n_stuffer resized = { 0 }, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&resized, 0));
+        EXPECT_OK(s2n_buffer_pool_acquire(&resized));
+        EXPECT_SUCCESS(s2n_stuffer_resize(&resized, S2N_BUFFER_POOL_BUFFER_SIZE * 2));
+        EXPECT_OK(s2n_buffer_pool_release(&resized));
+        EXPECT_NULL(resized.blob.data);
+
+        EXPECT_OK(s2n_buffer_pool_cleanup_thread());
+    }
+
+    EXPECT_SUCCESS(s2n_enable_tls13());
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+    struct s2n_config *config = NULL;
+    EXPECT_NOT_NULL(config = s2n_config_new());
+    EXPECT_SUCCESS(s2n_config_set_cipher_preferences(config, "default_tls13"));
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(config, chain_and_key));
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(config));
+
+    EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_dynamic_buffers(NULL, true), S2N_ERR_NULL);
+
+    /* By default, connections keep their record buffers */
+    {
+        struct s2n_connection *server_conn = NULL, *client_conn = NULL;
+        struct s2n_test_io_pair io_pair = { 0 };
+        EXPECT_SUCCESS(s2n_test_new_connections(config, &server_conn, &client_conn, &io_pair));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_NOT_NULL(server_conn->in.blob.data);
+        EXPECT_NOT_NULL(server_conn->out.blob.data);
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+    }
+
+    EXPECT_SUCCESS(s2n_config_set_dynamic_buffers(config, true));
+
+    /* With dynamic buffers, idle connections hold no record buffers */
+    {
+        struct s2n_connection *server_conn = NULL, *client_conn = NULL;
+        struct s2n_test_io_pair io_pair = { 0 };
+        EXPECT_SUCCESS(s2n_test_new_connections(config, &server_conn, &client_conn, &io_pair));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_EQUAL(server_conn->actual_protocol_version, S2N_TLS13);
+        struct s2n_connection *conns[] = { server_conn, client_conn };
+        for (size_t i = 0; i < s2n_array_len(conns); i++) {
+            EXPECT_NULL(conns[i]->in.blob.data);
+            EXPECT_NULL(conns[i]->out.blob.data);
+        }
+
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        uint8_t message[] = "dynamic buffers";
+        uint8_t received[sizeof(message)] = { 0 };
+
+        /* A connection waiting for data holds no input buffer */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv(server_conn, received, sizeof(received), &blocked), S2N_ERR_IO_BLOCKED);
+        EXPECT_NULL(server_conn->in.blob.data);
+
+        /* The output buffer is returned once the record is written */
+        EXPECT_EQUAL(s2n_send(client_conn, message, sizeof(message), &blocked), sizeof(message));
+        EXPECT_NULL(client_conn->out.blob.data);
+
+        /* A partially read record keeps its buffer until it is drained */
+        EXPECT_EQUAL(s2n_recv(server_conn, received, 1, &blocked), 1);
+        EXPECT_NOT_NULL(server_conn->in.blob.data);
+        EXPECT_EQUAL(s2n_recv(server_conn, received + 1, sizeof(received) - 1, &blocked), sizeof(received) - 1);
+        EXPECT_NULL(server_conn->in.blob.data);
+        EXPECT_BYTEARRAY_EQUAL(received, message, sizeof(message));
+
+        /* Plaintext lent out by s2n_recv_view stays valid until it is consumed */
+        EXPECT_EQUAL(s2n_send(server_conn, message, sizeof(message), &blocked), sizeof(message));
+        const uint8_t *view = NULL;
+        uint32_t view_size = 0;
+        EXPECT_SUCCESS(s2n_recv_view(client_conn, &view, &view_size, &blocked));
+        EXPECT_EQUAL(view_size, sizeof(message));
+        EXPECT_NOT_NULL(client_conn->in.blob.data);
+        EXPECT_BYTEARRAY_EQUAL(view, message, sizeof(message));
+        EXPECT_SUCCESS(s2n_recv_consume(client_conn, view_size));
+        EXPECT_NULL(client_conn->in.blob.data);
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(config));
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    EXPECT_SUCCESS(s2n_disable_tls13());
+
+    END_TEST();
+}
@@ -188,6 +188,47 @@ int main(int argc, char **argv)
         }
     }
 
+    /* Test: the pre-encoded chain matches the chain encoded one certificate at a time */
+    {
+        struct s2n_cert_chain *chain = chain_and_key->cert_chain;
+        EXPECT_EQUAL(chain->entries.size, chain->chain_size);
+        EXPECT_NOT_EQUAL(chain->tls13_tail_entries.size, 0);
+
+        uint8_t protocol_versions[] = { S2N_TLS12, S2N_TLS13 };
+        for (size_t i = 0; i < s2n_array_len(protocol_versions); i++) {
+            struct s2n_connection *conn;
+            EXPECT_NOT_NULL(conn = s2n_connection_new(S2N_SERVER));
+            conn->handshake_params.our_chain_and_key = chain_and_key;
+            conn->actual_protocol_version = protocol_versions[i];
+
+            EXPECT_SUCCESS(s2n_connection_allow_all_response_extensions(conn));
+            conn->status_type = S2N_STATUS_REQUEST_OCSP;
+            conn->ct_level_requested = S2N_CT_SUPPORT_REQUEST;
+
+            DEFER_CLEANUP(struct s2n_stuffer encoded, s2n_stuffer_free);
+            EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&encoded, 0));
+            EXPECT_SUCCESS(s2n_send_cert_chain(conn, &encoded, chain_and_key));
+
+            /* Hide the pre-encoded entries to force the chain to be walked */
+            struct s2n_blob entries = chain->entries;
+            struct s2n_blob tls13_tail_entries = chain->tls13_tail_entries;
+            chain->entries = (struct s2n_blob) { 0 };
+            chain->tls13_tail_entries = (struct s2n_blob) { 0 };
+
+            DEFER_CLEANUP(struct s2n_stuffer walked, s2n_stuffer_free);
+            EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&walked, 0));
+            EXPECT_SUCCESS(s2n_send_cert_chain(conn, &walked, chain_and_key));
+
+            chain->entries = entries;
+            chain->tls13_tail_entries = tls13_tail_entries;
+
+            EXPECT_EQUAL(s2n_stuffer_data_available(&encoded), s2n_stuffer_data_available(&walked));
+            EXPECT_BYTEARRAY_EQUAL(encoded.blob.data, walked.blob.data, s2n_stuffer_data_available(&walked));
+
+            EXPECT_SUCCESS(s2n_connection_free(conn));
+        }
+    }
+
     /* Test: s2n_x509_validator_validate_cert_chain handles the output of s2n_send_cert_chain */
     {
         /* Test: with no extensions */
@@ -213,32 +213,14 @@ int s2n_test_client_auth_message_by_message(bool no_cert)
     EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), ENCRYPTED_EXTENSIONS);
     EXPECT_SUCCESS(s2n_handshake_read_io(client_conn));
 
-    /* Client reads EncryptedExtensions */
+    /* Client reads EncryptedExtensions, CertificateRequest, ServerCert, CertVerify and ServerFinished
+     * from the single record holding the rest of the server's flight.
+     * Without a client cert, the client expects Cert but reads CertificateRequest. */
     EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), ENCRYPTED_EXTENSIONS);
     EXPECT_SUCCESS(s2n_handshake_read_io(client_conn));
 
-    if (no_cert) {
-        /* Client reads CertificateRequest but expects Cert */
-        EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), SERVER_CERT);
-    } else {
-        EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), SERVER_CERT_REQ);
-    }
-    EXPECT_SUCCESS(s2n_handshake_read_io(client_conn));
-
     EXPECT_EQUAL(client_conn->handshake.handshake_type, NEGOTIATED | FULL_HANDSHAKE | CLIENT_AUTH | MIDDLEBOX_COMPAT);
 
-    /* Client reads ServerCert */
-    EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), SERVER_CERT);
-    EXPECT_SUCCESS(s2n_handshake_read_io(client_conn));
-
-    /* Client reads CertVerify */
-    EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), SERVER_CERT_VERIFY);
-    EXPECT_SUCCESS(s2n_handshake_read_io(client_conn));
-
-    /* Client reads ServerFinished */
-    EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), SERVER_FINISHED);
-    EXPECT_SUCCESS(s2n_handshake_read_io(client_conn));
-
     /* Client sends CCS */
     EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), CLIENT_CHANGE_CIPHER_SPEC);
     EXPECT_SUCCESS(s2n_handshake_write_io(client_conn));
@@ -266,7 +248,7 @@ int s2n_test_client_auth_message_by_message(bool no_cert)
     EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn), CLIENT_CERT);
     EXPECT_SUCCESS(s2n_handshake_read_io(server_conn));
 
-    /* Server reads ClientCert */
+    /* Server reads ClientCert, CertVerify and ClientFinished from one record */
     EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn), CLIENT_CERT);
     EXPECT_SUCCESS(s2n_handshake_read_io(server_conn));
 
@@ -274,16 +256,8 @@ int s2n_test_client_auth_message_by_message(bool no_cert)
         EXPECT_EQUAL(server_conn->handshake.handshake_type, NEGOTIATED | FULL_HANDSHAKE | CLIENT_AUTH | NO_CLIENT_CERT | MIDDLEBOX_COMPAT);
     } else {
         EXPECT_EQUAL(server_conn->handshake.handshake_type, NEGOTIATED | FULL_HANDSHAKE | CLIENT_AUTH | MIDDLEBOX_COMPAT);
-
-        /* Server reads CertVerify */
-        EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn), CLIENT_CERT_VERIFY);
-        EXPECT_SUCCESS(s2n_handshake_read_io(server_conn));
     }
 
-    /* Server reads ClientFinished */
-    EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn), CLIENT_FINISHED);
-    EXPECT_SUCCESS(s2n_handshake_read_io(server_conn));
-
     EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), APPLICATION_DATA);
     EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn), APPLICATION_DATA);
 
@@ -0,0 +1,206 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <stddef.h>
+#include <unistd.h>
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_record.h"
+
+#define S2N_TEST_CACHE_LINE_SIZE 64
+
+/* The fields read on every record must not be pushed out of the first few cache lines */
+#define S2N_TEST_HOT_CACHE_LINES 5
+
+#define S2N_TEST_FIELD_END(type, field) (offsetof(type, field) + sizeof(((type *) NULL)->field))
+
+static int s2n_test_negotiate(struct s2n_config *config, struct s2n_connection *server_conn,
+        struct s2n_connection *client_conn, struct s2n_test_io_pair *io_pair)
+{
+    POSIX_GUARD(s2n_connection_set_config(server_conn, config));
+    POSIX_GUARD(s2n_connection_set_config(client_conn, config));
+    POSIX_GUARD(s2n_io_pair_init_non_blocking(io_pair));
+    POSIX_GUARD(s2n_connections_set_io_pair(client_conn, server_conn, io_pair));
+    POSIX_GUARD(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+    return S2N_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    /* The record path fields are grouped at the front of the connection */
+    {
+        const size_t hot_limit = S2N_TEST_HOT_CACHE_LINES * S2N_TEST_CACHE_LINE_SIZE;
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_connection, in) <= hot_limit);
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_connection, out) <= hot_limit);
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_connection, header_in) <= hot_limit);
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_connection, in_status) <= hot_limit);
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_connection, wire_bytes_in) <= hot_limit);
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_connection, wire_bytes_out) <= hot_limit);
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_connection, client) <= hot_limit);
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_connection, server) <= hot_limit);
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_connection, closed) <= hot_limit);
+
+        /* Handshake and configuration state comes after the crypto parameters */
+        EXPECT_TRUE(offsetof(struct s2n_connection, secure) >= hot_limit);
+        EXPECT_TRUE(offsetof(struct s2n_connection, handshake) > offsetof(struct s2n_connection, secure));
+        EXPECT_TRUE(offsetof(struct s2n_connection, client_hello) > offsetof(struct s2n_connection, handshake));
+        EXPECT_TRUE(offsetof(struct s2n_connection, server_name) > offsetof(struct s2n_connection, handshake));
+    }
+
+    /* The crypto parameters used to protect records come first */
+    {
+        const size_t record_fields_end = S2N_TEST_FIELD_END(struct s2n_crypto_parameters, record_mac_copy_workspace);
+        EXPECT_EQUAL(offsetof(struct s2n_crypto_parameters, cipher_suite), 0);
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_crypto_parameters, client_sequence_number) <= S2N_TEST_CACHE_LINE_SIZE);
+        EXPECT_TRUE(S2N_TEST_FIELD_END(struct s2n_crypto_parameters, server_sequence_number) <= S2N_TEST_CACHE_LINE_SIZE);
+        EXPECT_TRUE(record_fields_end <= offsetof(struct s2n_crypto_parameters, server_public_key));
+        EXPECT_TRUE(record_fields_end <= offsetof(struct s2n_crypto_parameters, master_secret));
+    }
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_TEST_CERT_CHAIN, S2N_DEFAULT_TEST_PRIVATE_KEY));
+
+    const uint8_t protocol_versions[] = { S2N_TLS12, S2N_TLS13 };
+    for (size_t i = 0; i < s2n_array_len(protocol_versions); i++) {
+        if (protocol_versions[i] == S2N_TLS13) {
+            EXPECT_SUCCESS(s2n_enable_tls13());
+        } else {
+            EXPECT_SUCCESS(s2n_disable_tls13());
+        }
+
+        struct s2n_config *config = NULL;
+        EXPECT_NOT_NULL(config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_set_cipher_preferences(config, "default_tls13"));
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(config, chain_and_key));
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(config));
+
+        struct s2n_connection *server_conn = NULL, *client_conn = NULL;
+        EXPECT_NOT_NULL(server_conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_NOT_NULL(client_conn = s2n_connection_new(S2N_CLIENT));
+        struct s2n_connection *conns[] = { server_conn, client_conn };
+
+        /* Handshake-only state is allocated with the connection */
+        for (size_t j = 0; j < s2n_array_len(conns); j++) {
+            EXPECT_NOT_NULL(conns[j]->initial);
+            EXPECT_NOT_NULL(conns[j]->prf_space);
+            EXPECT_NOT_NULL(conns[j]->handshake.hashes);
+            EXPECT_EQUAL(conns[j]->client, conns[j]->initial);
+            EXPECT_EQUAL(conns[j]->server, conns[j]->initial);
+        }
+
+        /* Handshake-only state survives an incomplete handshake */
+        for (size_t j = 0; j < s2n_array_len(conns); j++) {
+            EXPECT_SUCCESS(s2n_connection_free_handshake(conns[j]));
+            EXPECT_NOT_NULL(conns[j]->initial);
+            EXPECT_NOT_NULL(conns[j]->prf_space);
+            EXPECT_NOT_NULL(conns[j]->handshake.hashes);
+        }
+
+        struct s2n_test_io_pair io_pair = { 0 };
+        EXPECT_SUCCESS(s2n_test_negotiate(config, server_conn, client_conn, &io_pair));
+        EXPECT_EQUAL(server_conn->actual_protocol_version, protocol_versions[i]);
+
+        /* Handshake-only state is released once the handshake completes */
+        for (size_t j = 0; j < s2n_array_len(conns); j++) {
+            EXPECT_SUCCESS(s2n_connection_free_handshake(conns[j]));
+            EXPECT_NULL(conns[j]->initial);
+            EXPECT_NULL(conns[j]->prf_space);
+            EXPECT_NULL(conns[j]->handshake.hashes);
+            EXPECT_EQUAL(conns[j]->client, &conns[j]->secure);
+            EXPECT_EQUAL(conns[j]->server, &conns[j]->secure);
+
+            /* Freeing again is a no-op */
+            EXPECT_SUCCESS(s2n_connection_free_handshake(conns[j]));
+        }
+
+        /* Application data still flows */
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        uint8_t message[] = "layout";
+        uint8_t received[sizeof(message)] = { 0 };
+        EXPECT_EQUAL(s2n_send(client_conn, message, sizeof(message), &blocked), sizeof(message));
+        EXPECT_EQUAL(s2n_recv(server_conn, received, sizeof(received), &blocked), sizeof(received));
+        EXPECT_BYTEARRAY_EQUAL(received, message, sizeof(message));
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+
+        /* Wiping restores the released state so the connection can be reused */
+        for (size_t j = 0; j < s2n_array_len(conns); j++) {
+            EXPECT_SUCCESS(s2n_connection_wipe(conns[j]));
+            EXPECT_NOT_NULL(conns[j]->initial);
+            EXPECT_NOT_NULL(conns[j]->prf_space);
+            EXPECT_NOT_NULL(conns[j]->handshake.hashes);
+            EXPECT_EQUAL(conns[j]->client, conns[j]->initial);
+            EXPECT_EQUAL(conns[j]->server, conns[j]->initial);
+        }
+        EXPECT_SUCCESS(s2n_test_negotiate(config, server_conn, client_conn, &io_pair));
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* Once the handshake state is released, a TLS1.3 plaintext record is a bad record */
+    {
+        EXPECT_SUCCESS(s2n_enable_tls13());
+
+        struct s2n_config *config = NULL;
+        EXPECT_NOT_NULL(config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_set_cipher_preferences(config, "default_tls13"));
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(config, chain_and_key));
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(config));
+
+        struct s2n_connection *server_conn = NULL, *client_conn = NULL;
+        EXPECT_NOT_NULL(server_conn = s2n_connection_new(S2N_SERVER));
+        EXPECT_NOT_NULL(client_conn = s2n_connection_new(S2N_CLIENT));
+
+        struct s2n_test_io_pair io_pair = { 0 };
+        EXPECT_SUCCESS(s2n_test_negotiate(config, server_conn, client_conn, &io_pair));
+        EXPECT_EQUAL(server_conn->actual_protocol_version, S2N_TLS13);
+        EXPECT_SUCCESS(s2n_connection_free_handshake(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free_handshake(client_conn));
+        EXPECT_NULL(server_conn->initial);
+
+        /* A plaintext warning-level close_notify alert */
+        const uint8_t alert_record[] = { TLS_ALERT, 0x03, 0x03, 0x00, 0x02, 0x01, 0x00 };
+        EXPECT_EQUAL(write(io_pair.client, alert_record, sizeof(alert_record)), sizeof(alert_record));
+
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        uint8_t received[1] = { 0 };
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv(server_conn, received, sizeof(received), &blocked), S2N_ERR_BAD_MESSAGE);
+
+        /* Nor can a plaintext CCS be sent */
+        struct iovec ccs = { .iov_base = (void *) alert_record, .iov_len = 1 };
+        EXPECT_FAILURE_WITH_ERRNO(s2n_record_writev(client_conn, TLS_CHANGE_CIPHER_SPEC, &ccs, 1, 0, 1), S2N_ERR_BAD_MESSAGE);
+
+        EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    EXPECT_SUCCESS(s2n_disable_tls13());
+
+    END_TEST();
+}
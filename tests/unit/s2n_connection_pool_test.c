@@ -0,0 +1,213 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <sys/param.h>
+#include <pthread.h>
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_connection_pool.h"
+
+#define S2N_TEST_POOL_SIZE 4
+#define S2N_TEST_THREAD_COUNT 4
+#define S2N_TEST_THREAD_ITERATIONS 100
+
+static uint32_t s2n_test_pool_idle_count(struct s2n_connection_pool *pool)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < pool->shard_count; i++) {
+        count += pool->shards[i].count;
+    }
+    return count;
+}
+
+static void *s2n_test_pool_worker(void *arg)
+{
+    struct s2n_connection_pool *pool = (struct s2n_connection_pool *) arg;
+    for (size_t i = 0; i < S2N_TEST_THREAD_ITERATIONS; i++) {
+        struct s2n_connection *conn = s2n_connection_pool_acquire(pool);
+        if (conn == NULL) {
+            return (void *) -1;
+        }
+        conn->context = arg;
+        if (s2n_connection_pool_release(pool, conn) != S2N_SUCCESS) {
+            return (void *) -1;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+    struct s2n_config *server_config = s2n_config_new();
+    EXPECT_NOT_NULL(server_config);
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+
+    struct s2n_config *client_config = s2n_config_new();
+    EXPECT_NOT_NULL(client_config);
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    /* Safety */
+    {
+        EXPECT_NULL_WITH_ERRNO(s2n_connection_pool_new(NULL, S2N_SERVER, 1), S2N_ERR_NULL);
+        EXPECT_NULL_WITH_ERRNO(s2n_connection_pool_new(server_config, S2N_SERVER, 0), S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_NULL_WITH_ERRNO(s2n_connection_pool_acquire(NULL), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_pool_free(NULL), S2N_ERR_NULL);
+
+        struct s2n_connection_pool *pool = s2n_connection_pool_new(server_config, S2N_SERVER, 1);
+        EXPECT_NOT_NULL(pool);
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_pool_release(NULL, client_conn), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_pool_release(pool, NULL), S2N_ERR_NULL);
+
+        /* Connections of the wrong mode are rejected, and still owned by the caller */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_pool_release(pool, client_conn), S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+
+        EXPECT_SUCCESS(s2n_connection_pool_free(pool));
+    }
+
+    /* The pool is filled when it is created and spread across shards */
+    {
+        for (uint32_t size = 1; size <= S2N_CONNECTION_POOL_MAX_SHARDS * 2 + 1; size++) {
+            struct s2n_connection_pool *pool = s2n_connection_pool_new(server_config, S2N_SERVER, size);
+            EXPECT_NOT_NULL(pool);
+            EXPECT_EQUAL(pool->shard_count, MIN(size, S2N_CONNECTION_POOL_MAX_SHARDS));
+            EXPECT_EQUAL(s2n_test_pool_idle_count(pool), size);
+
+            uint32_t capacity = 0;
+            for (uint32_t i = 0; i < pool->shard_count; i++) {
+                EXPECT_TRUE(pool->shards[i].count > 0);
+                EXPECT_EQUAL(pool->shards[i].count, pool->shards[i].capacity);
+                capacity += pool->shards[i].capacity;
+            }
+            EXPECT_EQUAL(capacity, size);
+
+            EXPECT_SUCCESS(s2n_connection_pool_free(pool));
+        }
+    }
+
+    /* Connections are recycled */
+    {
+        struct s2n_connection_pool *server_pool = s2n_connection_pool_new(server_config, S2N_SERVER, S2N_TEST_POOL_SIZE);
+        EXPECT_NOT_NULL(server_pool);
+        struct s2n_connection_pool *client_pool = s2n_connection_pool_new(client_config, S2N_CLIENT, S2N_TEST_POOL_SIZE);
+        EXPECT_NOT_NULL(client_pool);
+
+        struct s2n_connection *first_server_conn = NULL;
+        for (size_t i = 0; i < 3; i++) {
+            struct s2n_connection *server_conn = s2n_connection_pool_acquire(server_pool);
+            EXPECT_NOT_NULL(server_conn);
+            EXPECT_EQUAL(server_conn->mode, S2N_SERVER);
+            EXPECT_EQUAL(server_conn->config, server_config);
+            EXPECT_NULL(server_conn->context);
+            EXPECT_EQUAL(s2n_test_pool_idle_count(server_pool), S2N_TEST_POOL_SIZE - 1);
+
+            /* The same connection is handed out again after it is released */
+            if (first_server_conn) {
+                EXPECT_EQUAL(server_conn, first_server_conn);
+            }
+            first_server_conn = server_conn;
+
+            struct s2n_connection *client_conn = s2n_connection_pool_acquire(client_pool);
+            EXPECT_NOT_NULL(client_conn);
+            EXPECT_EQUAL(client_conn->mode, S2N_CLIENT);
+            EXPECT_EQUAL(client_conn->config, client_config);
+
+            EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, "default_tls13"));
+            EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, "default_tls13"));
+            EXPECT_SUCCESS(s2n_connection_set_ctx(server_conn, server_pool));
+
+            DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+            DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+            EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+            EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+            EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+            EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+            EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+            EXPECT_EQUAL(s2n_connection_get_actual_protocol_version(server_conn), S2N_TLS13);
+
+            /* Config changes made while the connection was in use are undone */
+            EXPECT_SUCCESS(s2n_connection_set_config(server_conn, client_config));
+
+            EXPECT_SUCCESS(s2n_connection_pool_release(server_pool, server_conn));
+            EXPECT_SUCCESS(s2n_connection_pool_release(client_pool, client_conn));
+            EXPECT_EQUAL(s2n_test_pool_idle_count(server_pool), S2N_TEST_POOL_SIZE);
+        }
+
+        EXPECT_SUCCESS(s2n_connection_pool_free(server_pool));
+        EXPECT_SUCCESS(s2n_connection_pool_free(client_pool));
+    }
+
+    /* The pool grows on demand but never keeps more than its size */
+    {
+        struct s2n_connection_pool *pool = s2n_connection_pool_new(server_config, S2N_SERVER, S2N_TEST_POOL_SIZE);
+        EXPECT_NOT_NULL(pool);
+
+        struct s2n_connection *conns[S2N_TEST_POOL_SIZE * 2] = { 0 };
+        for (size_t i = 0; i < s2n_array_len(conns); i++) {
+            conns[i] = s2n_connection_pool_acquire(pool);
+            EXPECT_NOT_NULL(conns[i]);
+        }
+        EXPECT_EQUAL(s2n_test_pool_idle_count(pool), 0);
+
+        for (size_t i = 0; i < s2n_array_len(conns); i++) {
+            EXPECT_SUCCESS(s2n_connection_pool_release(pool, conns[i]));
+        }
+        EXPECT_EQUAL(s2n_test_pool_idle_count(pool), S2N_TEST_POOL_SIZE);
+
+        /* Acquired connections outlive the pool */
+        struct s2n_connection *conn = s2n_connection_pool_acquire(pool);
+        EXPECT_NOT_NULL(conn);
+        EXPECT_SUCCESS(s2n_connection_pool_free(pool));
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+    /* The pool can be shared between threads */
+    {
+        struct s2n_connection_pool *pool = s2n_connection_pool_new(server_config, S2N_SERVER, S2N_TEST_POOL_SIZE);
+        EXPECT_NOT_NULL(pool);
+
+        pthread_t threads[S2N_TEST_THREAD_COUNT];
+        for (size_t i = 0; i < S2N_TEST_THREAD_COUNT; i++) {
+            EXPECT_SUCCESS(pthread_create(&threads[i], NULL, s2n_test_pool_worker, pool));
+        }
+        for (size_t i = 0; i < S2N_TEST_THREAD_COUNT; i++) {
+            void *result = NULL;
+            EXPECT_SUCCESS(pthread_join(threads[i], &result));
+            EXPECT_NULL(result);
+        }
+        EXPECT_EQUAL(s2n_test_pool_idle_count(pool), S2N_TEST_POOL_SIZE);
+
+        EXPECT_SUCCESS(s2n_connection_pool_free(pool));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    END_TEST();
+}
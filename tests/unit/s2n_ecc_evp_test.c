@@ -80,6 +80,20 @@ int main(int argc, char **argv) {
             EXPECT_EQUAL(client_shared.size, server_shared.size);
             EXPECT_BYTEARRAY_EQUAL(client_shared.data, server_shared.data, client_shared.size);
 
+            /* The caller can provide the memory for the shared secret, which is shrunk to fit */
+            uint8_t provided_data[S2N_ECC_EVP_MAX_SHARED_SECRET_SIZE] = { 0 };
+            struct s2n_blob provided = { 0 };
+            EXPECT_SUCCESS(s2n_blob_init(&provided, provided_data, sizeof(provided_data)));
+            EXPECT_SUCCESS(s2n_ecc_evp_compute_shared_secret_from_params(&client_params, &server_params, &provided));
+            EXPECT_EQUAL(provided.data, provided_data);
+            EXPECT_EQUAL(provided.size, client_shared.size);
+            EXPECT_BYTEARRAY_EQUAL(provided.data, client_shared.data, client_shared.size);
+
+            /* Provided memory that is too small is rejected */
+            EXPECT_SUCCESS(s2n_blob_init(&provided, provided_data, client_shared.size - 1));
+            EXPECT_FAILURE_WITH_ERRNO(s2n_ecc_evp_compute_shared_secret_from_params(&client_params, &server_params, &provided),
+                    S2N_ERR_ECDHE_SHARED_SECRET);
+
             /* Clean up */
             EXPECT_SUCCESS(s2n_free(&server_shared));
             EXPECT_SUCCESS(s2n_free(&client_shared));
@@ -257,7 +271,7 @@ int main(int argc, char **argv) {
             struct s2n_ecc_evp_params client_params = {0}; 
             struct s2n_stuffer wire;
             struct s2n_blob ecdh_params_sent, ecdh_params_received;
-            struct s2n_blob server_shared_secret, client_shared_secret;
+            struct s2n_blob server_shared_secret = { 0 }, client_shared_secret = { 0 };
 
             EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&wire, 1024));
 
@@ -310,7 +324,8 @@ int main(int argc, char **argv) {
     for (int i = 0; i < s2n_all_supported_curves_list_len; i++) {
             struct s2n_ecc_evp_params server_params = {0}, client_params = {0};
             struct s2n_stuffer wire;
-            struct s2n_blob server_shared, client_shared, ecdh_params_sent, ecdh_params_received;
+            struct s2n_blob server_shared = { 0 }, client_shared = { 0 };
+            struct s2n_blob ecdh_params_sent, ecdh_params_received;
 
             EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&wire, 1024));
 
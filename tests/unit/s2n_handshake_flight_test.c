@@ -0,0 +1,132 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_handshake.h"
+#include "tls/s2n_record.h"
+
+static int s2n_count_records(struct s2n_stuffer *stuffer, uint8_t record_type, uint32_t *count)
+{
+    *count = 0;
+    uint32_t offset = stuffer->read_cursor;
+    while (offset + S2N_TLS_RECORD_HEADER_LENGTH <= stuffer->write_cursor) {
+        uint8_t *header = stuffer->blob.data + offset;
+        if (header[0] == record_type) {
+            (*count)++;
+        }
+        offset += S2N_TLS_RECORD_HEADER_LENGTH + ((header[3] << 8) | header[4]);
+    }
+    POSIX_ENSURE_EQ(offset, stuffer->write_cursor);
+    return S2N_SUCCESS;
+}
+
+static int s2n_test_server_flight(struct s2n_config *config, uint8_t protocol_version,
+        uint32_t expected_handshake_records, uint32_t expected_encrypted_records)
+{
+    struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+    POSIX_ENSURE_REF(server_conn);
+    POSIX_GUARD(s2n_connection_set_config(server_conn, config));
+
+    struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+    POSIX_ENSURE_REF(client_conn);
+    POSIX_GUARD(s2n_connection_set_config(client_conn, config));
+
+    DEFER_CLEANUP(struct s2n_stuffer client_to_server = { 0 }, s2n_stuffer_free);
+    DEFER_CLEANUP(struct s2n_stuffer server_to_client = { 0 }, s2n_stuffer_free);
+    POSIX_GUARD(s2n_stuffer_growable_alloc(&client_to_server, 0));
+    POSIX_GUARD(s2n_stuffer_growable_alloc(&server_to_client, 0));
+    POSIX_GUARD(s2n_connection_set_io_stuffers(&server_to_client, &client_to_server, client_conn));
+    POSIX_GUARD(s2n_connection_set_io_stuffers(&client_to_server, &server_to_client, server_conn));
+
+    /* Client sends ClientHello */
+    s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+    POSIX_ENSURE(s2n_negotiate(client_conn, &blocked) < S2N_SUCCESS, S2N_ERR_SAFETY);
+    POSIX_ENSURE_EQ(s2n_errno, S2N_ERR_IO_BLOCKED);
+
+    /* Server sends its whole flight, then waits for the client */
+    POSIX_ENSURE(s2n_negotiate(server_conn, &blocked) < S2N_SUCCESS, S2N_ERR_SAFETY);
+    POSIX_ENSURE_EQ(s2n_errno, S2N_ERR_IO_BLOCKED);
+    POSIX_ENSURE_EQ(blocked, S2N_BLOCKED_ON_READ);
+    POSIX_ENSURE_EQ(s2n_connection_get_actual_protocol_version(server_conn), protocol_version);
+
+    /* Nothing is left behind for a later flush */
+    POSIX_ENSURE_EQ(s2n_stuffer_data_available(&server_conn->out), 0);
+    POSIX_ENSURE_EQ(s2n_stuffer_data_available(&server_conn->handshake.flight), 0);
+    POSIX_ENSURE(!server_conn->handshake.flight_queued, S2N_ERR_SAFETY);
+
+    /* Before TLS1.3 every message of the flight is a plaintext handshake message.
+     * In TLS1.3 everything after the ServerHello is encrypted. */
+    uint32_t handshake_records = 0, encrypted_records = 0;
+    POSIX_GUARD(s2n_count_records(&server_to_client, TLS_HANDSHAKE, &handshake_records));
+    POSIX_GUARD(s2n_count_records(&server_to_client, TLS_APPLICATION_DATA, &encrypted_records));
+    POSIX_ENSURE_EQ(handshake_records, expected_handshake_records);
+    POSIX_ENSURE_EQ(encrypted_records, expected_encrypted_records);
+
+    /* The rest of the handshake still succeeds */
+    POSIX_GUARD(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+    POSIX_GUARD(s2n_connection_free(server_conn));
+    POSIX_GUARD(s2n_connection_free(client_conn));
+    return S2N_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    struct s2n_cert_chain_and_key *rsa_chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&rsa_chain_and_key,
+            S2N_DEFAULT_TEST_CERT_CHAIN, S2N_DEFAULT_TEST_PRIVATE_KEY));
+
+    struct s2n_cert_chain_and_key *ecdsa_chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&ecdsa_chain_and_key,
+            S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+    /* TLS1.2: ServerHello, Certificate, ServerKeyExchange and ServerHelloDone share one record */
+    {
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(config, rsa_chain_and_key));
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(config));
+        EXPECT_SUCCESS(s2n_config_set_cipher_preferences(config, "20170210"));
+
+        EXPECT_SUCCESS(s2n_test_server_flight(config, S2N_TLS12, 1, 0));
+
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* TLS1.3: the ServerHello is written with the plaintext keys, and everything
+     * from EncryptedExtensions to ServerFinished shares one encrypted record */
+    {
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(config, ecdsa_chain_and_key));
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(config));
+        EXPECT_SUCCESS(s2n_config_set_cipher_preferences(config, "default_tls13"));
+
+        EXPECT_SUCCESS(s2n_test_server_flight(config, S2N_TLS13, 1, 1));
+
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(rsa_chain_and_key));
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(ecdsa_chain_and_key));
+    END_TEST();
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <s2n.h>
+
+#include "crypto/s2n_hash.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_handshake.h"
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    uint8_t message[] = "handshake message";
+    struct s2n_blob message_blob = { 0 };
+    EXPECT_SUCCESS(s2n_blob_init(&message_blob, message, sizeof(message)));
+
+    uint8_t expected[SHA256_DIGEST_LENGTH] = { 0 };
+    uint8_t actual[SHA256_DIGEST_LENGTH] = { 0 };
+    {
+        DEFER_CLEANUP(struct s2n_hash_state hash = { 0 }, s2n_hash_free);
+        EXPECT_SUCCESS(s2n_hash_new(&hash));
+        EXPECT_SUCCESS(s2n_hash_init(&hash, S2N_HASH_SHA256));
+        EXPECT_SUCCESS(s2n_hash_update(&hash, message, sizeof(message)));
+        EXPECT_SUCCESS(s2n_hash_update(&hash, message, sizeof(message)));
+        EXPECT_SUCCESS(s2n_hash_digest(&hash, expected, sizeof(expected)));
+    }
+
+    /* Safety */
+    EXPECT_ERROR_WITH_ERRNO(s2n_handshake_transcript_flush(NULL), S2N_ERR_NULL);
+
+    /* Messages are buffered until the required hashes are known */
+    {
+        struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(conn);
+        EXPECT_TRUE(conn->handshake.transcript_buffering);
+
+        EXPECT_SUCCESS(s2n_conn_update_handshake_hashes(conn, &message_blob));
+        EXPECT_EQUAL(s2n_stuffer_data_available(&conn->handshake.transcript_buffer), sizeof(message));
+        EXPECT_EQUAL(conn->handshake.hashes->sha256.alg, S2N_HASH_NONE);
+        EXPECT_EQUAL(conn->handshake.hashes->sha384.alg, S2N_HASH_NONE);
+
+        /* Only the required hash is created and caught up */
+        memset(conn->handshake.required_hash_algs, 0, sizeof(conn->handshake.required_hash_algs));
+        conn->handshake.required_hash_algs[S2N_HASH_SHA256] = 1;
+        EXPECT_OK(s2n_handshake_transcript_flush(conn));
+        EXPECT_FALSE(conn->handshake.transcript_buffering);
+        EXPECT_EQUAL(s2n_stuffer_data_available(&conn->handshake.transcript_buffer), 0);
+        EXPECT_EQUAL(conn->handshake.hashes->sha256.alg, S2N_HASH_SHA256);
+        EXPECT_EQUAL(conn->handshake.hashes->sha384.alg, S2N_HASH_NONE);
+        EXPECT_EQUAL(conn->handshake.hashes->md5_sha1.alg, S2N_HASH_NONE);
+
+        /* Later messages go straight into the hash */
+        EXPECT_SUCCESS(s2n_conn_update_handshake_hashes(conn, &message_blob));
+        EXPECT_EQUAL(s2n_stuffer_data_available(&conn->handshake.transcript_buffer), 0);
+
+        struct s2n_hash_state hash_state = { 0 };
+        EXPECT_SUCCESS(s2n_handshake_get_hash_state(conn, S2N_HASH_SHA256, &hash_state));
+        EXPECT_SUCCESS(s2n_hash_copy(&conn->handshake.hashes->prf_tls12_hash_copy, &hash_state));
+        EXPECT_SUCCESS(s2n_hash_digest(&conn->handshake.hashes->prf_tls12_hash_copy, actual, sizeof(actual)));
+        EXPECT_BYTEARRAY_EQUAL(actual, expected, sizeof(expected));
+
+        /* Wiping the connection starts buffering again */
+        EXPECT_SUCCESS(s2n_connection_wipe(conn));
+        EXPECT_TRUE(conn->handshake.transcript_buffering);
+        EXPECT_EQUAL(s2n_stuffer_data_available(&conn->handshake.transcript_buffer), 0);
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+    /* Reading a transcript hash before the required hashes are known catches up every hash */
+    {
+        struct s2n_connection *conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(conn);
+
+        EXPECT_SUCCESS(s2n_conn_update_handshake_hashes(conn, &message_blob));
+        EXPECT_SUCCESS(s2n_conn_update_handshake_hashes(conn, &message_blob));
+
+        struct s2n_hash_state hash_state = { 0 };
+        EXPECT_SUCCESS(s2n_handshake_get_hash_state(conn, S2N_HASH_SHA256, &hash_state));
+        EXPECT_FALSE(conn->handshake.transcript_buffering);
+        EXPECT_EQUAL(conn->handshake.hashes->sha384.alg, S2N_HASH_SHA384);
+        EXPECT_EQUAL(conn->handshake.hashes->md5_sha1.alg, S2N_HASH_MD5_SHA1);
+
+        EXPECT_SUCCESS(s2n_hash_copy(&conn->handshake.hashes->prf_tls12_hash_copy, &hash_state));
+        EXPECT_SUCCESS(s2n_hash_digest(&conn->handshake.hashes->prf_tls12_hash_copy, actual, sizeof(actual)));
+        EXPECT_BYTEARRAY_EQUAL(actual, expected, sizeof(expected));
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+    /* A TLS1.3 handshake only creates the hash used by the cipher suite */
+    {
+        struct s2n_cert_chain_and_key *chain_and_key = NULL;
+        EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+                S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(config, chain_and_key));
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(config));
+        EXPECT_SUCCESS(s2n_config_set_cipher_preferences(config, "default_tls13"));
+
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, config));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, config));
+
+        DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+        DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_EQUAL(s2n_connection_get_actual_protocol_version(server_conn), S2N_TLS13);
+
+        struct s2n_connection *conns[] = { server_conn, client_conn };
+        for (size_t i = 0; i < s2n_array_len(conns); i++) {
+            struct s2n_handshake *handshake = &conns[i]->handshake;
+            EXPECT_FALSE(handshake->transcript_buffering);
+            EXPECT_EQUAL(handshake->hashes->md5.alg, S2N_HASH_NONE);
+            EXPECT_EQUAL(handshake->hashes->sha1.alg, S2N_HASH_NONE);
+            EXPECT_EQUAL(handshake->hashes->md5_sha1.alg, S2N_HASH_NONE);
+            EXPECT_EQUAL(handshake->hashes->sha224.alg, S2N_HASH_NONE);
+            EXPECT_EQUAL(handshake->hashes->sha512.alg, S2N_HASH_NONE);
+        }
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_config_free(config));
+        EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    }
+
+    END_TEST();
+}
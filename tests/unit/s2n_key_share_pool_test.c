@@ -0,0 +1,282 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <s2n.h>
+
+#include "tls/s2n_config.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_key_share_pool.h"
+
+#define TEST_KEYS_PER_CURVE 4
+
+static uint32_t s2n_test_pool_key_count(struct s2n_key_share_pool *pool)
+{
+    uint32_t count = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (uint32_t i = 0; i < pool->ring_count; i++) {
+        count += pool->rings[i].count;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return count;
+}
+
+static int s2n_test_wait_for_full_pool(struct s2n_key_share_pool *pool)
+{
+    /* Give the workers up to ten seconds */
+    for (int i = 0; i < 1000; i++) {
+        if (s2n_test_pool_key_count(pool) == pool->ring_count * pool->capacity) {
+            return S2N_SUCCESS;
+        }
+        usleep(10000);
+    }
+    POSIX_BAIL(S2N_ERR_SAFETY);
+}
+
+static const struct s2n_ecc_named_curve *s2n_test_real_curve = NULL;
+static uint32_t s2n_test_generate_failures = 0;
+
+static int s2n_test_failing_generate_key(const struct s2n_ecc_named_curve *curve, EVP_PKEY **evp_pkey)
+{
+    if (s2n_test_generate_failures > 0) {
+        s2n_test_generate_failures--;
+        POSIX_BAIL(S2N_ERR_ECDHE_GEN_KEY);
+    }
+    return s2n_test_real_curve->generate_key(s2n_test_real_curve, evp_pkey);
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    /* Safety */
+    {
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_key_share_pool(NULL, TEST_KEYS_PER_CURVE, 1), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_key_share_pool(config, TEST_KEYS_PER_CURVE, 0), S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_NULL(config->key_share_pool);
+
+        /* Zero keys disables the pool */
+        EXPECT_SUCCESS(s2n_config_set_key_share_pool(config, 0, 0));
+        EXPECT_NULL(config->key_share_pool);
+
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* The workers fill a ring for every supported curve */
+    {
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+
+        EXPECT_SUCCESS(s2n_config_set_key_share_pool(config, TEST_KEYS_PER_CURVE, 2));
+        struct s2n_key_share_pool *pool = config->key_share_pool;
+        EXPECT_NOT_NULL(pool);
+        EXPECT_EQUAL(pool->ring_count, s2n_all_supported_curves_list_len);
+        EXPECT_SUCCESS(s2n_test_wait_for_full_pool(pool));
+
+        /* Each key is handed out exactly once, and the workers replace it */
+        for (size_t i = 0; i < s2n_all_supported_curves_list_len; i++) {
+            struct s2n_key_share_pool_ring *ring = &pool->rings[i];
+            EXPECT_EQUAL(ring->curve, s2n_all_supported_curves_list[i]);
+
+            pthread_mutex_lock(&pool->lock);
+            EVP_PKEY *next_key = ring->keys[ring->head];
+            pthread_mutex_unlock(&pool->lock);
+
+            struct s2n_ecc_evp_params first = { .negotiated_curve = ring->curve };
+            EXPECT_SUCCESS(s2n_key_share_pool_generate_key(config, &first));
+            EXPECT_EQUAL(first.evp_pkey, next_key);
+
+            struct s2n_ecc_evp_params second = { .negotiated_curve = ring->curve };
+            EXPECT_SUCCESS(s2n_key_share_pool_generate_key(config, &second));
+            EXPECT_NOT_NULL(second.evp_pkey);
+            EXPECT_NOT_EQUAL(second.evp_pkey, first.evp_pkey);
+
+            /* The pooled keys are usable */
+            struct s2n_blob shared_key = { 0 };
+            EXPECT_SUCCESS(s2n_ecc_evp_compute_shared_secret_from_params(&first, &second, &shared_key));
+            EXPECT_SUCCESS(s2n_free(&shared_key));
+
+            /* A key is never replaced */
+            EXPECT_FAILURE_WITH_ERRNO(s2n_key_share_pool_generate_key(config, &first), S2N_ERR_ECDHE_GEN_KEY);
+
+            EXPECT_SUCCESS(s2n_ecc_evp_params_free(&first));
+            EXPECT_SUCCESS(s2n_ecc_evp_params_free(&second));
+        }
+        EXPECT_SUCCESS(s2n_test_wait_for_full_pool(pool));
+
+        /* Connections may be using the pool, so it can't be replaced or disabled */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_key_share_pool(config, TEST_KEYS_PER_CURVE, 1), S2N_ERR_INVALID_STATE);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_key_share_pool(config, 0, 0), S2N_ERR_INVALID_STATE);
+        EXPECT_EQUAL(config->key_share_pool, pool);
+
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* A worker keeps going after a key fails to generate */
+    {
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+        EXPECT_SUCCESS(s2n_config_set_key_share_pool(config, TEST_KEYS_PER_CURVE, 1));
+        struct s2n_key_share_pool *pool = config->key_share_pool;
+        EXPECT_SUCCESS(s2n_test_wait_for_full_pool(pool));
+
+        struct s2n_key_share_pool_ring *ring = &pool->rings[0];
+        s2n_test_real_curve = ring->curve;
+        const struct s2n_ecc_named_curve failing_curve = {
+            .iana_id = s2n_test_real_curve->iana_id,
+            .libcrypto_nid = s2n_test_real_curve->libcrypto_nid,
+            .name = s2n_test_real_curve->name,
+            .share_size = s2n_test_real_curve->share_size,
+            .generate_key = s2n_test_failing_generate_key,
+        };
+        s2n_test_generate_failures = 3;
+
+        /* Empty the ring and make its next few keys fail */
+        pthread_mutex_lock(&pool->lock);
+        ring->curve = &failing_curve;
+        pthread_mutex_unlock(&pool->lock);
+        for (uint32_t i = 0; i < pool->capacity; i++) {
+            struct s2n_ecc_evp_params params = { .negotiated_curve = &failing_curve };
+            EXPECT_SUCCESS(s2n_key_share_pool_generate_key(config, &params));
+            EXPECT_SUCCESS(s2n_ecc_evp_params_free(&params));
+        }
+
+        EXPECT_SUCCESS(s2n_test_wait_for_full_pool(pool));
+        EXPECT_EQUAL(s2n_test_generate_failures, 0);
+
+        pthread_mutex_lock(&pool->lock);
+        ring->curve = s2n_test_real_curve;
+        pthread_mutex_unlock(&pool->lock);
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* A forked child never hands out the keys it inherited */
+    {
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+        EXPECT_SUCCESS(s2n_config_set_key_share_pool(config, TEST_KEYS_PER_CURVE, 2));
+        struct s2n_key_share_pool *pool = config->key_share_pool;
+        EXPECT_SUCCESS(s2n_test_wait_for_full_pool(pool));
+
+        /* Hold references to the parent's keys so that the child can't allocate a new key at the same address */
+        struct s2n_key_share_pool_ring *ring = &pool->rings[0];
+        EVP_PKEY *inherited[TEST_KEYS_PER_CURVE] = { 0 };
+        pthread_mutex_lock(&pool->lock);
+        for (uint32_t i = 0; i < ring->count; i++) {
+            inherited[i] = ring->keys[(ring->head + i) % pool->capacity];
+            EXPECT_EQUAL(EVP_PKEY_up_ref(inherited[i]), 1);
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            struct s2n_ecc_evp_params params = { .negotiated_curve = ring->curve };
+            EXPECT_SUCCESS(s2n_key_share_pool_generate_key(config, &params));
+            EXPECT_NOT_NULL(params.evp_pkey);
+            for (size_t i = 0; i < s2n_array_len(inherited); i++) {
+                EXPECT_NOT_EQUAL(params.evp_pkey, inherited[i]);
+            }
+            EXPECT_SUCCESS(s2n_ecc_evp_params_free(&params));
+
+            /* The child's own workers fill the pool again */
+            EXPECT_EQUAL(pool->pid, getpid());
+            EXPECT_EQUAL(pool->worker_count, 2);
+            EXPECT_SUCCESS(s2n_test_wait_for_full_pool(pool));
+            EXPECT_SUCCESS(s2n_config_free(config));
+            exit(EXIT_SUCCESS);
+        }
+
+        int status = 0;
+        EXPECT_EQUAL(waitpid(pid, &status, 0), pid);
+        EXPECT_EQUAL(status, EXIT_SUCCESS);
+
+        /* The parent's pool is unaffected */
+        struct s2n_ecc_evp_params params = { .negotiated_curve = ring->curve };
+        EXPECT_SUCCESS(s2n_key_share_pool_generate_key(config, &params));
+        EXPECT_EQUAL(params.evp_pkey, inherited[0]);
+        EXPECT_SUCCESS(s2n_ecc_evp_params_free(&params));
+
+        for (size_t i = 0; i < s2n_array_len(inherited); i++) {
+            EVP_PKEY_free(inherited[i]);
+        }
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* Without a pool, keys are generated inline */
+    {
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+
+        struct s2n_ecc_evp_params params = { .negotiated_curve = &s2n_ecc_curve_secp256r1 };
+        EXPECT_SUCCESS(s2n_key_share_pool_generate_key(config, &params));
+        EXPECT_NOT_NULL(params.evp_pkey);
+        EXPECT_SUCCESS(s2n_ecc_evp_params_free(&params));
+
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* Handshakes use the pooled keys */
+    {
+        struct s2n_cert_chain_and_key *chain_and_key = NULL;
+        EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+                S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+        const char *policies[] = { "20190801", "default_tls13" };
+        for (size_t i = 0; i < s2n_array_len(policies); i++) {
+            struct s2n_config *config = s2n_config_new();
+            EXPECT_NOT_NULL(config);
+            EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(config, chain_and_key));
+            EXPECT_SUCCESS(s2n_config_disable_x509_verification(config));
+            EXPECT_SUCCESS(s2n_config_set_cipher_preferences(config, policies[i]));
+            EXPECT_SUCCESS(s2n_config_set_key_share_pool(config, TEST_KEYS_PER_CURVE, 1));
+            EXPECT_SUCCESS(s2n_test_wait_for_full_pool(config->key_share_pool));
+
+            struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+            EXPECT_NOT_NULL(server_conn);
+            EXPECT_SUCCESS(s2n_connection_set_config(server_conn, config));
+
+            struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+            EXPECT_NOT_NULL(client_conn);
+            EXPECT_SUCCESS(s2n_connection_set_config(client_conn, config));
+
+            struct s2n_test_io_pair io_pair = { 0 };
+            EXPECT_SUCCESS(s2n_io_pair_init_non_blocking(&io_pair));
+            EXPECT_SUCCESS(s2n_connections_set_io_pair(client_conn, server_conn, &io_pair));
+
+            EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+            EXPECT_NOT_NULL(server_conn->secure.server_ecc_evp_params.negotiated_curve);
+
+            /* The workers replace the keys the handshake took */
+            EXPECT_SUCCESS(s2n_test_wait_for_full_pool(config->key_share_pool));
+
+            EXPECT_SUCCESS(s2n_connection_free(server_conn));
+            EXPECT_SUCCESS(s2n_connection_free(client_conn));
+            EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+            EXPECT_SUCCESS(s2n_config_free(config));
+        }
+
+        EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    }
+
+    END_TEST();
+}
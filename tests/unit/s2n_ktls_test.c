@@ -0,0 +1,347 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <s2n.h>
+
+#include "tls/s2n_config.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_ktls.h"
+
+#define S2N_TEST_DATA_SIZE 1000
+
+/* kTLS requires TCP sockets, so connect a client and a server over loopback */
+static int s2n_test_tcp_io_pair_init(struct s2n_test_io_pair *io_pair)
+{
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addr_len = sizeof(addr);
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    POSIX_ENSURE_GTE(listener, 0);
+    POSIX_GUARD(bind(listener, (struct sockaddr *) &addr, sizeof(addr)));
+    POSIX_GUARD(listen(listener, 1));
+    POSIX_GUARD(getsockname(listener, (struct sockaddr *) &addr, &addr_len));
+
+    io_pair->client = socket(AF_INET, SOCK_STREAM, 0);
+    POSIX_ENSURE_GTE(io_pair->client, 0);
+    POSIX_GUARD(connect(io_pair->client, (struct sockaddr *) &addr, sizeof(addr)));
+    io_pair->server = accept(listener, NULL, NULL);
+    POSIX_ENSURE_GTE(io_pair->server, 0);
+    POSIX_GUARD(close(listener));
+
+    POSIX_GUARD(s2n_fd_set_non_blocking(io_pair->client));
+    POSIX_GUARD(s2n_fd_set_non_blocking(io_pair->server));
+    return S2N_SUCCESS;
+}
+
+/* Unlike s2n_negotiate_test_server_and_client, tolerates data that is still in flight between the sockets */
+static int s2n_test_negotiate_over_tcp(struct s2n_connection *server_conn, struct s2n_connection *client_conn)
+{
+    s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+    bool server_done = false, client_done = false;
+    while (!server_done || !client_done) {
+        if (!client_done) {
+            client_done = (s2n_negotiate(client_conn, &blocked) == S2N_SUCCESS);
+            POSIX_ENSURE(client_done || s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED, s2n_errno);
+        }
+        if (!server_done) {
+            server_done = (s2n_negotiate(server_conn, &blocked) == S2N_SUCCESS);
+            POSIX_ENSURE(server_done || s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED, s2n_errno);
+        }
+    }
+    return S2N_SUCCESS;
+}
+
+static int s2n_test_send_and_recv(struct s2n_connection *sender, struct s2n_connection *receiver, uint8_t *data, ssize_t size)
+{
+    s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+    POSIX_ENSURE_EQ(s2n_send(sender, data, size, &blocked), size);
+
+    uint8_t received[S2N_TEST_DATA_SIZE] = { 0 };
+    POSIX_ENSURE_LTE(size, sizeof(received));
+    ssize_t total = 0;
+    while (total < size) {
+        ssize_t r = s2n_recv(receiver, received + total, size - total, &blocked);
+        if (r < 0 && s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED) {
+            continue;
+        }
+        POSIX_ENSURE_GT(r, 0);
+        total += r;
+    }
+    POSIX_ENSURE_EQ(memcmp(received, data, size), 0);
+    return S2N_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    uint8_t test_data[S2N_TEST_DATA_SIZE] = { 0 };
+    for (size_t i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t) i;
+    }
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+    /* s2n_config_set_ktls_mode */
+    {
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_ktls_mode(NULL, S2N_KTLS_MODE_DUPLEX), S2N_ERR_NULL);
+
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+        EXPECT_FALSE(config->ktls_send);
+        EXPECT_FALSE(config->ktls_recv);
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_ktls_mode(config, S2N_KTLS_MODE_DUPLEX + 1), S2N_ERR_INVALID_ARGUMENT);
+
+        EXPECT_SUCCESS(s2n_config_set_ktls_mode(config, S2N_KTLS_MODE_SEND));
+        EXPECT_TRUE(config->ktls_send);
+        EXPECT_FALSE(config->ktls_recv);
+
+        EXPECT_SUCCESS(s2n_config_set_ktls_mode(config, S2N_KTLS_MODE_DUPLEX));
+        EXPECT_TRUE(config->ktls_send);
+        EXPECT_TRUE(config->ktls_recv);
+
+        EXPECT_SUCCESS(s2n_config_set_ktls_mode(config, S2N_KTLS_MODE_DISABLED));
+        EXPECT_FALSE(config->ktls_send);
+        EXPECT_FALSE(config->ktls_recv);
+
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* s2n_connection_is_ktls_enabled */
+    {
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_is_ktls_enabled(NULL, S2N_KTLS_MODE_SEND), S2N_ERR_NULL);
+
+        struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(conn);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_is_ktls_enabled(conn, S2N_KTLS_MODE_DISABLED), S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(conn, S2N_KTLS_MODE_DUPLEX), 0);
+
+        conn->ktls_send_enabled = 1;
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(conn, S2N_KTLS_MODE_SEND), 1);
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(conn, S2N_KTLS_MODE_RECV), 0);
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(conn, S2N_KTLS_MODE_DUPLEX), 0);
+
+        /* Records can't be sealed in userspace once the kernel encrypts them */
+        uint8_t *buffer = NULL;
+        uint32_t size = 0;
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        EXPECT_FAILURE_WITH_ERRNO(s2n_send_reserve(conn, &buffer, &size, &blocked), S2N_ERR_KTLS_UNSUPPORTED);
+
+        /* The state is reset by a wipe */
+        EXPECT_SUCCESS(s2n_connection_wipe(conn));
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(conn, S2N_KTLS_MODE_SEND), 0);
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+#if defined(S2N_KTLS_SUPPORTED)
+    /* KeyUpdates fail with a specific error if the kernel can't take new keys */
+    {
+        struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(conn);
+        conn->actual_protocol_version = S2N_TLS13;
+
+        EXPECT_ERROR_WITH_ERRNO(s2n_ktls_update_keys(conn, S2N_CLIENT), S2N_ERR_INVALID_STATE);
+
+        EXPECT_OK(s2n_ktls_set_rekey_support_for_testing(S2N_KTLS_REKEY_UNSUPPORTED));
+        EXPECT_FALSE(s2n_ktls_is_rekey_supported());
+        conn->ktls_recv_enabled = 1;
+        EXPECT_ERROR_WITH_ERRNO(s2n_ktls_update_keys(conn, S2N_CLIENT), S2N_ERR_KTLS_KEY_UPDATE);
+        conn->ktls_send_enabled = 1;
+        EXPECT_ERROR_WITH_ERRNO(s2n_ktls_update_keys(conn, S2N_SERVER), S2N_ERR_KTLS_KEY_UPDATE);
+
+        EXPECT_OK(s2n_ktls_set_rekey_support_for_testing(S2N_KTLS_REKEY_SUPPORTED));
+        EXPECT_TRUE(s2n_ktls_is_rekey_supported());
+        EXPECT_OK(s2n_ktls_set_rekey_support_for_testing(S2N_KTLS_REKEY_DETECT));
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+#endif
+
+    struct s2n_config *server_config = s2n_config_new();
+    EXPECT_NOT_NULL(server_config);
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+    EXPECT_SUCCESS(s2n_config_set_ktls_mode(server_config, S2N_KTLS_MODE_DUPLEX));
+
+    struct s2n_config *client_config = s2n_config_new();
+    EXPECT_NOT_NULL(client_config);
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+    EXPECT_SUCCESS(s2n_config_set_ktls_mode(client_config, S2N_KTLS_MODE_DUPLEX));
+
+    /* Connections that don't use s2n-managed sockets keep the userspace record layer */
+    {
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, "default_tls13"));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, "default_tls13"));
+
+        DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+        DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(server_conn, S2N_KTLS_MODE_SEND), 0);
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(server_conn, S2N_KTLS_MODE_RECV), 0);
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(client_conn, S2N_KTLS_MODE_SEND), 0);
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(client_conn, S2N_KTLS_MODE_RECV), 0);
+
+        EXPECT_SUCCESS(s2n_test_send_and_recv(client_conn, server_conn, test_data, sizeof(test_data)));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    /* Connections over TCP sockets use kTLS if the kernel supports it, and fall back otherwise.
+     * Either way, application data, post-handshake messages and alerts must get through.
+     */
+    const char *policies[] = { "ELBSecurityPolicy-TLS-1-2-2017-01", "default_tls13" };
+    for (size_t i = 0; i < s2n_array_len(policies); i++) {
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, policies[i]));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, policies[i]));
+
+        struct s2n_test_io_pair io_pair = { 0 };
+        EXPECT_SUCCESS(s2n_test_tcp_io_pair_init(&io_pair));
+        EXPECT_SUCCESS(s2n_connections_set_io_pair(client_conn, server_conn, &io_pair));
+
+        EXPECT_SUCCESS(s2n_test_negotiate_over_tcp(server_conn, client_conn));
+        if (s2n_connection_is_ktls_enabled(server_conn, S2N_KTLS_MODE_DUPLEX)) {
+            /* Support depends on the kernel, not on the connection */
+            EXPECT_EQUAL(s2n_connection_is_ktls_enabled(client_conn, S2N_KTLS_MODE_DUPLEX), 1);
+        }
+
+        EXPECT_SUCCESS(s2n_test_send_and_recv(client_conn, server_conn, test_data, sizeof(test_data)));
+        EXPECT_SUCCESS(s2n_test_send_and_recv(server_conn, client_conn, test_data, sizeof(test_data)));
+
+        /* Vectored writes with an offset */
+        struct iovec iov[3] = {
+            { .iov_base = test_data, .iov_len = 10 },
+            { .iov_base = test_data + 10, .iov_len = 90 },
+            { .iov_base = test_data + 100, .iov_len = sizeof(test_data) - 100 },
+        };
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        const ssize_t offset = 50;
+        EXPECT_EQUAL(s2n_sendv_with_offset(server_conn, iov, s2n_array_len(iov), offset, &blocked),
+                sizeof(test_data) - offset);
+        uint8_t received[S2N_TEST_DATA_SIZE] = { 0 };
+        ssize_t total = 0;
+        while (total < sizeof(test_data) - offset) {
+            ssize_t r = s2n_recv(client_conn, received + total, sizeof(received) - total, &blocked);
+            if (r < 0 && s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED) {
+                continue;
+            }
+            EXPECT_TRUE(r > 0);
+            total += r;
+        }
+        EXPECT_BYTEARRAY_EQUAL(received, test_data + offset, sizeof(test_data) - offset);
+
+        /* Files are sent with sendfile(2) when the kernel encrypts records */
+        FILE *test_file = tmpfile();
+        EXPECT_NOT_NULL(test_file);
+        EXPECT_EQUAL(fwrite(test_data, 1, sizeof(test_data), test_file), sizeof(test_data));
+        EXPECT_SUCCESS(fflush(test_file));
+        EXPECT_EQUAL(s2n_sendfile(server_conn, fileno(test_file), offset, sizeof(test_data) - offset, &blocked),
+                sizeof(test_data) - offset);
+        EXPECT_SUCCESS(fclose(test_file));
+        total = 0;
+        while (total < sizeof(test_data) - offset) {
+            ssize_t r = s2n_recv(client_conn, received + total, sizeof(received) - total, &blocked);
+            if (r < 0 && s2n_error_get_type(s2n_errno) == S2N_ERR_T_BLOCKED) {
+                continue;
+            }
+            EXPECT_TRUE(r > 0);
+            total += r;
+        }
+        EXPECT_BYTEARRAY_EQUAL(received, test_data + offset, sizeof(test_data) - offset);
+
+        /* close_notify alerts are exchanged as control records */
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+    }
+
+    /* Without kernel rekey support, TLS1.3 connections keep the userspace record layer,
+     * so that a KeyUpdate from the peer can still be handled.
+     */
+    {
+        EXPECT_OK(s2n_ktls_set_rekey_support_for_testing(S2N_KTLS_REKEY_UNSUPPORTED));
+
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, "default_tls13"));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, "default_tls13"));
+
+        struct s2n_test_io_pair io_pair = { 0 };
+        EXPECT_SUCCESS(s2n_test_tcp_io_pair_init(&io_pair));
+        EXPECT_SUCCESS(s2n_connections_set_io_pair(client_conn, server_conn, &io_pair));
+
+        EXPECT_SUCCESS(s2n_test_negotiate_over_tcp(server_conn, client_conn));
+        EXPECT_EQUAL(server_conn->actual_protocol_version, S2N_TLS13);
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(server_conn, S2N_KTLS_MODE_SEND), 0);
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(server_conn, S2N_KTLS_MODE_RECV), 0);
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(client_conn, S2N_KTLS_MODE_SEND), 0);
+        EXPECT_EQUAL(s2n_connection_is_ktls_enabled(client_conn, S2N_KTLS_MODE_RECV), 0);
+
+        /* The client updates its keys before sending more data */
+        client_conn->key_update_pending = true;
+        EXPECT_SUCCESS(s2n_test_send_and_recv(client_conn, server_conn, test_data, sizeof(test_data)));
+        EXPECT_FALSE(client_conn->key_update_pending);
+        EXPECT_SUCCESS(s2n_test_send_and_recv(server_conn, client_conn, test_data, sizeof(test_data)));
+
+        EXPECT_SUCCESS(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_io_pair_close(&io_pair));
+        EXPECT_OK(s2n_ktls_set_rekey_support_for_testing(S2N_KTLS_REKEY_DETECT));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    END_TEST();
+}
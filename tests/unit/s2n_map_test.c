@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "utils/s2n_map.h"
+#include "utils/s2n_map_internal.h"
 
 int main(int argc, char **argv)
 {
@@ -175,5 +176,49 @@ int main(int argc, char **argv)
 
     EXPECT_OK(s2n_map_free(map));
 
+    /* Keys too long to be stored inline survive resizes and replacement */
+    {
+        char long_keystr[S2N_MAP_INLINE_KEY_SIZE * 2] = { 0 };
+        EXPECT_NOT_NULL(map = s2n_map_new_with_initial_capacity(1));
+
+        for (int i = 0; i < 1024; i++) {
+            EXPECT_SUCCESS(snprintf(long_keystr, sizeof(long_keystr), "%0*x", (int) sizeof(long_keystr) - 1, i));
+            EXPECT_SUCCESS(snprintf(keystr, sizeof(keystr), "%04x", i));
+            EXPECT_SUCCESS(snprintf(valstr, sizeof(valstr), "%05d", i));
+
+            /* Alternate long and inline keys */
+            key.data = (void *) ((i % 2) ? long_keystr : keystr);
+            key.size = strlen((char *) key.data) + 1;
+            val.data = (void *) valstr;
+            val.size = strlen(valstr) + 1;
+
+            EXPECT_OK(s2n_map_add(map, &key, &val));
+            EXPECT_ERROR_WITH_ERRNO(s2n_map_add(map, &key, &val), S2N_ERR_MAP_DUPLICATE);
+            EXPECT_OK(s2n_map_put(map, &key, &val));
+        }
+        EXPECT_OK(s2n_map_complete(map));
+
+        for (int i = 0; i < 1024; i++) {
+            EXPECT_SUCCESS(snprintf(long_keystr, sizeof(long_keystr), "%0*x", (int) sizeof(long_keystr) - 1, i));
+            EXPECT_SUCCESS(snprintf(keystr, sizeof(keystr), "%04x", i));
+            EXPECT_SUCCESS(snprintf(valstr, sizeof(valstr), "%05d", i));
+
+            key.data = (void *) ((i % 2) ? long_keystr : keystr);
+            key.size = strlen((char *) key.data) + 1;
+
+            EXPECT_OK(s2n_map_lookup(map, &key, &val, &key_found));
+            EXPECT_EQUAL(key_found, true);
+            EXPECT_SUCCESS(memcmp(val.data, valstr, strlen(valstr) + 1));
+
+            /* The other form of the key was never added */
+            key.data = (void *) ((i % 2) ? keystr : long_keystr);
+            key.size = strlen((char *) key.data) + 1;
+            EXPECT_OK(s2n_map_lookup(map, &key, &val, &key_found));
+            EXPECT_EQUAL(key_found, false);
+        }
+
+        EXPECT_OK(s2n_map_free(map));
+    }
+
     END_TEST();
 }
@@ -0,0 +1,258 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "utils/s2n_mem.h"
+#include "utils/s2n_mem_slab.h"
+
+#define S2N_TEST_THREAD_COUNT 4
+#define S2N_TEST_ALLOCATIONS (4 * S2N_MEM_SLAB_MAGAZINE_SIZE)
+
+static bool s2n_test_is_zero(const uint8_t *data, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++) {
+        if (data[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *s2n_test_slab_worker(void *arg)
+{
+    const uint8_t marker = (uint8_t) (uintptr_t) arg;
+    void *chunks[S2N_TEST_ALLOCATIONS] = { 0 };
+
+    for (size_t round = 0; round < 10; round++) {
+        for (size_t i = 0; i < S2N_TEST_ALLOCATIONS; i++) {
+            uint32_t allocated = 0;
+            if (s2n_result_is_error(s2n_mem_slab_alloc(64, &chunks[i], &allocated))) {
+                return (void *) -1;
+            }
+            memset(chunks[i], marker, allocated);
+        }
+        for (size_t i = 0; i < S2N_TEST_ALLOCATIONS; i++) {
+            /* No other thread was handed the same chunk */
+            const uint8_t *data = chunks[i];
+            if (data[0] != marker || data[63] != marker) {
+                return (void *) -1;
+            }
+            if (s2n_result_is_error(s2n_mem_slab_free(chunks[i], 64))) {
+                return (void *) -1;
+            }
+        }
+    }
+
+    if (s2n_result_is_error(s2n_mem_slab_cleanup_thread())) {
+        return (void *) -1;
+    }
+    return NULL;
+}
+
+static void *s2n_test_slab_exiting_worker(void *chunk)
+{
+    /* Exits with the chunk in its magazine, without calling s2n_mem_slab_cleanup_thread */
+    uint32_t allocated = 0;
+    if (s2n_result_is_error(s2n_mem_slab_alloc(S2N_MEM_SLAB_MAX_SIZE, chunk, &allocated))
+            || s2n_result_is_error(s2n_mem_slab_free(*(void **) chunk, allocated))) {
+        return (void *) -1;
+    }
+    return NULL;
+}
+
+#if defined(__linux__)
+/* Returns the amount of locked memory of this process, in kB */
+static int s2n_test_locked_kb(uint64_t *locked_kb)
+{
+    FILE *status = fopen("/proc/self/status", "r");
+    POSIX_ENSURE_REF(status);
+
+    char line[256] = { 0 };
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), status)) {
+        unsigned long long value = 0;
+        found = sscanf(line, "VmLck: %llu kB", &value) == 1;
+        *locked_kb = value;
+    }
+    fclose(status);
+
+    POSIX_ENSURE(found, S2N_ERR_SAFETY);
+    return S2N_SUCCESS;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    /* Requests are rounded up to a power of two size class */
+    {
+        const uint32_t requests[] = { 1, 16, 17, 100, 1024, 1025, S2N_MEM_SLAB_MAX_SIZE };
+        const uint32_t expected[] = { 16, 16, 32, 128, 1024, 2048, S2N_MEM_SLAB_MAX_SIZE };
+        for (size_t i = 0; i < s2n_array_len(requests); i++) {
+            void *ptr = NULL;
+            uint32_t allocated = 0;
+            EXPECT_OK(s2n_mem_slab_alloc(requests[i], &ptr, &allocated));
+            EXPECT_NOT_NULL(ptr);
+            EXPECT_EQUAL(allocated, expected[i]);
+            EXPECT_EQUAL((uintptr_t) ptr % S2N_MEM_SLAB_MIN_SIZE, 0);
+            EXPECT_OK(s2n_mem_slab_free(ptr, allocated));
+        }
+
+        void *ptr = NULL;
+        uint32_t allocated = 0;
+        EXPECT_ERROR_WITH_ERRNO(s2n_mem_slab_alloc(S2N_MEM_SLAB_MAX_SIZE + 1, &ptr, &allocated), S2N_ERR_ALLOC);
+        EXPECT_ERROR_WITH_ERRNO(s2n_mem_slab_free(NULL, S2N_MEM_SLAB_MIN_SIZE), S2N_ERR_NULL);
+    }
+
+    /* Freed chunks are zeroed and reused, whether freed with the requested or the allocated size */
+    {
+        void *ptr = NULL;
+        uint32_t allocated = 0;
+        EXPECT_OK(s2n_mem_slab_alloc(100, &ptr, &allocated));
+        memset(ptr, 0xAB, allocated);
+        EXPECT_OK(s2n_mem_slab_free(ptr, 100));
+        EXPECT_TRUE(s2n_test_is_zero(ptr, allocated));
+
+        void *reused = NULL;
+        EXPECT_OK(s2n_mem_slab_alloc(allocated, &reused, &allocated));
+        EXPECT_EQUAL(reused, ptr);
+        EXPECT_OK(s2n_mem_slab_free(reused, allocated));
+    }
+
+    /* More chunks than a magazine holds move through the depot, and each is handed out once */
+    {
+        void *chunks[S2N_TEST_ALLOCATIONS] = { 0 };
+        uint32_t allocated = 0;
+        for (size_t i = 0; i < S2N_TEST_ALLOCATIONS; i++) {
+            EXPECT_OK(s2n_mem_slab_alloc(S2N_MEM_SLAB_MAX_SIZE, &chunks[i], &allocated));
+            for (size_t j = 0; j < i; j++) {
+                EXPECT_NOT_EQUAL(chunks[i], chunks[j]);
+            }
+        }
+        for (size_t i = 0; i < S2N_TEST_ALLOCATIONS; i++) {
+            EXPECT_OK(s2n_mem_slab_free(chunks[i], allocated));
+        }
+        EXPECT_OK(s2n_mem_slab_cleanup_thread());
+    }
+
+    /* s2n_alloc uses the slab for small blobs and whole locked pages for large ones */
+    if (getenv("S2N_DONT_MLOCK") == NULL && getenv("S2N_MLOCK_PER_PAGE") == NULL) {
+        struct s2n_blob small = { 0 };
+        EXPECT_SUCCESS(s2n_alloc(&small, 32));
+        EXPECT_EQUAL(small.allocated, 32);
+
+        /* Growing within the class doesn't reallocate */
+        uint8_t *data = small.data;
+        EXPECT_SUCCESS(s2n_realloc(&small, 20));
+        EXPECT_SUCCESS(s2n_realloc(&small, 32));
+        EXPECT_EQUAL(small.data, data);
+        EXPECT_SUCCESS(s2n_free(&small));
+
+        struct s2n_blob large = { 0 };
+        EXPECT_SUCCESS(s2n_alloc(&large, S2N_MEM_SLAB_MAX_SIZE + 1));
+        EXPECT_EQUAL(large.allocated % s2n_mem_get_page_size(), 0);
+        EXPECT_SUCCESS(s2n_free(&large));
+
+        uint8_t *object = NULL;
+        struct s2n_blob mem = { 0 };
+        EXPECT_SUCCESS(s2n_alloc(&mem, 200));
+        object = mem.data;
+        EXPECT_SUCCESS(s2n_free_object(&object, 200));
+        EXPECT_NULL(object);
+    }
+
+    /* Threads share the depot without handing the same chunk to two of them */
+    {
+        pthread_t threads[S2N_TEST_THREAD_COUNT] = { 0 };
+        for (uintptr_t i = 0; i < S2N_TEST_THREAD_COUNT; i++) {
+            EXPECT_EQUAL(pthread_create(&threads[i], NULL, s2n_test_slab_worker, (void *) (i + 1)), 0);
+        }
+        for (size_t i = 0; i < S2N_TEST_THREAD_COUNT; i++) {
+            void *result = NULL;
+            EXPECT_EQUAL(pthread_join(threads[i], &result), 0);
+            EXPECT_NULL(result);
+        }
+    }
+
+    /* A thread that exits without cleaning up still returns its chunks to the depot */
+    {
+        EXPECT_OK(s2n_mem_slab_cleanup_thread());
+
+        void *chunk = NULL;
+        pthread_t thread = { 0 };
+        EXPECT_EQUAL(pthread_create(&thread, NULL, s2n_test_slab_exiting_worker, &chunk), 0);
+        void *result = NULL;
+        EXPECT_EQUAL(pthread_join(thread, &result), 0);
+        EXPECT_NULL(result);
+        EXPECT_NOT_NULL(chunk);
+
+        /* The exited thread's chunk was the last one returned, so it is in the next refill */
+        void *chunks[S2N_MEM_SLAB_MAGAZINE_SIZE / 2] = { 0 };
+        bool reused = false;
+        uint32_t allocated = 0;
+        for (size_t i = 0; i < s2n_array_len(chunks); i++) {
+            EXPECT_OK(s2n_mem_slab_alloc(S2N_MEM_SLAB_MAX_SIZE, &chunks[i], &allocated));
+            reused |= (chunks[i] == chunk);
+        }
+        EXPECT_TRUE(reused);
+        for (size_t i = 0; i < s2n_array_len(chunks); i++) {
+            EXPECT_OK(s2n_mem_slab_free(chunks[i], allocated));
+        }
+    }
+
+#if defined(__linux__)
+    /* A forked child locks the regions again */
+    {
+        void *ptr = NULL;
+        uint32_t allocated = 0;
+        EXPECT_OK(s2n_mem_slab_alloc(S2N_MEM_SLAB_MIN_SIZE, &ptr, &allocated));
+
+        uint64_t parent_locked_kb = 0;
+        EXPECT_SUCCESS(s2n_test_locked_kb(&parent_locked_kb));
+        EXPECT_TRUE(parent_locked_kb >= S2N_MEM_SLAB_REGION_SIZE / 1024);
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            uint64_t child_locked_kb = 0;
+            EXPECT_SUCCESS(s2n_test_locked_kb(&child_locked_kb));
+            EXPECT_TRUE(child_locked_kb >= S2N_MEM_SLAB_REGION_SIZE / 1024);
+
+            /* The child can still allocate and free */
+            void *child_ptr = NULL;
+            EXPECT_OK(s2n_mem_slab_alloc(S2N_MEM_SLAB_MIN_SIZE, &child_ptr, &allocated));
+            EXPECT_OK(s2n_mem_slab_free(child_ptr, allocated));
+            exit(EXIT_SUCCESS);
+        }
+        EXPECT_TRUE(pid > 0);
+
+        int status = 0;
+        EXPECT_EQUAL(waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status));
+        EXPECT_EQUAL(WEXITSTATUS(status), 0);
+
+        EXPECT_OK(s2n_mem_slab_free(ptr, allocated));
+    }
+#endif
+
+    END_TEST();
+}
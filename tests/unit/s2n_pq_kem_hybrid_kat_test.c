@@ -50,9 +50,9 @@ static const struct s2n_kem_hybrid_test_vector test_vectors[] = {
                 .kat_file = "kats/hybrid_ecdhe_bike_r2.kat",
                 .server_key_msg_len = 3279,
                 .client_key_msg_len = 3014,
-                .asm_is_enabled = s2n_pq_no_asm_available,
-                .enable_asm = s2n_pq_noop_asm,
-                .disable_asm = s2n_pq_noop_asm,
+                .asm_is_enabled = s2n_bike1l1r2_x86_64_opt_is_enabled,
+                .enable_asm = s2n_try_enable_bike1l1r2_x86_64_opt,
+                .disable_asm = s2n_disable_bike1l1r2_x86_64_opt,
         },
         {
                 .kem = &s2n_sike_p503_r1,
@@ -83,9 +83,9 @@ static const struct s2n_kem_hybrid_test_vector test_vectors[] = {
                 .kat_file = "kats/hybrid_ecdhe_kyber_r2.kat",
                 .server_key_msg_len = 1133,
                 .client_key_msg_len = 804,
-                .asm_is_enabled = s2n_pq_no_asm_available,
-                .enable_asm = s2n_pq_noop_asm,
-                .disable_asm = s2n_pq_noop_asm,
+                .asm_is_enabled = s2n_kyber512r2_avx2_is_enabled,
+                .enable_asm = s2n_try_enable_kyber512r2_avx2,
+                .disable_asm = s2n_disable_kyber512r2_avx2,
         },
 };
 
@@ -37,9 +37,9 @@ static const struct s2n_kem_test_vector test_vectors[] = {
         {
                 .kem = &s2n_bike1_l1_r2,
                 .kat_file = "kats/bike_r2.kat",
-                .asm_is_enabled = s2n_pq_no_asm_available,
-                .enable_asm = s2n_pq_noop_asm,
-                .disable_asm = s2n_pq_noop_asm,
+                .asm_is_enabled = s2n_bike1l1r2_x86_64_opt_is_enabled,
+                .enable_asm = s2n_try_enable_bike1l1r2_x86_64_opt,
+                .disable_asm = s2n_disable_bike1l1r2_x86_64_opt,
         },
         {
                 .kem = &s2n_sike_p503_r1,
@@ -58,9 +58,9 @@ static const struct s2n_kem_test_vector test_vectors[] = {
         {
                 .kem = &s2n_kyber_512_r2,
                 .kat_file = "kats/kyber_r2.kat",
-                .asm_is_enabled = s2n_pq_no_asm_available,
-                .enable_asm = s2n_pq_noop_asm,
-                .disable_asm = s2n_pq_noop_asm,
+                .asm_is_enabled = s2n_kyber512r2_avx2_is_enabled,
+                .enable_asm = s2n_try_enable_kyber512r2_avx2,
+                .disable_asm = s2n_disable_kyber512r2_avx2,
         },
         {
                 .kem = &s2n_kyber_512_90s_r2,
@@ -0,0 +1,169 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <errno.h>
+#include <sys/param.h>
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+
+#define S2N_TEST_RECORD_COUNT 20
+#define S2N_TEST_RECORD_SIZE  100
+
+struct s2n_test_recv_ctx {
+    struct s2n_stuffer *input;
+    uint32_t calls;
+};
+
+static int s2n_test_counting_recv_fn(void *io_context, uint8_t *buf, uint32_t len)
+{
+    struct s2n_test_recv_ctx *ctx = (struct s2n_test_recv_ctx*) io_context;
+    ctx->calls++;
+
+    uint32_t available = MIN(len, s2n_stuffer_data_available(ctx->input));
+    if (available == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    POSIX_GUARD(s2n_stuffer_read_bytes(ctx->input, buf, available));
+    return available;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    uint8_t test_data[S2N_TEST_RECORD_SIZE] = { 0 };
+    for (size_t i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t) i;
+    }
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+    struct s2n_config *server_config = s2n_config_new();
+    EXPECT_NOT_NULL(server_config);
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+
+    struct s2n_config *client_config = s2n_config_new();
+    EXPECT_NOT_NULL(client_config);
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    /* s2n_connection_set_recv_buffering */
+    {
+        EXPECT_FAILURE_WITH_ERRNO(s2n_connection_set_recv_buffering(NULL, 1024), S2N_ERR_NULL);
+
+        struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(conn);
+        EXPECT_EQUAL(conn->recv_buffer_size, 0);
+
+        EXPECT_SUCCESS(s2n_connection_set_recv_buffering(conn, 1024));
+        EXPECT_EQUAL(conn->recv_buffer_size, 1024);
+
+        EXPECT_SUCCESS(s2n_connection_set_recv_buffering(conn, 0));
+        EXPECT_EQUAL(conn->recv_buffer_size, 0);
+
+        /* The setting is reset by a wipe */
+        EXPECT_SUCCESS(s2n_connection_set_recv_buffering(conn, 1024));
+        EXPECT_SUCCESS(s2n_connection_wipe(conn));
+        EXPECT_EQUAL(conn->recv_buffer_size, 0);
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+    /* Many records can be received with a single read */
+    const uint32_t buffer_sizes[] = { 0, 10, S2N_TLS_MAXIMUM_RECORD_LENGTH };
+    for (size_t i = 0; i < s2n_array_len(buffer_sizes); i++) {
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, "default_tls13"));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, "default_tls13"));
+
+        DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+        DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_connection_set_recv_buffering(server_conn, buffer_sizes[i]));
+
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        for (size_t j = 0; j < S2N_TEST_RECORD_COUNT; j++) {
+            EXPECT_EQUAL(s2n_send(client_conn, test_data, sizeof(test_data), &blocked), sizeof(test_data));
+        }
+
+        struct s2n_test_recv_ctx recv_ctx = { .input = &input };
+        EXPECT_SUCCESS(s2n_connection_set_recv_cb(server_conn, s2n_test_counting_recv_fn));
+        EXPECT_SUCCESS(s2n_connection_set_recv_ctx(server_conn, &recv_ctx));
+
+        for (size_t j = 0; j < S2N_TEST_RECORD_COUNT; j++) {
+            uint8_t received[S2N_TEST_RECORD_SIZE] = { 0 };
+            EXPECT_EQUAL(s2n_recv(server_conn, received, sizeof(received), &blocked), sizeof(received));
+            EXPECT_BYTEARRAY_EQUAL(received, test_data, sizeof(test_data));
+        }
+        EXPECT_EQUAL(s2n_stuffer_data_available(&input), 0);
+        EXPECT_EQUAL(s2n_peek_buffered(server_conn), 0);
+
+        if (buffer_sizes[i] == 0) {
+            /* Without buffering, the header and the body of every record are read separately */
+            EXPECT_EQUAL(recv_ctx.calls, S2N_TEST_RECORD_COUNT * 2);
+        } else if (buffer_sizes[i] == S2N_TLS_MAXIMUM_RECORD_LENGTH) {
+            /* All of the records fit into the buffer */
+            EXPECT_EQUAL(recv_ctx.calls, 1);
+        }
+
+        /* Buffered data is reported and blocks releasing the buffers */
+        if (buffer_sizes[i] == S2N_TLS_MAXIMUM_RECORD_LENGTH) {
+            EXPECT_EQUAL(s2n_send(client_conn, test_data, sizeof(test_data), &blocked), sizeof(test_data));
+            EXPECT_EQUAL(s2n_send(client_conn, test_data, sizeof(test_data), &blocked), sizeof(test_data));
+
+            uint8_t received[S2N_TEST_RECORD_SIZE] = { 0 };
+            EXPECT_EQUAL(s2n_recv(server_conn, received, sizeof(received), &blocked), sizeof(received));
+            EXPECT_NOT_EQUAL(s2n_peek_buffered(server_conn), 0);
+            EXPECT_FAILURE_WITH_ERRNO(s2n_connection_release_buffers(server_conn), S2N_ERR_STUFFER_HAS_UNPROCESSED_DATA);
+
+            /* Disabling buffering still drains the data already read ahead */
+            EXPECT_SUCCESS(s2n_connection_set_recv_buffering(server_conn, 0));
+            recv_ctx.calls = 0;
+            EXPECT_EQUAL(s2n_recv(server_conn, received, sizeof(received), &blocked), sizeof(received));
+            EXPECT_BYTEARRAY_EQUAL(received, test_data, sizeof(test_data));
+            EXPECT_EQUAL(recv_ctx.calls, 0);
+            EXPECT_EQUAL(s2n_peek_buffered(server_conn), 0);
+
+            EXPECT_SUCCESS(s2n_connection_release_buffers(server_conn));
+            EXPECT_EQUAL(server_conn->buffer_in.blob.size, 0);
+        }
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    END_TEST();
+}
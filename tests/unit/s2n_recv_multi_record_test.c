@@ -0,0 +1,189 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <s2n.h>
+
+#include "tls/s2n_config.h"
+#include "tls/s2n_connection.h"
+
+#define S2N_TEST_RECORD_COUNT 10
+#define S2N_TEST_RECORD_SIZE  100
+#define S2N_TEST_DATA_SIZE    (S2N_TEST_RECORD_COUNT * S2N_TEST_RECORD_SIZE)
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    uint8_t test_data[S2N_TEST_DATA_SIZE] = { 0 };
+    for (size_t i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t) i;
+    }
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+    /* s2n_config_set_recv_multi_record */
+    {
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_recv_multi_record(NULL, true), S2N_ERR_NULL);
+
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+        EXPECT_FALSE(config->recv_multi_record);
+
+        EXPECT_SUCCESS(s2n_config_set_recv_multi_record(config, true));
+        EXPECT_TRUE(config->recv_multi_record);
+
+        EXPECT_SUCCESS(s2n_config_set_recv_multi_record(config, false));
+        EXPECT_FALSE(config->recv_multi_record);
+
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    for (uint8_t multi_record = 0; multi_record <= 1; multi_record++) {
+        for (uint8_t read_ahead = 0; read_ahead <= 1; read_ahead++) {
+            struct s2n_config *server_config = s2n_config_new();
+            EXPECT_NOT_NULL(server_config);
+            EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+            EXPECT_SUCCESS(s2n_config_set_recv_multi_record(server_config, multi_record));
+
+            struct s2n_config *client_config = s2n_config_new();
+            EXPECT_NOT_NULL(client_config);
+            EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+            struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+            EXPECT_NOT_NULL(server_conn);
+            EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+            EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, "default_tls13"));
+
+            struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+            EXPECT_NOT_NULL(client_conn);
+            EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+            EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, "default_tls13"));
+
+            DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+            DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+            EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+            EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+            EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+            EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+            EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+            if (read_ahead) {
+                EXPECT_SUCCESS(s2n_connection_set_recv_buffering(server_conn, S2N_TLS_MAXIMUM_RECORD_LENGTH));
+            }
+
+            /* Send every chunk of the test data as its own record */
+            s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+            for (size_t i = 0; i < S2N_TEST_RECORD_COUNT; i++) {
+                EXPECT_EQUAL(s2n_send(client_conn, test_data + i * S2N_TEST_RECORD_SIZE, S2N_TEST_RECORD_SIZE, &blocked),
+                        S2N_TEST_RECORD_SIZE);
+            }
+
+            uint8_t received[S2N_TEST_DATA_SIZE * 2] = { 0 };
+            if (multi_record && read_ahead) {
+                /* A partial record fills the remainder of the caller's buffer */
+                const ssize_t partial_size = S2N_TEST_RECORD_SIZE * 2 + S2N_TEST_RECORD_SIZE / 2;
+                EXPECT_EQUAL(s2n_recv(server_conn, received, partial_size, &blocked), partial_size);
+                EXPECT_EQUAL(s2n_peek(server_conn), S2N_TEST_RECORD_SIZE / 2);
+
+                /* All remaining records are returned by a single call */
+                EXPECT_EQUAL(s2n_recv(server_conn, received + partial_size, sizeof(received) - partial_size, &blocked),
+                        S2N_TEST_DATA_SIZE - partial_size);
+                EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+            } else {
+                /* Each call returns a single record. Without read-ahead buffering, no further record
+                 * is available without reading from the network, so multi-record reads stop too. */
+                for (size_t i = 0; i < S2N_TEST_RECORD_COUNT; i++) {
+                    EXPECT_EQUAL(s2n_recv(server_conn, received + i * S2N_TEST_RECORD_SIZE,
+                            sizeof(received) - i * S2N_TEST_RECORD_SIZE, &blocked), S2N_TEST_RECORD_SIZE);
+                    EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+                }
+            }
+            EXPECT_BYTEARRAY_EQUAL(received, test_data, sizeof(test_data));
+
+            /* No more data is available */
+            EXPECT_FAILURE_WITH_ERRNO(s2n_recv(server_conn, received, sizeof(received), &blocked), S2N_ERR_IO_BLOCKED);
+            EXPECT_EQUAL(blocked, S2N_BLOCKED_ON_READ);
+
+            EXPECT_SUCCESS(s2n_connection_free(server_conn));
+            EXPECT_SUCCESS(s2n_connection_free(client_conn));
+            EXPECT_SUCCESS(s2n_config_free(server_config));
+            EXPECT_SUCCESS(s2n_config_free(client_config));
+        }
+    }
+
+    /* A record that fails after data was already copied doesn't lose that data */
+    {
+        struct s2n_config *server_config = s2n_config_new();
+        EXPECT_NOT_NULL(server_config);
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+        EXPECT_SUCCESS(s2n_config_set_recv_multi_record(server_config, true));
+
+        struct s2n_config *client_config = s2n_config_new();
+        EXPECT_NOT_NULL(client_config);
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, "default_tls13"));
+        EXPECT_SUCCESS(s2n_connection_set_blinding(server_conn, S2N_SELF_SERVICE_BLINDING));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, "default_tls13"));
+
+        DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+        DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+        EXPECT_SUCCESS(s2n_connection_set_recv_buffering(server_conn, S2N_TLS_MAXIMUM_RECORD_LENGTH));
+
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        for (size_t i = 0; i < 2; i++) {
+            EXPECT_EQUAL(s2n_send(client_conn, test_data + i * S2N_TEST_RECORD_SIZE, S2N_TEST_RECORD_SIZE, &blocked),
+                    S2N_TEST_RECORD_SIZE);
+        }
+
+        /* Corrupt the tag of the second record */
+        input.blob.data[input.write_cursor - 1] ^= 1;
+
+        uint8_t received[S2N_TEST_DATA_SIZE] = { 0 };
+        EXPECT_EQUAL(s2n_recv(server_conn, received, sizeof(received), &blocked), S2N_TEST_RECORD_SIZE);
+        EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+        EXPECT_BYTEARRAY_EQUAL(received, test_data, S2N_TEST_RECORD_SIZE);
+
+        /* The error is reported by the next call, then the connection is closed */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv(server_conn, received, sizeof(received), &blocked), S2N_ERR_DECRYPT);
+        EXPECT_EQUAL(s2n_recv(server_conn, received, sizeof(received), &blocked), 0);
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_config_free(server_config));
+        EXPECT_SUCCESS(s2n_config_free(client_config));
+    }
+
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    END_TEST();
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+
+#define S2N_TEST_RECORD_SIZE 100
+
+struct s2n_test_consume_ctx {
+    struct s2n_connection *conn;
+    int result;
+    int error;
+};
+
+/* A recv callback that tries to consume data while s2n is reading into conn->in */
+static int s2n_test_consume_recv_cb(void *io_context, uint8_t *buf, uint32_t len)
+{
+    struct s2n_test_consume_ctx *ctx = (struct s2n_test_consume_ctx *) io_context;
+    ctx->result = s2n_recv_consume(ctx->conn, 1);
+    ctx->error = s2n_errno;
+    errno = EAGAIN;
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    uint8_t test_data[S2N_TEST_RECORD_SIZE] = { 0 };
+    for (size_t i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t) i;
+    }
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+    struct s2n_config *server_config = s2n_config_new();
+    EXPECT_NOT_NULL(server_config);
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+
+    struct s2n_config *client_config = s2n_config_new();
+    EXPECT_NOT_NULL(client_config);
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    /* Safety */
+    {
+        struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(conn);
+
+        const uint8_t *data = NULL;
+        uint32_t size = 0;
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_view(NULL, &data, &size, &blocked), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_view(conn, NULL, &size, &blocked), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_view(conn, &data, NULL, &blocked), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_view(conn, &data, &size, NULL), S2N_ERR_NULL);
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_consume(NULL, 1), S2N_ERR_NULL);
+        EXPECT_SUCCESS(s2n_recv_consume(conn, 0));
+
+        /* Nothing has been decrypted yet */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_consume(conn, 1), S2N_ERR_INVALID_STATE);
+
+        /* Data can't be consumed from within a recv callback */
+        struct s2n_test_consume_ctx ctx = { .conn = conn };
+        EXPECT_SUCCESS(s2n_connection_set_recv_cb(conn, s2n_test_consume_recv_cb));
+        EXPECT_SUCCESS(s2n_connection_set_recv_ctx(conn, &ctx));
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_view(conn, &data, &size, &blocked), S2N_ERR_IO_BLOCKED);
+        EXPECT_EQUAL(ctx.result, S2N_FAILURE);
+        EXPECT_EQUAL(ctx.error, S2N_ERR_REENTRANCY);
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+    /* Decrypted records are lent to the caller */
+    {
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, "default_tls13"));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, "default_tls13"));
+
+        DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+        DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        const uint8_t *data = NULL;
+        uint32_t size = 0;
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+
+        /* No records are available yet */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_view(server_conn, &data, &size, &blocked), S2N_ERR_IO_BLOCKED);
+        EXPECT_EQUAL(blocked, S2N_BLOCKED_ON_READ);
+        EXPECT_NULL(data);
+        EXPECT_EQUAL(size, 0);
+
+        EXPECT_EQUAL(s2n_send(client_conn, test_data, sizeof(test_data), &blocked), sizeof(test_data));
+        EXPECT_EQUAL(s2n_send(client_conn, test_data, sizeof(test_data), &blocked), sizeof(test_data));
+
+        /* The view points at the decrypted record */
+        EXPECT_SUCCESS(s2n_recv_view(server_conn, &data, &size, &blocked));
+        EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+        EXPECT_EQUAL(size, sizeof(test_data));
+        EXPECT_BYTEARRAY_EQUAL(data, test_data, sizeof(test_data));
+        EXPECT_EQUAL(s2n_peek(server_conn), sizeof(test_data));
+
+        /* Without consuming any data, the same view is returned */
+        const uint8_t *first_view = data;
+        EXPECT_SUCCESS(s2n_recv_view(server_conn, &data, &size, &blocked));
+        EXPECT_EQUAL(data, first_view);
+        EXPECT_EQUAL(size, sizeof(test_data));
+
+        /* Consuming part of the record advances the view */
+        const uint32_t consumed = 40;
+        EXPECT_SUCCESS(s2n_recv_consume(server_conn, consumed));
+        EXPECT_SUCCESS(s2n_recv_view(server_conn, &data, &size, &blocked));
+        EXPECT_EQUAL(data, first_view + consumed);
+        EXPECT_EQUAL(size, sizeof(test_data) - consumed);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_recv_consume(server_conn, size + 1), S2N_ERR_INVALID_ARGUMENT);
+
+        /* s2n_recv can be mixed with the view */
+        uint8_t received[10] = { 0 };
+        EXPECT_EQUAL(s2n_recv(server_conn, received, sizeof(received), &blocked), sizeof(received));
+        EXPECT_BYTEARRAY_EQUAL(received, test_data + consumed, sizeof(received));
+        EXPECT_SUCCESS(s2n_recv_view(server_conn, &data, &size, &blocked));
+        EXPECT_EQUAL(size, sizeof(test_data) - consumed - sizeof(received));
+        EXPECT_BYTEARRAY_EQUAL(data, test_data + consumed + sizeof(received), size);
+
+        /* Consuming the rest of the record moves on to the next one */
+        EXPECT_SUCCESS(s2n_recv_consume(server_conn, size));
+        EXPECT_EQUAL(s2n_peek(server_conn), 0);
+        EXPECT_SUCCESS(s2n_recv_view(server_conn, &data, &size, &blocked));
+        EXPECT_EQUAL(size, sizeof(test_data));
+        EXPECT_BYTEARRAY_EQUAL(data, test_data, sizeof(test_data));
+        EXPECT_SUCCESS(s2n_recv_consume(server_conn, size));
+
+        /* A closed connection returns an empty view */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_shutdown(client_conn, &blocked), S2N_ERR_IO_BLOCKED);
+        EXPECT_SUCCESS(s2n_recv_view(server_conn, &data, &size, &blocked));
+        EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+        EXPECT_NULL(data);
+        EXPECT_EQUAL(size, 0);
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    END_TEST();
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <errno.h>
+#include <s2n.h>
+
+#include "tls/s2n_config.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_record.h"
+
+#define S2N_TEST_RECORD_COUNT 10
+#define S2N_TEST_DATA_SIZE (S2N_TLS_MAXIMUM_FRAGMENT_LENGTH * S2N_TEST_RECORD_COUNT)
+#define S2N_TEST_SEND_BUFFER_SIZE (S2N_TLS_MAXIMUM_RECORD_LENGTH * 4)
+
+struct s2n_test_send_ctx {
+    struct s2n_stuffer *output;
+    uint32_t calls;
+    /* Number of successful calls before the callback starts blocking. Zero means never block. */
+    uint32_t calls_until_blocked;
+};
+
+static int s2n_test_counting_send_fn(void *io_context, const uint8_t *buf, uint32_t len)
+{
+    struct s2n_test_send_ctx *ctx = (struct s2n_test_send_ctx*) io_context;
+
+    if (ctx->calls_until_blocked && ctx->calls >= ctx->calls_until_blocked) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    ctx->calls++;
+    POSIX_GUARD(s2n_stuffer_write_bytes(ctx->output, buf, len));
+    return len;
+}
+
+static int s2n_test_recv_all(struct s2n_connection *conn, uint8_t *data, ssize_t size)
+{
+    s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+    ssize_t total = 0;
+    while (total < size) {
+        ssize_t r = s2n_recv(conn, data + total, size - total, &blocked);
+        POSIX_ENSURE_GT(r, 0);
+        total += r;
+    }
+    return S2N_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    uint8_t test_data[S2N_TEST_DATA_SIZE] = { 0 };
+    for (size_t i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t) i;
+    }
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+    /* s2n_config_set_send_buffer_size */
+    {
+        struct s2n_config *config = s2n_config_new();
+        EXPECT_NOT_NULL(config);
+        EXPECT_EQUAL(config->send_buffer_size_override, 0);
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_send_buffer_size(NULL, S2N_TEST_SEND_BUFFER_SIZE), S2N_ERR_NULL);
+
+        /* The buffer must be able to hold a full record */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_send_buffer_size(config, 0), S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_send_buffer_size(config, S2N_TLS_MAXIMUM_RECORD_LENGTH - 1),
+                S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_EQUAL(config->send_buffer_size_override, 0);
+
+        EXPECT_SUCCESS(s2n_config_set_send_buffer_size(config, S2N_TLS_MAXIMUM_RECORD_LENGTH));
+        EXPECT_EQUAL(config->send_buffer_size_override, S2N_TLS_MAXIMUM_RECORD_LENGTH);
+
+        EXPECT_SUCCESS(s2n_config_free(config));
+    }
+
+    /* Records are batched into as few writes as the send buffer allows */
+    for (uint32_t send_buffer_size = 0; send_buffer_size <= S2N_TEST_SEND_BUFFER_SIZE;
+            send_buffer_size += S2N_TEST_SEND_BUFFER_SIZE) {
+        struct s2n_config *server_config = s2n_config_new();
+        EXPECT_NOT_NULL(server_config);
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+        if (send_buffer_size) {
+            EXPECT_SUCCESS(s2n_config_set_send_buffer_size(server_config, send_buffer_size));
+        }
+
+        struct s2n_config *client_config = s2n_config_new();
+        EXPECT_NOT_NULL(client_config);
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, "default_tls13"));
+        /* Use maximum sized records to make the expected number of writes easy to reason about */
+        EXPECT_SUCCESS(s2n_connection_prefer_throughput(server_conn));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, "default_tls13"));
+
+        DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+        DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        struct s2n_test_send_ctx send_ctx = { .output = &output };
+        EXPECT_SUCCESS(s2n_connection_set_send_cb(server_conn, s2n_test_counting_send_fn));
+        EXPECT_SUCCESS(s2n_connection_set_send_ctx(server_conn, &send_ctx));
+
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        EXPECT_EQUAL(s2n_send(server_conn, test_data, sizeof(test_data), &blocked), sizeof(test_data));
+        EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+        EXPECT_EQUAL(s2n_stuffer_data_available(&server_conn->out), 0);
+
+        if (send_buffer_size) {
+            /* Four full records fit into the buffer, so ten records need three writes */
+            EXPECT_EQUAL(send_ctx.calls, 3);
+        } else {
+            EXPECT_EQUAL(send_ctx.calls, S2N_TEST_RECORD_COUNT);
+        }
+
+        uint8_t received[S2N_TEST_DATA_SIZE] = { 0 };
+        EXPECT_SUCCESS(s2n_test_recv_all(client_conn, received, sizeof(received)));
+        EXPECT_BYTEARRAY_EQUAL(received, test_data, sizeof(test_data));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_config_free(server_config));
+        EXPECT_SUCCESS(s2n_config_free(client_config));
+    }
+
+    /* Partial writes are reported correctly when the connection blocks with records still buffered */
+    {
+        struct s2n_config *server_config = s2n_config_new();
+        EXPECT_NOT_NULL(server_config);
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+        EXPECT_SUCCESS(s2n_config_set_send_buffer_size(server_config, S2N_TEST_SEND_BUFFER_SIZE));
+
+        struct s2n_config *client_config = s2n_config_new();
+        EXPECT_NOT_NULL(client_config);
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, "default_tls13"));
+        /* Use maximum sized records to make the expected number of writes easy to reason about */
+        EXPECT_SUCCESS(s2n_connection_prefer_throughput(server_conn));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, "default_tls13"));
+
+        DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+        DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        struct s2n_test_send_ctx send_ctx = { .output = &output, .calls_until_blocked = 1 };
+        EXPECT_SUCCESS(s2n_connection_set_send_cb(server_conn, s2n_test_counting_send_fn));
+        EXPECT_SUCCESS(s2n_connection_set_send_ctx(server_conn, &send_ctx));
+
+        /* Only the first batch of records reaches the network */
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        const ssize_t first_batch_size = S2N_TLS_MAXIMUM_FRAGMENT_LENGTH * 4;
+        EXPECT_EQUAL(s2n_send(server_conn, test_data, sizeof(test_data), &blocked), first_batch_size);
+        EXPECT_EQUAL(blocked, S2N_BLOCKED_ON_WRITE);
+        EXPECT_NOT_EQUAL(s2n_stuffer_data_available(&server_conn->out), 0);
+
+        /* Retrying with the remaining data sends the buffered records first */
+        send_ctx.calls_until_blocked = 0;
+        EXPECT_EQUAL(s2n_send(server_conn, test_data + first_batch_size, sizeof(test_data) - first_batch_size, &blocked),
+                sizeof(test_data) - first_batch_size);
+        EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+        EXPECT_EQUAL(s2n_stuffer_data_available(&server_conn->out), 0);
+
+        uint8_t received[S2N_TEST_DATA_SIZE] = { 0 };
+        EXPECT_SUCCESS(s2n_test_recv_all(client_conn, received, sizeof(received)));
+        EXPECT_BYTEARRAY_EQUAL(received, test_data, sizeof(test_data));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_config_free(server_config));
+        EXPECT_SUCCESS(s2n_config_free(client_config));
+    }
+
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    END_TEST();
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_record.h"
+
+#define S2N_TEST_RECORD_SIZE 100
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    uint8_t test_data[S2N_TEST_RECORD_SIZE] = { 0 };
+    for (size_t i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t) i;
+    }
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+    struct s2n_config *server_config = s2n_config_new();
+    EXPECT_NOT_NULL(server_config);
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+
+    struct s2n_config *client_config = s2n_config_new();
+    EXPECT_NOT_NULL(client_config);
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    /* Safety */
+    {
+        struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(conn);
+
+        uint8_t *buffer = NULL;
+        uint32_t size = 0;
+        const uint8_t *wire = NULL;
+        uint32_t wire_size = 0;
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_send_reserve(NULL, &buffer, &size, &blocked), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_send_reserve(conn, NULL, &size, &blocked), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_send_reserve(conn, &buffer, NULL, &blocked), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_send_reserve(conn, &buffer, &size, NULL), S2N_ERR_NULL);
+
+        EXPECT_FAILURE_WITH_ERRNO(s2n_send_seal(NULL, 1, &wire, &wire_size), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_send_seal(conn, 1, NULL, &wire_size), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_send_seal(conn, 1, &wire, NULL), S2N_ERR_NULL);
+
+        /* Nothing was reserved */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_send_seal(conn, 1, &wire, &wire_size), S2N_ERR_INVALID_STATE);
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+    const char *policies[] = { "ELBSecurityPolicy-TLS-1-2-2017-01", "default_tls13" };
+    for (size_t i = 0; i < s2n_array_len(policies); i++) {
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, policies[i]));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, policies[i]));
+
+        DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+        DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        uint16_t max_payload_size = 0;
+        EXPECT_OK(s2n_record_max_write_payload_size(server_conn, &max_payload_size));
+
+        uint8_t *buffer = NULL;
+        uint32_t size = 0;
+        const uint8_t *wire = NULL;
+        uint32_t wire_size = 0;
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+
+        /* Records sealed in place can be decrypted by the peer */
+        for (size_t j = 0; j < 3; j++) {
+            EXPECT_SUCCESS(s2n_send_reserve(server_conn, &buffer, &size, &blocked));
+            EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+            EXPECT_NOT_NULL(buffer);
+            EXPECT_EQUAL(size, max_payload_size);
+            EXPECT_TRUE(buffer > server_conn->out.blob.data);
+            EXPECT_TRUE(buffer + size <= server_conn->out.blob.data + server_conn->out.blob.size);
+
+            EXPECT_MEMCPY_SUCCESS(buffer, test_data, sizeof(test_data));
+            EXPECT_FAILURE_WITH_ERRNO(s2n_send_seal(server_conn, 0, &wire, &wire_size), S2N_ERR_INVALID_ARGUMENT);
+            EXPECT_FAILURE_WITH_ERRNO(s2n_send_seal(server_conn, size + 1, &wire, &wire_size), S2N_ERR_INVALID_ARGUMENT);
+            EXPECT_SUCCESS(s2n_send_seal(server_conn, sizeof(test_data), &wire, &wire_size));
+            EXPECT_NOT_NULL(wire);
+            EXPECT_TRUE(wire_size > sizeof(test_data) + S2N_TLS_RECORD_HEADER_LENGTH);
+
+            /* The record was handed to the caller instead of being sent */
+            EXPECT_EQUAL(s2n_stuffer_data_available(&output), 0);
+            EXPECT_EQUAL(s2n_stuffer_data_available(&server_conn->out), 0);
+
+            /* The reservation can only be sealed once */
+            EXPECT_FAILURE_WITH_ERRNO(s2n_send_seal(server_conn, sizeof(test_data), &wire, &wire_size),
+                    S2N_ERR_INVALID_STATE);
+
+            EXPECT_SUCCESS(s2n_stuffer_write_bytes(&output, wire, wire_size));
+            uint8_t received[S2N_TEST_RECORD_SIZE] = { 0 };
+            EXPECT_EQUAL(s2n_recv(client_conn, received, sizeof(received), &blocked), sizeof(received));
+            EXPECT_BYTEARRAY_EQUAL(received, test_data, sizeof(test_data));
+        }
+
+        /* Writing to the connection cancels the reservation */
+        {
+            EXPECT_SUCCESS(s2n_send_reserve(server_conn, &buffer, &size, &blocked));
+            EXPECT_EQUAL(s2n_send(server_conn, test_data, sizeof(test_data), &blocked), sizeof(test_data));
+            EXPECT_FAILURE_WITH_ERRNO(s2n_send_seal(server_conn, sizeof(test_data), &wire, &wire_size),
+                    S2N_ERR_INVALID_STATE);
+
+            uint8_t received[S2N_TEST_RECORD_SIZE] = { 0 };
+            EXPECT_EQUAL(s2n_recv(client_conn, received, sizeof(received), &blocked), sizeof(received));
+            EXPECT_BYTEARRAY_EQUAL(received, test_data, sizeof(test_data));
+        }
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    END_TEST();
+}
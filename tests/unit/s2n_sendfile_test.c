@@ -0,0 +1,218 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <s2n.h>
+
+#include "tls/s2n_config.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_record.h"
+
+#define S2N_TEST_RECORD_COUNT 10
+#define S2N_TEST_FILE_SIZE (S2N_TLS_MAXIMUM_FRAGMENT_LENGTH * S2N_TEST_RECORD_COUNT)
+#define S2N_TEST_SEND_BUFFER_SIZE (S2N_TLS_MAXIMUM_RECORD_LENGTH * 4)
+
+struct s2n_test_send_ctx {
+    struct s2n_stuffer *output;
+    uint32_t calls;
+    /* Number of successful calls before the callback starts blocking. Zero means never block. */
+    uint32_t calls_until_blocked;
+};
+
+static int s2n_test_counting_send_fn(void *io_context, const uint8_t *buf, uint32_t len)
+{
+    struct s2n_test_send_ctx *ctx = (struct s2n_test_send_ctx*) io_context;
+
+    if (ctx->calls_until_blocked && ctx->calls >= ctx->calls_until_blocked) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    ctx->calls++;
+    POSIX_GUARD(s2n_stuffer_write_bytes(ctx->output, buf, len));
+    return len;
+}
+
+static int s2n_test_recv_all(struct s2n_connection *conn, uint8_t *data, ssize_t size)
+{
+    s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+    ssize_t total = 0;
+    while (total < size) {
+        ssize_t r = s2n_recv(conn, data + total, size - total, &blocked);
+        POSIX_ENSURE_GT(r, 0);
+        total += r;
+    }
+    return S2N_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    static uint8_t test_data[S2N_TEST_FILE_SIZE] = { 0 };
+    for (size_t i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = (uint8_t) i;
+    }
+
+    FILE *test_file = tmpfile();
+    EXPECT_NOT_NULL(test_file);
+    EXPECT_EQUAL(fwrite(test_data, 1, sizeof(test_data), test_file), sizeof(test_data));
+    EXPECT_SUCCESS(fflush(test_file));
+    const int fd = fileno(test_file);
+
+    struct s2n_cert_chain_and_key *chain_and_key = NULL;
+    EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+            S2N_DEFAULT_ECDSA_TEST_CERT_CHAIN, S2N_DEFAULT_ECDSA_TEST_PRIVATE_KEY));
+
+    struct s2n_config *server_config = s2n_config_new();
+    EXPECT_NOT_NULL(server_config);
+    EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+
+    struct s2n_config *client_config = s2n_config_new();
+    EXPECT_NOT_NULL(client_config);
+    EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+    /* Safety */
+    {
+        struct s2n_connection *conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(conn);
+
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        EXPECT_FAILURE_WITH_ERRNO(s2n_sendfile(NULL, fd, 0, 1, &blocked), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_sendfile(conn, fd, 0, 1, NULL), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_sendfile(conn, -1, 0, 1, &blocked), S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_sendfile(conn, fd, -1, 1, &blocked), S2N_ERR_INVALID_ARGUMENT);
+
+        EXPECT_SUCCESS(s2n_connection_free(conn));
+    }
+
+    /* The file is sent in records of the usual size */
+    const char *policies[] = { "ELBSecurityPolicy-TLS-1-2-2017-01", "default_tls13" };
+    for (size_t i = 0; i < s2n_array_len(policies); i++) {
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, server_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, policies[i]));
+        EXPECT_SUCCESS(s2n_connection_prefer_throughput(server_conn));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, policies[i]));
+
+        DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+        DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        struct s2n_test_send_ctx send_ctx = { .output = &output };
+        EXPECT_SUCCESS(s2n_connection_set_send_cb(server_conn, s2n_test_counting_send_fn));
+        EXPECT_SUCCESS(s2n_connection_set_send_ctx(server_conn, &send_ctx));
+
+        static uint8_t received[S2N_TEST_FILE_SIZE] = { 0 };
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+
+        /* The whole file */
+        EXPECT_EQUAL(s2n_sendfile(server_conn, fd, 0, sizeof(test_data), &blocked), sizeof(test_data));
+        EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+        EXPECT_EQUAL(send_ctx.calls, S2N_TEST_RECORD_COUNT);
+        EXPECT_SUCCESS(s2n_test_recv_all(client_conn, received, sizeof(test_data)));
+        EXPECT_BYTEARRAY_EQUAL(received, test_data, sizeof(test_data));
+
+        /* A range in the middle of the file */
+        const off_t offset = 1000;
+        const size_t count = S2N_TLS_MAXIMUM_FRAGMENT_LENGTH + 10;
+        EXPECT_EQUAL(s2n_sendfile(server_conn, fd, offset, count, &blocked), count);
+        EXPECT_SUCCESS(s2n_test_recv_all(client_conn, received, count));
+        EXPECT_BYTEARRAY_EQUAL(received, test_data + offset, count);
+
+        /* Nothing to send */
+        EXPECT_EQUAL(s2n_sendfile(server_conn, fd, 0, 0, &blocked), 0);
+        EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+
+        /* Reading past the end of the file fails */
+        EXPECT_FAILURE_WITH_ERRNO(s2n_sendfile(server_conn, fd, sizeof(test_data), 1, &blocked),
+                S2N_ERR_INVALID_ARGUMENT);
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+    }
+
+    /* Partial writes are reported like they are by s2n_sendv_with_offset */
+    {
+        struct s2n_config *buffered_config = s2n_config_new();
+        EXPECT_NOT_NULL(buffered_config);
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(buffered_config, chain_and_key));
+        EXPECT_SUCCESS(s2n_config_set_send_buffer_size(buffered_config, S2N_TEST_SEND_BUFFER_SIZE));
+
+        struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+        EXPECT_NOT_NULL(server_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(server_conn, buffered_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(server_conn, "default_tls13"));
+        EXPECT_SUCCESS(s2n_connection_prefer_throughput(server_conn));
+
+        struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+        EXPECT_NOT_NULL(client_conn);
+        EXPECT_SUCCESS(s2n_connection_set_config(client_conn, client_config));
+        EXPECT_SUCCESS(s2n_connection_set_cipher_preferences(client_conn, "default_tls13"));
+
+        DEFER_CLEANUP(struct s2n_stuffer input, s2n_stuffer_free);
+        DEFER_CLEANUP(struct s2n_stuffer output, s2n_stuffer_free);
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&input, 0));
+        EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&output, 0));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&input, &output, server_conn));
+        EXPECT_SUCCESS(s2n_connection_set_io_stuffers(&output, &input, client_conn));
+
+        EXPECT_SUCCESS(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+        struct s2n_test_send_ctx send_ctx = { .output = &output, .calls_until_blocked = 1 };
+        EXPECT_SUCCESS(s2n_connection_set_send_cb(server_conn, s2n_test_counting_send_fn));
+        EXPECT_SUCCESS(s2n_connection_set_send_ctx(server_conn, &send_ctx));
+
+        /* Only the first batch of records reaches the network */
+        s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+        const ssize_t first_batch_size = S2N_TLS_MAXIMUM_FRAGMENT_LENGTH * 4;
+        EXPECT_EQUAL(s2n_sendfile(server_conn, fd, 0, sizeof(test_data), &blocked), first_batch_size);
+        EXPECT_EQUAL(blocked, S2N_BLOCKED_ON_WRITE);
+
+        /* Retrying with the rest of the file sends the buffered records first */
+        send_ctx.calls_until_blocked = 0;
+        EXPECT_EQUAL(s2n_sendfile(server_conn, fd, first_batch_size, sizeof(test_data) - first_batch_size, &blocked),
+                sizeof(test_data) - first_batch_size);
+        EXPECT_EQUAL(blocked, S2N_NOT_BLOCKED);
+
+        static uint8_t received[S2N_TEST_FILE_SIZE] = { 0 };
+        EXPECT_SUCCESS(s2n_test_recv_all(client_conn, received, sizeof(received)));
+        EXPECT_BYTEARRAY_EQUAL(received, test_data, sizeof(test_data));
+
+        EXPECT_SUCCESS(s2n_connection_free(server_conn));
+        EXPECT_SUCCESS(s2n_connection_free(client_conn));
+        EXPECT_SUCCESS(s2n_config_free(buffered_config));
+    }
+
+    EXPECT_SUCCESS(s2n_config_free(server_config));
+    EXPECT_SUCCESS(s2n_config_free(client_config));
+    EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    EXPECT_SUCCESS(fclose(test_file));
+    END_TEST();
+}
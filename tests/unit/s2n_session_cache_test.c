@@ -0,0 +1,303 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+#include "testlib/s2n_testlib.h"
+
+#include <string.h>
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "tls/s2n_session_cache.h"
+
+#define S2N_TEST_SESSION_LIFETIME 100
+
+static uint8_t ticket_key_name[] = "2016.07.26.15\0";
+static uint8_t ticket_key[32] = { 0x07, 0x77, 0x09, 0x36, 0x2c, 0x2e, 0x32, 0xdf, 0x0d, 0xdc,
+                                  0x3f, 0x0d, 0xc4, 0x7b, 0xba, 0x63, 0x90, 0xb6, 0xc7, 0x3b,
+                                  0xb5, 0x0f, 0x9c, 0x31, 0x22, 0xec, 0x84, 0x4a, 0xd7, 0xc2,
+                                  0xb3, 0xe5 };
+
+static int s2n_test_cache_resumption_handshake(struct s2n_config *server_config, struct s2n_config *client_config,
+        uint8_t *session, size_t *session_len, bool *resumed)
+{
+    struct s2n_connection *server_conn = s2n_connection_new(S2N_SERVER);
+    POSIX_ENSURE_REF(server_conn);
+    struct s2n_connection *client_conn = s2n_connection_new(S2N_CLIENT);
+    POSIX_ENSURE_REF(client_conn);
+    POSIX_GUARD(s2n_connection_set_config(server_conn, server_config));
+    POSIX_GUARD(s2n_connection_set_config(client_conn, client_config));
+
+    if (*session_len) {
+        POSIX_GUARD(s2n_connection_set_session(client_conn, session, *session_len));
+    }
+
+    struct s2n_test_io_pair io_pair = { 0 };
+    POSIX_GUARD(s2n_io_pair_init_non_blocking(&io_pair));
+    POSIX_GUARD(s2n_connections_set_io_pair(client_conn, server_conn, &io_pair));
+    POSIX_GUARD(s2n_negotiate_test_server_and_client(server_conn, client_conn));
+
+    *resumed = IS_RESUMPTION_HANDSHAKE(server_conn);
+    int length = s2n_connection_get_session_length(client_conn);
+    POSIX_GUARD(length);
+    POSIX_ENSURE_EQ(s2n_connection_get_session(client_conn, session, length), length);
+    *session_len = length;
+
+    POSIX_GUARD(s2n_shutdown_test_server_and_client(server_conn, client_conn));
+    POSIX_GUARD(s2n_connection_free(server_conn));
+    POSIX_GUARD(s2n_connection_free(client_conn));
+    POSIX_GUARD(s2n_io_pair_close(&io_pair));
+    return S2N_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    uint8_t state_data[S2N_TLS12_TICKET_SIZE_IN_BYTES] = { 0 };
+    struct s2n_blob state = { 0 };
+    EXPECT_SUCCESS(s2n_blob_init(&state, state_data, sizeof(state_data)));
+
+    uint8_t out_data[S2N_TLS12_TICKET_SIZE_IN_BYTES] = { 0 };
+    struct s2n_blob out = { 0 };
+    EXPECT_SUCCESS(s2n_blob_init(&out, out_data, sizeof(out_data)));
+
+    uint8_t session_id[S2N_TLS_SESSION_ID_MAX_LEN] = { 0 };
+    bool found = false;
+
+    /* Safety */
+    {
+        EXPECT_NULL_WITH_ERRNO(s2n_session_cache_new(0), S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_NULL_WITH_ERRNO(s2n_session_cache_new(sizeof(struct s2n_session_cache_entry)), S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_session_cache_free(NULL), S2N_ERR_NULL);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_config_set_session_cache(NULL, NULL), S2N_ERR_NULL);
+
+        struct s2n_session_cache *cache = s2n_session_cache_new(UINT16_MAX);
+        EXPECT_NOT_NULL(cache);
+        EXPECT_FAILURE_WITH_ERRNO(s2n_session_cache_get_stats(cache, NULL), S2N_ERR_NULL);
+        EXPECT_ERROR_WITH_ERRNO(s2n_session_cache_store(cache, 0, S2N_TEST_SESSION_LIFETIME, session_id, 0, &state),
+                S2N_ERR_SESSION_ID_TOO_SHORT);
+        EXPECT_ERROR_WITH_ERRNO(s2n_session_cache_store(cache, 0, S2N_TEST_SESSION_LIFETIME, session_id, S2N_TLS_SESSION_ID_MAX_LEN + 1, &state),
+                S2N_ERR_SESSION_ID_TOO_LONG);
+        EXPECT_ERROR_WITH_ERRNO(s2n_session_cache_store(cache, 0, 0, session_id, sizeof(session_id), &state),
+                S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_ERROR_WITH_ERRNO(s2n_session_cache_store(cache, UINT64_MAX, 1, session_id, sizeof(session_id), &state),
+                S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_SUCCESS(s2n_session_cache_free(cache));
+    }
+
+    /* The memory budget bounds the number of shards and entries */
+    {
+        struct s2n_session_cache *cache = s2n_session_cache_new(S2N_SESSION_CACHE_BUCKET_WAYS * sizeof(struct s2n_session_cache_entry));
+        EXPECT_NOT_NULL(cache);
+        EXPECT_EQUAL(cache->shard_count, 1);
+        EXPECT_EQUAL(cache->shards[0].bucket_count, 1);
+        EXPECT_SUCCESS(s2n_session_cache_free(cache));
+
+        const uint64_t max_entries = 1000;
+        cache = s2n_session_cache_new(max_entries * sizeof(struct s2n_session_cache_entry));
+        EXPECT_NOT_NULL(cache);
+        EXPECT_EQUAL(cache->shard_count, S2N_SESSION_CACHE_MAX_SHARDS);
+        uint64_t entries = 0;
+        for (uint32_t i = 0; i < cache->shard_count; i++) {
+            entries += cache->shards[i].bucket_count * S2N_SESSION_CACHE_BUCKET_WAYS;
+        }
+        EXPECT_TRUE(entries <= max_entries);
+        EXPECT_TRUE(entries > max_entries - S2N_SESSION_CACHE_MAX_SHARDS * S2N_SESSION_CACHE_BUCKET_WAYS);
+        EXPECT_SUCCESS(s2n_session_cache_free(cache));
+    }
+
+    /* A budget too large for the shards is rejected instead of truncating their allocations */
+    {
+        const uint64_t entry_size = sizeof(struct s2n_session_cache_entry);
+        const uint64_t max_shard_size = S2N_SESSION_CACHE_MAX_BUCKETS_PER_SHARD * S2N_SESSION_CACHE_BUCKET_WAYS * entry_size;
+        EXPECT_TRUE(max_shard_size <= UINT32_MAX);
+
+        const uint64_t oversized_budget = S2N_SESSION_CACHE_MAX_SHARDS * (max_shard_size + S2N_SESSION_CACHE_BUCKET_WAYS * entry_size);
+        EXPECT_NULL_WITH_ERRNO(s2n_session_cache_new(oversized_budget), S2N_ERR_INVALID_ARGUMENT);
+        EXPECT_NULL_WITH_ERRNO(s2n_session_cache_new(UINT64_MAX), S2N_ERR_INVALID_ARGUMENT);
+    }
+
+    /* Store, retrieve and delete */
+    {
+        struct s2n_session_cache *cache = s2n_session_cache_new(UINT16_MAX);
+        EXPECT_NOT_NULL(cache);
+
+        memset(session_id, 1, sizeof(session_id));
+        memset(state_data, 2, sizeof(state_data));
+        EXPECT_OK(s2n_session_cache_retrieve(cache, 0, session_id, sizeof(session_id), &out, &found));
+        EXPECT_FALSE(found);
+
+        EXPECT_OK(s2n_session_cache_store(cache, 0, S2N_TEST_SESSION_LIFETIME, session_id, sizeof(session_id), &state));
+        EXPECT_OK(s2n_session_cache_retrieve(cache, 0, session_id, sizeof(session_id), &out, &found));
+        EXPECT_TRUE(found);
+        EXPECT_BYTEARRAY_EQUAL(out_data, state_data, sizeof(state_data));
+
+        /* Ids only match with the same length */
+        EXPECT_OK(s2n_session_cache_retrieve(cache, 0, session_id, sizeof(session_id) - 1, &out, &found));
+        EXPECT_FALSE(found);
+
+        /* Storing the same id again replaces the session */
+        memset(state_data, 3, sizeof(state_data));
+        EXPECT_OK(s2n_session_cache_store(cache, 0, S2N_TEST_SESSION_LIFETIME, session_id, sizeof(session_id), &state));
+        EXPECT_OK(s2n_session_cache_retrieve(cache, 0, session_id, sizeof(session_id), &out, &found));
+        EXPECT_TRUE(found);
+        EXPECT_BYTEARRAY_EQUAL(out_data, state_data, sizeof(state_data));
+
+        struct s2n_session_cache_stats stats = { 0 };
+        EXPECT_SUCCESS(s2n_session_cache_get_stats(cache, &stats));
+        EXPECT_EQUAL(stats.entries, 1);
+        EXPECT_EQUAL(stats.stores, 2);
+        EXPECT_EQUAL(stats.hits, 2);
+        EXPECT_EQUAL(stats.misses, 2);
+
+        EXPECT_OK(s2n_session_cache_delete(cache, session_id, sizeof(session_id)));
+        EXPECT_OK(s2n_session_cache_retrieve(cache, 0, session_id, sizeof(session_id), &out, &found));
+        EXPECT_FALSE(found);
+
+        /* Deleting a missing session is not an error */
+        EXPECT_OK(s2n_session_cache_delete(cache, session_id, sizeof(session_id)));
+
+        EXPECT_SUCCESS(s2n_session_cache_get_stats(cache, &stats));
+        EXPECT_EQUAL(stats.entries, 0);
+        EXPECT_EQUAL(stats.deletes, 1);
+        EXPECT_EQUAL(stats.misses, 3);
+
+        EXPECT_SUCCESS(s2n_session_cache_free(cache));
+    }
+
+    /* Sessions expire */
+    {
+        struct s2n_session_cache *cache = s2n_session_cache_new(UINT16_MAX);
+        EXPECT_NOT_NULL(cache);
+
+        EXPECT_OK(s2n_session_cache_store(cache, 10, S2N_TEST_SESSION_LIFETIME, session_id, sizeof(session_id), &state));
+        EXPECT_OK(s2n_session_cache_retrieve(cache, 10 + S2N_TEST_SESSION_LIFETIME - 1, session_id, sizeof(session_id), &out, &found));
+        EXPECT_TRUE(found);
+        EXPECT_OK(s2n_session_cache_retrieve(cache, 10 + S2N_TEST_SESSION_LIFETIME, session_id, sizeof(session_id), &out, &found));
+        EXPECT_FALSE(found);
+
+        struct s2n_session_cache_stats stats = { 0 };
+        EXPECT_SUCCESS(s2n_session_cache_get_stats(cache, &stats));
+        EXPECT_EQUAL(stats.entries, 0);
+        EXPECT_EQUAL(stats.expirations, 1);
+
+        EXPECT_SUCCESS(s2n_session_cache_free(cache));
+    }
+
+    /* A full cache evicts the session closest to expiring */
+    {
+        struct s2n_session_cache *cache = s2n_session_cache_new(S2N_SESSION_CACHE_BUCKET_WAYS * sizeof(struct s2n_session_cache_entry));
+        EXPECT_NOT_NULL(cache);
+
+        for (uint8_t i = 0; i < S2N_SESSION_CACHE_BUCKET_WAYS; i++) {
+            session_id[0] = i;
+            EXPECT_OK(s2n_session_cache_store(cache, i, S2N_TEST_SESSION_LIFETIME, session_id, sizeof(session_id), &state));
+        }
+
+        session_id[0] = S2N_SESSION_CACHE_BUCKET_WAYS;
+        EXPECT_OK(s2n_session_cache_store(cache, S2N_SESSION_CACHE_BUCKET_WAYS, S2N_TEST_SESSION_LIFETIME,
+                session_id, sizeof(session_id), &state));
+
+        for (uint8_t i = 0; i <= S2N_SESSION_CACHE_BUCKET_WAYS; i++) {
+            session_id[0] = i;
+            EXPECT_OK(s2n_session_cache_retrieve(cache, S2N_SESSION_CACHE_BUCKET_WAYS, session_id, sizeof(session_id), &out, &found));
+            EXPECT_EQUAL(found, i != 0);
+        }
+
+        struct s2n_session_cache_stats stats = { 0 };
+        EXPECT_SUCCESS(s2n_session_cache_get_stats(cache, &stats));
+        EXPECT_EQUAL(stats.entries, S2N_SESSION_CACHE_BUCKET_WAYS);
+        EXPECT_EQUAL(stats.evictions, 1);
+        EXPECT_EQUAL(stats.expirations, 0);
+
+        /* Once sessions expire, they are reclaimed rather than evicted */
+        session_id[0] = S2N_SESSION_CACHE_BUCKET_WAYS + 1;
+        EXPECT_OK(s2n_session_cache_store(cache, UINT32_MAX, S2N_TEST_SESSION_LIFETIME, session_id, sizeof(session_id), &state));
+        EXPECT_SUCCESS(s2n_session_cache_get_stats(cache, &stats));
+        EXPECT_EQUAL(stats.evictions, 1);
+        EXPECT_EQUAL(stats.expirations, 1);
+
+        EXPECT_SUCCESS(s2n_session_cache_free(cache));
+    }
+
+    /* A server resumes sessions from the built-in cache without any cache callbacks */
+    {
+        struct s2n_cert_chain_and_key *chain_and_key = NULL;
+        EXPECT_SUCCESS(s2n_test_cert_chain_and_key_new(&chain_and_key,
+                S2N_DEFAULT_TEST_CERT_CHAIN, S2N_DEFAULT_TEST_PRIVATE_KEY));
+
+        struct s2n_session_cache *cache = s2n_session_cache_new(UINT16_MAX);
+        EXPECT_NOT_NULL(cache);
+
+        struct s2n_config *server_config = s2n_config_new();
+        EXPECT_NOT_NULL(server_config);
+        EXPECT_SUCCESS(s2n_config_set_cipher_preferences(server_config, "20170210"));
+        EXPECT_SUCCESS(s2n_config_add_cert_chain_and_key_to_store(server_config, chain_and_key));
+
+        /* Without a cache or callbacks, session caching can't be enabled */
+        EXPECT_SUCCESS(s2n_config_set_session_cache_onoff(server_config, 1));
+        EXPECT_FALSE(server_config->use_session_cache);
+
+        EXPECT_SUCCESS(s2n_config_set_session_cache(server_config, cache));
+        EXPECT_TRUE(server_config->use_session_cache);
+        EXPECT_SUCCESS(s2n_config_add_ticket_crypto_key(server_config, ticket_key_name, strlen((char *) ticket_key_name),
+                ticket_key, sizeof(ticket_key), 0));
+
+        struct s2n_config *client_config = s2n_config_new();
+        EXPECT_NOT_NULL(client_config);
+        EXPECT_SUCCESS(s2n_config_set_cipher_preferences(client_config, "20170210"));
+        EXPECT_SUCCESS(s2n_config_disable_x509_verification(client_config));
+
+        uint8_t session[S2N_TLS12_SESSION_SIZE] = { 0 };
+        size_t session_len = 0;
+        bool resumed = false;
+
+        EXPECT_SUCCESS(s2n_test_cache_resumption_handshake(server_config, client_config, session, &session_len, &resumed));
+        EXPECT_FALSE(resumed);
+
+        struct s2n_session_cache_stats stats = { 0 };
+        EXPECT_SUCCESS(s2n_session_cache_get_stats(cache, &stats));
+        EXPECT_EQUAL(stats.stores, 1);
+        EXPECT_EQUAL(stats.entries, 1);
+
+        EXPECT_SUCCESS(s2n_test_cache_resumption_handshake(server_config, client_config, session, &session_len, &resumed));
+        EXPECT_TRUE(resumed);
+
+        EXPECT_SUCCESS(s2n_session_cache_get_stats(cache, &stats));
+        EXPECT_EQUAL(stats.hits, 1);
+
+        /* Sessions deleted from the cache fall back to a full handshake */
+        uint8_t cached_session_id[S2N_TLS_SESSION_ID_MAX_LEN] = { 0 };
+        memcpy(cached_session_id, session + S2N_STATE_FORMAT_LEN + 1, S2N_TLS_SESSION_ID_MAX_LEN);
+        EXPECT_OK(s2n_session_cache_delete(cache, cached_session_id, S2N_TLS_SESSION_ID_MAX_LEN));
+        EXPECT_SUCCESS(s2n_session_cache_get_stats(cache, &stats));
+        EXPECT_EQUAL(stats.deletes, 1);
+
+        EXPECT_SUCCESS(s2n_test_cache_resumption_handshake(server_config, client_config, session, &session_len, &resumed));
+        EXPECT_FALSE(resumed);
+
+        /* Detaching the cache disables session caching again */
+        EXPECT_SUCCESS(s2n_config_set_session_cache(server_config, NULL));
+        EXPECT_FALSE(server_config->use_session_cache);
+
+        EXPECT_SUCCESS(s2n_config_free(server_config));
+        EXPECT_SUCCESS(s2n_config_free(client_config));
+        EXPECT_SUCCESS(s2n_session_cache_free(cache));
+        EXPECT_SUCCESS(s2n_cert_chain_and_key_free(chain_and_key));
+    }
+
+    END_TEST();
+}
@@ -49,6 +49,12 @@ static int mock_time(void *data, uint64_t *nanoseconds)
     return S2N_SUCCESS;
 }
 
+static int mock_fixed_time(void *data, uint64_t *nanoseconds)
+{
+    *nanoseconds = *(uint64_t *) data;
+    return S2N_SUCCESS;
+}
+
 uint8_t cb_session_data[S2N_TLS12_SESSION_SIZE] = { 0 };
 size_t cb_session_data_len = 0;
 uint32_t cb_session_lifetime = 0;
@@ -1039,6 +1045,139 @@ int main(int argc, char **argv)
         EXPECT_SUCCESS(s2n_config_free(server_config));
     }
 
+    /* Ticket keys reuse their keyed AES-GCM contexts for every ticket and connection */
+    {
+        EXPECT_NOT_NULL(server_config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_set_session_tickets_onoff(server_config, 1));
+        EXPECT_SUCCESS(s2n_config_add_ticket_crypto_key(server_config, ticket_key_name1, strlen((char *)ticket_key_name1), ticket_key1, sizeof(ticket_key1), 0));
+
+        /* The contexts are created when the key is added */
+        EXPECT_OK(s2n_set_get(server_config->ticket_keys, 0, (void **)&ticket_key));
+        EXPECT_NOT_NULL(ticket_key->encrypt_key.evp_cipher_ctx);
+        EXPECT_NOT_NULL(ticket_key->decrypt_key.evp_cipher_ctx);
+        struct s2n_session_key encrypt_key = ticket_key->encrypt_key;
+        struct s2n_session_key decrypt_key = ticket_key->decrypt_key;
+
+        for (uint8_t i = 0; i < 10; i++) {
+            struct s2n_connection *encrypt_conn = NULL, *decrypt_conn = NULL;
+            EXPECT_NOT_NULL(encrypt_conn = s2n_connection_new(S2N_SERVER));
+            EXPECT_NOT_NULL(decrypt_conn = s2n_connection_new(S2N_SERVER));
+            EXPECT_SUCCESS(s2n_connection_set_config(encrypt_conn, server_config));
+            EXPECT_SUCCESS(s2n_connection_set_config(decrypt_conn, server_config));
+            encrypt_conn->actual_protocol_version = S2N_TLS12;
+            decrypt_conn->actual_protocol_version = S2N_TLS12;
+            memset(encrypt_conn->secure.master_secret, i, S2N_TLS_SECRET_LEN);
+
+            DEFER_CLEANUP(struct s2n_stuffer ticket = { 0 }, s2n_stuffer_free);
+            EXPECT_SUCCESS(s2n_stuffer_growable_alloc(&ticket, 0));
+            EXPECT_SUCCESS(s2n_encrypt_session_cache(encrypt_conn, &ticket));
+            EXPECT_SUCCESS(s2n_decrypt_session_cache(decrypt_conn, &ticket));
+            EXPECT_BYTEARRAY_EQUAL(decrypt_conn->secure.master_secret, encrypt_conn->secure.master_secret, S2N_TLS_SECRET_LEN);
+
+            EXPECT_SUCCESS(s2n_connection_free(encrypt_conn));
+            EXPECT_SUCCESS(s2n_connection_free(decrypt_conn));
+        }
+
+        /* No ticket replaced the key's contexts */
+        EXPECT_OK(s2n_set_get(server_config->ticket_keys, 0, (void **)&ticket_key));
+        EXPECT_EQUAL(ticket_key->encrypt_key.evp_cipher_ctx, encrypt_key.evp_cipher_ctx);
+        EXPECT_EQUAL(ticket_key->decrypt_key.evp_cipher_ctx, decrypt_key.evp_cipher_ctx);
+
+        EXPECT_SUCCESS(s2n_config_free(server_config));
+    }
+
+    /* Ticket keys are indexed by name and by when they are in encrypt-decrypt state */
+    {
+        const uint64_t one_hour_in_secs = 3600;
+        const uint64_t start_in_secs = ONE_WEEK_IN_SEC;
+        uint64_t mock_now = start_in_secs * ONE_SEC_IN_NANOS;
+
+        EXPECT_NOT_NULL(server_config = s2n_config_new());
+        EXPECT_SUCCESS(s2n_config_set_session_tickets_onoff(server_config, 1));
+        EXPECT_SUCCESS(s2n_config_set_wall_clock(server_config, mock_fixed_time, &mock_now));
+
+        /* With the default 2 hour encrypt-decrypt lifetime, key1 and key2 overlap now and key2 and key3 overlap in 90 minutes */
+        EXPECT_SUCCESS(s2n_config_add_ticket_crypto_key(server_config, ticket_key_name1, strlen((char *)ticket_key_name1),
+                ticket_key1, sizeof(ticket_key1), start_in_secs - one_hour_in_secs));
+        EXPECT_SUCCESS(s2n_config_add_ticket_crypto_key(server_config, ticket_key_name2, strlen((char *)ticket_key_name2),
+                ticket_key2, sizeof(ticket_key2), start_in_secs - one_hour_in_secs / 2));
+        EXPECT_SUCCESS(s2n_config_add_ticket_crypto_key(server_config, ticket_key_name3, strlen((char *)ticket_key_name3),
+                ticket_key3, sizeof(ticket_key3), start_in_secs + one_hour_in_secs));
+
+        /* Every key starts and ends an epoch, plus the empty epoch before any key */
+        EXPECT_EQUAL(server_config->ticket_key_epoch_count, 7);
+
+        struct s2n_ticket_key *key1 = s2n_find_ticket_key(server_config, ticket_key_name1);
+        struct s2n_ticket_key *key2 = s2n_find_ticket_key(server_config, ticket_key_name2);
+        struct s2n_ticket_key *key3 = s2n_find_ticket_key(server_config, ticket_key_name3);
+        EXPECT_NOT_NULL(key1);
+        EXPECT_NOT_NULL(key2);
+        EXPECT_NOT_NULL(key3);
+        EXPECT_BYTEARRAY_EQUAL(key1->key_name, ticket_key_name1, sizeof(ticket_key_name1));
+        EXPECT_BYTEARRAY_EQUAL(key2->key_name, ticket_key_name2, sizeof(ticket_key_name2));
+        EXPECT_BYTEARRAY_EQUAL(key3->key_name, ticket_key_name3, sizeof(ticket_key_name3));
+
+        uint8_t unknown_key_name[S2N_TICKET_KEY_NAME_LEN] = "unknown";
+        EXPECT_NULL(s2n_find_ticket_key(server_config, unknown_key_name));
+
+        /* key1 and key2 are both in encrypt-decrypt state, and both get picked */
+        bool key1_picked = false, key2_picked = false;
+        for (int i = 0; i < 100; i++) {
+            struct s2n_ticket_key *picked = s2n_get_ticket_encrypt_decrypt_key(server_config);
+            EXPECT_TRUE(picked == key1 || picked == key2);
+            key1_picked |= (picked == key1);
+            key2_picked |= (picked == key2);
+        }
+        EXPECT_TRUE(key1_picked);
+        EXPECT_TRUE(key2_picked);
+
+        /* In two hours only key3 is in encrypt-decrypt state */
+        mock_now = (start_in_secs + 2 * one_hour_in_secs) * ONE_SEC_IN_NANOS;
+        EXPECT_EQUAL(s2n_config_is_encrypt_decrypt_key_available(server_config), 1);
+        EXPECT_EQUAL(s2n_get_ticket_encrypt_decrypt_key(server_config), key3);
+
+        /* In four hours no key can encrypt */
+        mock_now = (start_in_secs + 4 * one_hour_in_secs) * ONE_SEC_IN_NANOS;
+        EXPECT_EQUAL(s2n_config_is_encrypt_decrypt_key_available(server_config), 0);
+        EXPECT_NULL(s2n_get_ticket_encrypt_decrypt_key(server_config));
+
+        /* Once key1 expires it can no longer be found, but a lookup doesn't free it:
+         * other connections may still be using its session keys.
+         */
+        void *key1_encrypt_ctx = key1->encrypt_key.evp_cipher_ctx;
+        void *key1_decrypt_ctx = key1->decrypt_key.evp_cipher_ctx;
+        struct s2n_map *ticket_key_names = server_config->ticket_key_names;
+        const uint8_t ticket_key_epoch_count = server_config->ticket_key_epoch_count;
+        mock_now = (start_in_secs + 14 * one_hour_in_secs + one_hour_in_secs / 4) * ONE_SEC_IN_NANOS;
+        EXPECT_NULL(s2n_find_ticket_key(server_config, ticket_key_name1));
+        EXPECT_NULL(s2n_get_ticket_encrypt_decrypt_key(server_config));
+        EXPECT_OK(s2n_set_len(server_config->ticket_keys, &ticket_keys_len));
+        EXPECT_EQUAL(ticket_keys_len, 3);
+        EXPECT_EQUAL(key1->encrypt_key.evp_cipher_ctx, key1_encrypt_ctx);
+        EXPECT_EQUAL(key1->decrypt_key.evp_cipher_ctx, key1_decrypt_ctx);
+
+        /* Lookups don't rebuild the index that other handshakes are reading */
+        EXPECT_EQUAL(server_config->ticket_key_names, ticket_key_names);
+        EXPECT_EQUAL(server_config->ticket_key_epoch_count, ticket_key_epoch_count);
+
+        /* Adding a key removes key1, and the remaining keys are still found by name */
+        uint8_t ticket_key_name4[16] = "2019.07.26.15\0";
+        uint8_t ticket_key4[sizeof(ticket_key3)] = { 0 };
+        EXPECT_MEMCPY_SUCCESS(ticket_key4, ticket_key3, sizeof(ticket_key3));
+        ticket_key4[0] ^= 1;
+        EXPECT_SUCCESS(s2n_config_add_ticket_crypto_key(server_config, ticket_key_name4, strlen((char *)ticket_key_name4),
+                ticket_key4, sizeof(ticket_key4), start_in_secs + 14 * one_hour_in_secs));
+        EXPECT_OK(s2n_set_len(server_config->ticket_keys, &ticket_keys_len));
+        EXPECT_EQUAL(ticket_keys_len, 3);
+        EXPECT_NULL(s2n_find_ticket_key(server_config, ticket_key_name1));
+        EXPECT_NOT_NULL(key2 = s2n_find_ticket_key(server_config, ticket_key_name2));
+        EXPECT_NOT_NULL(key3 = s2n_find_ticket_key(server_config, ticket_key_name3));
+        EXPECT_BYTEARRAY_EQUAL(key2->key_name, ticket_key_name2, sizeof(ticket_key_name2));
+        EXPECT_BYTEARRAY_EQUAL(key3->key_name, ticket_key_name3, sizeof(ticket_key_name3));
+
+        EXPECT_SUCCESS(s2n_config_free(server_config));
+    }
+
     /* Test s2n_connection_is_session_resumed */
     {
         EXPECT_NOT_NULL(server_conn = s2n_connection_new(S2N_SERVER));
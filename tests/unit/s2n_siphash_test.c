@@ -0,0 +1,62 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "s2n_test.h"
+
+#include "utils/s2n_siphash.h"
+
+struct s2n_siphash_test_vector {
+    uint32_t len;
+    uint64_t expected;
+};
+
+/* SipHash-1-3 with key 00 01 .. 0f over the input 00 01 .. (len - 1) */
+static const struct s2n_siphash_test_vector test_vectors[] = {
+    { .len = 0, .expected = 0xabac0158050fc4dcULL },
+    { .len = 1, .expected = 0xc9f49bf37d57ca93ULL },
+    { .len = 7, .expected = 0xd3927d989bb11140ULL },
+    { .len = 8, .expected = 0x369095118d299a8eULL },
+    { .len = 15, .expected = 0xd320d86d2a519956ULL },
+    { .len = 64, .expected = 0xf17997ec4b4a6065ULL },
+};
+
+int main(int argc, char **argv)
+{
+    BEGIN_TEST();
+
+    uint8_t key[S2N_SIPHASH_KEY_LEN] = { 0 };
+    for (size_t i = 0; i < sizeof(key); i++) {
+        key[i] = i;
+    }
+
+    uint8_t input[64] = { 0 };
+    for (size_t i = 0; i < sizeof(input); i++) {
+        input[i] = i;
+    }
+
+    /* Known answers */
+    for (size_t i = 0; i < s2n_array_len(test_vectors); i++) {
+        EXPECT_EQUAL(s2n_siphash13(key, input, test_vectors[i].len), test_vectors[i].expected);
+    }
+
+    /* A different key gives a different hash */
+    {
+        uint64_t hash = s2n_siphash13(key, input, sizeof(input));
+        key[0] ^= 1;
+        EXPECT_NOT_EQUAL(s2n_siphash13(key, input, sizeof(input)), hash);
+    }
+
+    END_TEST();
+}
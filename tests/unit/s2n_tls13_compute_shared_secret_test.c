@@ -59,7 +59,7 @@ int main(int argc, char **argv) {
         /* Recreating conditions where negotiated curve was not set */
         struct s2n_ecc_evp_params missing_params = {NULL,NULL};
         client_conn->secure.server_ecc_evp_params = missing_params;
-        DEFER_CLEANUP(struct s2n_blob client_shared_secret = {0}, s2n_free);
+        struct s2n_blob client_shared_secret = {0};
         /* Compute fails because server's curve and public key are missing. */
         EXPECT_FAILURE_WITH_ERRNO(s2n_tls13_compute_shared_secret(client_conn, &client_shared_secret), S2N_ERR_NULL);
 
@@ -85,7 +85,7 @@ int main(int argc, char **argv) {
         /* Set curve server sent in server hello */
         client_conn->secure.server_ecc_evp_params.negotiated_curve = ecc_pref->ecc_curves[0];
 
-        DEFER_CLEANUP(struct s2n_blob client_shared_secret = {0}, s2n_free);
+        struct s2n_blob client_shared_secret = {0};
         /* Compute fails because server's public key is missing */
         EXPECT_FAILURE_WITH_ERRNO(s2n_tls13_compute_shared_secret(client_conn, &client_shared_secret), S2N_ERR_NULL);
 
@@ -113,8 +113,11 @@ int main(int argc, char **argv) {
 
         /* Generate public key server sent in server hello */
         EXPECT_SUCCESS(s2n_ecc_evp_generate_ephemeral_key(&client_conn->secure.server_ecc_evp_params));
-        DEFER_CLEANUP(struct s2n_blob client_shared_secret = {0}, s2n_free);
+        /* The shared secret is allocated from the connection's handshake arena */
+        struct s2n_blob client_shared_secret = {0};
         EXPECT_SUCCESS(s2n_tls13_compute_shared_secret(client_conn, &client_shared_secret));
+        EXPECT_EQUAL(client_shared_secret.allocated, 0);
+        EXPECT_TRUE(client_shared_secret.size < S2N_ECC_EVP_MAX_SHARED_SECRET_SIZE);
 
         EXPECT_SUCCESS(s2n_connection_free(client_conn));
     }
@@ -139,11 +142,11 @@ int main(int argc, char **argv) {
                 s2n_stuffer_data_available(&server_conn->handshake.io)));
         EXPECT_SUCCESS(s2n_server_hello_recv(client_conn));
 
-        DEFER_CLEANUP(struct s2n_blob client_shared_secret = {0}, s2n_free);
+        struct s2n_blob client_shared_secret = {0};
         EXPECT_SUCCESS(s2n_tls13_compute_shared_secret(client_conn, &client_shared_secret));
         EXPECT_TRUE(client_shared_secret.size > 0);
 
-        DEFER_CLEANUP(struct s2n_blob server_shared_secret = {0}, s2n_free);
+        struct s2n_blob server_shared_secret = {0};
         EXPECT_SUCCESS(s2n_tls13_compute_shared_secret(server_conn, &server_shared_secret));
         EXPECT_TRUE(server_shared_secret.size > 0);
 
@@ -46,8 +46,8 @@
 static int s2n_setup_tls13_secrets_prereqs(struct s2n_connection *conn)
 {
     conn->secure.cipher_suite = &s2n_tls13_aes_128_gcm_sha256;
-    POSIX_GUARD(s2n_tls13_conn_copy_hash(conn, &conn->handshake.server_hello_copy));
-    POSIX_GUARD(s2n_tls13_conn_copy_hash(conn, &conn->handshake.server_finished_copy));
+    POSIX_GUARD(s2n_tls13_conn_copy_hash(conn, &conn->handshake.hashes->server_hello_copy));
+    POSIX_GUARD(s2n_tls13_conn_copy_hash(conn, &conn->handshake.hashes->server_finished_copy));
 
     const struct s2n_ecc_preferences *ecc_pref = NULL;
     POSIX_GUARD(s2n_connection_get_ecc_preferences(conn, &ecc_pref));
@@ -191,8 +191,8 @@ int main(int argc, char **argv)
         server_conn->secure.cipher_suite = &s2n_tls13_aes_128_gcm_sha256;
 
         /* populating server hello hash is now a requirement for s2n_tls13_handle_handshake_traffic_secret */
-        EXPECT_SUCCESS(s2n_tls13_conn_copy_hash(server_conn, &server_conn->handshake.server_hello_copy));
-        EXPECT_SUCCESS(s2n_tls13_conn_copy_hash(client_conn, &client_conn->handshake.server_hello_copy));
+        EXPECT_SUCCESS(s2n_tls13_conn_copy_hash(server_conn, &server_conn->handshake.hashes->server_hello_copy));
+        EXPECT_SUCCESS(s2n_tls13_conn_copy_hash(client_conn, &client_conn->handshake.hashes->server_hello_copy));
 
         EXPECT_SUCCESS(s2n_tls13_handle_early_secret(server_conn));
         EXPECT_SUCCESS(s2n_tls13_handle_handshake_master_secret(server_conn));
@@ -220,7 +220,7 @@ int main(int argc, char **argv)
         EXPECT_BYTEARRAY_EQUAL(server_conn->handshake.client_finished, client_conn->handshake.client_finished, client_secrets.size);
 
         /* server writes message to client in plaintext */
-        server_conn->server = &server_conn->initial;
+        server_conn->server = server_conn->initial;
         S2N_BLOB_FROM_HEX(deadbeef_from_server, "DEADBEEF");
 
         EXPECT_SUCCESS(s2n_record_write(server_conn, TLS_APPLICATION_DATA, &deadbeef_from_server));
@@ -243,7 +243,7 @@ int main(int argc, char **argv)
         S2N_STUFFER_READ_EXPECT_EQUAL(&client_conn->in, TLS_APPLICATION_DATA, uint8);
 
         /* client writes message to server in plaintext */
-        client_conn->client = &client_conn->initial;
+        client_conn->client = client_conn->initial;
         S2N_BLOB_FROM_HEX(cafefood_from_client, "CAFED00D");
         EXPECT_SUCCESS(s2n_record_write(client_conn, TLS_APPLICATION_DATA, &cafefood_from_client));
 
@@ -259,7 +259,7 @@ int main(int argc, char **argv)
         EXPECT_SUCCESS(s2n_stuffer_copy(&client_conn->out, &server_conn->in, s2n_stuffer_data_available(&client_conn->out)));
 
         /* if aead payload is parsed as plaintext, it would be of length 21 */
-        server_conn->client = &server_conn->initial;
+        server_conn->client = server_conn->initial;
         EXPECT_SUCCESS(s2n_record_parse(server_conn));
         EXPECT_EQUAL(s2n_stuffer_data_available(&server_conn->in), 21);
         EXPECT_SUCCESS(s2n_stuffer_reread(&client_conn->out));
@@ -276,8 +276,8 @@ int main(int argc, char **argv)
         S2N_STUFFER_READ_EXPECT_EQUAL(&server_conn->in, TLS_APPLICATION_DATA, uint8);
 
         /* populating server finished hash is now a requirement for s2n_tls13_handle_application_secrets */
-        EXPECT_SUCCESS(s2n_tls13_conn_copy_hash(server_conn, &server_conn->handshake.server_finished_copy));
-        EXPECT_SUCCESS(s2n_tls13_conn_copy_hash(client_conn, &client_conn->handshake.server_finished_copy));
+        EXPECT_SUCCESS(s2n_tls13_conn_copy_hash(server_conn, &server_conn->handshake.hashes->server_finished_copy));
+        EXPECT_SUCCESS(s2n_tls13_conn_copy_hash(client_conn, &client_conn->handshake.hashes->server_finished_copy));
 
         EXPECT_SUCCESS(s2n_tls13_handle_master_secret(client_conn));
         EXPECT_SUCCESS(s2n_tls13_handle_master_secret(server_conn));
@@ -606,10 +606,11 @@ int main(int argc, char **argv)
         EXPECT_SUCCESS(s2n_handshake_write_io(server_conn));
         S2N_BLOB_EXPECT_EQUAL(server_seq, seq_0);
 
-        /* Server sends EncryptedExtensions */
+        /* Server sends EncryptedExtensions
+         * The message is held back to share a record with the rest of the flight. */
         EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn), ENCRYPTED_EXTENSIONS);
         EXPECT_SUCCESS(s2n_handshake_write_io(server_conn));
-        S2N_BLOB_EXPECT_EQUAL(server_seq, seq_1);
+        S2N_BLOB_EXPECT_EQUAL(server_seq, seq_0);
 
         /* Server sends ServerCert */
         EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn), SERVER_CERT);
@@ -618,6 +619,19 @@ int main(int argc, char **argv)
         /* Server sends CertVerify */
         EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn), SERVER_CERT_VERIFY);
         EXPECT_SUCCESS(s2n_handshake_write_io(server_conn));
+        S2N_BLOB_EXPECT_EQUAL(server_seq, seq_0);
+
+        /* ServerFinished moves the server on to the master secret, so save the handshake secrets to compare */
+        uint8_t server_derive_secret[S2N_TLS13_SECRET_MAX_LEN] = { 0 };
+        uint8_t server_extract_secret[S2N_TLS13_SECRET_MAX_LEN] = { 0 };
+        EXPECT_EQUAL(server_secrets.size, 48);
+        EXPECT_MEMCPY_SUCCESS(server_derive_secret, server_secrets.derive_secret.data, server_secrets.size);
+        EXPECT_MEMCPY_SUCCESS(server_extract_secret, server_secrets.extract_secret.data, server_secrets.size);
+
+        /* Server sends ServerFinished
+         * The whole encrypted flight is written as a single record. */
+        EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn), SERVER_FINISHED);
+        EXPECT_SUCCESS(s2n_handshake_write_io(server_conn));
 
         /* Client reads ServerHello */
         EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), SERVER_HELLO);
@@ -632,28 +646,16 @@ int main(int argc, char **argv)
         EXPECT_EQUAL(client_secrets.size, 48);
 
         /* Verify that derive and extract secrets match */
-        S2N_BLOB_EXPECT_EQUAL(server_secrets.derive_secret, client_secrets.derive_secret);
-        S2N_BLOB_EXPECT_EQUAL(server_secrets.extract_secret, client_secrets.extract_secret);
+        EXPECT_BYTEARRAY_EQUAL(server_derive_secret, client_secrets.derive_secret.data, client_secrets.size);
+        EXPECT_BYTEARRAY_EQUAL(server_extract_secret, client_secrets.extract_secret.data, client_secrets.size);
 
-        /* Client reads Encrypted extensions */
+        /* Client reads EncryptedExtensions, ServerCert, CertVerify and ServerFinished from one record */
         EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), ENCRYPTED_EXTENSIONS);
         EXPECT_SUCCESS(s2n_handshake_read_io(client_conn));
-
-        /* Client reads ServerCert */
-        EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), SERVER_CERT);
-        EXPECT_SUCCESS(s2n_handshake_read_io(client_conn));
-
-        /* Client reads CertVerify */
-        EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), SERVER_CERT_VERIFY);
-        EXPECT_SUCCESS(s2n_handshake_read_io(client_conn));
-
-        /* Server sends ServerFinished */
-        EXPECT_EQUAL(s2n_conn_get_current_message_type(server_conn), SERVER_FINISHED);
-        EXPECT_SUCCESS(s2n_handshake_write_io(server_conn));
-
-        /* Client reads ServerFinished */
-        EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), SERVER_FINISHED);
-        EXPECT_SUCCESS(s2n_handshake_read_io(client_conn));
+        EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), CLIENT_CHANGE_CIPHER_SPEC);
+        struct s2n_blob client_server_seq = { .data = client_conn->secure.server_sequence_number,
+                .size = sizeof(client_conn->secure.server_sequence_number) };
+        S2N_BLOB_EXPECT_EQUAL(client_server_seq, seq_1);
 
         /* Client sends CCS */
         EXPECT_EQUAL(s2n_conn_get_current_message_type(client_conn), CLIENT_CHANGE_CIPHER_SPEC);
@@ -378,9 +378,10 @@ int main(int argc, char **argv) {
             EXPECT_SUCCESS(set_up_conns(client_conn, server_conn, test_vector->client_ecc_key,
                     test_vector->server_ecc_key, kem_group, test_vector->pq_secret));
 
-            /* Calculate the hybrid shared secret */
-            DEFER_CLEANUP(struct s2n_blob client_calculated_shared_secret = {0}, s2n_free);
-            DEFER_CLEANUP(struct s2n_blob server_calculated_shared_secret = {0}, s2n_free);
+            /* Calculate the hybrid shared secret. It is allocated from the connection's handshake arena,
+             * so it is released with the connection. */
+            struct s2n_blob client_calculated_shared_secret = {0};
+            struct s2n_blob server_calculated_shared_secret = {0};
             EXPECT_SUCCESS(s2n_tls13_compute_shared_secret(client_conn, &client_calculated_shared_secret));
             EXPECT_SUCCESS(s2n_tls13_compute_shared_secret(server_conn, &server_calculated_shared_secret));
 
@@ -435,7 +436,7 @@ int main(int argc, char **argv) {
             struct s2n_connection *conn = NULL;
             EXPECT_NOT_NULL(conn = s2n_connection_new(modes[i]));
             EXPECT_FAILURE_WITH_ERRNO(s2n_tls13_compute_pq_hybrid_shared_secret(conn, NULL), S2N_ERR_NULL);
-            DEFER_CLEANUP(struct s2n_blob calculated_shared_secret = {0}, s2n_free);
+            struct s2n_blob calculated_shared_secret = {0};
             EXPECT_FAILURE_WITH_ERRNO(s2n_tls13_compute_pq_hybrid_shared_secret(NULL, &calculated_shared_secret), S2N_ERR_NULL);
 
             /* Failures because classic (non-hybrid) parameters were configured */
@@ -137,6 +137,10 @@ int s2n_test_tls13_pq_handshake(const struct s2n_security_policy *client_sec_pol
         POSIX_GUARD(s2n_handshake_write_io(server_conn));
     }
 
+    /* The rest of the server's flight is never written, so flush the records written so far */
+    s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+    POSIX_GUARD(s2n_flush(server_conn, &blocked));
+
     /* Client reads ServerHello */
     POSIX_ENSURE_EQ(s2n_conn_get_current_message_type(client_conn), SERVER_HELLO);
     POSIX_GUARD(s2n_handshake_read_io(client_conn));
@@ -166,8 +166,7 @@ int main(int argc, char **argv)
         EXPECT_SUCCESS(s2n_connection_free(conn));
 
         free(tls13_cert_chain_hex);
-        /* free memory allocated in s2n_alloc*/
-        free(tls13_cert.data);
+        EXPECT_SUCCESS(s2n_free(&tls13_cert));
     }
 
     /* Test server sends cert and client receives cert for tls 1.3 */
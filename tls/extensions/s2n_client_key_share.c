@@ -15,6 +15,7 @@
 
 #include "tls/extensions/s2n_client_key_share.h"
 #include "tls/extensions/s2n_key_share.h"
+#include "tls/s2n_key_share_pool.h"
 #include "tls/s2n_security_policies.h"
 #include "tls/s2n_kem_preferences.h"
 
@@ -61,6 +62,18 @@ const s2n_extension_type s2n_client_key_share_extension = {
     .if_missing = s2n_extension_noop_if_missing,
 };
 
+static int s2n_client_ecdhe_parameters_send(struct s2n_connection *conn, struct s2n_ecc_evp_params *ecc_evp_params,
+        struct s2n_stuffer *out)
+{
+    /* If we received a HRR for any reason other than to request a different key share,
+     * we might have already generated the key. */
+    if (ecc_evp_params->evp_pkey == NULL) {
+        POSIX_GUARD(s2n_key_share_pool_generate_key(conn->config, ecc_evp_params));
+    }
+    POSIX_GUARD(s2n_ecdhe_parameters_send(ecc_evp_params, out));
+    return S2N_SUCCESS;
+}
+
 static int s2n_generate_preferred_ecc_key_shares(struct s2n_connection *conn, struct s2n_stuffer *out)
 {
     POSIX_ENSURE_REF(conn);
@@ -81,7 +94,7 @@ static int s2n_generate_preferred_ecc_key_shares(struct s2n_connection *conn, st
         if (S2N_IS_KEY_SHARE_REQUESTED(preferred_key_shares, i)) {
             ecc_evp_params = &conn->secure.client_ecc_evp_params[i];
             ecc_evp_params->negotiated_curve = ecc_pref->ecc_curves[i];
-            POSIX_GUARD(s2n_ecdhe_parameters_send(ecc_evp_params, out));
+            POSIX_GUARD(s2n_client_ecdhe_parameters_send(conn, ecc_evp_params, out));
         }
     }
 
@@ -98,7 +111,7 @@ static int s2n_generate_default_ecc_key_share(struct s2n_connection *conn, struc
     struct s2n_ecc_evp_params *ecc_evp_params = NULL;
     ecc_evp_params = &conn->secure.client_ecc_evp_params[0];
     ecc_evp_params->negotiated_curve = ecc_pref->ecc_curves[0];
-    POSIX_GUARD(s2n_ecdhe_parameters_send(ecc_evp_params, out));
+    POSIX_GUARD(s2n_client_ecdhe_parameters_send(conn, ecc_evp_params, out));
 
     return S2N_SUCCESS;
 }
@@ -195,7 +208,7 @@ static int s2n_send_hrr_ecc_keyshare(struct s2n_connection *conn, struct s2n_stu
 
     /* Generate the keyshare for the server negotiated curve */
     ecc_evp_params->negotiated_curve = server_negotiated_curve;
-    POSIX_GUARD(s2n_ecdhe_parameters_send(ecc_evp_params, out));
+    POSIX_GUARD(s2n_client_ecdhe_parameters_send(conn, ecc_evp_params, out));
 
     return S2N_SUCCESS;
 }
@@ -14,6 +14,7 @@
  */
 
 #include "tls/extensions/s2n_server_key_share.h"
+#include "tls/s2n_key_share_pool.h"
 #include "tls/s2n_security_policies.h"
 #include "tls/s2n_tls.h"
 #include "tls/s2n_tls13.h"
@@ -51,7 +52,7 @@ static int s2n_server_key_share_generate_pq_hybrid(struct s2n_connection *conn,
     struct s2n_ecc_evp_params *server_ecc_params = &server_kem_group_params->ecc_params;
     POSIX_ENSURE_REF(server_ecc_params->negotiated_curve);
     POSIX_GUARD(s2n_stuffer_write_uint16(out, server_ecc_params->negotiated_curve->share_size));
-    POSIX_GUARD(s2n_ecc_evp_generate_ephemeral_key(server_ecc_params));
+    POSIX_GUARD(s2n_key_share_pool_generate_key(conn->config, server_ecc_params));
     POSIX_GUARD(s2n_ecc_evp_write_params_point(server_ecc_params, out));
 
     POSIX_ENSURE_REF(conn->secure.chosen_client_kem_group_params);
@@ -153,6 +154,9 @@ static int s2n_server_key_share_send(struct s2n_connection *conn, struct s2n_stu
 
     if (curve != NULL) {
         POSIX_GUARD(s2n_server_key_share_send_check_ecdhe(conn));
+        if (conn->secure.server_ecc_evp_params.evp_pkey == NULL) {
+            POSIX_GUARD(s2n_key_share_pool_generate_key(conn->config, &conn->secure.server_ecc_evp_params));
+        }
         POSIX_GUARD(s2n_ecdhe_parameters_send(&conn->secure.server_ecc_evp_params, out));
     } else {
         POSIX_GUARD(s2n_server_key_share_send_check_pq_hybrid(conn));
@@ -113,7 +113,7 @@ int s2n_process_alert_fragment(struct s2n_connection *conn)
 
             /* RFC 5077 5.1 - Expire any cached session on an error alert */
             if (s2n_allowed_to_cache_connection(conn) && conn->session_id_len) {
-                conn->config->cache_delete(conn, conn->config->cache_delete_data, conn->session_id, conn->session_id_len);
+                s2n_delete_from_cache(conn);
             }
 
             /* All other alerts are treated as fatal errors */
@@ -20,13 +20,12 @@
 #include "s2n.h"
 #include "tls/s2n_connection.h"
 #include "tls/s2n_handshake.h"
+#include "utils/s2n_array.h"
 #include "utils/s2n_blob.h"
 #include "utils/s2n_mem.h"
 #include "utils/s2n_result.h"
 #include "utils/s2n_safety.h"
 
-typedef enum { S2N_ASYNC_DECRYPT, S2N_ASYNC_SIGN } s2n_async_pkey_op_type;
-
 struct s2n_async_pkey_decrypt_data {
     s2n_async_pkey_decrypt_complete on_complete;
     struct s2n_blob                 encrypted;
@@ -52,9 +51,19 @@ struct s2n_async_pkey_op {
     } op;
 };
 
+/* Pending operations collected across connections, performed together by s2n_async_pkey_batch_flush */
+struct s2n_async_pkey_batch {
+    struct s2n_array ops;
+    struct s2n_array ready_conns;
+    struct s2n_array failed_conns;
+};
+
 struct s2n_async_pkey_op_actions {
     S2N_RESULT (*perform)(struct s2n_async_pkey_op *op, s2n_cert_private_key *pkey);
     S2N_RESULT (*apply)(struct s2n_async_pkey_op *op, struct s2n_connection *conn);
+    S2N_RESULT (*get_input_size)(struct s2n_async_pkey_op *op, uint32_t *data_len);
+    S2N_RESULT (*get_input)(struct s2n_async_pkey_op *op, uint8_t *data, uint32_t data_len);
+    S2N_RESULT (*set_output)(struct s2n_async_pkey_op *op, const uint8_t *data, uint32_t data_len);
     S2N_RESULT (*free)(struct s2n_async_pkey_op *op);
 };
 
@@ -76,19 +85,31 @@ static S2N_RESULT s2n_async_pkey_decrypt_sync(struct s2n_connection *conn, struc
 
 static S2N_RESULT s2n_async_pkey_decrypt_perform(struct s2n_async_pkey_op *op, s2n_cert_private_key *pkey);
 static S2N_RESULT s2n_async_pkey_decrypt_apply(struct s2n_async_pkey_op *op, struct s2n_connection *conn);
+static S2N_RESULT s2n_async_pkey_decrypt_get_input_size(struct s2n_async_pkey_op *op, uint32_t *data_len);
+static S2N_RESULT s2n_async_pkey_decrypt_get_input(struct s2n_async_pkey_op *op, uint8_t *data, uint32_t data_len);
+static S2N_RESULT s2n_async_pkey_decrypt_set_output(struct s2n_async_pkey_op *op, const uint8_t *data, uint32_t data_len);
 static S2N_RESULT s2n_async_pkey_decrypt_free(struct s2n_async_pkey_op *op);
 
 static S2N_RESULT s2n_async_pkey_sign_perform(struct s2n_async_pkey_op *op, s2n_cert_private_key *pkey);
 static S2N_RESULT s2n_async_pkey_sign_apply(struct s2n_async_pkey_op *op, struct s2n_connection *conn);
+static S2N_RESULT s2n_async_pkey_sign_get_input_size(struct s2n_async_pkey_op *op, uint32_t *data_len);
+static S2N_RESULT s2n_async_pkey_sign_get_input(struct s2n_async_pkey_op *op, uint8_t *data, uint32_t data_len);
+static S2N_RESULT s2n_async_pkey_sign_set_output(struct s2n_async_pkey_op *op, const uint8_t *data, uint32_t data_len);
 static S2N_RESULT s2n_async_pkey_sign_free(struct s2n_async_pkey_op *op);
 
-static const struct s2n_async_pkey_op_actions s2n_async_pkey_decrypt_op = { .perform = &s2n_async_pkey_decrypt_perform,
-                                                                            .apply   = &s2n_async_pkey_decrypt_apply,
-                                                                            .free    = &s2n_async_pkey_decrypt_free };
+static const struct s2n_async_pkey_op_actions s2n_async_pkey_decrypt_op = { .perform        = &s2n_async_pkey_decrypt_perform,
+                                                                            .apply          = &s2n_async_pkey_decrypt_apply,
+                                                                            .get_input_size = &s2n_async_pkey_decrypt_get_input_size,
+                                                                            .get_input      = &s2n_async_pkey_decrypt_get_input,
+                                                                            .set_output     = &s2n_async_pkey_decrypt_set_output,
+                                                                            .free           = &s2n_async_pkey_decrypt_free };
 
-static const struct s2n_async_pkey_op_actions s2n_async_pkey_sign_op = { .perform = &s2n_async_pkey_sign_perform,
-                                                                         .apply   = &s2n_async_pkey_sign_apply,
-                                                                         .free    = &s2n_async_pkey_sign_free };
+static const struct s2n_async_pkey_op_actions s2n_async_pkey_sign_op = { .perform        = &s2n_async_pkey_sign_perform,
+                                                                         .apply          = &s2n_async_pkey_sign_apply,
+                                                                         .get_input_size = &s2n_async_pkey_sign_get_input_size,
+                                                                         .get_input      = &s2n_async_pkey_sign_get_input,
+                                                                         .set_output     = &s2n_async_pkey_sign_set_output,
+                                                                         .free           = &s2n_async_pkey_sign_free };
 
 DEFINE_POINTER_CLEANUP_FUNC(struct s2n_async_pkey_op *, s2n_async_pkey_op_free);
 
@@ -260,11 +281,11 @@ S2N_RESULT s2n_async_pkey_sign_sync(struct s2n_connection *conn, s2n_signature_a
     RESULT_ENSURE_REF(on_complete);
 
     const struct s2n_pkey *pkey = conn->handshake_params.our_chain_and_key->private_key;
-    DEFER_CLEANUP(struct s2n_blob signed_content = { 0 }, s2n_free);
+    DEFER_CLEANUP(struct s2n_blob signed_content = { 0 }, s2n_blob_zeroize_free);
 
     uint32_t maximum_signature_length = 0;
     RESULT_GUARD(s2n_pkey_size(pkey, &maximum_signature_length));
-    RESULT_GUARD_POSIX(s2n_alloc(&signed_content, maximum_signature_length));
+    RESULT_GUARD(s2n_arena_alloc(&conn->handshake_arena, &signed_content, maximum_signature_length));
 
     RESULT_GUARD_POSIX(s2n_pkey_sign(pkey, sig_alg, digest, &signed_content));
 
@@ -334,6 +355,267 @@ int s2n_async_pkey_op_free(struct s2n_async_pkey_op *op)
     return S2N_SUCCESS;
 }
 
+int s2n_async_pkey_op_get_op_type(struct s2n_async_pkey_op *op, s2n_async_pkey_op_type *type)
+{
+    POSIX_ENSURE_REF(op);
+    POSIX_ENSURE_REF(type);
+
+    *type = op->type;
+
+    return S2N_SUCCESS;
+}
+
+int s2n_async_pkey_op_get_signature_algorithm(struct s2n_async_pkey_op *op, s2n_tls_signature_algorithm *sig_alg)
+{
+    POSIX_ENSURE_REF(op);
+    POSIX_ENSURE_REF(sig_alg);
+    POSIX_ENSURE(op->type == S2N_ASYNC_SIGN, S2N_ERR_INVALID_STATE);
+
+    switch (op->op.sign.sig_alg) {
+        case S2N_SIGNATURE_RSA:
+            *sig_alg = S2N_TLS_SIGNATURE_RSA;
+            return S2N_SUCCESS;
+        case S2N_SIGNATURE_ECDSA:
+            *sig_alg = S2N_TLS_SIGNATURE_ECDSA;
+            return S2N_SUCCESS;
+        case S2N_SIGNATURE_RSA_PSS_RSAE:
+            *sig_alg = S2N_TLS_SIGNATURE_RSA_PSS_RSAE;
+            return S2N_SUCCESS;
+        case S2N_SIGNATURE_RSA_PSS_PSS:
+            *sig_alg = S2N_TLS_SIGNATURE_RSA_PSS_PSS;
+            return S2N_SUCCESS;
+        case S2N_SIGNATURE_ANONYMOUS:
+            break;
+    }
+
+    POSIX_BAIL(S2N_ERR_INVALID_SIGNATURE_ALGORITHM);
+}
+
+int s2n_async_pkey_op_get_hash_algorithm(struct s2n_async_pkey_op *op, s2n_tls_hash_algorithm *hash_alg)
+{
+    POSIX_ENSURE_REF(op);
+    POSIX_ENSURE_REF(hash_alg);
+    POSIX_ENSURE(op->type == S2N_ASYNC_SIGN, S2N_ERR_INVALID_STATE);
+
+    switch (op->op.sign.digest.alg) {
+        case S2N_HASH_MD5:
+            *hash_alg = S2N_TLS_HASH_MD5;
+            return S2N_SUCCESS;
+        case S2N_HASH_SHA1:
+            *hash_alg = S2N_TLS_HASH_SHA1;
+            return S2N_SUCCESS;
+        case S2N_HASH_SHA224:
+            *hash_alg = S2N_TLS_HASH_SHA224;
+            return S2N_SUCCESS;
+        case S2N_HASH_SHA256:
+            *hash_alg = S2N_TLS_HASH_SHA256;
+            return S2N_SUCCESS;
+        case S2N_HASH_SHA384:
+            *hash_alg = S2N_TLS_HASH_SHA384;
+            return S2N_SUCCESS;
+        case S2N_HASH_SHA512:
+            *hash_alg = S2N_TLS_HASH_SHA512;
+            return S2N_SUCCESS;
+        case S2N_HASH_MD5_SHA1:
+            *hash_alg = S2N_TLS_HASH_MD5_SHA1;
+            return S2N_SUCCESS;
+        case S2N_HASH_NONE:
+        case S2N_HASH_SENTINEL:
+            break;
+    }
+
+    POSIX_BAIL(S2N_ERR_HASH_INVALID_ALGORITHM);
+}
+
+int s2n_async_pkey_op_get_input_size(struct s2n_async_pkey_op *op, uint32_t *data_len)
+{
+    POSIX_ENSURE_REF(op);
+    POSIX_ENSURE_REF(data_len);
+
+    const struct s2n_async_pkey_op_actions *actions = NULL;
+    POSIX_GUARD_RESULT(s2n_async_get_actions(op->type, &actions));
+    POSIX_ENSURE_REF(actions);
+
+    POSIX_GUARD_RESULT(actions->get_input_size(op, data_len));
+
+    return S2N_SUCCESS;
+}
+
+int s2n_async_pkey_op_get_input(struct s2n_async_pkey_op *op, uint8_t *data, uint32_t data_len)
+{
+    POSIX_ENSURE_REF(op);
+    POSIX_ENSURE_REF(data);
+
+    const struct s2n_async_pkey_op_actions *actions = NULL;
+    POSIX_GUARD_RESULT(s2n_async_get_actions(op->type, &actions));
+    POSIX_ENSURE_REF(actions);
+
+    POSIX_GUARD_RESULT(actions->get_input(op, data, data_len));
+
+    return S2N_SUCCESS;
+}
+
+int s2n_async_pkey_op_set_output(struct s2n_async_pkey_op *op, const uint8_t *data, uint32_t data_len)
+{
+    POSIX_ENSURE_REF(op);
+    POSIX_ENSURE_REF(data);
+    POSIX_ENSURE(!op->complete, S2N_ERR_ASYNC_ALREADY_PERFORMED);
+
+    const struct s2n_async_pkey_op_actions *actions = NULL;
+    POSIX_GUARD_RESULT(s2n_async_get_actions(op->type, &actions));
+    POSIX_ENSURE_REF(actions);
+
+    POSIX_GUARD_RESULT(actions->set_output(op, data, data_len));
+
+    op->complete = true;
+
+    return S2N_SUCCESS;
+}
+
+struct s2n_async_pkey_batch *s2n_async_pkey_batch_new(void)
+{
+    DEFER_CLEANUP(struct s2n_blob mem = { 0 }, s2n_free);
+    PTR_GUARD_POSIX(s2n_alloc(&mem, sizeof(struct s2n_async_pkey_batch)));
+    PTR_GUARD_POSIX(s2n_blob_zero(&mem));
+
+    struct s2n_async_pkey_batch *batch = (void *) mem.data;
+    PTR_GUARD_RESULT(s2n_array_init(&batch->ops, sizeof(struct s2n_async_pkey_op *)));
+    PTR_GUARD_RESULT(s2n_array_init(&batch->ready_conns, sizeof(struct s2n_connection *)));
+    PTR_GUARD_RESULT(s2n_array_init(&batch->failed_conns, sizeof(struct s2n_connection *)));
+
+    ZERO_TO_DISABLE_DEFER_CLEANUP(mem);
+    return batch;
+}
+
+static S2N_RESULT s2n_async_pkey_batch_clear(struct s2n_array *array)
+{
+    uint32_t len = 0;
+    RESULT_GUARD(s2n_array_num_elements(array, &len));
+
+    /* Removing from the back never moves any other element */
+    while (len > 0) {
+        RESULT_GUARD(s2n_array_remove(array, --len));
+    }
+
+    return S2N_RESULT_OK;
+}
+
+static S2N_RESULT s2n_async_pkey_batch_free_ops(struct s2n_async_pkey_batch *batch)
+{
+    uint32_t len = 0;
+    RESULT_GUARD(s2n_array_num_elements(&batch->ops, &len));
+
+    for (uint32_t i = 0; i < len; i++) {
+        struct s2n_async_pkey_op **op = NULL;
+        RESULT_GUARD(s2n_array_get(&batch->ops, i, (void **) &op));
+        RESULT_GUARD_POSIX(s2n_async_pkey_op_free(*op));
+    }
+    RESULT_GUARD(s2n_async_pkey_batch_clear(&batch->ops));
+
+    return S2N_RESULT_OK;
+}
+
+int s2n_async_pkey_batch_free(struct s2n_async_pkey_batch *batch)
+{
+    POSIX_ENSURE_REF(batch);
+
+    POSIX_GUARD_RESULT(s2n_async_pkey_batch_free_ops(batch));
+    POSIX_GUARD(s2n_free(&batch->ops.mem));
+    POSIX_GUARD(s2n_free(&batch->ready_conns.mem));
+    POSIX_GUARD(s2n_free(&batch->failed_conns.mem));
+    POSIX_GUARD(s2n_free_object((uint8_t **) &batch, sizeof(struct s2n_async_pkey_batch)));
+
+    return S2N_SUCCESS;
+}
+
+int s2n_async_pkey_batch_add(struct s2n_async_pkey_batch *batch, struct s2n_async_pkey_op *op)
+{
+    POSIX_ENSURE_REF(batch);
+    POSIX_ENSURE_REF(op);
+    POSIX_ENSURE(!op->applied, S2N_ERR_ASYNC_ALREADY_APPLIED);
+
+    struct s2n_async_pkey_op **slot = NULL;
+    POSIX_GUARD_RESULT(s2n_array_pushback(&batch->ops, (void **) &slot));
+    *slot = op;
+
+    return S2N_SUCCESS;
+}
+
+int s2n_async_pkey_batch_get_count(struct s2n_async_pkey_batch *batch, uint32_t *count)
+{
+    POSIX_ENSURE_REF(batch);
+    POSIX_ENSURE_REF(count);
+
+    POSIX_GUARD_RESULT(s2n_array_num_elements(&batch->ops, count));
+
+    return S2N_SUCCESS;
+}
+
+static S2N_RESULT s2n_async_pkey_batch_push_conn(struct s2n_array *conns, struct s2n_connection *conn)
+{
+    struct s2n_connection **slot = NULL;
+    RESULT_GUARD(s2n_array_pushback(conns, (void **) &slot));
+    *slot = conn;
+    return S2N_RESULT_OK;
+}
+
+/* Calls `notify` once with every connection in `conns`, then empties `conns` */
+static int s2n_async_pkey_batch_notify(struct s2n_array *conns, s2n_async_pkey_batch_ready_fn notify, void *ctx)
+{
+    uint32_t conns_count = 0;
+    POSIX_GUARD_RESULT(s2n_array_num_elements(conns, &conns_count));
+    int result = S2N_SUCCESS;
+    if (conns_count > 0) {
+        result = notify((struct s2n_connection **)(void *) conns->mem.data, conns_count, ctx);
+    }
+    POSIX_GUARD_RESULT(s2n_async_pkey_batch_clear(conns));
+    return result;
+}
+
+int s2n_async_pkey_batch_flush(struct s2n_async_pkey_batch *batch, s2n_async_pkey_batch_perform_fn perform,
+                               s2n_async_pkey_batch_ready_fn ready, s2n_async_pkey_batch_failed_fn failed,
+                               void *ctx)
+{
+    POSIX_ENSURE_REF(batch);
+    POSIX_ENSURE_REF(perform);
+    POSIX_ENSURE_REF(ready);
+    POSIX_ENSURE_REF(failed);
+
+    uint32_t ops_count = 0;
+    POSIX_GUARD_RESULT(s2n_array_num_elements(&batch->ops, &ops_count));
+    if (ops_count == 0) {
+        return S2N_SUCCESS;
+    }
+
+    /* The array stores the op pointers contiguously, so it can be handed to the application as is */
+    struct s2n_async_pkey_op **ops = (struct s2n_async_pkey_op **)(void *) batch->ops.mem.data;
+    const bool performed = perform(ops, ops_count, ctx) == S2N_SUCCESS;
+
+    /* Apply every result before notifying the application, so that it is woken up once per batch.
+     * If perform failed, none of the results can be trusted and every connection is stuck. */
+    for (uint32_t i = 0; i < ops_count; i++) {
+        struct s2n_connection *conn = ops[i]->conn;
+        if (performed && s2n_async_pkey_op_apply(ops[i], conn) == S2N_SUCCESS) {
+            POSIX_GUARD_RESULT(s2n_async_pkey_batch_push_conn(&batch->ready_conns, conn));
+        } else {
+            POSIX_GUARD_RESULT(s2n_async_pkey_batch_push_conn(&batch->failed_conns, conn));
+        }
+    }
+    POSIX_GUARD_RESULT(s2n_async_pkey_batch_free_ops(batch));
+
+    uint32_t failed_count = 0;
+    POSIX_GUARD_RESULT(s2n_array_num_elements(&batch->failed_conns, &failed_count));
+
+    const int ready_result = s2n_async_pkey_batch_notify(&batch->ready_conns, ready, ctx);
+    const int failed_result = s2n_async_pkey_batch_notify(&batch->failed_conns, failed, ctx);
+
+    POSIX_ENSURE(performed, S2N_ERR_ASYNC_CALLBACK_FAILED);
+    POSIX_ENSURE(ready_result == S2N_SUCCESS && failed_result == S2N_SUCCESS, S2N_ERR_ASYNC_CALLBACK_FAILED);
+    POSIX_ENSURE(failed_count == 0, S2N_ERR_ASYNC_NOT_PERFORMED);
+
+    return S2N_SUCCESS;
+}
+
 S2N_RESULT s2n_async_pkey_decrypt_perform(struct s2n_async_pkey_op *op, s2n_cert_private_key *pkey)
 {
     RESULT_ENSURE_REF(op);
@@ -358,6 +640,43 @@ S2N_RESULT s2n_async_pkey_decrypt_apply(struct s2n_async_pkey_op *op, struct s2n
     return S2N_RESULT_OK;
 }
 
+S2N_RESULT s2n_async_pkey_decrypt_get_input_size(struct s2n_async_pkey_op *op, uint32_t *data_len)
+{
+    RESULT_ENSURE_REF(op);
+    RESULT_ENSURE_REF(data_len);
+
+    *data_len = op->op.decrypt.encrypted.size;
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_async_pkey_decrypt_get_input(struct s2n_async_pkey_op *op, uint8_t *data, uint32_t data_len)
+{
+    RESULT_ENSURE_REF(op);
+    RESULT_ENSURE_REF(data);
+
+    struct s2n_async_pkey_decrypt_data *decrypt = &op->op.decrypt;
+    RESULT_ENSURE(data_len >= decrypt->encrypted.size, S2N_ERR_SIZE_MISMATCH);
+
+    RESULT_CHECKED_MEMCPY(data, decrypt->encrypted.data, decrypt->encrypted.size);
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_async_pkey_decrypt_set_output(struct s2n_async_pkey_op *op, const uint8_t *data, uint32_t data_len)
+{
+    RESULT_ENSURE_REF(op);
+    RESULT_ENSURE_REF(data);
+
+    struct s2n_async_pkey_decrypt_data *decrypt = &op->op.decrypt;
+
+    RESULT_GUARD_POSIX(s2n_realloc(&decrypt->decrypted, data_len));
+    RESULT_CHECKED_MEMCPY(decrypt->decrypted.data, data, data_len);
+    decrypt->rsa_failed = false;
+
+    return S2N_RESULT_OK;
+}
+
 S2N_RESULT s2n_async_pkey_decrypt_free(struct s2n_async_pkey_op *op)
 {
     RESULT_ENSURE_REF(op);
@@ -400,6 +719,51 @@ S2N_RESULT s2n_async_pkey_sign_apply(struct s2n_async_pkey_op *op, struct s2n_co
     return S2N_RESULT_OK;
 }
 
+S2N_RESULT s2n_async_pkey_sign_get_input_size(struct s2n_async_pkey_op *op, uint32_t *data_len)
+{
+    RESULT_ENSURE_REF(op);
+    RESULT_ENSURE_REF(data_len);
+
+    uint8_t digest_length = 0;
+    RESULT_GUARD_POSIX(s2n_hash_digest_size(op->op.sign.digest.alg, &digest_length));
+    *data_len = digest_length;
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_async_pkey_sign_get_input(struct s2n_async_pkey_op *op, uint8_t *data, uint32_t data_len)
+{
+    RESULT_ENSURE_REF(op);
+    RESULT_ENSURE_REF(data);
+
+    struct s2n_async_pkey_sign_data *sign = &op->op.sign;
+
+    uint8_t digest_length = 0;
+    RESULT_GUARD_POSIX(s2n_hash_digest_size(sign->digest.alg, &digest_length));
+    RESULT_ENSURE(data_len >= digest_length, S2N_ERR_SIZE_MISMATCH);
+
+    /* Finish a copy, so that the op can still be performed locally afterwards */
+    DEFER_CLEANUP(struct s2n_hash_state digest_copy = { 0 }, s2n_hash_free);
+    RESULT_GUARD_POSIX(s2n_hash_new(&digest_copy));
+    RESULT_GUARD_POSIX(s2n_hash_copy(&digest_copy, &sign->digest));
+    RESULT_GUARD_POSIX(s2n_hash_digest(&digest_copy, data, digest_length));
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_async_pkey_sign_set_output(struct s2n_async_pkey_op *op, const uint8_t *data, uint32_t data_len)
+{
+    RESULT_ENSURE_REF(op);
+    RESULT_ENSURE_REF(data);
+
+    struct s2n_async_pkey_sign_data *sign = &op->op.sign;
+
+    RESULT_GUARD_POSIX(s2n_realloc(&sign->signature, data_len));
+    RESULT_CHECKED_MEMCPY(sign->signature.data, data, data_len);
+
+    return S2N_RESULT_OK;
+}
+
 S2N_RESULT s2n_async_pkey_sign_free(struct s2n_async_pkey_op *op)
 {
     RESULT_ENSURE_REF(op);
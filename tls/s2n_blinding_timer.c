@@ -0,0 +1,217 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "tls/s2n_blinding_timer.h"
+
+#include <sys/param.h>
+#include <time.h>
+
+#include "utils/s2n_mem.h"
+#include "utils/s2n_safety.h"
+
+#if defined(CLOCK_MONOTONIC_RAW)
+#define S2N_BLINDING_TIMER_CLOCK CLOCK_MONOTONIC_RAW
+#else
+#define S2N_BLINDING_TIMER_CLOCK CLOCK_MONOTONIC
+#endif
+
+#define S2N_BLINDING_TIMER_SLOT(tick) ((tick) & (S2N_BLINDING_TIMER_SLOTS - 1))
+
+static int s2n_blinding_timer_monotonic_clock(void *data, uint64_t *nanoseconds)
+{
+    struct timespec current_time = { 0 };
+
+    POSIX_GUARD(clock_gettime(S2N_BLINDING_TIMER_CLOCK, &current_time));
+
+    *nanoseconds = (uint64_t) current_time.tv_sec * 1000000000ull;
+    *nanoseconds += current_time.tv_nsec;
+
+    return 0;
+}
+
+/* Must be called with the timer locked */
+static void s2n_blinding_timer_unlink(struct s2n_blinding_timer *timer, struct s2n_connection *conn)
+{
+    if (conn->blinding_prev) {
+        conn->blinding_prev->blinding_next = conn->blinding_next;
+    } else {
+        timer->slots[S2N_BLINDING_TIMER_SLOT(conn->blinding_deadline / S2N_BLINDING_TIMER_TICK_IN_NANOS)] = conn->blinding_next;
+    }
+    if (conn->blinding_next) {
+        conn->blinding_next->blinding_prev = conn->blinding_prev;
+    }
+
+    conn->blinding_timer = NULL;
+    conn->blinding_next = NULL;
+    conn->blinding_prev = NULL;
+    timer->count--;
+}
+
+struct s2n_blinding_timer *s2n_blinding_timer_new(void)
+{
+    struct s2n_blob mem = { 0 };
+    PTR_GUARD_POSIX(s2n_alloc(&mem, sizeof(struct s2n_blinding_timer)));
+    PTR_GUARD_POSIX(s2n_blob_zero(&mem));
+
+    struct s2n_blinding_timer *timer = (struct s2n_blinding_timer *)(void *) mem.data;
+    if (pthread_mutex_init(&timer->lock, NULL) != 0) {
+        s2n_free(&mem);
+        PTR_BAIL(S2N_ERR_LOCK);
+    }
+    timer->monotonic_clock = s2n_blinding_timer_monotonic_clock;
+
+    return timer;
+}
+
+int s2n_blinding_timer_free(struct s2n_blinding_timer *timer)
+{
+    POSIX_ENSURE_REF(timer);
+
+    /* Connections still waiting forget the timer, so freeing them later doesn't touch it */
+    for (uint32_t i = 0; i < S2N_BLINDING_TIMER_SLOTS; i++) {
+        while (timer->slots[i]) {
+            s2n_blinding_timer_unlink(timer, timer->slots[i]);
+        }
+    }
+
+    POSIX_ENSURE(pthread_mutex_destroy(&timer->lock) == 0, S2N_ERR_LOCK);
+    POSIX_GUARD(s2n_free_object((uint8_t **) &timer, sizeof(struct s2n_blinding_timer)));
+    return S2N_SUCCESS;
+}
+
+S2N_RESULT s2n_blinding_timer_add(struct s2n_blinding_timer *timer, struct s2n_connection *conn)
+{
+    RESULT_ENSURE_REF(timer);
+    RESULT_ENSURE_REF(conn);
+
+    /* A connection killed twice only waits for its latest delay */
+    RESULT_GUARD(s2n_blinding_timer_remove(conn));
+
+    uint64_t now = 0;
+    RESULT_GUARD_POSIX(timer->monotonic_clock(timer->monotonic_clock_ctx, &now));
+
+    RESULT_ENSURE(pthread_mutex_lock(&timer->lock) == 0, S2N_ERR_LOCK);
+
+    if (timer->count == 0) {
+        timer->tick = now / S2N_BLINDING_TIMER_TICK_IN_NANOS;
+    }
+
+    conn->blinding_deadline = now + conn->delay;
+    struct s2n_connection **slot = &timer->slots[S2N_BLINDING_TIMER_SLOT(conn->blinding_deadline / S2N_BLINDING_TIMER_TICK_IN_NANOS)];
+    conn->blinding_timer = timer;
+    conn->blinding_prev = NULL;
+    conn->blinding_next = *slot;
+    if (*slot) {
+        (*slot)->blinding_prev = conn;
+    }
+    *slot = conn;
+    timer->count++;
+
+    RESULT_ENSURE(pthread_mutex_unlock(&timer->lock) == 0, S2N_ERR_LOCK);
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_blinding_timer_remove(struct s2n_connection *conn)
+{
+    RESULT_ENSURE_REF(conn);
+
+    struct s2n_blinding_timer *timer = conn->blinding_timer;
+    if (timer == NULL) {
+        return S2N_RESULT_OK;
+    }
+
+    RESULT_ENSURE(pthread_mutex_lock(&timer->lock) == 0, S2N_ERR_LOCK);
+    /* The connection may have been popped since blinding_timer was read */
+    if (conn->blinding_timer == timer) {
+        s2n_blinding_timer_unlink(timer, conn);
+    }
+    RESULT_ENSURE(pthread_mutex_unlock(&timer->lock) == 0, S2N_ERR_LOCK);
+
+    return S2N_RESULT_OK;
+}
+
+int s2n_blinding_timer_get_next_expiry(struct s2n_blinding_timer *timer, uint64_t *nanoseconds)
+{
+    POSIX_ENSURE_REF(timer);
+    POSIX_ENSURE_MUT(nanoseconds);
+
+    uint64_t now = 0;
+    POSIX_GUARD(timer->monotonic_clock(timer->monotonic_clock_ctx, &now));
+
+    POSIX_ENSURE(pthread_mutex_lock(&timer->lock) == 0, S2N_ERR_LOCK);
+
+    /* Walk one rotation of the wheel from the current tick. The first slot holding a deadline
+     * from that rotation holds the earliest deadline. Deadlines from later rotations can only
+     * remain if the application stopped polling for longer than a rotation. */
+    uint64_t next = UINT64_MAX;
+    uint64_t later = UINT64_MAX;
+    for (uint64_t tick = timer->tick; tick < timer->tick + S2N_BLINDING_TIMER_SLOTS && next == UINT64_MAX; tick++) {
+        for (struct s2n_connection *conn = timer->slots[S2N_BLINDING_TIMER_SLOT(tick)]; conn; conn = conn->blinding_next) {
+            if (conn->blinding_deadline / S2N_BLINDING_TIMER_TICK_IN_NANOS == tick) {
+                next = MIN(next, conn->blinding_deadline);
+            } else {
+                later = MIN(later, conn->blinding_deadline);
+            }
+        }
+    }
+    next = MIN(next, later);
+
+    POSIX_ENSURE(pthread_mutex_unlock(&timer->lock) == 0, S2N_ERR_LOCK);
+
+    if (next == UINT64_MAX) {
+        *nanoseconds = UINT64_MAX;
+    } else {
+        *nanoseconds = next > now ? next - now : 0;
+    }
+    return S2N_SUCCESS;
+}
+
+int s2n_blinding_timer_pop_expired(struct s2n_blinding_timer *timer, struct s2n_connection **conn)
+{
+    POSIX_ENSURE_REF(timer);
+    POSIX_ENSURE_REF(conn);
+    *conn = NULL;
+
+    uint64_t now = 0;
+    POSIX_GUARD(timer->monotonic_clock(timer->monotonic_clock_ctx, &now));
+    const uint64_t now_tick = now / S2N_BLINDING_TIMER_TICK_IN_NANOS;
+
+    POSIX_ENSURE(pthread_mutex_lock(&timer->lock) == 0, S2N_ERR_LOCK);
+
+    /* After a full rotation every slot has been visited, so older ticks can be skipped */
+    if (now_tick >= S2N_BLINDING_TIMER_SLOTS) {
+        timer->tick = MAX(timer->tick, now_tick - S2N_BLINDING_TIMER_SLOTS + 1);
+    }
+
+    while (timer->count > 0 && timer->tick <= now_tick) {
+        for (struct s2n_connection *entry = timer->slots[S2N_BLINDING_TIMER_SLOT(timer->tick)]; entry; entry = entry->blinding_next) {
+            if (entry->blinding_deadline <= now) {
+                *conn = entry;
+                break;
+            }
+        }
+        if (*conn) {
+            s2n_blinding_timer_unlink(timer, *conn);
+            break;
+        }
+        if (timer->tick == now_tick) {
+            break;
+        }
+        timer->tick++;
+    }
+
+    POSIX_ENSURE(pthread_mutex_unlock(&timer->lock) == 0, S2N_ERR_LOCK);
+    return S2N_SUCCESS;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+#include "utils/s2n_result.h"
+
+/* Killed connections wait in the slot of the tick their delay ends in. Blinding delays are
+ * at most 30 seconds, so with one second ticks a single wheel covers every deadline and
+ * no overflow levels are needed. Must be a power of two. */
+#define S2N_BLINDING_TIMER_SLOTS 64
+#define S2N_BLINDING_TIMER_TICK_IN_NANOS INT64_C(1000000000)
+
+struct s2n_blinding_timer {
+    pthread_mutex_t lock;
+
+    s2n_clock_time_nanoseconds monotonic_clock;
+    void *monotonic_clock_ctx;
+
+    /* Each slot is a list of connections, linked through their blinding_next and blinding_prev */
+    struct s2n_connection *slots[S2N_BLINDING_TIMER_SLOTS];
+    /* No connection has a deadline before this tick */
+    uint64_t tick;
+    uint32_t count;
+};
+
+extern S2N_RESULT s2n_blinding_timer_add(struct s2n_blinding_timer *timer, struct s2n_connection *conn);
+extern S2N_RESULT s2n_blinding_timer_remove(struct s2n_connection *conn);
@@ -0,0 +1,79 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "tls/s2n_buffer_pool.h"
+
+#include "error/s2n_errno.h"
+#include "utils/s2n_mem.h"
+#include "utils/s2n_safety.h"
+
+struct s2n_buffer_pool {
+    struct s2n_blob buffers[S2N_BUFFER_POOL_MAX_BUFFERS];
+    uint32_t count;
+};
+
+/* Connections are usually driven by one thread at a time, so each thread keeps its own
+ * pool and borrowing or returning a buffer takes no lock. A buffer may be returned to a
+ * different thread's pool than the one it was taken from. */
+static __thread struct s2n_buffer_pool pool;
+
+S2N_RESULT s2n_buffer_pool_acquire(struct s2n_stuffer *stuffer)
+{
+    RESULT_ENSURE_REF(stuffer);
+    if (stuffer->blob.data != NULL) {
+        return S2N_RESULT_OK;
+    }
+    RESULT_ENSURE(stuffer->growable, S2N_ERR_RESIZE_STATIC_STUFFER);
+    RESULT_ENSURE(!stuffer->tainted, S2N_ERR_RESIZE_TAINTED_STUFFER);
+
+    if (pool.count > 0) {
+        pool.count--;
+        stuffer->blob = pool.buffers[pool.count];
+        pool.buffers[pool.count] = (struct s2n_blob) { 0 };
+    } else {
+        RESULT_GUARD_POSIX(s2n_alloc(&stuffer->blob, S2N_BUFFER_POOL_BUFFER_SIZE));
+    }
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_buffer_pool_release(struct s2n_stuffer *stuffer)
+{
+    RESULT_ENSURE_REF(stuffer);
+    if (stuffer->blob.data == NULL || s2n_stuffer_data_available(stuffer) > 0) {
+        return S2N_RESULT_OK;
+    }
+    RESULT_ENSURE(stuffer->growable, S2N_ERR_RESIZE_STATIC_STUFFER);
+
+    RESULT_GUARD_POSIX(s2n_stuffer_wipe(stuffer));
+
+    /* Buffers resized away from the pool size, for example by a send buffer, are not reused */
+    if (stuffer->blob.size == S2N_BUFFER_POOL_BUFFER_SIZE && pool.count < S2N_BUFFER_POOL_MAX_BUFFERS) {
+        pool.buffers[pool.count++] = stuffer->blob;
+        stuffer->blob = (struct s2n_blob) { 0 };
+    } else {
+        RESULT_GUARD_POSIX(s2n_free(&stuffer->blob));
+    }
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_buffer_pool_cleanup_thread(void)
+{
+    while (pool.count > 0) {
+        pool.count--;
+        RESULT_GUARD_POSIX(s2n_free(&pool.buffers[pool.count]));
+    }
+    return S2N_RESULT_OK;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include "stuffer/s2n_stuffer.h"
+#include "tls/s2n_tls_parameters.h"
+#include "utils/s2n_result.h"
+
+/* Every pooled buffer can hold a whole record, so it can back either conn->in or conn->out */
+#define S2N_BUFFER_POOL_BUFFER_SIZE S2N_LARGE_RECORD_LENGTH
+
+/* Buffers kept by each thread for reuse. Buffers released beyond this are freed. */
+#define S2N_BUFFER_POOL_MAX_BUFFERS 16
+
+/* Gives an empty growable stuffer a buffer from the calling thread's pool.
+ * Stuffers that already own memory are left alone. */
+extern S2N_RESULT s2n_buffer_pool_acquire(struct s2n_stuffer *stuffer);
+/* Wipes a drained stuffer and hands its memory back to the calling thread's pool.
+ * Stuffers still holding data are left alone. */
+extern S2N_RESULT s2n_buffer_pool_release(struct s2n_stuffer *stuffer);
+extern S2N_RESULT s2n_buffer_pool_cleanup_thread(void);
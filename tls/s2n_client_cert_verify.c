@@ -46,10 +46,10 @@ int s2n_client_cert_verify_recv(struct s2n_connection *conn)
     /* Use a copy of the hash state since the verify digest computation may modify the running hash state we need later. */
     struct s2n_hash_state hash_state = {0};
     POSIX_GUARD(s2n_handshake_get_hash_state(conn, chosen_sig_scheme.hash_alg, &hash_state));
-    POSIX_GUARD(s2n_hash_copy(&conn->handshake.ccv_hash_copy, &hash_state));
+    POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->ccv_hash_copy, &hash_state));
 
     /* Verify the signature */
-    POSIX_GUARD(s2n_pkey_verify(&conn->secure.client_public_key, chosen_sig_scheme.sig_alg, &conn->handshake.ccv_hash_copy, &signature));
+    POSIX_GUARD(s2n_pkey_verify(&conn->secure.client_public_key, chosen_sig_scheme.sig_alg, &conn->handshake.hashes->ccv_hash_copy, &signature));
 
     /* Client certificate has been verified. Minimize required handshake hash algs */
     POSIX_GUARD(s2n_conn_update_required_handshake_hashes(conn));
@@ -71,16 +71,16 @@ int s2n_client_cert_verify_send(struct s2n_connection *conn)
     /* Use a copy of the hash state since the verify digest computation may modify the running hash state we need later. */
     struct s2n_hash_state hash_state = {0};
     POSIX_GUARD(s2n_handshake_get_hash_state(conn, chosen_sig_scheme.hash_alg, &hash_state));
-    POSIX_GUARD(s2n_hash_copy(&conn->handshake.ccv_hash_copy, &hash_state));
+    POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->ccv_hash_copy, &hash_state));
 
     struct s2n_cert_chain_and_key *cert_chain_and_key = conn->handshake_params.our_chain_and_key;
 
-    DEFER_CLEANUP(struct s2n_blob signature = {0}, s2n_free);
+    DEFER_CLEANUP(struct s2n_blob signature = {0}, s2n_blob_zeroize_free);
     uint32_t max_signature_size = 0;
     POSIX_GUARD_RESULT(s2n_pkey_size(cert_chain_and_key->private_key, &max_signature_size));
-    POSIX_GUARD(s2n_alloc(&signature, max_signature_size));
+    POSIX_GUARD_RESULT(s2n_arena_alloc(&conn->handshake_arena, &signature, max_signature_size));
 
-    POSIX_GUARD(s2n_pkey_sign(cert_chain_and_key->private_key, chosen_sig_scheme.sig_alg, &conn->handshake.ccv_hash_copy, &signature));
+    POSIX_GUARD(s2n_pkey_sign(cert_chain_and_key->private_key, chosen_sig_scheme.sig_alg, &conn->handshake.hashes->ccv_hash_copy, &signature));
 
     POSIX_GUARD(s2n_stuffer_write_uint16(out, signature.size));
     POSIX_GUARD(s2n_stuffer_write(out, &signature));
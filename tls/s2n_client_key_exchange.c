@@ -58,7 +58,7 @@ static int s2n_hybrid_client_action(struct s2n_connection *conn, struct s2n_blob
     POSIX_ENSURE_REF(client_key_exchange_message->data);
     const uint32_t start_cursor = *cursor;
 
-    DEFER_CLEANUP(struct s2n_blob shared_key_0 = {0}, s2n_free);
+    DEFER_CLEANUP(struct s2n_blob shared_key_0 = {0}, s2n_blob_zeroize_free);
     POSIX_GUARD_RESULT(kex_method(hybrid_kex_0, conn, &shared_key_0));
 
     struct s2n_blob *shared_key_1 = &(conn->secure.kem_params.shared_secret);
@@ -68,7 +68,7 @@ static int s2n_hybrid_client_action(struct s2n_connection *conn, struct s2n_blob
     POSIX_ENSURE_GTE(end_cursor, start_cursor);
     client_key_exchange_message->size = end_cursor - start_cursor;
 
-    POSIX_GUARD(s2n_alloc(combined_shared_key, shared_key_0.size + shared_key_1->size));
+    POSIX_GUARD_RESULT(s2n_arena_alloc(&conn->handshake_arena, combined_shared_key, shared_key_0.size + shared_key_1->size));
     struct s2n_stuffer stuffer_combiner = {0};
     POSIX_GUARD(s2n_stuffer_init(&stuffer_combiner, combined_shared_key));
     POSIX_GUARD(s2n_stuffer_write(&stuffer_combiner, &shared_key_0));
@@ -182,6 +182,7 @@ int s2n_ecdhe_client_key_recv(struct s2n_connection *conn, struct s2n_blob *shar
     struct s2n_stuffer *in = &conn->handshake.io;
 
     /* Get the shared key */
+    POSIX_GUARD_RESULT(s2n_arena_alloc(&conn->handshake_arena, shared_key, S2N_ECC_EVP_MAX_SHARED_SECRET_SIZE));
     POSIX_GUARD(s2n_ecc_evp_compute_shared_secret_as_server(&conn->secure.server_ecc_evp_params, in, shared_key));
     /* We don't need the server params any more */
     POSIX_GUARD(s2n_ecc_evp_params_free(&conn->secure.server_ecc_evp_params));
@@ -238,6 +239,7 @@ int s2n_dhe_client_key_send(struct s2n_connection *conn, struct s2n_blob *shared
 int s2n_ecdhe_client_key_send(struct s2n_connection *conn, struct s2n_blob *shared_key)
 {
     struct s2n_stuffer *out = &conn->handshake.io;
+    POSIX_GUARD_RESULT(s2n_arena_alloc(&conn->handshake_arena, shared_key, S2N_ECC_EVP_MAX_SHARED_SECRET_SIZE));
     POSIX_GUARD(s2n_ecc_evp_compute_shared_secret_as_client(&conn->secure.server_ecc_evp_params, out, shared_key));
 
     /* We don't need the server params any more */
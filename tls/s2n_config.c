@@ -22,6 +22,7 @@
 #include "crypto/s2n_fips.h"
 
 #include "tls/s2n_cipher_preferences.h"
+#include "tls/s2n_key_share_pool.h"
 #include "tls/s2n_security_policies.h"
 #include "tls/s2n_tls13.h"
 #include "utils/s2n_safety.h"
@@ -126,6 +127,7 @@ static int s2n_config_cleanup(struct s2n_config *config)
     POSIX_GUARD(s2n_config_free_dhparams(config));
     POSIX_GUARD(s2n_free(&config->application_protocols));
     POSIX_GUARD_RESULT(s2n_map_free(config->domain_name_to_cert_map));
+    POSIX_GUARD_RESULT(s2n_key_share_pool_free(&config->key_share_pool));
 
     return 0;
 }
@@ -296,9 +298,19 @@ int s2n_config_init_session_ticket_keys(struct s2n_config *config)
 int s2n_config_free_session_ticket_keys(struct s2n_config *config)
 {
     if (config->ticket_keys != NULL) {
+        uint32_t ticket_keys_len = 0;
+        POSIX_GUARD_RESULT(s2n_set_len(config->ticket_keys, &ticket_keys_len));
+        for (uint32_t i = 0; i < ticket_keys_len; i++) {
+            struct s2n_ticket_key *ticket_key = NULL;
+            POSIX_GUARD_RESULT(s2n_set_get(config->ticket_keys, i, (void **)&ticket_key));
+            POSIX_GUARD_RESULT(s2n_ticket_key_free_session_keys(ticket_key));
+        }
         POSIX_GUARD_RESULT(s2n_set_free_p(&config->ticket_keys));
     }
 
+    /* With ticket_keys gone, this only releases the name index */
+    POSIX_GUARD_RESULT(s2n_config_update_ticket_key_index(config));
+
     if (config->ticket_key_hashes != NULL) {
         POSIX_GUARD_RESULT(s2n_set_free_p(&config->ticket_key_hashes));
     }
@@ -688,7 +700,7 @@ int s2n_config_set_session_tickets_onoff(struct s2n_config *config, uint8_t enab
 int s2n_config_set_session_cache_onoff(struct s2n_config *config, uint8_t enabled)
 {
     POSIX_ENSURE_REF(config);
-    if (enabled && config->cache_store && config->cache_retrieve && config->cache_delete) {
+    if (enabled && (config->session_cache || s2n_config_has_session_cache_callbacks(config))) {
         POSIX_GUARD(s2n_config_init_session_ticket_keys(config));
         config->use_session_cache = 1;
     }
@@ -701,12 +713,30 @@ int s2n_config_set_session_cache_onoff(struct s2n_config *config, uint8_t enable
     return 0;
 }
 
+int s2n_config_set_session_cache(struct s2n_config *config, struct s2n_session_cache *cache)
+{
+    POSIX_ENSURE_REF(config);
+
+    config->session_cache = cache;
+    POSIX_GUARD(s2n_config_set_session_cache_onoff(config, cache != NULL || config->use_session_cache));
+    return 0;
+}
+
+int s2n_config_set_blinding_timer(struct s2n_config *config, struct s2n_blinding_timer *timer)
+{
+    POSIX_ENSURE_REF(config);
+
+    config->blinding_timer = timer;
+    return 0;
+}
+
 int s2n_config_set_ticket_encrypt_decrypt_key_lifetime(struct s2n_config *config,
                                                        uint64_t lifetime_in_secs)
 {
     POSIX_ENSURE_REF(config);
 
     config->encrypt_decrypt_key_lifetime_in_nanos = (lifetime_in_secs * ONE_SEC_IN_NANOS);
+    POSIX_GUARD_RESULT(s2n_config_update_ticket_key_index(config));
     return 0;
 }
 
@@ -733,7 +763,7 @@ int s2n_config_add_ticket_crypto_key(struct s2n_config *config,
         return 0;
     }
 
-    POSIX_GUARD(s2n_config_wipe_expired_ticket_crypto_keys(config, -1));
+    POSIX_GUARD(s2n_config_wipe_expired_ticket_crypto_keys(config));
 
     S2N_ERROR_IF(key_len == 0, S2N_ERR_INVALID_TICKET_KEY_LENGTH);
 
@@ -753,6 +783,7 @@ int s2n_config_add_ticket_crypto_key(struct s2n_config *config,
     DEFER_CLEANUP(struct s2n_blob allocator = {0}, s2n_free);
     POSIX_GUARD(s2n_alloc(&allocator, sizeof(struct s2n_ticket_key)));
     session_ticket_key = (struct s2n_ticket_key *) (void *) allocator.data;
+    *session_ticket_key = (struct s2n_ticket_key) { 0 };
 
     DEFER_CLEANUP(struct s2n_hmac_state hmac = {0}, s2n_hmac_free);
 
@@ -789,7 +820,14 @@ int s2n_config_add_ticket_crypto_key(struct s2n_config *config,
         session_ticket_key->intro_timestamp = (intro_time_in_seconds_from_epoch * ONE_SEC_IN_NANOS);
     }
 
-    POSIX_GUARD(s2n_config_store_ticket_key(config, session_ticket_key));
+    /* The set takes a copy of session_ticket_key, including its session key pointers */
+    if (!s2n_result_is_ok(s2n_ticket_key_init_session_keys(session_ticket_key))
+            || s2n_config_store_ticket_key(config, session_ticket_key) != S2N_SUCCESS) {
+        s2n_result_ignore(s2n_ticket_key_free_session_keys(session_ticket_key));
+        S2N_ERROR_PRESERVE_ERRNO();
+    }
+
+    POSIX_GUARD_RESULT(s2n_config_update_ticket_key_index(config));
 
     return 0;
 }
@@ -833,6 +871,50 @@ int s2n_config_enable_cert_req_dss_legacy_compat(struct s2n_config *config)
     return S2N_SUCCESS;
 }
 
+int s2n_config_set_send_buffer_size(struct s2n_config *config, uint32_t size)
+{
+    POSIX_ENSURE_REF(config);
+    /* The buffer must be able to hold at least one maximum sized record */
+    POSIX_ENSURE(size >= S2N_TLS_MAXIMUM_RECORD_LENGTH, S2N_ERR_INVALID_ARGUMENT);
+    config->send_buffer_size_override = size;
+    return S2N_SUCCESS;
+}
+
+int s2n_config_set_recv_multi_record(struct s2n_config *config, bool enabled)
+{
+    POSIX_ENSURE_REF(config);
+    config->recv_multi_record = enabled;
+    return S2N_SUCCESS;
+}
+
+int s2n_config_set_dynamic_buffers(struct s2n_config *config, bool enabled)
+{
+    POSIX_ENSURE_REF(config);
+    config->dynamic_buffers = enabled;
+    return S2N_SUCCESS;
+}
+
+int s2n_config_set_ktls_mode(struct s2n_config *config, s2n_ktls_mode mode)
+{
+    POSIX_ENSURE_REF(config);
+    POSIX_ENSURE((mode & ~S2N_KTLS_MODE_DUPLEX) == 0, S2N_ERR_INVALID_ARGUMENT);
+    config->ktls_send = !!(mode & S2N_KTLS_MODE_SEND);
+    config->ktls_recv = !!(mode & S2N_KTLS_MODE_RECV);
+    return S2N_SUCCESS;
+}
+
+int s2n_config_set_key_share_pool(struct s2n_config *config, uint32_t keys_per_curve, uint8_t worker_count)
+{
+    POSIX_ENSURE_REF(config);
+    /* Connections using the config may be taking keys from the existing pool */
+    POSIX_ENSURE(config->key_share_pool == NULL, S2N_ERR_INVALID_STATE);
+    if (keys_per_curve == 0) {
+        return S2N_SUCCESS;
+    }
+    POSIX_GUARD_RESULT(s2n_key_share_pool_new(&config->key_share_pool, keys_per_curve, worker_count));
+    return S2N_SUCCESS;
+}
+
 int s2n_config_set_psk_selection_callback(struct s2n_config *config, s2n_psk_selection_callback cb)
 {
     POSIX_ENSURE_REF(config);
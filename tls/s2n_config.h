@@ -21,11 +21,14 @@
 #include "tls/s2n_resume.h"
 #include "tls/s2n_x509_validator.h"
 #include "utils/s2n_blob.h"
+#include "utils/s2n_map.h"
 #include "utils/s2n_set.h"
 #include "tls/s2n_psk.h"
 
 #define S2N_MAX_TICKET_KEYS 48
 #define S2N_MAX_TICKET_KEY_HASHES 500 /* 10KB */
+/* Each key starts and ends an epoch, and the first epoch starts at 0 */
+#define S2N_MAX_TICKET_KEY_EPOCHS (2 * S2N_MAX_TICKET_KEYS + 1)
 
 struct s2n_cipher_preferences;
 
@@ -45,6 +48,16 @@ struct s2n_config {
     /* Whether to add dss cert type during a server certificate request.
      * See https://github.com/awslabs/s2n/blob/main/docs/USAGE-GUIDE.md */
     unsigned cert_req_dss_legacy_compat_enabled:1;
+    /* Whether s2n_recv should keep reading records until the caller's buffer is full.
+     * See s2n_config_set_recv_multi_record */
+    unsigned recv_multi_record:1;
+    /* Which directions of the record layer to offload to the kernel.
+     * See s2n_config_set_ktls_mode */
+    unsigned ktls_send:1;
+    unsigned ktls_recv:1;
+    /* Whether connections return their record buffers to a per-thread pool when idle.
+     * See s2n_config_set_dynamic_buffers */
+    unsigned dynamic_buffers:1;
 
     struct s2n_dh_params *dhparams;
     /* Needed until we can deprecate s2n_config_add_cert_chain_and_key. This is
@@ -69,6 +82,15 @@ struct s2n_config {
 
     struct s2n_set *ticket_keys;
     struct s2n_set *ticket_key_hashes;
+    /* Lookup structures derived from ticket_keys and the key lifetimes, rebuilt by
+     * s2n_config_update_ticket_key_index whenever a config API changes either. Handshakes
+     * only read them, and never remove keys, even expired ones. ticket_key_names maps
+     * a key name to its index in ticket_keys; ticket_key_epochs lists, in order, the
+     * periods of time during which the same keys are in encrypt-decrypt state.
+     */
+    struct s2n_map *ticket_key_names;
+    struct s2n_ticket_key_epoch ticket_key_epochs[S2N_MAX_TICKET_KEY_EPOCHS];
+    uint8_t ticket_key_epoch_count;
     uint64_t encrypt_decrypt_key_lifetime_in_nanos;
     uint64_t decrypt_key_lifetime_in_nanos;
 
@@ -82,6 +104,10 @@ struct s2n_config {
     s2n_cache_delete_callback cache_delete;
     void *cache_delete_data;
 
+    struct s2n_session_cache *session_cache;
+
+    struct s2n_blinding_timer *blinding_timer;
+
     s2n_ct_support_level ct_type;
 
     s2n_cert_auth_type client_cert_auth_type;
@@ -113,6 +139,13 @@ struct s2n_config {
     void *session_ticket_ctx;
 
     uint32_t server_max_early_data_size;
+
+    /* Size of the connection output buffer. When set, s2n_send packs as many
+     * records as fit into the buffer before flushing them to the socket. */
+    uint32_t send_buffer_size_override;
+
+    /* Ephemeral keys generated in the background. See s2n_config_set_key_share_pool */
+    struct s2n_key_share_pool *key_share_pool;
 };
 
 int s2n_config_defaults_init(void);
@@ -29,6 +29,8 @@
 
 #include "tls/extensions/s2n_client_server_name.h"
 #include "tls/s2n_alerts.h"
+#include "tls/s2n_blinding_timer.h"
+#include "tls/s2n_buffer_pool.h"
 #include "tls/s2n_cipher_suites.h"
 #include "tls/s2n_connection.h"
 #include "tls/s2n_connection_evp_digests.h"
@@ -60,22 +62,6 @@
 static int s2n_connection_new_hashes(struct s2n_connection *conn)
 {
     /* Allocate long-term memory for the Connection's hash states */
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.md5));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.sha1));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.sha224));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.sha256));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.sha384));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.sha512));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.md5_sha1));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.ccv_hash_copy));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.prf_md5_hash_copy));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.prf_sha1_hash_copy));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.prf_tls12_hash_copy));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.server_hello_copy));
-    POSIX_GUARD(s2n_hash_new(&conn->handshake.server_finished_copy));
-    POSIX_GUARD(s2n_hash_new(&conn->prf_space.ssl3.md5));
-    POSIX_GUARD(s2n_hash_new(&conn->prf_space.ssl3.sha1));
-    POSIX_GUARD(s2n_hash_new(&conn->initial.signature_hash));
     POSIX_GUARD(s2n_hash_new(&conn->secure.signature_hash));
 
     return 0;
@@ -87,41 +73,12 @@ static int s2n_connection_init_hashes(struct s2n_connection *conn)
 
     if (s2n_hash_is_available(S2N_HASH_MD5)) {
         /* Only initialize hashes that use MD5 if available. */
-        POSIX_GUARD(s2n_hash_init(&conn->prf_space.ssl3.md5, S2N_HASH_MD5));
+        POSIX_GUARD(s2n_hash_init(&conn->prf_space->ssl3.md5, S2N_HASH_MD5));
     }
 
-
-    /* Allow MD5 for hash states that are used by the PRF. This is required
-     * to comply with the TLS 1.0 and 1.1 RFCs and is approved as per
-     * NIST Special Publication 800-52 Revision 1.
-     */
-    if (s2n_is_in_fips_mode()) {
-        POSIX_GUARD(s2n_hash_allow_md5_for_fips(&conn->handshake.md5));
-        POSIX_GUARD(s2n_hash_allow_md5_for_fips(&conn->handshake.prf_md5_hash_copy));
-
-        /* Do not check s2n_hash_is_available before initialization. Allow MD5 and
-         * SHA-1 for both fips and non-fips mode. This is required to perform the
-         * signature checks in the CertificateVerify message in TLS 1.0 and TLS 1.1.
-         * This is approved per Nist SP 800-52r1.*/
-        POSIX_GUARD(s2n_hash_allow_md5_for_fips(&conn->handshake.md5_sha1));
-    }
-
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.md5, S2N_HASH_MD5));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.prf_md5_hash_copy, S2N_HASH_MD5));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.md5_sha1, S2N_HASH_MD5_SHA1));
-
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.sha1, S2N_HASH_SHA1));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.sha224, S2N_HASH_SHA224));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.sha256, S2N_HASH_SHA256));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.sha384, S2N_HASH_SHA384));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.sha512, S2N_HASH_SHA512));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.ccv_hash_copy, S2N_HASH_NONE));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.prf_tls12_hash_copy, S2N_HASH_NONE));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.server_hello_copy, S2N_HASH_NONE));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.server_finished_copy, S2N_HASH_NONE));
-    POSIX_GUARD(s2n_hash_init(&conn->handshake.prf_sha1_hash_copy, S2N_HASH_SHA1));
-    POSIX_GUARD(s2n_hash_init(&conn->prf_space.ssl3.sha1, S2N_HASH_SHA1));
-    POSIX_GUARD(s2n_hash_init(&conn->initial.signature_hash, S2N_HASH_NONE));
+    POSIX_GUARD_RESULT(s2n_handshake_hashes_init(conn->handshake.hashes));
+    POSIX_GUARD(s2n_hash_init(&conn->prf_space->ssl3.sha1, S2N_HASH_SHA1));
+    POSIX_GUARD(s2n_hash_init(&conn->initial->signature_hash, S2N_HASH_NONE));
     POSIX_GUARD(s2n_hash_init(&conn->secure.signature_hash, S2N_HASH_NONE));
 
     return 0;
@@ -130,9 +87,6 @@ static int s2n_connection_init_hashes(struct s2n_connection *conn)
 static int s2n_connection_new_hmacs(struct s2n_connection *conn)
 {
     /* Allocate long-term memory for the Connection's HMAC states */
-    POSIX_GUARD(s2n_hmac_new(&conn->initial.client_record_mac));
-    POSIX_GUARD(s2n_hmac_new(&conn->initial.server_record_mac));
-    POSIX_GUARD(s2n_hmac_new(&conn->initial.record_mac_copy_workspace));
     POSIX_GUARD(s2n_hmac_new(&conn->secure.client_record_mac));
     POSIX_GUARD(s2n_hmac_new(&conn->secure.server_record_mac));
     POSIX_GUARD(s2n_hmac_new(&conn->secure.record_mac_copy_workspace));
@@ -143,9 +97,9 @@ static int s2n_connection_new_hmacs(struct s2n_connection *conn)
 static int s2n_connection_init_hmacs(struct s2n_connection *conn)
 {
     /* Initialize all of the Connection's HMAC states */
-    POSIX_GUARD(s2n_hmac_init(&conn->initial.client_record_mac, S2N_HMAC_NONE, NULL, 0));
-    POSIX_GUARD(s2n_hmac_init(&conn->initial.server_record_mac, S2N_HMAC_NONE, NULL, 0));
-    POSIX_GUARD(s2n_hmac_init(&conn->initial.record_mac_copy_workspace, S2N_HMAC_NONE, NULL, 0));
+    POSIX_GUARD(s2n_hmac_init(&conn->initial->client_record_mac, S2N_HMAC_NONE, NULL, 0));
+    POSIX_GUARD(s2n_hmac_init(&conn->initial->server_record_mac, S2N_HMAC_NONE, NULL, 0));
+    POSIX_GUARD(s2n_hmac_init(&conn->initial->record_mac_copy_workspace, S2N_HMAC_NONE, NULL, 0));
     POSIX_GUARD(s2n_hmac_init(&conn->secure.client_record_mac, S2N_HMAC_NONE, NULL, 0));
     POSIX_GUARD(s2n_hmac_init(&conn->secure.server_record_mac, S2N_HMAC_NONE, NULL, 0));
     POSIX_GUARD(s2n_hmac_init(&conn->secure.record_mac_copy_workspace, S2N_HMAC_NONE, NULL, 0));
@@ -153,6 +107,33 @@ static int s2n_connection_init_hmacs(struct s2n_connection *conn)
     return 0;
 }
 
+/* The initial crypto parameters, the PRF working space and the transcript hashes are only
+ * needed until the handshake completes, so they live outside of the connection structure.
+ * s2n_connection_free_handshake releases them and s2n_connection_wipe recreates them. */
+static int s2n_connection_alloc_handshake_state(struct s2n_connection *conn)
+{
+    if (conn->initial == NULL) {
+        POSIX_GUARD_RESULT(s2n_crypto_parameters_new(&conn->initial));
+    }
+    if (conn->prf_space == NULL) {
+        POSIX_GUARD(s2n_prf_new(conn));
+    }
+    if (conn->handshake.hashes == NULL) {
+        POSIX_GUARD_RESULT(s2n_handshake_hashes_new(&conn->handshake.hashes));
+    }
+
+    return 0;
+}
+
+static int s2n_connection_free_handshake_state(struct s2n_connection *conn)
+{
+    POSIX_GUARD_RESULT(s2n_handshake_hashes_free(&conn->handshake.hashes));
+    POSIX_GUARD(s2n_prf_free(conn));
+    POSIX_GUARD_RESULT(s2n_crypto_parameters_free(&conn->initial));
+
+    return 0;
+}
+
 struct s2n_connection *s2n_connection_new(s2n_mode mode)
 {
     struct s2n_blob blob = {0};
@@ -206,11 +187,9 @@ struct s2n_connection *s2n_connection_new(s2n_mode mode)
     /* Allocate long term key memory */
     PTR_GUARD_POSIX(s2n_session_key_alloc(&conn->secure.client_key));
     PTR_GUARD_POSIX(s2n_session_key_alloc(&conn->secure.server_key));
-    PTR_GUARD_POSIX(s2n_session_key_alloc(&conn->initial.client_key));
-    PTR_GUARD_POSIX(s2n_session_key_alloc(&conn->initial.server_key));
 
     /* Allocate long term hash and HMAC memory */
-    PTR_GUARD_POSIX(s2n_prf_new(conn));
+    PTR_GUARD_POSIX(s2n_connection_alloc_handshake_state(conn));
 
     PTR_GUARD_POSIX(s2n_connection_new_hashes(conn));
     PTR_GUARD_POSIX(s2n_connection_init_hashes(conn));
@@ -226,7 +205,10 @@ struct s2n_connection *s2n_connection_new(s2n_mode mode)
     PTR_GUARD_POSIX(s2n_stuffer_init(&conn->header_in, &blob));
     PTR_GUARD_POSIX(s2n_stuffer_growable_alloc(&conn->out, 0));
     PTR_GUARD_POSIX(s2n_stuffer_growable_alloc(&conn->in, 0));
+    PTR_GUARD_POSIX(s2n_stuffer_growable_alloc(&conn->buffer_in, 0));
     PTR_GUARD_POSIX(s2n_stuffer_growable_alloc(&conn->handshake.io, 0));
+    PTR_GUARD_POSIX(s2n_stuffer_growable_alloc(&conn->handshake.transcript_buffer, 0));
+    PTR_GUARD_POSIX(s2n_stuffer_growable_alloc(&conn->handshake.flight, 0));
     PTR_GUARD_POSIX(s2n_stuffer_growable_alloc(&conn->client_hello.raw_message, 0));
     PTR_GUARD_POSIX(s2n_connection_wipe(conn));
     PTR_GUARD_RESULT(s2n_timer_start(conn->config, &conn->write_timer));
@@ -242,22 +224,35 @@ static int s2n_connection_free_keys(struct s2n_connection *conn)
 {
     POSIX_GUARD(s2n_session_key_free(&conn->secure.client_key));
     POSIX_GUARD(s2n_session_key_free(&conn->secure.server_key));
-    POSIX_GUARD(s2n_session_key_free(&conn->initial.client_key));
-    POSIX_GUARD(s2n_session_key_free(&conn->initial.server_key));
 
     return 0;
 }
 
 static int s2n_connection_zero(struct s2n_connection *conn, int mode, struct s2n_config *config)
 {
+    /* The handshake state is allocated separately. Zero it, but keep it. */
+    struct s2n_crypto_parameters *initial = conn->initial;
+    struct s2n_prf_working_space *prf_space = conn->prf_space;
+    struct s2n_handshake_hashes *hashes = conn->handshake.hashes;
+    POSIX_ENSURE_REF(initial);
+    POSIX_ENSURE_REF(prf_space);
+    POSIX_ENSURE_REF(hashes);
+    POSIX_CHECKED_MEMSET(initial, 0, sizeof(struct s2n_crypto_parameters));
+    POSIX_CHECKED_MEMSET(prf_space, 0, sizeof(struct s2n_prf_working_space));
+    POSIX_CHECKED_MEMSET(hashes, 0, sizeof(struct s2n_handshake_hashes));
+
     /* Zero the whole connection structure */
     POSIX_CHECKED_MEMSET(conn, 0, sizeof(struct s2n_connection));
 
+    conn->initial = initial;
+    conn->prf_space = prf_space;
+    conn->handshake.hashes = hashes;
+
     conn->mode = mode;
-    conn->initial.cipher_suite = &s2n_null_cipher_suite;
+    conn->initial->cipher_suite = &s2n_null_cipher_suite;
     conn->secure.cipher_suite = &s2n_null_cipher_suite;
-    conn->server = &conn->initial;
-    conn->client = &conn->initial;
+    conn->server = conn->initial;
+    conn->client = conn->initial;
     conn->max_outgoing_fragment_length = S2N_DEFAULT_FRAGMENT_LENGTH;
     conn->handshake.end_of_messages = APPLICATION_DATA;
     s2n_connection_set_config(conn, config);
@@ -313,22 +308,10 @@ static int s2n_connection_wipe_keys(struct s2n_connection *conn)
 static int s2n_connection_reset_hashes(struct s2n_connection *conn)
 {
     /* Reset all of the Connection's hash states */
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.md5));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.sha1));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.sha224));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.sha256));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.sha384));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.sha512));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.md5_sha1));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.ccv_hash_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.prf_md5_hash_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.prf_sha1_hash_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.prf_tls12_hash_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.server_hello_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.server_finished_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->prf_space.ssl3.md5));
-    POSIX_GUARD(s2n_hash_reset(&conn->prf_space.ssl3.sha1));
-    POSIX_GUARD(s2n_hash_reset(&conn->initial.signature_hash));
+    POSIX_GUARD_RESULT(s2n_handshake_hashes_reset(conn->handshake.hashes));
+    POSIX_GUARD(s2n_hash_reset(&conn->prf_space->ssl3.md5));
+    POSIX_GUARD(s2n_hash_reset(&conn->prf_space->ssl3.sha1));
+    POSIX_GUARD(s2n_hash_reset(&conn->initial->signature_hash));
     POSIX_GUARD(s2n_hash_reset(&conn->secure.signature_hash));
 
     return 0;
@@ -337,9 +320,9 @@ static int s2n_connection_reset_hashes(struct s2n_connection *conn)
 static int s2n_connection_reset_hmacs(struct s2n_connection *conn)
 {
     /* Reset all of the Connection's HMAC states */
-    POSIX_GUARD(s2n_hmac_reset(&conn->initial.client_record_mac));
-    POSIX_GUARD(s2n_hmac_reset(&conn->initial.server_record_mac));
-    POSIX_GUARD(s2n_hmac_reset(&conn->initial.record_mac_copy_workspace));
+    POSIX_GUARD(s2n_hmac_reset(&conn->initial->client_record_mac));
+    POSIX_GUARD(s2n_hmac_reset(&conn->initial->server_record_mac));
+    POSIX_GUARD(s2n_hmac_reset(&conn->initial->record_mac_copy_workspace));
     POSIX_GUARD(s2n_hmac_reset(&conn->secure.client_record_mac));
     POSIX_GUARD(s2n_hmac_reset(&conn->secure.server_record_mac));
     POSIX_GUARD(s2n_hmac_reset(&conn->secure.record_mac_copy_workspace));
@@ -381,22 +364,7 @@ static int s2n_connection_wipe_io(struct s2n_connection *conn)
 static int s2n_connection_free_hashes(struct s2n_connection *conn)
 {
     /* Free all of the Connection's hash states */
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.md5));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.sha1));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.sha224));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.sha256));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.sha384));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.sha512));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.md5_sha1));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.ccv_hash_copy));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.prf_md5_hash_copy));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.prf_sha1_hash_copy));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.prf_tls12_hash_copy));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.server_hello_copy));
-    POSIX_GUARD(s2n_hash_free(&conn->handshake.server_finished_copy));
-    POSIX_GUARD(s2n_hash_free(&conn->prf_space.ssl3.md5));
-    POSIX_GUARD(s2n_hash_free(&conn->prf_space.ssl3.sha1));
-    POSIX_GUARD(s2n_hash_free(&conn->initial.signature_hash));
+    POSIX_GUARD(s2n_hash_reset(&conn->secure.signature_hash));
     POSIX_GUARD(s2n_hash_free(&conn->secure.signature_hash));
 
     return 0;
@@ -405,9 +373,9 @@ static int s2n_connection_free_hashes(struct s2n_connection *conn)
 static int s2n_connection_free_hmacs(struct s2n_connection *conn)
 {
     /* Free all of the Connection's HMAC states */
-    POSIX_GUARD(s2n_hmac_free(&conn->initial.client_record_mac));
-    POSIX_GUARD(s2n_hmac_free(&conn->initial.server_record_mac));
-    POSIX_GUARD(s2n_hmac_free(&conn->initial.record_mac_copy_workspace));
+    POSIX_GUARD(s2n_hmac_reset(&conn->secure.client_record_mac));
+    POSIX_GUARD(s2n_hmac_reset(&conn->secure.server_record_mac));
+    POSIX_GUARD(s2n_hmac_reset(&conn->secure.record_mac_copy_workspace));
     POSIX_GUARD(s2n_hmac_free(&conn->secure.client_record_mac));
     POSIX_GUARD(s2n_hmac_free(&conn->secure.server_record_mac));
     POSIX_GUARD(s2n_hmac_free(&conn->secure.record_mac_copy_workspace));
@@ -451,16 +419,13 @@ static uint8_t s2n_default_verify_host(const char *host_name, size_t len, void *
 
 int s2n_connection_free(struct s2n_connection *conn)
 {
+    POSIX_GUARD_RESULT(s2n_blinding_timer_remove(conn));
     POSIX_GUARD(s2n_connection_wipe_keys(conn));
     POSIX_GUARD(s2n_connection_free_keys(conn));
     POSIX_GUARD_RESULT(s2n_psk_parameters_wipe(&conn->psk_params));
 
-    POSIX_GUARD(s2n_prf_free(conn));
-
-    POSIX_GUARD(s2n_connection_reset_hashes(conn));
+    POSIX_GUARD(s2n_connection_free_handshake_state(conn));
     POSIX_GUARD(s2n_connection_free_hashes(conn));
-
-    POSIX_GUARD(s2n_connection_reset_hmacs(conn));
     POSIX_GUARD(s2n_connection_free_hmacs(conn));
 
     POSIX_GUARD(s2n_connection_free_io_contexts(conn));
@@ -471,11 +436,15 @@ int s2n_connection_free(struct s2n_connection *conn)
     POSIX_GUARD(s2n_free(&conn->peer_quic_transport_parameters));
     POSIX_GUARD(s2n_stuffer_free(&conn->in));
     POSIX_GUARD(s2n_stuffer_free(&conn->out));
+    POSIX_GUARD(s2n_stuffer_free(&conn->buffer_in));
     POSIX_GUARD(s2n_stuffer_free(&conn->handshake.io));
+    POSIX_GUARD(s2n_stuffer_free(&conn->handshake.transcript_buffer));
+    POSIX_GUARD(s2n_stuffer_free(&conn->handshake.flight));
     s2n_x509_validator_wipe(&conn->x509_validator);
     POSIX_GUARD(s2n_client_hello_free(&conn->client_hello));
     POSIX_GUARD(s2n_free(&conn->application_protocols_overridden));
     POSIX_GUARD(s2n_stuffer_free(&conn->cookie_stuffer));
+    POSIX_GUARD_RESULT(s2n_arena_free(&conn->handshake_arena));
     POSIX_GUARD(s2n_free_object((uint8_t **)&conn, sizeof(struct s2n_connection)));
 
     return 0;
@@ -553,6 +522,9 @@ int s2n_connection_release_buffers(struct s2n_connection *conn)
     POSIX_ENSURE(s2n_stuffer_is_consumed(&conn->in), S2N_ERR_STUFFER_HAS_UNPROCESSED_DATA);
     POSIX_GUARD(s2n_stuffer_resize(&conn->in, 0));
 
+    POSIX_ENSURE(s2n_stuffer_is_consumed(&conn->buffer_in), S2N_ERR_STUFFER_HAS_UNPROCESSED_DATA);
+    POSIX_GUARD(s2n_stuffer_resize(&conn->buffer_in, 0));
+
     POSIX_POSTCONDITION(s2n_stuffer_validate(&conn->out));
     POSIX_POSTCONDITION(s2n_stuffer_validate(&conn->in));
     return S2N_SUCCESS;
@@ -560,28 +532,31 @@ int s2n_connection_release_buffers(struct s2n_connection *conn)
 
 int s2n_connection_free_handshake(struct s2n_connection *conn)
 {
+    POSIX_ENSURE_REF(conn);
+
     /* We are done with the handshake */
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.md5));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.sha1));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.sha224));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.sha256));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.sha384));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.sha512));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.md5_sha1));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.ccv_hash_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.prf_md5_hash_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.prf_sha1_hash_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.prf_tls12_hash_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.server_hello_copy));
-    POSIX_GUARD(s2n_hash_reset(&conn->handshake.server_finished_copy));
+    if (is_handshake_complete(conn)) {
+        POSIX_GUARD_RESULT(s2n_handshake_hashes_free(&conn->handshake.hashes));
+        POSIX_GUARD(s2n_prf_free(conn));
+        /* Records are protected with the secure parameters once the handshake is complete */
+        if (conn->client != conn->initial && conn->server != conn->initial) {
+            POSIX_GUARD_RESULT(s2n_crypto_parameters_free(&conn->initial));
+        }
+    } else if (conn->handshake.hashes) {
+        POSIX_GUARD_RESULT(s2n_handshake_hashes_reset(conn->handshake.hashes));
+    }
 
     /* Wipe the buffers we are going to free */
     POSIX_GUARD(s2n_stuffer_wipe(&conn->handshake.io));
+    POSIX_GUARD(s2n_stuffer_wipe(&conn->handshake.transcript_buffer));
+    POSIX_GUARD(s2n_stuffer_wipe(&conn->handshake.flight));
     POSIX_GUARD(s2n_stuffer_wipe(&conn->client_hello.raw_message));
 
     /* Truncate buffers to save memory, we are done with the handshake */
     POSIX_GUARD(s2n_stuffer_resize(&conn->handshake.io, 0));
     POSIX_GUARD(s2n_stuffer_resize(&conn->client_hello.raw_message, 0));
+    POSIX_GUARD(s2n_stuffer_resize(&conn->handshake.transcript_buffer, 0));
+    POSIX_GUARD(s2n_stuffer_resize(&conn->handshake.flight, 0));
 
     /* We can free extension data we no longer need */
     POSIX_GUARD(s2n_free(&conn->client_ticket));
@@ -589,6 +564,7 @@ int s2n_connection_free_handshake(struct s2n_connection *conn)
     POSIX_GUARD(s2n_free(&conn->our_quic_transport_parameters));
     POSIX_GUARD(s2n_free(&conn->application_protocols_overridden));
     POSIX_GUARD(s2n_stuffer_free(&conn->cookie_stuffer));
+    POSIX_GUARD_RESULT(s2n_arena_free(&conn->handshake_arena));
 
     return 0;
 }
@@ -603,10 +579,13 @@ int s2n_connection_wipe(struct s2n_connection *conn)
     struct s2n_stuffer writer_alert_out = {0};
     struct s2n_stuffer client_ticket_to_decrypt = {0};
     struct s2n_stuffer handshake_io = {0};
+    struct s2n_stuffer transcript_buffer = {0};
+    struct s2n_stuffer flight = {0};
     struct s2n_stuffer client_hello_raw_message = {0};
     struct s2n_stuffer header_in = {0};
     struct s2n_stuffer in = {0};
     struct s2n_stuffer out = {0};
+    struct s2n_stuffer buffer_in = {0};
     /* Session keys will be wiped. Preserve structs to avoid reallocation */
     struct s2n_session_key initial_client_key = {0};
     struct s2n_session_key initial_server_key = {0};
@@ -617,6 +596,16 @@ int s2n_connection_wipe(struct s2n_connection *conn)
     struct s2n_connection_hash_handles hash_handles = {0};
     struct s2n_connection_hmac_handles hmac_handles = {0};
 
+    /* A recycled connection no longer waits for its blinding delay */
+    POSIX_GUARD_RESULT(s2n_blinding_timer_remove(conn));
+
+    /* Recreate any handshake state released by s2n_connection_free_handshake */
+    if (conn->initial == NULL || conn->prf_space == NULL || conn->handshake.hashes == NULL) {
+        POSIX_GUARD(s2n_connection_alloc_handshake_state(conn));
+        POSIX_GUARD(s2n_connection_init_hashes(conn));
+        POSIX_GUARD(s2n_connection_init_hmacs(conn));
+    }
+
     /* Wipe all of the sensitive stuff */
     POSIX_GUARD(s2n_connection_wipe_keys(conn));
     POSIX_GUARD(s2n_connection_reset_hashes(conn));
@@ -626,10 +615,13 @@ int s2n_connection_wipe(struct s2n_connection *conn)
     POSIX_GUARD(s2n_stuffer_wipe(&conn->writer_alert_out));
     POSIX_GUARD(s2n_stuffer_wipe(&conn->client_ticket_to_decrypt));
     POSIX_GUARD(s2n_stuffer_wipe(&conn->handshake.io));
+    POSIX_GUARD(s2n_stuffer_wipe(&conn->handshake.transcript_buffer));
+    POSIX_GUARD(s2n_stuffer_wipe(&conn->handshake.flight));
     POSIX_GUARD(s2n_stuffer_wipe(&conn->client_hello.raw_message));
     POSIX_GUARD(s2n_stuffer_wipe(&conn->header_in));
     POSIX_GUARD(s2n_stuffer_wipe(&conn->in));
     POSIX_GUARD(s2n_stuffer_wipe(&conn->out));
+    POSIX_GUARD(s2n_stuffer_wipe(&conn->buffer_in));
 
     POSIX_GUARD_RESULT(s2n_psk_parameters_wipe(&conn->psk_params));
 
@@ -641,14 +633,18 @@ int s2n_connection_wipe(struct s2n_connection *conn)
     POSIX_GUARD(s2n_free(&conn->application_protocols_overridden));
     POSIX_GUARD(s2n_free(&conn->our_quic_transport_parameters));
     POSIX_GUARD(s2n_free(&conn->peer_quic_transport_parameters));
+    POSIX_GUARD_RESULT(s2n_arena_free(&conn->handshake_arena));
 
     /* Allocate memory for handling handshakes */
     POSIX_GUARD(s2n_stuffer_resize(&conn->handshake.io, S2N_LARGE_RECORD_LENGTH));
 
     /* Truncate the message buffers to save memory, we will dynamically resize it as needed */
     POSIX_GUARD(s2n_stuffer_resize(&conn->client_hello.raw_message, 0));
+    POSIX_GUARD(s2n_stuffer_resize(&conn->handshake.transcript_buffer, 0));
+    POSIX_GUARD(s2n_stuffer_resize(&conn->handshake.flight, 0));
     POSIX_GUARD(s2n_stuffer_resize(&conn->in, 0));
     POSIX_GUARD(s2n_stuffer_resize(&conn->out, 0));
+    POSIX_GUARD(s2n_stuffer_resize(&conn->buffer_in, 0));
 
     /* Remove context associated with connection */
     conn->context = NULL;
@@ -668,12 +664,15 @@ int s2n_connection_wipe(struct s2n_connection *conn)
     POSIX_CHECKED_MEMCPY(&writer_alert_out, &conn->writer_alert_out, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&client_ticket_to_decrypt, &conn->client_ticket_to_decrypt, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&handshake_io, &conn->handshake.io, sizeof(struct s2n_stuffer));
+    POSIX_CHECKED_MEMCPY(&transcript_buffer, &conn->handshake.transcript_buffer, sizeof(struct s2n_stuffer));
+    POSIX_CHECKED_MEMCPY(&flight, &conn->handshake.flight, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&client_hello_raw_message, &conn->client_hello.raw_message, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&header_in, &conn->header_in, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&in, &conn->in, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&out, &conn->out, sizeof(struct s2n_stuffer));
-    POSIX_CHECKED_MEMCPY(&initial_client_key, &conn->initial.client_key, sizeof(struct s2n_session_key));
-    POSIX_CHECKED_MEMCPY(&initial_server_key, &conn->initial.server_key, sizeof(struct s2n_session_key));
+    POSIX_CHECKED_MEMCPY(&buffer_in, &conn->buffer_in, sizeof(struct s2n_stuffer));
+    POSIX_CHECKED_MEMCPY(&initial_client_key, &conn->initial->client_key, sizeof(struct s2n_session_key));
+    POSIX_CHECKED_MEMCPY(&initial_server_key, &conn->initial->server_key, sizeof(struct s2n_session_key));
     POSIX_CHECKED_MEMCPY(&secure_client_key, &conn->secure.client_key, sizeof(struct s2n_session_key));
     POSIX_CHECKED_MEMCPY(&secure_server_key, &conn->secure.server_key, sizeof(struct s2n_session_key));
     POSIX_GUARD(s2n_connection_save_prf_state(&prf_handles, conn));
@@ -690,12 +689,15 @@ int s2n_connection_wipe(struct s2n_connection *conn)
     POSIX_CHECKED_MEMCPY(&conn->writer_alert_out, &writer_alert_out, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&conn->client_ticket_to_decrypt, &client_ticket_to_decrypt, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&conn->handshake.io, &handshake_io, sizeof(struct s2n_stuffer));
+    POSIX_CHECKED_MEMCPY(&conn->handshake.transcript_buffer, &transcript_buffer, sizeof(struct s2n_stuffer));
+    POSIX_CHECKED_MEMCPY(&conn->handshake.flight, &flight, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&conn->client_hello.raw_message, &client_hello_raw_message, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&conn->header_in, &header_in, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&conn->in, &in, sizeof(struct s2n_stuffer));
     POSIX_CHECKED_MEMCPY(&conn->out, &out, sizeof(struct s2n_stuffer));
-    POSIX_CHECKED_MEMCPY(&conn->initial.client_key, &initial_client_key, sizeof(struct s2n_session_key));
-    POSIX_CHECKED_MEMCPY(&conn->initial.server_key, &initial_server_key, sizeof(struct s2n_session_key));
+    POSIX_CHECKED_MEMCPY(&conn->buffer_in, &buffer_in, sizeof(struct s2n_stuffer));
+    POSIX_CHECKED_MEMCPY(&conn->initial->client_key, &initial_client_key, sizeof(struct s2n_session_key));
+    POSIX_CHECKED_MEMCPY(&conn->initial->server_key, &initial_server_key, sizeof(struct s2n_session_key));
     POSIX_CHECKED_MEMCPY(&conn->secure.client_key, &secure_client_key, sizeof(struct s2n_session_key));
     POSIX_CHECKED_MEMCPY(&conn->secure.server_key, &secure_server_key, sizeof(struct s2n_session_key));
     POSIX_GUARD(s2n_connection_restore_prf_state(conn, &prf_handles));
@@ -710,6 +712,8 @@ int s2n_connection_wipe(struct s2n_connection *conn)
 
     /* Require all handshakes hashes. This set can be reduced as the handshake progresses. */
     POSIX_GUARD(s2n_handshake_require_all_hashes(&conn->handshake));
+    /* Buffer the transcript until the required hashes are known */
+    conn->handshake.transcript_buffering = 1;
 
     if (conn->mode == S2N_SERVER) {
         /* Start with the highest protocol version so that the highest common protocol version can be selected */
@@ -1203,7 +1207,9 @@ int s2n_connection_kill(struct s2n_connection *conn)
     /* Restart the write timer */
     POSIX_GUARD_RESULT(s2n_timer_start(conn->config, &conn->write_timer));
 
-    if (conn->blinding == S2N_BUILT_IN_BLINDING) {
+    if (conn->blinding == S2N_BUILT_IN_BLINDING && conn->config->blinding_timer) {
+        POSIX_GUARD_RESULT(s2n_blinding_timer_add(conn->config->blinding_timer, conn));
+    } else if (conn->blinding == S2N_BUILT_IN_BLINDING) {
         struct timespec sleep_time = {.tv_sec = conn->delay / ONE_S,.tv_nsec = conn->delay % ONE_S };
         int r;
 
@@ -1247,6 +1253,20 @@ int s2n_connection_prefer_low_latency(struct s2n_connection *conn)
     return 0;
 }
 
+int s2n_connection_set_recv_buffering(struct s2n_connection *conn, uint32_t buffer_size)
+{
+    POSIX_ENSURE_REF(conn);
+
+    conn->recv_buffer_size = buffer_size;
+
+    /* Drop an idle buffer so that it is reallocated with the new size on the next read */
+    if (s2n_stuffer_data_available(&conn->buffer_in) == 0) {
+        POSIX_GUARD(s2n_stuffer_resize(&conn->buffer_in, 0));
+    }
+
+    return S2N_SUCCESS;
+}
+
 int s2n_connection_set_dynamic_record_threshold(struct s2n_connection *conn, uint32_t resize_threshold, uint16_t timeout_threshold)
 {
     POSIX_ENSURE_REF(conn);
@@ -1285,6 +1305,38 @@ int s2n_connection_recv_stuffer(struct s2n_stuffer *stuffer, struct s2n_connecti
     return r;
 }
 
+S2N_RESULT s2n_connection_acquire_record_buffer(struct s2n_connection *conn, struct s2n_stuffer *stuffer, uint32_t size)
+{
+    RESULT_ENSURE_REF(conn);
+    RESULT_ENSURE_REF(conn->config);
+
+    if (conn->config->dynamic_buffers && size <= S2N_BUFFER_POOL_BUFFER_SIZE) {
+        RESULT_GUARD(s2n_buffer_pool_acquire(stuffer));
+    }
+    RESULT_GUARD_POSIX(s2n_stuffer_resize_if_empty(stuffer, size));
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_connection_release_record_buffers(struct s2n_connection *conn)
+{
+    RESULT_ENSURE_REF(conn);
+    RESULT_ENSURE_REF(conn->config);
+
+    if (!conn->config->dynamic_buffers) {
+        return S2N_RESULT_OK;
+    }
+
+    /* Buffers holding part of a record, or plaintext lent out by s2n_recv_view, are kept */
+    if (conn->in_status == ENCRYPTED) {
+        RESULT_GUARD(s2n_buffer_pool_release(&conn->in));
+    }
+    RESULT_GUARD(s2n_buffer_pool_release(&conn->buffer_in));
+    RESULT_GUARD(s2n_buffer_pool_release(&conn->out));
+
+    return S2N_RESULT_OK;
+}
+
 int s2n_connection_send_stuffer(struct s2n_stuffer *stuffer, struct s2n_connection *conn, uint32_t len)
 {
     POSIX_ENSURE_REF(conn);
@@ -39,6 +39,7 @@
 #include "crypto/s2n_hash.h"
 #include "crypto/s2n_hmac.h"
 
+#include "utils/s2n_arena.h"
 #include "utils/s2n_mem.h"
 #include "utils/s2n_timer.h"
 
@@ -52,20 +53,17 @@ typedef enum {
     S2N_NEW_TICKET
 } s2n_session_ticket_status;
 
+/* Fields are grouped by how often they are touched. The first group is read on every record
+ * sent or received and is kept small so that it spans only a few cache lines. The secure crypto
+ * parameters follow, then state that is only used while establishing or tearing down the
+ * connection. Handshake-only state that isn't needed afterwards (the initial crypto parameters,
+ * the PRF working space and the transcript hashes) is allocated separately and released by
+ * s2n_connection_free_handshake. Build the s2n_connection_layout_report target (needs pahole)
+ * to print the resulting layout. */
 struct s2n_connection {
     /* The configuration (cert, key .. etc ) */
     struct s2n_config *config;
 
-    /* Overrides Security Policy in config if non-null */
-    const struct s2n_security_policy *security_policy_override;
-
-    /* The user defined context associated with connection */
-    void *context;
-
-    /* The user defined secret callback and context */
-    s2n_secret_cb secret_cb;
-    void *secret_cb_context;
-
     /* The send and receive callbacks don't have to be the same (e.g. two pipes) */
     s2n_send_fn *send;
     s2n_recv_fn *recv;
@@ -74,6 +72,13 @@ struct s2n_connection {
     void *send_io_context;
     void *recv_io_context;
 
+    /* Which set is the client/server actually using? */
+    struct s2n_crypto_parameters *client;
+    struct s2n_crypto_parameters *server;
+
+    /* Is this connection a client or a server connection */
+    s2n_mode mode;
+
     /* Has the user set their own I/O callbacks or is this connection using the
      * default socket-based I/O set by s2n */
     uint8_t managed_io;
@@ -111,36 +116,20 @@ struct s2n_connection {
     /* If write fd is broken */
     unsigned write_fd_broken:1;
 
-    /* Track request extensions to ensure correct response extension behavior.
-     *
-     * We need to track client and server extensions separately because some
-     * extensions (like request_status and other Certificate extensions) can
-     * be requested by the client, the server, or both.
-     */
-    s2n_extension_bitfield extension_requests_sent;
-    s2n_extension_bitfield extension_requests_received;
+    /* Whether conn->out holds space handed out by s2n_send_reserve */
+    unsigned send_reserved:1;
 
-    /* Is this connection a client or a server connection */
-    s2n_mode mode;
-
-    /* Does s2n handle the blinding, or does the application */
-    s2n_blinding blinding;
+    /* Whether records are encrypted / decrypted by the kernel. See s2n_ktls.h */
+    unsigned ktls_send_enabled:1;
+    unsigned ktls_recv_enabled:1;
+    /* Whether the kernel must switch to new send keys once conn->out is flushed */
+    unsigned ktls_send_key_update_pending:1;
 
-    /* A timer to measure the time between record writes */
-    struct s2n_timer write_timer;
+    /* Key update data */
+    unsigned key_update_pending:1;
 
-    /* last written time */
-    uint64_t last_write_elapsed;
-
-    /* When fatal errors occurs, s2n imposes a pause before
-     * the connection is closed. If non-zero, this value tracks
-     * how many nanoseconds to pause - which will be relative to
-     * the write_timer value. */
-    uint64_t delay;
-
-    /* The session id */
-    uint8_t session_id[S2N_TLS_SESSION_ID_MAX_LEN];
-    uint8_t session_id_len;
+    /* With kTLS, conn->out holds plaintext of this content type instead of encrypted records */
+    uint8_t ktls_out_content_type;
 
     /* The version advertised by the client, by the
      * server, and the actual version we are currently
@@ -154,33 +143,27 @@ struct s2n_connection {
      * negotiated yet. */
     uint8_t actual_protocol_version_established;
 
-    /* Our crypto parameters */
-    struct s2n_crypto_parameters initial;
-    struct s2n_crypto_parameters secure;
-
-    /* Which set is the client/server actually using? */
-    struct s2n_crypto_parameters *client;
-    struct s2n_crypto_parameters *server;
-
-    /* Contains parameters needed during the handshake phase */
-    struct s2n_handshake_parameters handshake_params;
-
-    /* Our PSK parameters */
-    struct s2n_psk_parameters psk_params;
-
-    /* The PRF needs some storage elements to work with */
-    struct s2n_prf_working_space prf_space;
+    /* Flags to prevent users from calling methods recursively.
+     * This can be an easy mistake to make when implementing send/receive callbacks.
+     */
+    bool send_in_use;
+    bool recv_in_use;
 
-    /* Whether to use client_cert_auth_type stored in s2n_config or in this s2n_connection.
+    /* Is the connection open or closed ? We use C's only
+     * atomic type as both the reader and the writer threads
+     * may declare a connection closed.
      *
-     * By default the s2n_connection will defer to s2n_config->client_cert_auth_type on whether or not to use Client Auth.
-     * But users can override Client Auth at the connection level using s2n_connection_set_client_auth_type() without mutating
-     * s2n_config since s2n_config can be shared between multiple s2n_connections. */
-    uint8_t client_cert_auth_type_overridden;
-
-    /* Whether or not the s2n_connection should require the Client to authenticate itself to the server. Only used if
-     * client_cert_auth_type_overridden is non-zero. */
-    s2n_cert_auth_type client_cert_auth_type;
+     * A connection can be gracefully closed or hard-closed.
+     * When gracefully closed the reader or the writer mark
+     * the connection as closing, and then the writer will
+     * send an alert message before closing the connection
+     * and marking it as closed.
+     *
+     * A hard-close goes straight to closed with no alert
+     * message being sent.
+     */
+    sig_atomic_t closing;
+    sig_atomic_t closed;
 
     /* Our workhorse stuffers, used for buffering the plaintext
      * and encrypted data in both directions.
@@ -191,12 +174,56 @@ struct s2n_connection {
     struct s2n_stuffer out;
     enum { ENCRYPTED, PLAINTEXT } in_status;
 
+    /* An error hit by s2n_recv after it had already copied data to the caller.
+     * The data is returned first and the error is reported by the next call. */
+    int recv_deferred_error;
+
+    /* Optional read-ahead buffer for encrypted records. When recv_buffer_size is set,
+     * reads from the network pull up to recv_buffer_size bytes into buffer_in, and
+     * record headers and fragments are copied out of it without further reads.
+     */
+    uint32_t recv_buffer_size;
+    struct s2n_stuffer buffer_in;
+
     /* How much of the current user buffer have we already
      * encrypted and sent or have pending for the wire but have
      * not acknowledged to the user.
      */
     ssize_t current_user_data_consumed;
 
+    /* Keep some accounting on each connection */
+    uint64_t wire_bytes_in;
+    uint64_t wire_bytes_out;
+
+    /* Maximum outgoing fragment size for this connection. Does not limit
+     * incoming record size.
+     *
+     * This value is updated when:
+     *   1. s2n_connection_prefer_low_latency is set
+     *   2. s2n_connection_prefer_throughput is set
+     *   3. TLS Maximum Fragment Length extension is negotiated
+     *
+     * Default value: S2N_DEFAULT_FRAGMENT_LENGTH
+     */
+    uint16_t max_outgoing_fragment_length;
+
+    /* Reset record size back to a single segment after threshold seconds of inactivity */
+    uint16_t dynamic_record_timeout_threshold;
+
+    /* The number of bytes to send before changing the record size. 
+     * If this value > 0 then dynamic TLS record size is enabled. Otherwise, the feature is disabled (default). 
+     */
+    uint32_t dynamic_record_resize_threshold;
+
+    /* number of bytes consumed during application activity */
+    uint64_t active_application_bytes_consumed;
+
+    /* A timer to measure the time between record writes */
+    struct s2n_timer write_timer;
+
+    /* last written time */
+    uint64_t last_write_elapsed;
+
     /* An alert may be fragmented across multiple records,
      * this stuffer is used to re-assemble.
      */
@@ -216,65 +243,84 @@ struct s2n_connection {
     struct s2n_stuffer reader_alert_out;
     struct s2n_stuffer writer_alert_out;
 
+    s2n_early_data_state early_data_state;
+    uint64_t early_data_bytes;
+
+    /* Our crypto parameters */
+    struct s2n_crypto_parameters secure;
+    /* Only used until the handshake is complete.
+     * NULL once s2n_connection_free_handshake has released it. */
+    struct s2n_crypto_parameters *initial;
+
+    /* The PRF needs some storage elements to work with.
+     * NULL once s2n_connection_free_handshake has released it. */
+    struct s2n_prf_working_space *prf_space;
+
     /* Our handshake state machine */
     struct s2n_handshake handshake;
 
-    /* Maximum outgoing fragment size for this connection. Does not limit
-     * incoming record size.
-     *
-     * This value is updated when:
-     *   1. s2n_connection_prefer_low_latency is set
-     *   2. s2n_connection_prefer_throughput is set
-     *   3. TLS Maximum Fragment Length extension is negotiated
+    /* Scratch memory for handshake messages, wiped and released in one shot
+     * once the handshake completes */
+    struct s2n_arena handshake_arena;
+
+    /* Overrides Security Policy in config if non-null */
+    const struct s2n_security_policy *security_policy_override;
+
+    /* The user defined context associated with connection */
+    void *context;
+
+    /* The user defined secret callback and context */
+    s2n_secret_cb secret_cb;
+    void *secret_cb_context;
+
+    /* Track request extensions to ensure correct response extension behavior.
      *
-     * Default value: S2N_DEFAULT_FRAGMENT_LENGTH
+     * We need to track client and server extensions separately because some
+     * extensions (like request_status and other Certificate extensions) can
+     * be requested by the client, the server, or both.
      */
-    uint16_t max_outgoing_fragment_length;
+    s2n_extension_bitfield extension_requests_sent;
+    s2n_extension_bitfield extension_requests_received;
 
-    /* The number of bytes to send before changing the record size. 
-     * If this value > 0 then dynamic TLS record size is enabled. Otherwise, the feature is disabled (default). 
-     */
-    uint32_t dynamic_record_resize_threshold;
+    /* Does s2n handle the blinding, or does the application */
+    s2n_blinding blinding;
 
-    /* Reset record size back to a single segment after threshold seconds of inactivity */
-    uint16_t dynamic_record_timeout_threshold;
+    /* When fatal errors occurs, s2n imposes a pause before
+     * the connection is closed. If non-zero, this value tracks
+     * how many nanoseconds to pause - which will be relative to
+     * the write_timer value. */
+    uint64_t delay;
 
-    /* number of bytes consumed during application activity */
-    uint64_t active_application_bytes_consumed;
+    /* With a blinding timer on the config, built-in blinding waits here instead of sleeping.
+     * blinding_deadline is measured with the timer's clock. */
+    struct s2n_blinding_timer *blinding_timer;
+    struct s2n_connection *blinding_next;
+    struct s2n_connection *blinding_prev;
+    uint64_t blinding_deadline;
+
+    /* The session id */
+    uint8_t session_id[S2N_TLS_SESSION_ID_MAX_LEN];
+    uint8_t session_id_len;
 
     /* Negotiated TLS extension Maximum Fragment Length code */
     uint8_t mfl_code;
 
-    /* Keep some accounting on each connection */
-    uint64_t wire_bytes_in;
-    uint64_t wire_bytes_out;
-    uint64_t early_data_bytes;
-
-    /* Is the connection open or closed ? We use C's only
-     * atomic type as both the reader and the writer threads
-     * may declare a connection closed.
-     *
-     * A connection can be gracefully closed or hard-closed.
-     * When gracefully closed the reader or the writer mark
-     * the connection as closing, and then the writer will
-     * send an alert message before closing the connection
-     * and marking it as closed.
+    /* Whether to use client_cert_auth_type stored in s2n_config or in this s2n_connection.
      *
-     * A hard-close goes straight to closed with no alert
-     * message being sent.
-     */
-    sig_atomic_t closing;
-    sig_atomic_t closed;
+     * By default the s2n_connection will defer to s2n_config->client_cert_auth_type on whether or not to use Client Auth.
+     * But users can override Client Auth at the connection level using s2n_connection_set_client_auth_type() without mutating
+     * s2n_config since s2n_config can be shared between multiple s2n_connections. */
+    uint8_t client_cert_auth_type_overridden;
 
-    /* TLS extension data */
-    char server_name[S2N_MAX_SERVER_NAME + 1];
+    /* Whether or not the s2n_connection should require the Client to authenticate itself to the server. Only used if
+     * client_cert_auth_type_overridden is non-zero. */
+    s2n_cert_auth_type client_cert_auth_type;
 
-    /* The application protocol decided upon during the client hello.
-     * If ALPN is being used, then:
-     * In server mode, this will be set by the time client_hello_cb is invoked.
-     * In client mode, this will be set after is_handshake_complete(connection) is true.
-     */
-    char application_protocol[256];
+    /* Contains parameters needed during the handshake phase */
+    struct s2n_handshake_parameters handshake_params;
+
+    /* Our PSK parameters */
+    struct s2n_psk_parameters psk_params;
 
     /* OCSP stapling response data */
     s2n_status_request_type status_type;
@@ -317,9 +363,6 @@ struct s2n_connection {
     /* Cookie extension data */
     struct s2n_stuffer cookie_stuffer;
 
-    /* Key update data */
-    unsigned key_update_pending:1;
-
     /* Early data supported by caller.
      * If a caller does not use any APIs that support early data,
      * do not negotiate early data.
@@ -337,17 +380,20 @@ struct s2n_connection {
      * */
     uint8_t preferred_key_shares;
 
-    /* Flags to prevent users from calling methods recursively.
-     * This can be an easy mistake to make when implementing send/receive callbacks.
-     */
-    bool send_in_use;
-    bool recv_in_use;
-    
     uint16_t tickets_to_send;
     uint16_t tickets_sent;
 
-    s2n_early_data_state early_data_state;
     uint32_t server_max_early_data_size;
+
+    /* TLS extension data */
+    char server_name[S2N_MAX_SERVER_NAME + 1];
+
+    /* The application protocol decided upon during the client hello.
+     * If ALPN is being used, then:
+     * In server mode, this will be set by the time client_hello_cb is invoked.
+     * In client mode, this will be set after is_handshake_complete(connection) is true.
+     */
+    char application_protocol[256];
 };
 
 int s2n_connection_is_managed_corked(const struct s2n_connection *s2n_connection);
@@ -360,6 +406,10 @@ int s2n_connection_kill(struct s2n_connection *conn);
 int s2n_connection_send_stuffer(struct s2n_stuffer *stuffer, struct s2n_connection *conn, uint32_t len);
 int s2n_connection_recv_stuffer(struct s2n_stuffer *stuffer, struct s2n_connection *conn, uint32_t len);
 
+/* Record buffers, borrowed from the thread's buffer pool when dynamic buffers are enabled */
+S2N_RESULT s2n_connection_acquire_record_buffer(struct s2n_connection *conn, struct s2n_stuffer *stuffer, uint32_t size);
+S2N_RESULT s2n_connection_release_record_buffers(struct s2n_connection *conn);
+
 S2N_RESULT s2n_connection_wipe_all_keyshares(struct s2n_connection *conn);
 
 int s2n_connection_get_cipher_preferences(struct s2n_connection *conn, const struct s2n_cipher_preferences **cipher_preferences);
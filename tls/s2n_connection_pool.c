@@ -0,0 +1,201 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "tls/s2n_connection_pool.h"
+
+#include <sys/param.h>
+#include <stdint.h>
+
+#include "utils/s2n_blob.h"
+#include "utils/s2n_mem.h"
+#include "utils/s2n_safety.h"
+
+/* Only the address of this variable matters: it is different in every thread */
+static __thread uint8_t s2n_connection_pool_thread_marker;
+
+static uint32_t s2n_connection_pool_home_shard(struct s2n_connection_pool *pool)
+{
+    /* Thread-local storage is laid out per thread, so mixing the address of a thread-local
+     * variable gives every thread a stable shard without any shared state. */
+    uint64_t hash = (uint64_t) (uintptr_t) &s2n_connection_pool_thread_marker;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash % pool->shard_count;
+}
+
+static S2N_RESULT s2n_connection_pool_shard_pop(struct s2n_connection_pool_shard *shard, struct s2n_connection **conn)
+{
+    *conn = NULL;
+    RESULT_ENSURE(pthread_mutex_lock(&shard->lock) == 0, S2N_ERR_LOCK);
+    if (shard->count > 0) {
+        *conn = shard->connections[--shard->count];
+        shard->connections[shard->count] = NULL;
+    }
+    RESULT_ENSURE(pthread_mutex_unlock(&shard->lock) == 0, S2N_ERR_LOCK);
+    return S2N_RESULT_OK;
+}
+
+/* Sets `pushed` if the shard had room for the connection */
+static S2N_RESULT s2n_connection_pool_shard_push(struct s2n_connection_pool_shard *shard,
+        struct s2n_connection *conn, bool *pushed)
+{
+    *pushed = false;
+    RESULT_ENSURE(pthread_mutex_lock(&shard->lock) == 0, S2N_ERR_LOCK);
+    if (shard->count < shard->capacity) {
+        shard->connections[shard->count++] = conn;
+        *pushed = true;
+    }
+    RESULT_ENSURE(pthread_mutex_unlock(&shard->lock) == 0, S2N_ERR_LOCK);
+    return S2N_RESULT_OK;
+}
+
+static struct s2n_connection *s2n_connection_pool_create_connection(struct s2n_connection_pool *pool)
+{
+    struct s2n_connection *conn = s2n_connection_new(pool->mode);
+    PTR_ENSURE_REF(conn);
+    if (s2n_connection_set_config(conn, pool->config) != S2N_SUCCESS) {
+        s2n_connection_free(conn);
+        return NULL;
+    }
+    return conn;
+}
+
+static int s2n_connection_pool_init(struct s2n_connection_pool *pool, struct s2n_config *config, s2n_mode mode, uint32_t size)
+{
+    pool->config = config;
+    pool->mode = mode;
+    pool->shard_count = MIN(size, S2N_CONNECTION_POOL_MAX_SHARDS);
+
+    for (uint32_t i = 0; i < pool->shard_count; i++) {
+        struct s2n_connection_pool_shard *shard = &pool->shards[i];
+
+        /* Split `size` as evenly as possible between the shards */
+        const uint32_t shard_capacity = size / pool->shard_count + (i < size % pool->shard_count);
+
+        struct s2n_blob mem = { 0 };
+        POSIX_GUARD(s2n_alloc(&mem, shard_capacity * sizeof(struct s2n_connection *)));
+        POSIX_GUARD(s2n_blob_zero(&mem));
+        shard->connections = (struct s2n_connection **)(void *) mem.data;
+        shard->capacity = shard_capacity;
+
+        if (pthread_mutex_init(&shard->lock, NULL) != 0) {
+            POSIX_GUARD(s2n_free_object((uint8_t **) &shard->connections, mem.size));
+            POSIX_BAIL(S2N_ERR_LOCK);
+        }
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        struct s2n_connection *conn = s2n_connection_pool_create_connection(pool);
+        POSIX_ENSURE_REF(conn);
+
+        struct s2n_connection_pool_shard *shard = &pool->shards[i % pool->shard_count];
+        shard->connections[shard->count++] = conn;
+    }
+
+    return S2N_SUCCESS;
+}
+
+struct s2n_connection_pool *s2n_connection_pool_new(struct s2n_config *config, s2n_mode mode, uint32_t size)
+{
+    PTR_ENSURE_REF(config);
+    PTR_ENSURE(size > 0, S2N_ERR_INVALID_ARGUMENT);
+
+    struct s2n_blob mem = { 0 };
+    PTR_GUARD_POSIX(s2n_alloc(&mem, sizeof(struct s2n_connection_pool)));
+    PTR_GUARD_POSIX(s2n_blob_zero(&mem));
+
+    struct s2n_connection_pool *pool = (struct s2n_connection_pool *)(void *) mem.data;
+    if (s2n_connection_pool_init(pool, config, mode, size) != S2N_SUCCESS) {
+        s2n_connection_pool_free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+int s2n_connection_pool_free(struct s2n_connection_pool *pool)
+{
+    POSIX_ENSURE_REF(pool);
+
+    for (uint32_t i = 0; i < pool->shard_count; i++) {
+        struct s2n_connection_pool_shard *shard = &pool->shards[i];
+        if (shard->connections == NULL) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < shard->count; j++) {
+            POSIX_GUARD(s2n_connection_free(shard->connections[j]));
+            shard->connections[j] = NULL;
+        }
+        shard->count = 0;
+
+        /* The lock is only initialized if the shard's storage was allocated */
+        POSIX_ENSURE(pthread_mutex_destroy(&shard->lock) == 0, S2N_ERR_LOCK);
+        POSIX_GUARD(s2n_free_object((uint8_t **) &shard->connections, shard->capacity * sizeof(struct s2n_connection *)));
+    }
+
+    POSIX_GUARD(s2n_free_object((uint8_t **) &pool, sizeof(struct s2n_connection_pool)));
+    return S2N_SUCCESS;
+}
+
+struct s2n_connection *s2n_connection_pool_acquire(struct s2n_connection_pool *pool)
+{
+    PTR_ENSURE_REF(pool);
+
+    /* Prefer this thread's shard, then take an idle connection from any other shard
+     * before paying for a new connection. */
+    const uint32_t home = s2n_connection_pool_home_shard(pool);
+    for (uint32_t i = 0; i < pool->shard_count; i++) {
+        struct s2n_connection *conn = NULL;
+        PTR_GUARD_RESULT(s2n_connection_pool_shard_pop(&pool->shards[(home + i) % pool->shard_count], &conn));
+        if (conn) {
+            return conn;
+        }
+    }
+
+    return s2n_connection_pool_create_connection(pool);
+}
+
+int s2n_connection_pool_release(struct s2n_connection_pool *pool, struct s2n_connection *conn)
+{
+    POSIX_ENSURE_REF(pool);
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE(conn->mode == pool->mode, S2N_ERR_INVALID_ARGUMENT);
+
+    /* Wipe outside of any lock: it is the expensive part of recycling a connection */
+    if (s2n_connection_wipe(conn) != S2N_SUCCESS
+            || s2n_connection_set_config(conn, pool->config) != S2N_SUCCESS) {
+        s2n_connection_free(conn);
+        S2N_ERROR_PRESERVE_ERRNO();
+    }
+
+    /* Prefer this thread's shard, but keep the connection if any shard has room for it */
+    const uint32_t home = s2n_connection_pool_home_shard(pool);
+    for (uint32_t i = 0; i < pool->shard_count; i++) {
+        bool pushed = false;
+        if (s2n_result_is_error(s2n_connection_pool_shard_push(&pool->shards[(home + i) % pool->shard_count], conn, &pushed))) {
+            s2n_connection_free(conn);
+            S2N_ERROR_PRESERVE_ERRNO();
+        }
+        if (pushed) {
+            return S2N_SUCCESS;
+        }
+    }
+
+    /* The pool is full */
+    POSIX_GUARD(s2n_connection_free(conn));
+    return S2N_SUCCESS;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <s2n.h>
+
+#include "tls/s2n_connection.h"
+
+/* Idle connections are spread across shards so that threads releasing and acquiring
+ * connections concurrently rarely wait on the same lock. */
+#define S2N_CONNECTION_POOL_MAX_SHARDS 8
+
+struct s2n_connection_pool_shard {
+    pthread_mutex_t lock;
+    struct s2n_connection **connections;
+    uint32_t count;
+    uint32_t capacity;
+};
+
+struct s2n_connection_pool {
+    struct s2n_config *config;
+    s2n_mode mode;
+
+    struct s2n_connection_pool_shard shards[S2N_CONNECTION_POOL_MAX_SHARDS];
+    uint32_t shard_count;
+};
@@ -0,0 +1,78 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "tls/s2n_crypto.h"
+
+#include "tls/s2n_cipher_suites.h"
+#include "utils/s2n_blob.h"
+#include "utils/s2n_mem.h"
+#include "utils/s2n_safety.h"
+
+S2N_RESULT s2n_crypto_parameters_new(struct s2n_crypto_parameters **params)
+{
+    RESULT_ENSURE_REF(params);
+    RESULT_ENSURE_EQ(*params, NULL);
+
+    DEFER_CLEANUP(struct s2n_blob mem = { 0 }, s2n_free);
+    RESULT_GUARD_POSIX(s2n_alloc(&mem, sizeof(struct s2n_crypto_parameters)));
+    RESULT_GUARD_POSIX(s2n_blob_zero(&mem));
+    struct s2n_crypto_parameters *new_params = (struct s2n_crypto_parameters *)(void *) mem.data;
+
+    new_params->cipher_suite = &s2n_null_cipher_suite;
+
+    /* Allocate long term key, hash and HMAC memory */
+    RESULT_GUARD_POSIX(s2n_session_key_alloc(&new_params->client_key));
+    RESULT_GUARD_POSIX(s2n_session_key_alloc(&new_params->server_key));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_params->signature_hash));
+    RESULT_GUARD_POSIX(s2n_hmac_new(&new_params->client_record_mac));
+    RESULT_GUARD_POSIX(s2n_hmac_new(&new_params->server_record_mac));
+    RESULT_GUARD_POSIX(s2n_hmac_new(&new_params->record_mac_copy_workspace));
+
+    *params = new_params;
+    ZERO_TO_DISABLE_DEFER_CLEANUP(mem);
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_crypto_parameters_free(struct s2n_crypto_parameters **params)
+{
+    RESULT_ENSURE_REF(params);
+    struct s2n_crypto_parameters *to_free = *params;
+    if (to_free == NULL) {
+        return S2N_RESULT_OK;
+    }
+
+    const struct s2n_cipher *cipher = NULL;
+    if (to_free->cipher_suite && to_free->cipher_suite->record_alg) {
+        cipher = to_free->cipher_suite->record_alg->cipher;
+    }
+    if (cipher && cipher->destroy_key) {
+        RESULT_GUARD_POSIX(cipher->destroy_key(&to_free->client_key));
+        RESULT_GUARD_POSIX(cipher->destroy_key(&to_free->server_key));
+    }
+    RESULT_GUARD_POSIX(s2n_session_key_free(&to_free->client_key));
+    RESULT_GUARD_POSIX(s2n_session_key_free(&to_free->server_key));
+
+    RESULT_GUARD_POSIX(s2n_hash_reset(&to_free->signature_hash));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->signature_hash));
+    RESULT_GUARD_POSIX(s2n_hmac_reset(&to_free->client_record_mac));
+    RESULT_GUARD_POSIX(s2n_hmac_reset(&to_free->server_record_mac));
+    RESULT_GUARD_POSIX(s2n_hmac_reset(&to_free->record_mac_copy_workspace));
+    RESULT_GUARD_POSIX(s2n_hmac_free(&to_free->client_record_mac));
+    RESULT_GUARD_POSIX(s2n_hmac_free(&to_free->server_record_mac));
+    RESULT_GUARD_POSIX(s2n_hmac_free(&to_free->record_mac_copy_workspace));
+
+    RESULT_GUARD_POSIX(s2n_free_object((uint8_t **) params, sizeof(struct s2n_crypto_parameters)));
+    return S2N_RESULT_OK;
+}
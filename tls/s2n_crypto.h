@@ -30,7 +30,20 @@
 #include "crypto/s2n_dhe.h"
 #include "crypto/s2n_ecc_evp.h"
 
+/* The fields used to protect every record come first so that the record path touches as few
+ * cache lines as possible. Key exchange and authentication state follows. */
 struct s2n_crypto_parameters {
+    struct s2n_cipher_suite *cipher_suite;
+    uint8_t client_sequence_number[S2N_TLS_SEQUENCE_NUM_LEN];
+    uint8_t server_sequence_number[S2N_TLS_SEQUENCE_NUM_LEN];
+    uint8_t client_implicit_iv[S2N_TLS_MAX_IV_LEN];
+    uint8_t server_implicit_iv[S2N_TLS_MAX_IV_LEN];
+    struct s2n_session_key client_key;
+    struct s2n_session_key server_key;
+    struct s2n_hmac_state client_record_mac;
+    struct s2n_hmac_state server_record_mac;
+    struct s2n_hmac_state record_mac_copy_workspace;
+
     struct s2n_pkey server_public_key;
     struct s2n_pkey client_public_key;
     struct s2n_dh_params server_dh_params;
@@ -52,22 +65,14 @@ struct s2n_crypto_parameters {
 
     struct s2n_signature_scheme client_cert_sig_scheme;
 
-    struct s2n_cipher_suite *cipher_suite;
-    struct s2n_session_key client_key;
-    struct s2n_session_key server_key;
-
     uint8_t rsa_premaster_secret[S2N_TLS_SECRET_LEN];
     uint8_t master_secret[S2N_TLS_SECRET_LEN];
     uint8_t client_random[S2N_TLS_RANDOM_DATA_LEN];
     uint8_t server_random[S2N_TLS_RANDOM_DATA_LEN];
-    uint8_t client_implicit_iv[S2N_TLS_MAX_IV_LEN];
-    uint8_t server_implicit_iv[S2N_TLS_MAX_IV_LEN];
     uint8_t client_app_secret[S2N_TLS13_SECRET_MAX_LEN];
     uint8_t server_app_secret[S2N_TLS13_SECRET_MAX_LEN];
     struct s2n_hash_state signature_hash;
-    struct s2n_hmac_state client_record_mac;
-    struct s2n_hmac_state server_record_mac;
-    struct s2n_hmac_state record_mac_copy_workspace;
-    uint8_t client_sequence_number[S2N_TLS_SEQUENCE_NUM_LEN];
-    uint8_t server_sequence_number[S2N_TLS_SEQUENCE_NUM_LEN];
 };
+
+S2N_RESULT s2n_crypto_parameters_new(struct s2n_crypto_parameters **params);
+S2N_RESULT s2n_crypto_parameters_free(struct s2n_crypto_parameters **params);
@@ -72,27 +72,33 @@ static int s2n_handshake_get_hash_state_ptr(struct s2n_connection *conn, s2n_has
 {
     POSIX_ENSURE_REF(conn);
 
+    /* Buffered handshake messages must be hashed before the transcript can be read */
+    POSIX_GUARD_RESULT(s2n_handshake_transcript_flush(conn));
+
+    struct s2n_handshake_hashes *hashes = conn->handshake.hashes;
+    POSIX_ENSURE_REF(hashes);
+
     switch (hash_alg) {
     case S2N_HASH_MD5:
-        *hash_state = &conn->handshake.md5;
+        *hash_state = &hashes->md5;
         break;
     case S2N_HASH_SHA1:
-        *hash_state = &conn->handshake.sha1;
+        *hash_state = &hashes->sha1;
         break;
     case S2N_HASH_SHA224:
-        *hash_state = &conn->handshake.sha224;
+        *hash_state = &hashes->sha224;
         break;
     case S2N_HASH_SHA256:
-        *hash_state = &conn->handshake.sha256;
+        *hash_state = &hashes->sha256;
         break;
     case S2N_HASH_SHA384:
-        *hash_state = &conn->handshake.sha384;
+        *hash_state = &hashes->sha384;
         break;
     case S2N_HASH_SHA512:
-        *hash_state = &conn->handshake.sha512;
+        *hash_state = &hashes->sha512;
         break;
     case S2N_HASH_MD5_SHA1:
-        *hash_state = &conn->handshake.md5_sha1;
+        *hash_state = &hashes->md5_sha1;
         break;
     default:
         POSIX_BAIL(S2N_ERR_HASH_INVALID_ALGORITHM);
@@ -166,6 +172,7 @@ int s2n_conn_update_required_handshake_hashes(struct s2n_connection *conn)
     /* If client authentication is possible, all hashes are needed until we're past CLIENT_CERT_VERIFY. */
     if ((client_cert_auth_type != S2N_CERT_AUTH_NONE) && !client_cert_verify_done) {
         POSIX_GUARD(s2n_handshake_require_all_hashes(&conn->handshake));
+        POSIX_GUARD_RESULT(s2n_handshake_transcript_flush(conn));
         return 0;
     }
 
@@ -190,6 +197,9 @@ int s2n_conn_update_required_handshake_hashes(struct s2n_connection *conn)
     }
     }
 
+    /* Now that the required hashes are known, hash any buffered messages with only those */
+    POSIX_GUARD_RESULT(s2n_handshake_transcript_flush(conn));
+
     return 0;
 }
 
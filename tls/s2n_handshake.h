@@ -19,6 +19,7 @@
 #include <s2n.h>
 
 #include "tls/s2n_crypto.h"
+#include "tls/s2n_handshake_hashes.h"
 #include "tls/s2n_handshake_type.h"
 #include "tls/s2n_signature_algorithms.h"
 #include "tls/s2n_tls_parameters.h"
@@ -122,30 +123,26 @@ struct s2n_handshake_parameters {
 struct s2n_handshake {
     struct s2n_stuffer io;
 
-    struct s2n_hash_state md5;
-    struct s2n_hash_state sha1;
-    struct s2n_hash_state sha224;
-    struct s2n_hash_state sha256;
-    struct s2n_hash_state sha384;
-    struct s2n_hash_state sha512;
-    struct s2n_hash_state md5_sha1;
-
-    /* A copy of the handshake messages hash used to validate the CertificateVerify message */
-    struct s2n_hash_state ccv_hash_copy;
-
-    /* Used for SSLv3, TLS 1.0, and TLS 1.1 PRFs */
-    struct s2n_hash_state prf_md5_hash_copy;
-    struct s2n_hash_state prf_sha1_hash_copy;
-    /*Used for TLS 1.2 PRF */
-    struct s2n_hash_state prf_tls12_hash_copy;
-    struct s2n_hash_state server_hello_copy;
-    struct s2n_hash_state server_finished_copy;
+    /* The transcript hashes. NULL once s2n_connection_free_handshake has released them. */
+    struct s2n_handshake_hashes *hashes;
 
     /* Hash algorithms required for this handshake. The set of required hashes can be reduced as session parameters are
      * negotiated, i.e. cipher suite and protocol version.
      */
     uint8_t required_hash_algs[S2N_HASH_SENTINEL];
 
+    /* Handshake messages that have not been added to the transcript hashes yet.
+     * Until the required hashes are known, messages are buffered here instead of being hashed
+     * with every algorithm. The buffer is replayed into the required hashes once they are known,
+     * or into all of them if a transcript hash is needed earlier.
+     */
+    struct s2n_stuffer transcript_buffer;
+
+    /* Handshake messages of the current flight that have not been written as records yet.
+     * Consecutive messages are collected here so that they can share records.
+     */
+    struct s2n_stuffer flight;
+
     uint8_t server_finished[S2N_TLS_SECRET_LEN];
     uint8_t client_finished[S2N_TLS_SECRET_LEN];
 
@@ -170,6 +167,16 @@ struct s2n_handshake {
 
     /* Set to 1 if the RSA verification failed */
     unsigned rsa_failed:1;
+
+    /* Set while handshake messages are added to transcript_buffer instead of the transcript hashes */
+    unsigned transcript_buffering:1;
+
+    /* Set while records of the current flight are queued in conn->out, waiting to be flushed together */
+    unsigned flight_queued:1;
+
+    /* Set once the current message has been queued, if the flight still has to be flushed before
+     * the state machine can advance */
+    unsigned flight_flush_pending:1;
 };
 
 extern message_type_t s2n_conn_get_current_message_type(struct s2n_connection *conn);
@@ -186,6 +193,7 @@ extern int s2n_conn_find_name_matching_certs(struct s2n_connection *conn);
 extern int s2n_create_wildcard_hostname(struct s2n_stuffer *hostname, struct s2n_stuffer *output);
 struct s2n_cert_chain_and_key *s2n_get_compatible_cert_chain_and_key(struct s2n_connection *conn, const s2n_pkey_type cert_type);
 int s2n_conn_update_handshake_hashes(struct s2n_connection *conn, struct s2n_blob *data);
+S2N_RESULT s2n_handshake_transcript_flush(struct s2n_connection *conn);
 S2N_RESULT s2n_quic_read_handshake_message(struct s2n_connection *conn, uint8_t *message_type);
 S2N_RESULT s2n_quic_write_handshake_message(struct s2n_connection *conn, struct s2n_blob *in);
 S2N_RESULT s2n_negotiate_until_message(struct s2n_connection *conn, s2n_blocked_status *blocked, message_type_t end_message);
@@ -0,0 +1,138 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "tls/s2n_handshake_hashes.h"
+
+#include "crypto/s2n_fips.h"
+#include "utils/s2n_blob.h"
+#include "utils/s2n_mem.h"
+#include "utils/s2n_safety.h"
+
+S2N_RESULT s2n_handshake_hashes_new(struct s2n_handshake_hashes **hashes)
+{
+    RESULT_ENSURE_REF(hashes);
+    RESULT_ENSURE_EQ(*hashes, NULL);
+
+    DEFER_CLEANUP(struct s2n_blob mem = { 0 }, s2n_free);
+    RESULT_GUARD_POSIX(s2n_alloc(&mem, sizeof(struct s2n_handshake_hashes)));
+    RESULT_GUARD_POSIX(s2n_blob_zero(&mem));
+    struct s2n_handshake_hashes *new_hashes = (struct s2n_handshake_hashes *)(void *) mem.data;
+
+    /* Allocate long-term memory for the hash states */
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->md5));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->sha1));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->sha224));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->sha256));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->sha384));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->sha512));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->md5_sha1));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->ccv_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->prf_md5_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->prf_sha1_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->prf_tls12_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->server_hello_copy));
+    RESULT_GUARD_POSIX(s2n_hash_new(&new_hashes->server_finished_copy));
+
+    *hashes = new_hashes;
+    ZERO_TO_DISABLE_DEFER_CLEANUP(mem);
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_handshake_hashes_init(struct s2n_handshake_hashes *hashes)
+{
+    RESULT_ENSURE_REF(hashes);
+
+    /* Allow MD5 for hash states that are used by the PRF. This is required
+     * to comply with the TLS 1.0 and 1.1 RFCs and is approved as per
+     * NIST Special Publication 800-52 Revision 1.
+     */
+    if (s2n_is_in_fips_mode()) {
+        RESULT_GUARD_POSIX(s2n_hash_allow_md5_for_fips(&hashes->md5));
+        RESULT_GUARD_POSIX(s2n_hash_allow_md5_for_fips(&hashes->prf_md5_hash_copy));
+
+        /* Do not check s2n_hash_is_available before initialization. Allow MD5 and
+         * SHA-1 for both fips and non-fips mode. This is required to perform the
+         * signature checks in the CertificateVerify message in TLS 1.0 and TLS 1.1.
+         * This is approved per Nist SP 800-52r1.*/
+        RESULT_GUARD_POSIX(s2n_hash_allow_md5_for_fips(&hashes->md5_sha1));
+    }
+
+    /* The transcript hashes are initialized once the handshake knows which of them it needs.
+     * See s2n_handshake_transcript_flush. */
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->md5, S2N_HASH_NONE));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->prf_md5_hash_copy, S2N_HASH_MD5));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->md5_sha1, S2N_HASH_NONE));
+
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->sha1, S2N_HASH_NONE));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->sha224, S2N_HASH_NONE));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->sha256, S2N_HASH_NONE));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->sha384, S2N_HASH_NONE));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->sha512, S2N_HASH_NONE));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->ccv_hash_copy, S2N_HASH_NONE));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->prf_tls12_hash_copy, S2N_HASH_NONE));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->server_hello_copy, S2N_HASH_NONE));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->server_finished_copy, S2N_HASH_NONE));
+    RESULT_GUARD_POSIX(s2n_hash_init(&hashes->prf_sha1_hash_copy, S2N_HASH_SHA1));
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_handshake_hashes_reset(struct s2n_handshake_hashes *hashes)
+{
+    RESULT_ENSURE_REF(hashes);
+
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->md5));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->sha1));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->sha224));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->sha256));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->sha384));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->sha512));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->md5_sha1));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->ccv_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->prf_md5_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->prf_sha1_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->prf_tls12_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->server_hello_copy));
+    RESULT_GUARD_POSIX(s2n_hash_reset(&hashes->server_finished_copy));
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_handshake_hashes_free(struct s2n_handshake_hashes **hashes)
+{
+    RESULT_ENSURE_REF(hashes);
+    struct s2n_handshake_hashes *to_free = *hashes;
+    if (to_free == NULL) {
+        return S2N_RESULT_OK;
+    }
+
+    RESULT_GUARD(s2n_handshake_hashes_reset(to_free));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->md5));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->sha1));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->sha224));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->sha256));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->sha384));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->sha512));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->md5_sha1));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->ccv_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->prf_md5_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->prf_sha1_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->prf_tls12_hash_copy));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->server_hello_copy));
+    RESULT_GUARD_POSIX(s2n_hash_free(&to_free->server_finished_copy));
+
+    RESULT_GUARD_POSIX(s2n_free_object((uint8_t **) hashes, sizeof(struct s2n_handshake_hashes)));
+    return S2N_RESULT_OK;
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include "crypto/s2n_hash.h"
+#include "utils/s2n_result.h"
+
+/* The transcript hashes are only needed until the handshake completes, so they are
+ * allocated separately from the connection and released by s2n_connection_free_handshake. */
+struct s2n_handshake_hashes {
+    struct s2n_hash_state md5;
+    struct s2n_hash_state sha1;
+    struct s2n_hash_state sha224;
+    struct s2n_hash_state sha256;
+    struct s2n_hash_state sha384;
+    struct s2n_hash_state sha512;
+    struct s2n_hash_state md5_sha1;
+
+    /* A copy of the handshake messages hash used to validate the CertificateVerify message */
+    struct s2n_hash_state ccv_hash_copy;
+
+    /* Used for SSLv3, TLS 1.0, and TLS 1.1 PRFs */
+    struct s2n_hash_state prf_md5_hash_copy;
+    struct s2n_hash_state prf_sha1_hash_copy;
+    /*Used for TLS 1.2 PRF */
+    struct s2n_hash_state prf_tls12_hash_copy;
+    struct s2n_hash_state server_hello_copy;
+    struct s2n_hash_state server_finished_copy;
+};
+
+S2N_RESULT s2n_handshake_hashes_new(struct s2n_handshake_hashes **hashes);
+S2N_RESULT s2n_handshake_hashes_init(struct s2n_handshake_hashes *hashes);
+S2N_RESULT s2n_handshake_hashes_reset(struct s2n_handshake_hashes *hashes);
+S2N_RESULT s2n_handshake_hashes_free(struct s2n_handshake_hashes **hashes);
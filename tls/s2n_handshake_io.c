@@ -32,6 +32,7 @@
 #include "tls/s2n_tls13.h"
 #include "tls/s2n_tls13_handshake.h"
 #include "tls/s2n_kex.h"
+#include "tls/s2n_ktls.h"
 #include "tls/s2n_post_handshake.h"
 
 #include "stuffer/s2n_stuffer.h"
@@ -851,61 +852,127 @@ const char *s2n_connection_get_handshake_type_name(struct s2n_connection *conn)
     return handshake_type_str[handshake_type];
 }
 
-/* Writing is relatively straight forward, simply write each message out as a record,
- * we may fragment a message across multiple records, but we never coalesce multiple
- * messages into single records.
- * Precondition: secure outbound I/O has already been flushed
+/* Returns true if the records for the current flight have to be written after the current message,
+ * instead of waiting for more messages to share them.
  */
-static int s2n_handshake_write_io(struct s2n_connection *conn)
+static bool s2n_handshake_is_record_boundary(struct s2n_connection *conn)
 {
-    uint8_t record_type = EXPECTED_RECORD_TYPE(conn);
-    s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+    /* QUIC frames each message itself */
+    if (conn->config->quic_enabled) {
+        return true;
+    }
 
-    /* Populate handshake.io with header/payload for the current state, once.
-     * Check wiped instead of s2n_stuffer_data_available to differentiate between the initial call
-     * to s2n_handshake_write_io and a repeated call after an EWOULDBLOCK.
-     */
-    if (s2n_stuffer_is_wiped(&conn->handshake.io)) {
-        if (record_type == TLS_HANDSHAKE) {
-            POSIX_GUARD(s2n_handshake_write_header(&conn->handshake.io, ACTIVE_STATE(conn).message_type));
-        }
-        POSIX_GUARD(ACTIVE_STATE(conn).handler[conn->mode] (conn));
-        if (record_type == TLS_HANDSHAKE) {
-            POSIX_GUARD(s2n_handshake_finish_header(&conn->handshake.io));
-        }
+    if (EXPECTED_RECORD_TYPE(conn) != TLS_HANDSHAKE) {
+        return true;
+    }
+
+    /* Records must be protected with the keys in place when their messages were written */
+    if (s2n_tls13_secrets_may_change(conn)) {
+        return true;
+    }
+
+    /* The flight ends when the next message is not ours to write */
+    message_type_t next_message = ACTIVE_HANDSHAKES(conn)[conn->handshake.handshake_type][conn->handshake.message_number + 1];
+    if (next_message == conn->handshake.end_of_messages) {
+        return true;
     }
+    struct s2n_handshake_action next_state = ACTIVE_STATE_MACHINE(conn)[next_message];
+    return next_state.writer != CONNECTION_WRITER(conn) || next_state.record_type != TLS_HANDSHAKE;
+}
+
+/* Returns true if the state machine has to wait for the peer, or stop, after the current message */
+static bool s2n_handshake_is_end_of_flight(struct s2n_connection *conn)
+{
+    message_type_t next_message = ACTIVE_HANDSHAKES(conn)[conn->handshake.handshake_type][conn->handshake.message_number + 1];
+    if (next_message == conn->handshake.end_of_messages) {
+        return true;
+    }
+    return ACTIVE_STATE_MACHINE(conn)[next_message].writer != CONNECTION_WRITER(conn);
+}
+
+static int s2n_handshake_write_flight(struct s2n_connection *conn, uint8_t record_type)
+{
+    struct s2n_stuffer *flight = &conn->handshake.flight;
 
     /* Write the handshake data to records in fragment sized chunks */
     struct s2n_blob out = {0};
-    while (s2n_stuffer_data_available(&conn->handshake.io) > 0) {
+    while (s2n_stuffer_data_available(flight) > 0) {
         uint16_t max_payload_size = 0;
         POSIX_GUARD_RESULT(s2n_record_max_write_payload_size(conn, &max_payload_size));
-        out.size = MIN(s2n_stuffer_data_available(&conn->handshake.io), max_payload_size);
+        out.size = MIN(s2n_stuffer_data_available(flight), max_payload_size);
 
-        out.data = s2n_stuffer_raw_read(&conn->handshake.io, out.size);
+        out.data = s2n_stuffer_raw_read(flight, out.size);
         POSIX_ENSURE_REF(out.data);
 
         if (conn->config->quic_enabled) {
             POSIX_GUARD_RESULT(s2n_quic_write_handshake_message(conn, &out));
         } else {
+            /* Queue the record behind the rest of the flight. It is flushed at the end of the flight. */
+            conn->handshake.flight_queued = 1;
             POSIX_GUARD(s2n_record_write(conn, record_type, &out));
         }
+    }
+
+    POSIX_GUARD(s2n_stuffer_wipe(flight));
 
-        /* MD5 and SHA sum the handshake data too */
+    return 0;
+}
+
+/* Writing is relatively straight forward. Consecutive handshake messages that we write with the
+ * same keys are collected into a flight and written out together, so several messages may share a
+ * record and a large message may be fragmented across multiple records.
+ * Precondition: secure outbound I/O has already been flushed
+ */
+static int s2n_handshake_write_io(struct s2n_connection *conn)
+{
+    uint8_t record_type = EXPECTED_RECORD_TYPE(conn);
+    s2n_blocked_status blocked = S2N_NOT_BLOCKED;
+
+    /* If the flush at the end of the flight blocked, the message has already been queued */
+    if (!conn->handshake.flight_flush_pending) {
+        /* Populate handshake.io with header/payload for the current state, once.
+         * Check wiped instead of s2n_stuffer_data_available to differentiate between the initial call
+         * to s2n_handshake_write_io and a repeated call after the handler blocked.
+         */
+        if (s2n_stuffer_is_wiped(&conn->handshake.io)) {
+            if (record_type == TLS_HANDSHAKE) {
+                POSIX_GUARD(s2n_handshake_write_header(&conn->handshake.io, ACTIVE_STATE(conn).message_type));
+            }
+            POSIX_GUARD(ACTIVE_STATE(conn).handler[conn->mode] (conn));
+            if (record_type == TLS_HANDSHAKE) {
+                POSIX_GUARD(s2n_handshake_finish_header(&conn->handshake.io));
+            }
+        }
+
+        /* MD5 and SHA sum the handshake data too. The handler for the next message may need the
+         * transcript, so the message is hashed now rather than when its records are written.
+         */
+        const uint32_t message_size = s2n_stuffer_data_available(&conn->handshake.io);
         if (record_type == TLS_HANDSHAKE) {
-            POSIX_GUARD(s2n_conn_update_handshake_hashes(conn, &out));
+            struct s2n_blob message = {0};
+            POSIX_GUARD(s2n_blob_init(&message, conn->handshake.io.blob.data + conn->handshake.io.read_cursor, message_size));
+            POSIX_GUARD(s2n_conn_update_handshake_hashes(conn, &message));
         }
 
-        /* Actually send the record. We could block here. Assume the caller will call flush before coming back. */
-        POSIX_GUARD(s2n_flush(conn, &blocked));
-    }
+        /* Add the message to the flight, and only write records once no more messages can share them */
+        POSIX_GUARD(s2n_stuffer_copy(&conn->handshake.io, &conn->handshake.flight, message_size));
+        POSIX_GUARD(s2n_stuffer_wipe(&conn->handshake.io));
+        if (s2n_handshake_is_record_boundary(conn)) {
+            POSIX_GUARD(s2n_handshake_write_flight(conn, record_type));
+        }
 
-    /* We're done sending the last record, reset everything */
-    POSIX_GUARD(s2n_stuffer_wipe(&conn->out));
-    POSIX_GUARD(s2n_stuffer_wipe(&conn->handshake.io));
+        /* Update the secrets, if necessary */
+        POSIX_GUARD(s2n_tls13_handle_secrets(conn));
+
+        conn->handshake.flight_flush_pending = s2n_handshake_is_end_of_flight(conn);
+    }
 
-    /* Update the secrets, if necessary */
-    POSIX_GUARD(s2n_tls13_handle_secrets(conn));
+    /* Actually send the flight. We could block here. Assume the caller will call flush before coming back. */
+    if (conn->handshake.flight_flush_pending) {
+        POSIX_GUARD(s2n_flush(conn, &blocked));
+        conn->handshake.flight_flush_pending = 0;
+        conn->handshake.flight_queued = 0;
+    }
 
     /* Advance the state machine */
     POSIX_GUARD(s2n_advance_message(conn));
@@ -1032,7 +1099,7 @@ static int s2n_try_delete_session_cache(struct s2n_connection *conn)
     POSIX_ENSURE_REF(conn);
 
     if (s2n_allowed_to_cache_connection(conn) > 0) {
-        conn->config->cache_delete(conn, conn->config->cache_delete_data, conn->session_id, conn->session_id_len);
+        s2n_delete_from_cache(conn);
     }
 
     return 0;
@@ -1267,17 +1334,16 @@ static int s2n_handle_retry_state(struct s2n_connection *conn)
     return 0;
 }
 
-int s2n_negotiate(struct s2n_connection *conn, s2n_blocked_status *blocked)
+static int s2n_negotiate_impl(struct s2n_connection *conn, s2n_blocked_status *blocked)
 {
-    POSIX_ENSURE_REF(conn);
-    POSIX_ENSURE_REF(blocked);
-
     while (ACTIVE_STATE(conn).writer != 'B' && ACTIVE_MESSAGE(conn) != conn->handshake.end_of_messages) {
         errno = 0;
         s2n_errno = S2N_ERR_OK;
 
-        /* Flush any pending I/O or alert messages */
-        POSIX_GUARD(s2n_flush(conn, blocked));
+        /* Flush any pending I/O or alert messages, unless a flight is still being assembled */
+        if (!conn->handshake.flight_queued) {
+            POSIX_GUARD(s2n_flush(conn, blocked));
+        }
 
         /* If the handshake was paused, retry the current message */
         if (conn->handshake.paused) {
@@ -1336,6 +1402,11 @@ int s2n_negotiate(struct s2n_connection *conn, s2n_blocked_status *blocked)
         /* If the handshake has just ended, free up memory */
         if (ACTIVE_STATE(conn).writer == 'B') {
             POSIX_GUARD(s2n_stuffer_resize(&conn->handshake.io, 0));
+            POSIX_GUARD(s2n_stuffer_resize(&conn->handshake.flight, 0));
+            POSIX_GUARD_RESULT(s2n_arena_free(&conn->handshake_arena));
+
+            /* Hand the record layer to the kernel if requested */
+            POSIX_GUARD_RESULT(s2n_ktls_enable(conn));
 
             /* Send any pending post-handshake messages */
             POSIX_GUARD(s2n_post_handshake_send(conn, blocked));
@@ -1346,3 +1417,15 @@ int s2n_negotiate(struct s2n_connection *conn, s2n_blocked_status *blocked)
 
     return 0;
 }
+
+int s2n_negotiate(struct s2n_connection *conn, s2n_blocked_status *blocked)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_REF(blocked);
+
+    int result = s2n_negotiate_impl(conn, blocked);
+    /* Whether the handshake completed or is waiting on I/O, connections with
+     * dynamic buffers hold no record buffers between calls */
+    POSIX_GUARD_RESULT(s2n_connection_release_record_buffers(conn));
+    return result;
+}
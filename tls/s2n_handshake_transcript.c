@@ -35,10 +35,9 @@ static int s2n_tls13_conn_copy_hash(struct s2n_connection *conn, struct s2n_hash
     return 0;
 }
 
-int s2n_conn_update_handshake_hashes(struct s2n_connection *conn, struct s2n_blob *data)
+static int s2n_handshake_transcript_update(struct s2n_connection *conn, struct s2n_blob *data)
 {
-    POSIX_ENSURE_REF(conn);
-    POSIX_ENSURE_REF(data);
+    POSIX_ENSURE_REF(conn->handshake.hashes);
 
     if (s2n_handshake_is_hash_required(&conn->handshake, S2N_HASH_MD5)) {
         /* The handshake MD5 hash state will fail the s2n_hash_is_available() check
@@ -47,11 +46,11 @@ int s2n_conn_update_handshake_hashes(struct s2n_connection *conn, struct s2n_blo
          * PRF, which is required to comply with the TLS 1.0 and 1.1 RFCs and is approved
          * as per NIST Special Publication 800-52 Revision 1.
          */
-        POSIX_GUARD(s2n_hash_update(&conn->handshake.md5, data->data, data->size));
+        POSIX_GUARD(s2n_hash_update(&conn->handshake.hashes->md5, data->data, data->size));
     }
 
     if (s2n_handshake_is_hash_required(&conn->handshake, S2N_HASH_SHA1)) {
-        POSIX_GUARD(s2n_hash_update(&conn->handshake.sha1, data->data, data->size));
+        POSIX_GUARD(s2n_hash_update(&conn->handshake.hashes->sha1, data->data, data->size));
     }
 
     const uint8_t md5_sha1_required = (s2n_handshake_is_hash_required(&conn->handshake, S2N_HASH_MD5) &&
@@ -63,31 +62,115 @@ int s2n_conn_update_handshake_hashes(struct s2n_connection *conn, struct s2n_blo
          * CertificateVerify message and the PRF. NIST SP 800-52r1 approves use
          * of MD5_SHA1 for these use cases (see footnotes 15 and 20, and section
          * 3.3.2) */
-        POSIX_GUARD(s2n_hash_update(&conn->handshake.md5_sha1, data->data, data->size));
+        POSIX_GUARD(s2n_hash_update(&conn->handshake.hashes->md5_sha1, data->data, data->size));
     }
 
     if (s2n_handshake_is_hash_required(&conn->handshake, S2N_HASH_SHA224)) {
-        POSIX_GUARD(s2n_hash_update(&conn->handshake.sha224, data->data, data->size));
+        POSIX_GUARD(s2n_hash_update(&conn->handshake.hashes->sha224, data->data, data->size));
     }
 
     if (s2n_handshake_is_hash_required(&conn->handshake, S2N_HASH_SHA256)) {
-        POSIX_GUARD(s2n_hash_update(&conn->handshake.sha256, data->data, data->size));
+        POSIX_GUARD(s2n_hash_update(&conn->handshake.hashes->sha256, data->data, data->size));
     }
 
     if (s2n_handshake_is_hash_required(&conn->handshake, S2N_HASH_SHA384)) {
-        POSIX_GUARD(s2n_hash_update(&conn->handshake.sha384, data->data, data->size));
+        POSIX_GUARD(s2n_hash_update(&conn->handshake.hashes->sha384, data->data, data->size));
     }
 
     if (s2n_handshake_is_hash_required(&conn->handshake, S2N_HASH_SHA512)) {
-        POSIX_GUARD(s2n_hash_update(&conn->handshake.sha512, data->data, data->size));
+        POSIX_GUARD(s2n_hash_update(&conn->handshake.hashes->sha512, data->data, data->size));
+    }
+
+    return 0;
+}
+
+static int s2n_handshake_transcript_init_hash(struct s2n_hash_state *state, s2n_hash_algorithm alg)
+{
+    /* A state that already uses alg is either new or was reset by s2n_connection_wipe */
+    if (state->alg != alg) {
+        POSIX_GUARD(s2n_hash_init(state, alg));
+    }
+    return 0;
+}
+
+/* Initializes the transcript hashes that the handshake still needs. Hashes that are never required
+ * are never initialized or updated. */
+static int s2n_handshake_transcript_init_required_hashes(struct s2n_connection *conn)
+{
+    struct s2n_handshake *handshake = &conn->handshake;
+    POSIX_ENSURE_REF(handshake->hashes);
+
+    if (s2n_handshake_is_hash_required(handshake, S2N_HASH_MD5)) {
+        POSIX_GUARD(s2n_handshake_transcript_init_hash(&handshake->hashes->md5, S2N_HASH_MD5));
+    }
+    if (s2n_handshake_is_hash_required(handshake, S2N_HASH_SHA1)) {
+        POSIX_GUARD(s2n_handshake_transcript_init_hash(&handshake->hashes->sha1, S2N_HASH_SHA1));
+    }
+    if (s2n_handshake_is_hash_required(handshake, S2N_HASH_MD5)
+            && s2n_handshake_is_hash_required(handshake, S2N_HASH_SHA1)) {
+        POSIX_GUARD(s2n_handshake_transcript_init_hash(&handshake->hashes->md5_sha1, S2N_HASH_MD5_SHA1));
+    }
+    if (s2n_handshake_is_hash_required(handshake, S2N_HASH_SHA224)) {
+        POSIX_GUARD(s2n_handshake_transcript_init_hash(&handshake->hashes->sha224, S2N_HASH_SHA224));
+    }
+    if (s2n_handshake_is_hash_required(handshake, S2N_HASH_SHA256)) {
+        POSIX_GUARD(s2n_handshake_transcript_init_hash(&handshake->hashes->sha256, S2N_HASH_SHA256));
+    }
+    if (s2n_handshake_is_hash_required(handshake, S2N_HASH_SHA384)) {
+        POSIX_GUARD(s2n_handshake_transcript_init_hash(&handshake->hashes->sha384, S2N_HASH_SHA384));
+    }
+    if (s2n_handshake_is_hash_required(handshake, S2N_HASH_SHA512)) {
+        POSIX_GUARD(s2n_handshake_transcript_init_hash(&handshake->hashes->sha512, S2N_HASH_SHA512));
+    }
+
+    return 0;
+}
+
+/* Ends transcript buffering: initializes the currently required hashes and catches them up
+ * with the buffered messages. Must be called before any transcript hash state is read. */
+S2N_RESULT s2n_handshake_transcript_flush(struct s2n_connection *conn)
+{
+    RESULT_ENSURE_REF(conn);
+
+    if (!conn->handshake.transcript_buffering) {
+        return S2N_RESULT_OK;
+    }
+    conn->handshake.transcript_buffering = 0;
+
+    RESULT_GUARD_POSIX(s2n_handshake_transcript_init_required_hashes(conn));
+
+    struct s2n_stuffer *buffer = &conn->handshake.transcript_buffer;
+    const uint32_t size = s2n_stuffer_data_available(buffer);
+    if (size > 0) {
+        struct s2n_blob buffered = { 0 };
+        RESULT_GUARD_POSIX(s2n_blob_init(&buffered, buffer->blob.data + buffer->read_cursor, size));
+        RESULT_GUARD_POSIX(s2n_handshake_transcript_update(conn, &buffered));
+    }
+
+    /* The buffer is only needed at the start of the handshake */
+    RESULT_GUARD_POSIX(s2n_stuffer_resize(buffer, 0));
+
+    return S2N_RESULT_OK;
+}
+
+int s2n_conn_update_handshake_hashes(struct s2n_connection *conn, struct s2n_blob *data)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_REF(data);
+    POSIX_ENSURE_REF(conn->handshake.hashes);
+
+    if (conn->handshake.transcript_buffering) {
+        POSIX_GUARD(s2n_stuffer_write(&conn->handshake.transcript_buffer, data));
+    } else {
+        POSIX_GUARD(s2n_handshake_transcript_update(conn, data));
     }
 
     /* Copy hashes that TLS1.3 will need later. */
     if (s2n_connection_get_protocol_version(conn) >= S2N_TLS13) {
         if (s2n_conn_get_current_message_type(conn) == SERVER_HELLO) {
-            POSIX_GUARD(s2n_tls13_conn_copy_hash(conn, &conn->handshake.server_hello_copy));
+            POSIX_GUARD(s2n_tls13_conn_copy_hash(conn, &conn->handshake.hashes->server_hello_copy));
         } else if (s2n_conn_get_current_message_type(conn) == SERVER_FINISHED) {
-            POSIX_GUARD(s2n_tls13_conn_copy_hash(conn, &conn->handshake.server_finished_copy));
+            POSIX_GUARD(s2n_tls13_conn_copy_hash(conn, &conn->handshake.hashes->server_finished_copy));
         }
     }
 
@@ -0,0 +1,331 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "tls/s2n_key_share_pool.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include "tls/s2n_config.h"
+#include "utils/s2n_blob.h"
+#include "utils/s2n_mem.h"
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+
+#define S2N_KEY_SHARE_POOL_MIN_BACKOFF_MS 10
+#define S2N_KEY_SHARE_POOL_MAX_BACKOFF_MS 1000
+
+/* Every pool's lock is held while the process forks, so that a child never inherits a lock
+ * held by one of the parent's workers. */
+static pthread_mutex_t s2n_key_share_pools_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct s2n_key_share_pool *s2n_key_share_pools = NULL;
+static pthread_once_t s2n_key_share_pool_atfork_once = PTHREAD_ONCE_INIT;
+static int s2n_key_share_pool_atfork_result = 0;
+
+static void s2n_key_share_pool_prepare_fork(void)
+{
+    pthread_mutex_lock(&s2n_key_share_pools_lock);
+    for (struct s2n_key_share_pool *pool = s2n_key_share_pools; pool; pool = pool->next) {
+        pthread_mutex_lock(&pool->lock);
+    }
+}
+
+static void s2n_key_share_pool_parent_fork(void)
+{
+    for (struct s2n_key_share_pool *pool = s2n_key_share_pools; pool; pool = pool->next) {
+        pthread_mutex_unlock(&pool->lock);
+    }
+    pthread_mutex_unlock(&s2n_key_share_pools_lock);
+}
+
+static void s2n_key_share_pool_child_fork(void)
+{
+    for (struct s2n_key_share_pool *pool = s2n_key_share_pools; pool; pool = pool->next) {
+        /* The parent's workers may have been waiting on the condition, but they don't exist in the child */
+        pthread_cond_init(&pool->refill, NULL);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    pthread_mutex_unlock(&s2n_key_share_pools_lock);
+}
+
+static void s2n_key_share_pool_register_atfork(void)
+{
+    s2n_key_share_pool_atfork_result = pthread_atfork(s2n_key_share_pool_prepare_fork,
+            s2n_key_share_pool_parent_fork, s2n_key_share_pool_child_fork);
+}
+
+/* Returns the ring furthest from full, or NULL if every ring is full or being filled */
+static struct s2n_key_share_pool_ring *s2n_key_share_pool_emptiest_ring(struct s2n_key_share_pool *pool)
+{
+    struct s2n_key_share_pool_ring *emptiest = NULL;
+    for (uint32_t i = 0; i < pool->ring_count; i++) {
+        struct s2n_key_share_pool_ring *ring = &pool->rings[i];
+        if (ring->count + ring->pending >= pool->capacity) {
+            continue;
+        }
+        if (emptiest == NULL || ring->count + ring->pending < emptiest->count + emptiest->pending) {
+            emptiest = ring;
+        }
+    }
+    return emptiest;
+}
+
+/* Waits on the refill condition for up to `ms` milliseconds. Must be called with the lock held. */
+static void s2n_key_share_pool_backoff(struct s2n_key_share_pool *pool, uint32_t ms)
+{
+    struct timespec deadline = { 0 };
+    if (clock_gettime(CLOCK_REALTIME, &deadline) != 0) {
+        return;
+    }
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (long) (ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(&pool->refill, &pool->lock, &deadline);
+}
+
+static void *s2n_key_share_pool_worker(void *arg)
+{
+    struct s2n_key_share_pool *pool = (struct s2n_key_share_pool *) arg;
+    uint32_t backoff_ms = S2N_KEY_SHARE_POOL_MIN_BACKOFF_MS;
+
+    if (pthread_mutex_lock(&pool->lock) != 0) {
+        return NULL;
+    }
+
+    while (!pool->shutdown) {
+        struct s2n_key_share_pool_ring *ring = s2n_key_share_pool_emptiest_ring(pool);
+        if (ring == NULL) {
+            pthread_cond_wait(&pool->refill, &pool->lock);
+            continue;
+        }
+
+        /* Generate the key without holding the lock: it is the expensive part */
+        ring->pending++;
+        pthread_mutex_unlock(&pool->lock);
+
+        EVP_PKEY *key = NULL;
+        const bool generated = ring->curve->generate_key(ring->curve, &key) == S2N_SUCCESS && key != NULL;
+
+        pthread_mutex_lock(&pool->lock);
+        ring->pending--;
+        if (!generated) {
+            /* Handshakes fall back to generating their own keys until the failure clears.
+             * Retry with an increasing delay rather than spinning or giving up. */
+            EVP_PKEY_free(key);
+            s2n_key_share_pool_backoff(pool, backoff_ms);
+            backoff_ms = backoff_ms * 2;
+            if (backoff_ms > S2N_KEY_SHARE_POOL_MAX_BACKOFF_MS) {
+                backoff_ms = S2N_KEY_SHARE_POOL_MAX_BACKOFF_MS;
+            }
+            continue;
+        }
+        backoff_ms = S2N_KEY_SHARE_POOL_MIN_BACKOFF_MS;
+        ring->keys[(ring->head + ring->count) % pool->capacity] = key;
+        ring->count++;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    /* Release this thread's DRBGs */
+    s2n_result_ignore(s2n_rand_cleanup_thread());
+    return NULL;
+}
+
+/* Must be called with the lock held */
+static void s2n_key_share_pool_start_workers(struct s2n_key_share_pool *pool)
+{
+    pool->pid = getpid();
+    while (pool->worker_count < pool->requested_worker_count) {
+        if (pthread_create(&pool->workers[pool->worker_count], NULL, s2n_key_share_pool_worker, pool) != 0) {
+            /* Handshakes fall back to generating their own keys */
+            break;
+        }
+        pool->worker_count++;
+    }
+}
+
+/* The keys in a forked child are copies of the keys in the parent and in every sibling, so none
+ * of them can be used. The parent's workers were not copied into the child either.
+ * Must be called with the lock held. */
+static void s2n_key_share_pool_reset_after_fork(struct s2n_key_share_pool *pool)
+{
+    for (uint32_t i = 0; i < pool->ring_count; i++) {
+        struct s2n_key_share_pool_ring *ring = &pool->rings[i];
+        for (uint32_t j = 0; j < ring->count; j++) {
+            uint32_t index = (ring->head + j) % pool->capacity;
+            EVP_PKEY_free(ring->keys[index]);
+            ring->keys[index] = NULL;
+        }
+        ring->head = 0;
+        ring->count = 0;
+        ring->pending = 0;
+    }
+    pool->worker_count = 0;
+    s2n_key_share_pool_start_workers(pool);
+}
+
+static S2N_RESULT s2n_key_share_pool_take(struct s2n_key_share_pool *pool, const struct s2n_ecc_named_curve *curve, EVP_PKEY **key)
+{
+    *key = NULL;
+
+    RESULT_ENSURE(pthread_mutex_lock(&pool->lock) == 0, S2N_ERR_LOCK);
+    if (pool->pid != getpid()) {
+        s2n_key_share_pool_reset_after_fork(pool);
+    }
+    for (uint32_t i = 0; i < pool->ring_count; i++) {
+        struct s2n_key_share_pool_ring *ring = &pool->rings[i];
+        if (ring->curve != curve || ring->count == 0) {
+            continue;
+        }
+
+        /* Each key leaves the ring exactly once */
+        *key = ring->keys[ring->head];
+        ring->keys[ring->head] = NULL;
+        ring->head = (ring->head + 1) % pool->capacity;
+        ring->count--;
+        pthread_cond_signal(&pool->refill);
+        break;
+    }
+    RESULT_ENSURE(pthread_mutex_unlock(&pool->lock) == 0, S2N_ERR_LOCK);
+
+    return S2N_RESULT_OK;
+}
+
+static S2N_RESULT s2n_key_share_pool_init(struct s2n_key_share_pool *pool, uint32_t keys_per_curve, uint8_t worker_count)
+{
+    pool->capacity = keys_per_curve;
+    RESULT_ENSURE_LTE(s2n_all_supported_curves_list_len, s2n_array_len(pool->rings));
+
+    for (size_t i = 0; i < s2n_all_supported_curves_list_len; i++) {
+        struct s2n_key_share_pool_ring *ring = &pool->rings[i];
+        ring->curve = s2n_all_supported_curves_list[i];
+
+        struct s2n_blob mem = { 0 };
+        RESULT_GUARD_POSIX(s2n_alloc(&mem, keys_per_curve * sizeof(EVP_PKEY *)));
+        RESULT_GUARD_POSIX(s2n_blob_zero(&mem));
+        ring->keys = (EVP_PKEY **)(void *) mem.data;
+        pool->ring_count++;
+    }
+
+    pool->requested_worker_count = worker_count;
+    RESULT_ENSURE(pthread_mutex_lock(&pool->lock) == 0, S2N_ERR_LOCK);
+    s2n_key_share_pool_start_workers(pool);
+    RESULT_ENSURE(pthread_mutex_unlock(&pool->lock) == 0, S2N_ERR_LOCK);
+    RESULT_ENSURE(pool->worker_count == worker_count, S2N_ERR_THREAD);
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_key_share_pool_new(struct s2n_key_share_pool **pool, uint32_t keys_per_curve, uint8_t worker_count)
+{
+    RESULT_ENSURE_REF(pool);
+    RESULT_ENSURE(keys_per_curve > 0, S2N_ERR_INVALID_ARGUMENT);
+    RESULT_ENSURE(worker_count > 0, S2N_ERR_INVALID_ARGUMENT);
+
+    RESULT_ENSURE(pthread_once(&s2n_key_share_pool_atfork_once, s2n_key_share_pool_register_atfork) == 0, S2N_ERR_THREAD);
+    RESULT_ENSURE(s2n_key_share_pool_atfork_result == 0, S2N_ERR_THREAD);
+
+    struct s2n_blob mem = { 0 };
+    RESULT_GUARD_POSIX(s2n_alloc(&mem, sizeof(struct s2n_key_share_pool)));
+    RESULT_GUARD_POSIX(s2n_blob_zero(&mem));
+    struct s2n_key_share_pool *new_pool = (struct s2n_key_share_pool *)(void *) mem.data;
+
+    if (pthread_mutex_init(&new_pool->lock, NULL) != 0) {
+        RESULT_GUARD_POSIX(s2n_free(&mem));
+        RESULT_BAIL(S2N_ERR_LOCK);
+    }
+    if (pthread_cond_init(&new_pool->refill, NULL) != 0) {
+        pthread_mutex_destroy(&new_pool->lock);
+        RESULT_GUARD_POSIX(s2n_free(&mem));
+        RESULT_BAIL(S2N_ERR_LOCK);
+    }
+
+    RESULT_ENSURE(pthread_mutex_lock(&s2n_key_share_pools_lock) == 0, S2N_ERR_LOCK);
+    new_pool->next = s2n_key_share_pools;
+    s2n_key_share_pools = new_pool;
+    RESULT_ENSURE(pthread_mutex_unlock(&s2n_key_share_pools_lock) == 0, S2N_ERR_LOCK);
+
+    if (s2n_result_is_error(s2n_key_share_pool_init(new_pool, keys_per_curve, worker_count))) {
+        s2n_result_ignore(s2n_key_share_pool_free(&new_pool));
+        return S2N_RESULT_ERROR;
+    }
+
+    *pool = new_pool;
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_key_share_pool_free(struct s2n_key_share_pool **pool)
+{
+    RESULT_ENSURE_REF(pool);
+    struct s2n_key_share_pool *to_free = *pool;
+    if (to_free == NULL) {
+        return S2N_RESULT_OK;
+    }
+
+    RESULT_ENSURE(pthread_mutex_lock(&s2n_key_share_pools_lock) == 0, S2N_ERR_LOCK);
+    for (struct s2n_key_share_pool **entry = &s2n_key_share_pools; *entry; entry = &(*entry)->next) {
+        if (*entry == to_free) {
+            *entry = to_free->next;
+            break;
+        }
+    }
+    RESULT_ENSURE(pthread_mutex_unlock(&s2n_key_share_pools_lock) == 0, S2N_ERR_LOCK);
+
+    /* Stop the workers before freeing anything they use */
+    RESULT_ENSURE(pthread_mutex_lock(&to_free->lock) == 0, S2N_ERR_LOCK);
+    to_free->shutdown = true;
+    pthread_cond_broadcast(&to_free->refill);
+    /* A forked child that never used the pool has no workers of its own to join */
+    const uint8_t worker_count = (to_free->pid == getpid()) ? to_free->worker_count : 0;
+    RESULT_ENSURE(pthread_mutex_unlock(&to_free->lock) == 0, S2N_ERR_LOCK);
+
+    for (uint8_t i = 0; i < worker_count; i++) {
+        RESULT_ENSURE(pthread_join(to_free->workers[i], NULL) == 0, S2N_ERR_THREAD);
+    }
+
+    for (uint32_t i = 0; i < to_free->ring_count; i++) {
+        struct s2n_key_share_pool_ring *ring = &to_free->rings[i];
+        for (uint32_t j = 0; j < ring->count; j++) {
+            EVP_PKEY_free(ring->keys[(ring->head + j) % to_free->capacity]);
+        }
+        RESULT_GUARD_POSIX(s2n_free_object((uint8_t **) &ring->keys, to_free->capacity * sizeof(EVP_PKEY *)));
+    }
+
+    RESULT_ENSURE(pthread_cond_destroy(&to_free->refill) == 0, S2N_ERR_LOCK);
+    RESULT_ENSURE(pthread_mutex_destroy(&to_free->lock) == 0, S2N_ERR_LOCK);
+    RESULT_GUARD_POSIX(s2n_free_object((uint8_t **) pool, sizeof(struct s2n_key_share_pool)));
+    return S2N_RESULT_OK;
+}
+
+int s2n_key_share_pool_generate_key(struct s2n_config *config, struct s2n_ecc_evp_params *ecc_evp_params)
+{
+    POSIX_ENSURE_REF(config);
+    POSIX_ENSURE_REF(ecc_evp_params);
+
+    if (config->key_share_pool && ecc_evp_params->evp_pkey == NULL) {
+        POSIX_GUARD_RESULT(s2n_key_share_pool_take(config->key_share_pool, ecc_evp_params->negotiated_curve,
+                &ecc_evp_params->evp_pkey));
+        if (ecc_evp_params->evp_pkey) {
+            return S2N_SUCCESS;
+        }
+    }
+
+    /* The pool is disabled or has run dry */
+    POSIX_GUARD(s2n_ecc_evp_generate_ephemeral_key(ecc_evp_params));
+    return S2N_SUCCESS;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "crypto/s2n_ecc_evp.h"
+
+struct s2n_config;
+
+/* Keys generated ahead of time for one curve. Keys are taken from the head of the ring. */
+struct s2n_key_share_pool_ring {
+    const struct s2n_ecc_named_curve *curve;
+    EVP_PKEY **keys;
+    uint32_t head;
+    uint32_t count;
+    /* Keys being generated by a worker for this ring */
+    uint32_t pending;
+};
+
+/* Background threads keep a ring of single-use ephemeral keys filled for every supported curve,
+ * so that handshakes do not pay for the key generation. */
+struct s2n_key_share_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t refill;
+    bool shutdown;
+
+    uint32_t capacity;
+    struct s2n_key_share_pool_ring rings[S2N_ECC_EVP_SUPPORTED_CURVES_COUNT];
+    uint32_t ring_count;
+
+    pthread_t workers[UINT8_MAX];
+    uint8_t worker_count;
+    uint8_t requested_worker_count;
+
+    /* The process that owns the keys and workers. A forked child inherits the keys but not the
+     * workers, so it drops the keys and starts its own workers. */
+    pid_t pid;
+    /* All pools are listed so that their locks can be held across fork() */
+    struct s2n_key_share_pool *next;
+};
+
+S2N_RESULT s2n_key_share_pool_new(struct s2n_key_share_pool **pool, uint32_t keys_per_curve, uint8_t worker_count);
+S2N_RESULT s2n_key_share_pool_free(struct s2n_key_share_pool **pool);
+
+/* Like s2n_ecc_evp_generate_ephemeral_key, but takes a pregenerated key from the config's pool if one is ready. */
+int s2n_key_share_pool_generate_key(struct s2n_config *config, struct s2n_ecc_evp_params *ecc_evp_params);
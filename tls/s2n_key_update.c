@@ -17,6 +17,7 @@
 
 #include "tls/s2n_connection.h"
 #include "tls/s2n_key_update.h"
+#include "tls/s2n_ktls.h"
 #include "tls/s2n_tls13_handshake.h"
 #include "tls/s2n_record.h"
 #include "tls/s2n_tls.h"
@@ -41,10 +42,10 @@ int s2n_key_update_recv(struct s2n_connection *conn, struct s2n_stuffer *request
     conn->key_update_pending = key_update_request;
 
     /* Update peer's key since a key_update was received */
-    if (conn->mode == S2N_CLIENT){
-        POSIX_GUARD(s2n_update_application_traffic_keys(conn, S2N_SERVER, RECEIVING));
-    } else {
-        POSIX_GUARD(s2n_update_application_traffic_keys(conn, S2N_CLIENT, RECEIVING));
+    const s2n_mode peer = (conn->mode == S2N_CLIENT) ? S2N_SERVER : S2N_CLIENT;
+    POSIX_GUARD(s2n_update_application_traffic_keys(conn, peer, RECEIVING));
+    if (conn->ktls_recv_enabled) {
+        POSIX_GUARD_RESULT(s2n_ktls_update_keys(conn, peer));
     }
 
     return S2N_SUCCESS;
@@ -78,6 +79,9 @@ int s2n_key_update_send(struct s2n_connection *conn, s2n_blocked_status *blocked
         POSIX_GUARD(s2n_update_application_traffic_keys(conn, conn->mode, SENDING));
         conn->key_update_pending = false;
 
+        /* With kTLS, the kernel switches keys once the message has been flushed */
+        conn->ktls_send_key_update_pending = conn->ktls_send_enabled;
+
         POSIX_GUARD(s2n_flush(conn, blocked));
     }
 
@@ -0,0 +1,571 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <errno.h>
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <sys/utsname.h>
+
+#if defined(S2N_KTLS_SUPPORTED)
+#include <linux/tls.h>
+#include <sys/sendfile.h>
+#endif
+
+#include "error/s2n_errno.h"
+
+#include "crypto/s2n_cipher.h"
+#include "crypto/s2n_tls13_keys.h"
+
+#include "tls/s2n_cipher_suites.h"
+#include "tls/s2n_connection.h"
+#include "tls/s2n_ktls.h"
+#include "tls/s2n_prf.h"
+#include "tls/s2n_record.h"
+#include "tls/s2n_tls.h"
+#include "tls/s2n_tls13_handshake.h"
+
+#include "utils/s2n_blob.h"
+#include "utils/s2n_safety.h"
+#include "utils/s2n_socket.h"
+
+/* Linux 6.14 is the first kernel to accept new TLS_TX / TLS_RX keys on an offloaded socket */
+#define S2N_KTLS_REKEY_KERNEL_MAJOR 6
+#define S2N_KTLS_REKEY_KERNEL_MINOR 14
+
+static s2n_ktls_rekey_support s2n_ktls_rekey_support_override = S2N_KTLS_REKEY_DETECT;
+
+S2N_RESULT s2n_ktls_set_rekey_support_for_testing(s2n_ktls_rekey_support support)
+{
+    RESULT_ENSURE(s2n_in_unit_test(), S2N_ERR_NOT_IN_UNIT_TEST);
+    s2n_ktls_rekey_support_override = support;
+    return S2N_RESULT_OK;
+}
+
+bool s2n_ktls_is_rekey_supported(void)
+{
+    if (s2n_ktls_rekey_support_override != S2N_KTLS_REKEY_DETECT) {
+        return s2n_ktls_rekey_support_override == S2N_KTLS_REKEY_SUPPORTED;
+    }
+
+    struct utsname name = { 0 };
+    int major = 0, minor = 0;
+    if (uname(&name) != 0 || sscanf(name.release, "%d.%d", &major, &minor) != 2) {
+        return false;
+    }
+    return major > S2N_KTLS_REKEY_KERNEL_MAJOR
+        || (major == S2N_KTLS_REKEY_KERNEL_MAJOR && minor >= S2N_KTLS_REKEY_KERNEL_MINOR);
+}
+
+int s2n_connection_is_ktls_enabled(struct s2n_connection *conn, s2n_ktls_mode mode)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE(mode != S2N_KTLS_MODE_DISABLED && (mode & ~S2N_KTLS_MODE_DUPLEX) == 0, S2N_ERR_INVALID_ARGUMENT);
+
+    if ((mode & S2N_KTLS_MODE_SEND) && !conn->ktls_send_enabled) {
+        return 0;
+    }
+    if ((mode & S2N_KTLS_MODE_RECV) && !conn->ktls_recv_enabled) {
+        return 0;
+    }
+    return 1;
+}
+
+#if defined(S2N_KTLS_SUPPORTED)
+
+/* Not every libc exposes these yet */
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+/* Upper bound on the number of iovecs passed to a single sendmsg call */
+#define S2N_KTLS_MAX_IOVECS 16
+
+struct s2n_ktls_crypto_info {
+    union {
+        struct tls_crypto_info info;
+        struct tls12_crypto_info_aes_gcm_128 aes_gcm_128;
+        struct tls12_crypto_info_aes_gcm_256 aes_gcm_256;
+        struct tls12_crypto_info_chacha20_poly1305 chacha20_poly1305;
+    } ciphers;
+    socklen_t size;
+
+    /* Scratch space for deriving the traffic key */
+    uint8_t key_block[S2N_MAX_KEY_BLOCK_LEN];
+    uint8_t key[S2N_TLS_AES_256_GCM_KEY_LEN];
+    uint8_t iv[S2N_TLS13_FIXED_IV_LEN];
+};
+
+static int s2n_ktls_send_fd(struct s2n_connection *conn)
+{
+    return ((struct s2n_socket_write_io_context *) conn->send_io_context)->fd;
+}
+
+static int s2n_ktls_recv_fd(struct s2n_connection *conn)
+{
+    return ((struct s2n_socket_read_io_context *) conn->recv_io_context)->fd;
+}
+
+static bool s2n_ktls_is_supported_cipher(const struct s2n_cipher *cipher)
+{
+    return cipher == &s2n_aes128_gcm || cipher == &s2n_tls13_aes128_gcm
+        || cipher == &s2n_aes256_gcm || cipher == &s2n_tls13_aes256_gcm
+        || cipher == &s2n_chacha20_poly1305;
+}
+
+/* The kernel only receives the traffic keys, so they have to be derived again from the secrets
+ * s2n keeps for the connection: the key block for TLS1.2, the application traffic secrets for TLS1.3.
+ */
+static S2N_RESULT s2n_ktls_derive_key(struct s2n_connection *conn, s2n_mode sender, struct s2n_ktls_crypto_info *crypto_info, struct s2n_blob *key)
+{
+    const struct s2n_cipher *cipher = conn->secure.cipher_suite->record_alg->cipher;
+    RESULT_GUARD_POSIX(s2n_blob_init(key, crypto_info->key, cipher->key_material_size));
+
+    if (conn->actual_protocol_version >= S2N_TLS13) {
+        DEFER_CLEANUP(struct s2n_tls13_keys keys = { 0 }, s2n_tls13_keys_free);
+        RESULT_GUARD_POSIX(s2n_tls13_keys_from_conn(&keys, conn));
+
+        uint8_t *secret_data = (sender == S2N_CLIENT) ? conn->secure.client_app_secret : conn->secure.server_app_secret;
+        struct s2n_blob secret = { 0 }, iv = { 0 };
+        RESULT_GUARD_POSIX(s2n_blob_init(&secret, secret_data, keys.size));
+        RESULT_GUARD_POSIX(s2n_blob_init(&iv, crypto_info->iv, sizeof(crypto_info->iv)));
+        RESULT_GUARD_POSIX(s2n_tls13_derive_traffic_keys(&keys, &secret, key, &iv));
+        return S2N_RESULT_OK;
+    }
+
+    /* TLS1.2 key block: client MAC key, server MAC key, client key, server key, ... */
+    uint8_t mac_size = 0;
+    RESULT_GUARD_POSIX(s2n_hmac_digest_size(conn->secure.cipher_suite->record_alg->hmac_alg, &mac_size));
+    uint32_t key_offset = mac_size * 2;
+    if (sender == S2N_SERVER) {
+        key_offset += key->size;
+    }
+
+    struct s2n_blob key_block = { 0 };
+    RESULT_GUARD_POSIX(s2n_blob_init(&key_block, crypto_info->key_block, sizeof(crypto_info->key_block)));
+    RESULT_GUARD_POSIX(s2n_prf_generate_key_block(conn, &key_block));
+    RESULT_ENSURE_LTE(key_offset + key->size, key_block.size);
+    RESULT_CHECKED_MEMCPY(key->data, key_block.data + key_offset, key->size);
+
+    return S2N_RESULT_OK;
+}
+
+static S2N_RESULT s2n_ktls_init_crypto_info(struct s2n_connection *conn, s2n_mode sender, struct s2n_ktls_crypto_info *crypto_info)
+{
+    RESULT_ENSURE_REF(conn->secure.cipher_suite);
+    const struct s2n_cipher *cipher = conn->secure.cipher_suite->record_alg->cipher;
+    RESULT_ENSURE(s2n_ktls_is_supported_cipher(cipher), S2N_ERR_KTLS_UNSUPPORTED);
+
+    struct s2n_blob key = { 0 };
+    RESULT_GUARD(s2n_ktls_derive_key(conn, sender, crypto_info, &key));
+
+    const bool is_tls13 = conn->actual_protocol_version >= S2N_TLS13;
+    const uint8_t *implicit_iv = (sender == S2N_CLIENT) ? conn->secure.client_implicit_iv : conn->secure.server_implicit_iv;
+    const uint8_t *sequence_number = (sender == S2N_CLIENT) ? conn->secure.client_sequence_number : conn->secure.server_sequence_number;
+
+    crypto_info->ciphers.info.version = is_tls13 ? TLS_1_3_VERSION : TLS_1_2_VERSION;
+
+    if (cipher == &s2n_chacha20_poly1305) {
+        /* RFC7905: the whole nonce is implicit */
+        struct tls12_crypto_info_chacha20_poly1305 *info = &crypto_info->ciphers.chacha20_poly1305;
+        info->info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+        RESULT_CHECKED_MEMCPY(info->iv, implicit_iv, sizeof(info->iv));
+        RESULT_CHECKED_MEMCPY(info->key, key.data, sizeof(info->key));
+        RESULT_CHECKED_MEMCPY(info->rec_seq, sequence_number, sizeof(info->rec_seq));
+        crypto_info->size = sizeof(*info);
+        return S2N_RESULT_OK;
+    }
+
+    /* AES-GCM: the kernel splits the nonce into a 4 byte salt and an 8 byte IV. In TLS1.2 the IV is the
+     * explicit nonce, which s2n sets to the sequence number; in TLS1.3 both come from the implicit IV.
+     */
+    uint8_t *salt = NULL, *iv = NULL, *info_key = NULL, *rec_seq = NULL;
+    if (key.size == S2N_TLS_AES_256_GCM_KEY_LEN) {
+        struct tls12_crypto_info_aes_gcm_256 *info = &crypto_info->ciphers.aes_gcm_256;
+        info->info.cipher_type = TLS_CIPHER_AES_GCM_256;
+        salt = info->salt, iv = info->iv, info_key = info->key, rec_seq = info->rec_seq;
+        crypto_info->size = sizeof(*info);
+    } else {
+        struct tls12_crypto_info_aes_gcm_128 *info = &crypto_info->ciphers.aes_gcm_128;
+        info->info.cipher_type = TLS_CIPHER_AES_GCM_128;
+        salt = info->salt, iv = info->iv, info_key = info->key, rec_seq = info->rec_seq;
+        crypto_info->size = sizeof(*info);
+    }
+
+    RESULT_CHECKED_MEMCPY(salt, implicit_iv, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+    if (is_tls13) {
+        RESULT_CHECKED_MEMCPY(iv, implicit_iv + TLS_CIPHER_AES_GCM_128_SALT_SIZE, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+    } else {
+        RESULT_CHECKED_MEMCPY(iv, sequence_number, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+    }
+    RESULT_CHECKED_MEMCPY(info_key, key.data, key.size);
+    RESULT_CHECKED_MEMCPY(rec_seq, sequence_number, S2N_TLS_SEQUENCE_NUM_LEN);
+
+    return S2N_RESULT_OK;
+}
+
+static S2N_RESULT s2n_ktls_set_keys_impl(struct s2n_connection *conn, int fd, s2n_mode sender, int direction,
+        struct s2n_ktls_crypto_info *crypto_info)
+{
+    RESULT_GUARD(s2n_ktls_init_crypto_info(conn, sender, crypto_info));
+    RESULT_ENSURE(setsockopt(fd, SOL_TLS, direction, &crypto_info->ciphers, crypto_info->size) == 0, S2N_ERR_KTLS_SET_KEYS);
+    return S2N_RESULT_OK;
+}
+
+static S2N_RESULT s2n_ktls_set_keys(struct s2n_connection *conn, int fd, s2n_mode sender, int direction)
+{
+    struct s2n_ktls_crypto_info crypto_info = { 0 };
+    s2n_result result = s2n_ktls_set_keys_impl(conn, fd, sender, direction, &crypto_info);
+
+    /* Don't leave copies of the traffic key on the stack */
+    struct s2n_blob crypto_info_blob = { 0 };
+    RESULT_GUARD_POSIX(s2n_blob_init(&crypto_info_blob, (uint8_t *) &crypto_info, sizeof(crypto_info)));
+    RESULT_GUARD_POSIX(s2n_blob_zero(&crypto_info_blob));
+
+    return result;
+}
+
+static S2N_RESULT s2n_ktls_set_ulp(int fd)
+{
+    /* Installing the ULP a second time, e.g. for the other direction, is not an error */
+    const char ulp_name[] = "tls";
+    RESULT_ENSURE(setsockopt(fd, IPPROTO_TCP, TCP_ULP, ulp_name, sizeof(ulp_name)) == 0 || errno == EEXIST,
+            S2N_ERR_KTLS_UNSUPPORTED);
+    return S2N_RESULT_OK;
+}
+
+static bool s2n_ktls_is_supported_conn(struct s2n_connection *conn)
+{
+    /* A TLS1.3 peer may send a KeyUpdate at any time. If the kernel can't take the new keys,
+     * the connection could not continue, so keep the records in userspace from the start. */
+    if (conn->actual_protocol_version >= S2N_TLS13 && !s2n_ktls_is_rekey_supported()) {
+        return false;
+    }
+
+    return conn->actual_protocol_version >= S2N_TLS12
+        && !conn->config->quic_enabled
+        && conn->secure.cipher_suite
+        && s2n_ktls_is_supported_cipher(conn->secure.cipher_suite->record_alg->cipher);
+}
+
+S2N_RESULT s2n_ktls_enable(struct s2n_connection *conn)
+{
+    RESULT_ENSURE_REF(conn);
+    RESULT_ENSURE_REF(conn->config);
+
+    if (!(conn->config->ktls_send || conn->config->ktls_recv) || !s2n_ktls_is_supported_conn(conn)) {
+        return S2N_RESULT_OK;
+    }
+
+    /* The kernel can only take over sockets that s2n writes to directly,
+     * and only once every record encrypted in userspace has been flushed.
+     */
+    if (conn->config->ktls_send && conn->send == s2n_socket_write && s2n_stuffer_data_available(&conn->out) == 0) {
+        const int fd = s2n_ktls_send_fd(conn);
+        if (s2n_result_is_ok(s2n_ktls_set_ulp(fd)) && s2n_result_is_ok(s2n_ktls_set_keys(conn, fd, conn->mode, TLS_TX))) {
+            conn->ktls_send_enabled = 1;
+        }
+    }
+
+    /* Likewise, records already read from the socket must have been decrypted in userspace */
+    const bool has_buffered_input = s2n_stuffer_data_available(&conn->buffer_in)
+            || s2n_stuffer_data_available(&conn->header_in) || s2n_stuffer_data_available(&conn->in);
+    if (conn->config->ktls_recv && conn->recv == s2n_socket_read && !has_buffered_input) {
+        const int fd = s2n_ktls_recv_fd(conn);
+        const s2n_mode peer = (conn->mode == S2N_CLIENT) ? S2N_SERVER : S2N_CLIENT;
+        if (s2n_result_is_ok(s2n_ktls_set_ulp(fd)) && s2n_result_is_ok(s2n_ktls_set_keys(conn, fd, peer, TLS_RX))) {
+            conn->ktls_recv_enabled = 1;
+        }
+    }
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_ktls_update_keys(struct s2n_connection *conn, s2n_mode sender)
+{
+    RESULT_ENSURE_REF(conn);
+
+    const bool is_send = (sender == conn->mode);
+    RESULT_ENSURE(is_send ? conn->ktls_send_enabled : conn->ktls_recv_enabled, S2N_ERR_INVALID_STATE);
+    RESULT_ENSURE(s2n_ktls_is_rekey_supported(), S2N_ERR_KTLS_KEY_UPDATE);
+
+    if (is_send) {
+        RESULT_GUARD(s2n_ktls_set_keys(conn, s2n_ktls_send_fd(conn), sender, TLS_TX));
+    } else {
+        RESULT_GUARD(s2n_ktls_set_keys(conn, s2n_ktls_recv_fd(conn), sender, TLS_RX));
+    }
+
+    return S2N_RESULT_OK;
+}
+
+int s2n_ktls_record_writev(struct s2n_connection *conn, uint8_t content_type, const struct iovec *in, int in_count, size_t offs, size_t to_write)
+{
+    POSIX_ENSURE_REF(conn);
+
+    /* Every sendmsg call carries a single content type, so plaintext of different types can't be mixed */
+    if (s2n_stuffer_data_available(&conn->out) == 0) {
+        POSIX_GUARD(s2n_stuffer_rewrite(&conn->out));
+        conn->ktls_out_content_type = content_type;
+    }
+    S2N_ERROR_IF(conn->ktls_out_content_type != content_type, S2N_ERR_RECORD_STUFFER_NEEDS_DRAINING);
+
+    uint16_t max_write_payload_size = 0;
+    POSIX_GUARD_RESULT(s2n_record_max_write_payload_size(conn, &max_write_payload_size));
+    const uint16_t data_bytes_to_take = MIN(to_write, max_write_payload_size);
+
+    POSIX_GUARD_RESULT(s2n_connection_acquire_record_buffer(conn, &conn->out, S2N_LARGE_RECORD_LENGTH));
+    POSIX_GUARD(s2n_stuffer_writev_bytes(&conn->out, in, in_count, offs, data_bytes_to_take));
+
+    return data_bytes_to_take;
+}
+
+static ssize_t s2n_ktls_sendmsg(int fd, uint8_t content_type, struct iovec *iov, size_t iov_count)
+{
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = iov_count };
+
+    /* Anything other than application data has to be labelled for the kernel */
+    char control[CMSG_SPACE(sizeof(uint8_t))] = { 0 };
+    if (content_type != TLS_APPLICATION_DATA) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        struct cmsghdr *header = CMSG_FIRSTHDR(&msg);
+        header->cmsg_level = SOL_TLS;
+        header->cmsg_type = TLS_SET_RECORD_TYPE;
+        header->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+        *CMSG_DATA(header) = content_type;
+    }
+
+    return sendmsg(fd, &msg, 0);
+}
+
+int s2n_ktls_send_stuffer(struct s2n_stuffer *stuffer, struct s2n_connection *conn, uint32_t len)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_REF(stuffer);
+    POSIX_ENSURE(!conn->write_fd_broken, S2N_ERR_SEND_STUFFER_TO_CONN);
+    S2N_ERROR_IF(s2n_stuffer_data_available(stuffer) < len, S2N_ERR_STUFFER_OUT_OF_DATA);
+
+    struct iovec iov = { .iov_base = stuffer->blob.data + stuffer->read_cursor, .iov_len = len };
+    ssize_t w = 0;
+    do {
+        errno = 0;
+        w = s2n_ktls_sendmsg(s2n_ktls_send_fd(conn), conn->ktls_out_content_type, &iov, 1);
+        if (w < 0 && errno == EPIPE) {
+            conn->write_fd_broken = 1;
+        }
+        S2N_ERROR_IF(w < 0 && errno != EINTR, S2N_ERR_SEND_STUFFER_TO_CONN);
+    } while (w < 0);
+
+    POSIX_GUARD(s2n_stuffer_skip_read(stuffer, w));
+    return w;
+}
+
+ssize_t s2n_ktls_sendv_with_offset(struct s2n_connection *conn, const struct iovec *bufs, ssize_t count, ssize_t offs, s2n_blocked_status *blocked)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE(count >= 0 && offs >= 0, S2N_ERR_INVALID_ARGUMENT);
+    POSIX_ENSURE(!conn->write_fd_broken, S2N_ERR_IO);
+
+    ssize_t total_size = 0;
+    for (ssize_t i = 0; i < count; i++) {
+        total_size += bufs[i].iov_len;
+    }
+    POSIX_ENSURE(offs <= total_size, S2N_ERR_SEND_SIZE);
+    total_size -= offs;
+
+    /* The kernel turns the plaintext into records, so any amount accepted by the socket counts as sent */
+    *blocked = S2N_BLOCKED_ON_WRITE;
+    ssize_t sent = 0;
+    while (sent < total_size) {
+        struct iovec iov[S2N_KTLS_MAX_IOVECS];
+        size_t iov_count = 0;
+        size_t skip = offs + sent;
+        for (ssize_t i = 0; i < count && iov_count < S2N_KTLS_MAX_IOVECS; i++) {
+            if (skip >= bufs[i].iov_len) {
+                skip -= bufs[i].iov_len;
+                continue;
+            }
+            iov[iov_count].iov_base = (uint8_t *) bufs[i].iov_base + skip;
+            iov[iov_count].iov_len = bufs[i].iov_len - skip;
+            iov_count++;
+            skip = 0;
+        }
+
+        errno = 0;
+        ssize_t w = s2n_ktls_sendmsg(s2n_ktls_send_fd(conn), TLS_APPLICATION_DATA, iov, iov_count);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EWOULDBLOCK || errno == EAGAIN) {
+                if (sent) {
+                    return sent;
+                }
+                POSIX_BAIL(S2N_ERR_IO_BLOCKED);
+            }
+            if (errno == EPIPE) {
+                conn->write_fd_broken = 1;
+            }
+            POSIX_BAIL(S2N_ERR_IO);
+        }
+        sent += w;
+        /* The record overhead added by the kernel is not visible here */
+        conn->wire_bytes_out += w;
+    }
+
+    *blocked = S2N_NOT_BLOCKED;
+    return total_size;
+}
+
+ssize_t s2n_ktls_sendfile(struct s2n_connection *conn, int fd, off_t offset, size_t count, s2n_blocked_status *blocked)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE(!conn->write_fd_broken, S2N_ERR_IO);
+
+    /* The file contents never leave the kernel */
+    *blocked = S2N_BLOCKED_ON_WRITE;
+    size_t sent = 0;
+    while (sent < count) {
+        off_t file_offset = offset + sent;
+        errno = 0;
+        ssize_t w = sendfile(s2n_ktls_send_fd(conn), fd, &file_offset, count - sent);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EWOULDBLOCK || errno == EAGAIN) {
+                if (sent) {
+                    return sent;
+                }
+                POSIX_BAIL(S2N_ERR_IO_BLOCKED);
+            }
+            if (errno == EPIPE) {
+                conn->write_fd_broken = 1;
+            }
+            POSIX_BAIL(S2N_ERR_IO);
+        }
+        /* The file is shorter than the caller claimed */
+        POSIX_ENSURE(w > 0, S2N_ERR_INVALID_ARGUMENT);
+        sent += w;
+        conn->wire_bytes_out += w;
+    }
+
+    *blocked = S2N_NOT_BLOCKED;
+    return count;
+}
+
+int s2n_ktls_read_full_record(struct s2n_connection *conn, uint8_t *record_type)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_REF(record_type);
+
+    /* The kernel returns at most one record of a type other than application data per call */
+    POSIX_GUARD(s2n_stuffer_rewrite(&conn->in));
+    POSIX_GUARD(s2n_stuffer_reserve_space(&conn->in, S2N_TLS_MAXIMUM_FRAGMENT_LENGTH));
+
+    struct iovec iov = {
+        .iov_base = conn->in.blob.data + conn->in.write_cursor,
+        .iov_len = s2n_stuffer_space_remaining(&conn->in),
+    };
+    char control[CMSG_SPACE(sizeof(uint8_t))] = { 0 };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control,
+        .msg_controllen = sizeof(control),
+    };
+
+    ssize_t r = 0;
+    do {
+        errno = 0;
+        r = recvmsg(s2n_ktls_recv_fd(conn), &msg, 0);
+    } while (r < 0 && errno == EINTR);
+
+    if (r == 0) {
+        conn->closed = 1;
+        POSIX_BAIL(S2N_ERR_CLOSED);
+    } else if (r < 0) {
+        if (errno == EWOULDBLOCK || errno == EAGAIN) {
+            POSIX_BAIL(S2N_ERR_IO_BLOCKED);
+        }
+        if (errno == EBADMSG) {
+            /* The kernel failed to authenticate a record */
+            POSIX_GUARD(s2n_connection_kill(conn));
+            POSIX_BAIL(S2N_ERR_DECRYPT);
+        }
+        POSIX_BAIL(S2N_ERR_IO);
+    }
+
+    *record_type = TLS_APPLICATION_DATA;
+    for (struct cmsghdr *header = CMSG_FIRSTHDR(&msg); header != NULL; header = CMSG_NXTHDR(&msg, header)) {
+        if (header->cmsg_level == SOL_TLS && header->cmsg_type == TLS_GET_RECORD_TYPE) {
+            *record_type = *CMSG_DATA(header);
+        }
+    }
+
+    POSIX_GUARD(s2n_stuffer_skip_write(&conn->in, r));
+    conn->wire_bytes_in += r;
+    if (*record_type == TLS_APPLICATION_DATA) {
+        conn->in_status = PLAINTEXT;
+    }
+
+    return S2N_SUCCESS;
+}
+
+#else
+
+S2N_RESULT s2n_ktls_enable(struct s2n_connection *conn)
+{
+    /* kTLS is not available on this platform, so the userspace record layer is always used */
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_ktls_update_keys(struct s2n_connection *conn, s2n_mode sender)
+{
+    RESULT_BAIL(S2N_ERR_KTLS_UNSUPPORTED);
+}
+
+int s2n_ktls_record_writev(struct s2n_connection *conn, uint8_t content_type, const struct iovec *in, int in_count, size_t offs, size_t to_write)
+{
+    POSIX_BAIL(S2N_ERR_KTLS_UNSUPPORTED);
+}
+
+int s2n_ktls_send_stuffer(struct s2n_stuffer *stuffer, struct s2n_connection *conn, uint32_t len)
+{
+    POSIX_BAIL(S2N_ERR_KTLS_UNSUPPORTED);
+}
+
+ssize_t s2n_ktls_sendv_with_offset(struct s2n_connection *conn, const struct iovec *bufs, ssize_t count, ssize_t offs, s2n_blocked_status *blocked)
+{
+    POSIX_BAIL(S2N_ERR_KTLS_UNSUPPORTED);
+}
+
+ssize_t s2n_ktls_sendfile(struct s2n_connection *conn, int fd, off_t offset, size_t count, s2n_blocked_status *blocked)
+{
+    POSIX_BAIL(S2N_ERR_KTLS_UNSUPPORTED);
+}
+
+int s2n_ktls_read_full_record(struct s2n_connection *conn, uint8_t *record_type)
+{
+    POSIX_BAIL(S2N_ERR_KTLS_UNSUPPORTED);
+}
+
+#endif
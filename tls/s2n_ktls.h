@@ -0,0 +1,54 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "tls/s2n_connection.h"
+#include "utils/s2n_result.h"
+
+/* kTLS hands the negotiated traffic keys to the Linux kernel, which then frames, encrypts and decrypts
+ * records on the socket itself. s2n keeps driving the connection, but reads and writes plaintext:
+ *
+ * - Application data is written straight to the socket and read straight into conn->in.
+ * - Other records (alerts, post-handshake messages) are staged in conn->out as plaintext and
+ *   tagged with their content type via a control message.
+ *
+ * See s2n_config_set_ktls_mode.
+ */
+
+/* Tries to offload the directions requested by the config. Falls back to the userspace record layer
+ * without reporting an error if the kernel or the connection cannot support kTLS. */
+extern S2N_RESULT s2n_ktls_enable(struct s2n_connection *conn);
+/* Pushes the current traffic keys of the given sender to the kernel after a TLS1.3 KeyUpdate */
+extern S2N_RESULT s2n_ktls_update_keys(struct s2n_connection *conn, s2n_mode sender);
+
+/* Whether the kernel accepts new keys on a socket that is already offloaded, which TLS1.3 needs
+ * to handle KeyUpdate messages. Tests can force the answer; S2N_KTLS_REKEY_DETECT restores detection. */
+typedef enum {
+    S2N_KTLS_REKEY_DETECT = 0,
+    S2N_KTLS_REKEY_SUPPORTED,
+    S2N_KTLS_REKEY_UNSUPPORTED,
+} s2n_ktls_rekey_support;
+extern bool s2n_ktls_is_rekey_supported(void);
+extern S2N_RESULT s2n_ktls_set_rekey_support_for_testing(s2n_ktls_rekey_support support);
+
+extern int s2n_ktls_record_writev(struct s2n_connection *conn, uint8_t content_type, const struct iovec *in, int in_count, size_t offs, size_t to_write);
+extern int s2n_ktls_send_stuffer(struct s2n_stuffer *stuffer, struct s2n_connection *conn, uint32_t len);
+extern ssize_t s2n_ktls_sendv_with_offset(struct s2n_connection *conn, const struct iovec *bufs, ssize_t count, ssize_t offs, s2n_blocked_status *blocked);
+extern ssize_t s2n_ktls_sendfile(struct s2n_connection *conn, int fd, off_t offset, size_t count, s2n_blocked_status *blocked);
+extern int s2n_ktls_read_full_record(struct s2n_connection *conn, uint8_t *record_type);
@@ -328,22 +328,49 @@ const struct s2n_p_hash_hmac *s2n_get_hmac_implementation() {
 
 int s2n_prf_new(struct s2n_connection *conn)
 {
-    /* Set p_hash_hmac_impl on initial prf creation. 
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_EQ(conn->prf_space, NULL);
+
+    DEFER_CLEANUP(struct s2n_blob mem = { 0 }, s2n_free);
+    POSIX_GUARD(s2n_alloc(&mem, sizeof(struct s2n_prf_working_space)));
+    POSIX_GUARD(s2n_blob_zero(&mem));
+    struct s2n_prf_working_space *prf_space = (struct s2n_prf_working_space *)(void *) mem.data;
+
+    /* Set p_hash_hmac_impl on initial prf creation.
      * When in FIPS mode, the EVP API's must be used for the p_hash HMAC.
      */
-    conn->prf_space.tls.p_hash_hmac_impl = s2n_get_hmac_implementation();
+    prf_space->tls.p_hash_hmac_impl = s2n_get_hmac_implementation();
+    POSIX_GUARD(prf_space->tls.p_hash_hmac_impl->alloc(prf_space));
+
+    POSIX_GUARD(s2n_hash_new(&prf_space->ssl3.md5));
+    POSIX_GUARD(s2n_hash_new(&prf_space->ssl3.sha1));
 
-    return conn->prf_space.tls.p_hash_hmac_impl->alloc(&conn->prf_space);
+    conn->prf_space = prf_space;
+    ZERO_TO_DISABLE_DEFER_CLEANUP(mem);
+    return S2N_SUCCESS;
 }
 
 int s2n_prf_free(struct s2n_connection *conn)
 {
-    /* Ensure that p_hash_hmac_impl is set, as it may have been reset for prf_space on s2n_connection_wipe. 
+    POSIX_ENSURE_REF(conn);
+    struct s2n_prf_working_space *prf_space = conn->prf_space;
+    if (prf_space == NULL) {
+        return S2N_SUCCESS;
+    }
+
+    /* Ensure that p_hash_hmac_impl is set, as it may have been reset for prf_space on s2n_connection_wipe.
      * When in FIPS mode, the EVP API's must be used for the p_hash HMAC.
      */
-    conn->prf_space.tls.p_hash_hmac_impl = s2n_get_hmac_implementation();
+    prf_space->tls.p_hash_hmac_impl = s2n_get_hmac_implementation();
+    POSIX_GUARD(prf_space->tls.p_hash_hmac_impl->free(prf_space));
+
+    POSIX_GUARD(s2n_hash_reset(&prf_space->ssl3.md5));
+    POSIX_GUARD(s2n_hash_reset(&prf_space->ssl3.sha1));
+    POSIX_GUARD(s2n_hash_free(&prf_space->ssl3.md5));
+    POSIX_GUARD(s2n_hash_free(&prf_space->ssl3.sha1));
 
-    return conn->prf_space.tls.p_hash_hmac_impl->free(&conn->prf_space);
+    POSIX_GUARD(s2n_free_object((uint8_t **) &conn->prf_space, sizeof(struct s2n_prf_working_space)));
+    return S2N_SUCCESS;
 }
 
 static int s2n_prf(struct s2n_connection *conn, struct s2n_blob *secret, struct s2n_blob *label, struct s2n_blob *seed_a,
@@ -352,9 +379,10 @@ static int s2n_prf(struct s2n_connection *conn, struct s2n_blob *secret, struct
     /* seed_a is always required, seed_b is optional, if seed_c is provided seed_b must also be provided */
     S2N_ERROR_IF(seed_a == NULL, S2N_ERR_PRF_INVALID_SEED);
     S2N_ERROR_IF(seed_b == NULL && seed_c != NULL, S2N_ERR_PRF_INVALID_SEED);
+    POSIX_ENSURE_REF(conn->prf_space);
 
     if (conn->actual_protocol_version == S2N_SSLv3) {
-        return s2n_sslv3_prf(&conn->prf_space, secret, seed_a, seed_b, seed_c, out);
+        return s2n_sslv3_prf(conn->prf_space, secret, seed_a, seed_b, seed_c, out);
     }
 
     /* We zero the out blob because p_hash works by XOR'ing with the existing
@@ -368,18 +396,18 @@ static int s2n_prf(struct s2n_connection *conn, struct s2n_blob *secret, struct
     /* Ensure that p_hash_hmac_impl is set, as it may have been reset for prf_space on s2n_connection_wipe. 
      * When in FIPS mode, the EVP API's must be used for the p_hash HMAC.
      */
-    conn->prf_space.tls.p_hash_hmac_impl = s2n_get_hmac_implementation();
+    conn->prf_space->tls.p_hash_hmac_impl = s2n_get_hmac_implementation();
 
     if (conn->actual_protocol_version == S2N_TLS12) {
-        return s2n_p_hash(&conn->prf_space, conn->secure.cipher_suite->prf_alg, secret, label, seed_a, seed_b,
+        return s2n_p_hash(conn->prf_space, conn->secure.cipher_suite->prf_alg, secret, label, seed_a, seed_b,
                           seed_c, out);
     }
 
     struct s2n_blob half_secret = {.data = secret->data,.size = (secret->size + 1) / 2 };
 
-    POSIX_GUARD(s2n_p_hash(&conn->prf_space, S2N_HMAC_MD5, &half_secret, label, seed_a, seed_b, seed_c, out));
+    POSIX_GUARD(s2n_p_hash(conn->prf_space, S2N_HMAC_MD5, &half_secret, label, seed_a, seed_b, seed_c, out));
     half_secret.data += secret->size - half_secret.size;
-    POSIX_GUARD(s2n_p_hash(&conn->prf_space, S2N_HMAC_SHA1, &half_secret, label, seed_a, seed_b, seed_c, out));
+    POSIX_GUARD(s2n_p_hash(conn->prf_space, S2N_HMAC_SHA1, &half_secret, label, seed_a, seed_b, seed_c, out));
 
     return 0;
 }
@@ -453,9 +481,9 @@ static int s2n_sslv3_client_finished(struct s2n_connection *conn)
     uint8_t prefix[4] = { 0x43, 0x4c, 0x4e, 0x54 };
 
     POSIX_ENSURE_LTE(MD5_DIGEST_LENGTH + SHA_DIGEST_LENGTH, sizeof(conn->handshake.client_finished));
-    POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_md5_hash_copy, &conn->handshake.md5));
-    POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_sha1_hash_copy, &conn->handshake.sha1));
-    return s2n_sslv3_finished(conn, prefix, &conn->handshake.prf_md5_hash_copy, &conn->handshake.prf_sha1_hash_copy, conn->handshake.client_finished);
+    POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_md5_hash_copy, &conn->handshake.hashes->md5));
+    POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_sha1_hash_copy, &conn->handshake.hashes->sha1));
+    return s2n_sslv3_finished(conn, prefix, &conn->handshake.hashes->prf_md5_hash_copy, &conn->handshake.hashes->prf_sha1_hash_copy, conn->handshake.client_finished);
 }
 
 static int s2n_sslv3_server_finished(struct s2n_connection *conn)
@@ -463,9 +491,9 @@ static int s2n_sslv3_server_finished(struct s2n_connection *conn)
     uint8_t prefix[4] = { 0x53, 0x52, 0x56, 0x52 };
 
     POSIX_ENSURE_LTE(MD5_DIGEST_LENGTH + SHA_DIGEST_LENGTH, sizeof(conn->handshake.server_finished));
-    POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_md5_hash_copy, &conn->handshake.md5));
-    POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_sha1_hash_copy, &conn->handshake.sha1));
-    return s2n_sslv3_finished(conn, prefix, &conn->handshake.prf_md5_hash_copy, &conn->handshake.prf_sha1_hash_copy, conn->handshake.server_finished);
+    POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_md5_hash_copy, &conn->handshake.hashes->md5));
+    POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_sha1_hash_copy, &conn->handshake.hashes->sha1));
+    return s2n_sslv3_finished(conn, prefix, &conn->handshake.hashes->prf_md5_hash_copy, &conn->handshake.hashes->prf_sha1_hash_copy, conn->handshake.server_finished);
 }
 
 int s2n_prf_client_finished(struct s2n_connection *conn)
@@ -477,6 +505,10 @@ int s2n_prf_client_finished(struct s2n_connection *conn)
     struct s2n_blob client_finished = {0};
     struct s2n_blob label = {0};
 
+    /* The transcript hashes are read directly below */
+    POSIX_GUARD_RESULT(s2n_handshake_transcript_flush(conn));
+    POSIX_ENSURE_REF(conn->handshake.hashes);
+
     if (conn->actual_protocol_version == S2N_SSLv3) {
         return s2n_sslv3_client_finished(conn);
     }
@@ -491,13 +523,13 @@ int s2n_prf_client_finished(struct s2n_connection *conn)
     if (conn->actual_protocol_version == S2N_TLS12) {
         switch (conn->secure.cipher_suite->prf_alg) {
         case S2N_HMAC_SHA256:
-            POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_tls12_hash_copy, &conn->handshake.sha256));
-            POSIX_GUARD(s2n_hash_digest(&conn->handshake.prf_tls12_hash_copy, sha_digest, SHA256_DIGEST_LENGTH));
+            POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_tls12_hash_copy, &conn->handshake.hashes->sha256));
+            POSIX_GUARD(s2n_hash_digest(&conn->handshake.hashes->prf_tls12_hash_copy, sha_digest, SHA256_DIGEST_LENGTH));
             sha.size = SHA256_DIGEST_LENGTH;
             break;
         case S2N_HMAC_SHA384:
-            POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_tls12_hash_copy, &conn->handshake.sha384));
-            POSIX_GUARD(s2n_hash_digest(&conn->handshake.prf_tls12_hash_copy, sha_digest, SHA384_DIGEST_LENGTH));
+            POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_tls12_hash_copy, &conn->handshake.hashes->sha384));
+            POSIX_GUARD(s2n_hash_digest(&conn->handshake.hashes->prf_tls12_hash_copy, sha_digest, SHA384_DIGEST_LENGTH));
             sha.size = SHA384_DIGEST_LENGTH;
             break;
         default:
@@ -508,11 +540,11 @@ int s2n_prf_client_finished(struct s2n_connection *conn)
         return s2n_prf(conn, &master_secret, &label, &sha, NULL, NULL, &client_finished);
     }
 
-    POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_md5_hash_copy, &conn->handshake.md5));
-    POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_sha1_hash_copy, &conn->handshake.sha1));
+    POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_md5_hash_copy, &conn->handshake.hashes->md5));
+    POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_sha1_hash_copy, &conn->handshake.hashes->sha1));
 
-    POSIX_GUARD(s2n_hash_digest(&conn->handshake.prf_md5_hash_copy, md5_digest, MD5_DIGEST_LENGTH));
-    POSIX_GUARD(s2n_hash_digest(&conn->handshake.prf_sha1_hash_copy, sha_digest, SHA_DIGEST_LENGTH));
+    POSIX_GUARD(s2n_hash_digest(&conn->handshake.hashes->prf_md5_hash_copy, md5_digest, MD5_DIGEST_LENGTH));
+    POSIX_GUARD(s2n_hash_digest(&conn->handshake.hashes->prf_sha1_hash_copy, sha_digest, SHA_DIGEST_LENGTH));
     md5.data = md5_digest;
     md5.size = MD5_DIGEST_LENGTH;
     sha.data = sha_digest;
@@ -530,6 +562,10 @@ int s2n_prf_server_finished(struct s2n_connection *conn)
     struct s2n_blob server_finished = {0};
     struct s2n_blob label = {0};
 
+    /* The transcript hashes are read directly below */
+    POSIX_GUARD_RESULT(s2n_handshake_transcript_flush(conn));
+    POSIX_ENSURE_REF(conn->handshake.hashes);
+
     if (conn->actual_protocol_version == S2N_SSLv3) {
         return s2n_sslv3_server_finished(conn);
     }
@@ -544,13 +580,13 @@ int s2n_prf_server_finished(struct s2n_connection *conn)
     if (conn->actual_protocol_version == S2N_TLS12) {
         switch (conn->secure.cipher_suite->prf_alg) {
         case S2N_HMAC_SHA256:
-            POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_tls12_hash_copy, &conn->handshake.sha256));
-            POSIX_GUARD(s2n_hash_digest(&conn->handshake.prf_tls12_hash_copy, sha_digest, SHA256_DIGEST_LENGTH));
+            POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_tls12_hash_copy, &conn->handshake.hashes->sha256));
+            POSIX_GUARD(s2n_hash_digest(&conn->handshake.hashes->prf_tls12_hash_copy, sha_digest, SHA256_DIGEST_LENGTH));
             sha.size = SHA256_DIGEST_LENGTH;
             break;
         case S2N_HMAC_SHA384:
-            POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_tls12_hash_copy, &conn->handshake.sha384));
-            POSIX_GUARD(s2n_hash_digest(&conn->handshake.prf_tls12_hash_copy, sha_digest, SHA384_DIGEST_LENGTH));
+            POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_tls12_hash_copy, &conn->handshake.hashes->sha384));
+            POSIX_GUARD(s2n_hash_digest(&conn->handshake.hashes->prf_tls12_hash_copy, sha_digest, SHA384_DIGEST_LENGTH));
             sha.size = SHA384_DIGEST_LENGTH;
             break;
         default:
@@ -561,11 +597,11 @@ int s2n_prf_server_finished(struct s2n_connection *conn)
         return s2n_prf(conn, &master_secret, &label, &sha, NULL, NULL, &server_finished);
     }
 
-    POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_md5_hash_copy, &conn->handshake.md5));
-    POSIX_GUARD(s2n_hash_copy(&conn->handshake.prf_sha1_hash_copy, &conn->handshake.sha1));
+    POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_md5_hash_copy, &conn->handshake.hashes->md5));
+    POSIX_GUARD(s2n_hash_copy(&conn->handshake.hashes->prf_sha1_hash_copy, &conn->handshake.hashes->sha1));
 
-    POSIX_GUARD(s2n_hash_digest(&conn->handshake.prf_md5_hash_copy, md5_digest, MD5_DIGEST_LENGTH));
-    POSIX_GUARD(s2n_hash_digest(&conn->handshake.prf_sha1_hash_copy, sha_digest, SHA_DIGEST_LENGTH));
+    POSIX_GUARD(s2n_hash_digest(&conn->handshake.hashes->prf_md5_hash_copy, md5_digest, MD5_DIGEST_LENGTH));
+    POSIX_GUARD(s2n_hash_digest(&conn->handshake.hashes->prf_sha1_hash_copy, sha_digest, SHA_DIGEST_LENGTH));
     md5.data = md5_digest;
     md5.size = MD5_DIGEST_LENGTH;
     sha.data = sha_digest;
@@ -606,21 +642,32 @@ static int s2n_prf_make_server_key(struct s2n_connection *conn, struct s2n_stuff
     return 0;
 }
 
-int s2n_prf_key_expansion(struct s2n_connection *conn)
+int s2n_prf_generate_key_block(struct s2n_connection *conn, struct s2n_blob *key_block)
 {
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_REF(key_block);
+
     struct s2n_blob client_random = {.data = conn->secure.client_random,.size = sizeof(conn->secure.client_random) };
     struct s2n_blob server_random = {.data = conn->secure.server_random,.size = sizeof(conn->secure.server_random) };
     struct s2n_blob master_secret = {.data = conn->secure.master_secret,.size = sizeof(conn->secure.master_secret) };
-    struct s2n_blob label, out;
+    struct s2n_blob label;
     uint8_t key_expansion_label[] = "key expansion";
-    uint8_t key_block[S2N_MAX_KEY_BLOCK_LEN];
 
     label.data = key_expansion_label;
     label.size = sizeof(key_expansion_label) - 1;
+
+    POSIX_GUARD(s2n_prf(conn, &master_secret, &label, &server_random, &client_random, NULL, key_block));
+    return S2N_SUCCESS;
+}
+
+int s2n_prf_key_expansion(struct s2n_connection *conn)
+{
+    struct s2n_blob out;
+    uint8_t key_block[S2N_MAX_KEY_BLOCK_LEN];
     POSIX_GUARD(s2n_blob_init(&out, key_block, sizeof(key_block)));
 
     struct s2n_stuffer key_material = {0};
-    POSIX_GUARD(s2n_prf(conn, &master_secret, &label, &server_random, &client_random, NULL, &out));
+    POSIX_GUARD(s2n_prf_generate_key_block(conn, &out));
     POSIX_GUARD(s2n_stuffer_init(&key_material, &out));
     POSIX_GUARD(s2n_stuffer_write(&key_material, &out));
 
@@ -65,6 +65,7 @@ extern int s2n_prf_new(struct s2n_connection *conn);
 extern int s2n_prf_free(struct s2n_connection *conn);
 extern int s2n_tls_prf_master_secret(struct s2n_connection *conn, struct s2n_blob *premaster_secret);
 extern int s2n_hybrid_prf_master_secret(struct s2n_connection *conn, struct s2n_blob *premaster_secret);
+extern int s2n_prf_generate_key_block(struct s2n_connection *conn, struct s2n_blob *key_block);
 extern int s2n_prf_key_expansion(struct s2n_connection *conn);
 extern int s2n_prf_server_finished(struct s2n_connection *conn);
 extern int s2n_prf_client_finished(struct s2n_connection *conn);
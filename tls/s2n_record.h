@@ -21,8 +21,15 @@
 
 #define TLS13_CONTENT_TYPE_LENGTH 1
 
+/* RFC5246 6.2.3 allows a record to expand its fragment by at most 2048 bytes.
+ * This is an upper bound on the wire size of a record carrying "fragment" bytes of plaintext.
+ */
+#define S2N_TLS_MAX_RECORD_EXPANSION 2048
+#define S2N_TLS_MAX_RECORD_LEN_FOR(fragment) ((fragment) + S2N_TLS_MAX_RECORD_EXPANSION + S2N_TLS_RECORD_HEADER_LENGTH)
+
 extern S2N_RESULT s2n_record_max_write_payload_size(struct s2n_connection *conn, uint16_t *max_fragment_size);
 extern S2N_RESULT s2n_record_min_write_payload_size(struct s2n_connection *conn, uint16_t *payload_size);
+extern S2N_RESULT s2n_record_explicit_iv_size(struct s2n_connection *conn, uint16_t *out);
 extern int s2n_record_write(struct s2n_connection *conn, uint8_t content_type, struct s2n_blob *in);
 extern int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const struct iovec *in, int in_count, size_t offs, size_t to_write);
 extern int s2n_record_parse(struct s2n_connection *conn);
@@ -120,8 +120,11 @@ int s2n_record_parse(struct s2n_connection *conn)
     struct s2n_crypto_parameters *current_client_crypto = conn->client;
     struct s2n_crypto_parameters *current_server_crypto = conn->server;
     if (s2n_is_tls13_plaintext_content(conn, content_type)) {
-        conn->client = &conn->initial;
-        conn->server = &conn->initial;
+        /* The initial parameters are released with the rest of the handshake state,
+         * after which a plaintext record from the peer can only be a bad record */
+        POSIX_ENSURE(conn->initial != NULL, S2N_ERR_BAD_MESSAGE);
+        conn->client = conn->initial;
+        conn->server = conn->initial;
     }
 
     const struct s2n_cipher_suite *cipher_suite = conn->client->cipher_suite;
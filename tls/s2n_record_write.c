@@ -20,6 +20,7 @@
 
 #include "tls/s2n_cipher_suites.h"
 #include "tls/s2n_connection.h"
+#include "tls/s2n_ktls.h"
 #include "tls/s2n_record.h"
 #include "tls/s2n_crypto.h"
 
@@ -82,6 +83,28 @@ S2N_RESULT s2n_record_max_write_payload_size(struct s2n_connection *conn, uint16
     return S2N_RESULT_OK;
 }
 
+/* The number of bytes between the record header and the plaintext, used for explicit IVs */
+S2N_RESULT s2n_record_explicit_iv_size(struct s2n_connection *conn, uint16_t *out)
+{
+    RESULT_ENSURE_REF(conn);
+    RESULT_ENSURE_MUT(out);
+    struct s2n_crypto_parameters *active = conn->mode == S2N_CLIENT ? conn->client : conn->server;
+    const struct s2n_cipher *cipher = active->cipher_suite->record_alg->cipher;
+
+    *out = 0;
+    if (cipher->type == S2N_AEAD) {
+        *out = cipher->io.aead.record_iv_size;
+    } else if (conn->actual_protocol_version > S2N_TLS10) {
+        if (cipher->type == S2N_CBC) {
+            *out = cipher->io.cbc.record_iv_size;
+        } else if (cipher->type == S2N_COMPOSITE) {
+            *out = cipher->io.comp.record_iv_size;
+        }
+    }
+
+    return S2N_RESULT_OK;
+}
+
 /* Find the largest size that will fit within an ethernet frame for a "small" payload */
 S2N_RESULT s2n_record_min_write_payload_size(struct s2n_connection *conn, uint16_t *payload_size)
 {
@@ -121,7 +144,7 @@ S2N_RESULT s2n_record_min_write_payload_size(struct s2n_connection *conn, uint16
     return S2N_RESULT_OK;
 }
 
-int s2n_record_write_protocol_version(struct s2n_connection *conn)
+int s2n_record_write_protocol_version(struct s2n_connection *conn, struct s2n_stuffer *out)
 {
     uint8_t record_protocol_version = conn->actual_protocol_version;
     if (conn->server_protocol_version == s2n_unknown_protocol_version) {
@@ -141,7 +164,7 @@ int s2n_record_write_protocol_version(struct s2n_connection *conn)
     protocol_version[0] = record_protocol_version / 10;
     protocol_version[1] = record_protocol_version % 10;
 
-    POSIX_GUARD(s2n_stuffer_write_bytes(&conn->out, protocol_version, S2N_TLS_PROTOCOL_VERSION_LEN));
+    POSIX_GUARD(s2n_stuffer_write_bytes(out, protocol_version, S2N_TLS_PROTOCOL_VERSION_LEN));
 
     return 0;
 }
@@ -191,6 +214,11 @@ static inline int s2n_record_encrypt(
 
 int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const struct iovec *in, int in_count, size_t offs, size_t to_write)
 {
+    /* With kTLS, the kernel builds and encrypts the record */
+    if (conn->ktls_send_enabled) {
+        return s2n_ktls_record_writev(conn, content_type, in, in_count, offs, to_write);
+    }
+
     struct s2n_blob iv = { 0 };
     uint8_t padding = 0;
     uint16_t block_size = 0;
@@ -200,8 +228,11 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
     struct s2n_crypto_parameters *current_client_crypto = conn->client;
     struct s2n_crypto_parameters *current_server_crypto = conn->server;
     if (conn->actual_protocol_version == S2N_TLS13 && content_type == TLS_CHANGE_CIPHER_SPEC) {
-        conn->client = &conn->initial;
-        conn->server = &conn->initial;
+        /* A CCS is only part of the handshake, so it can't be sent once the
+         * initial parameters have been released */
+        POSIX_ENSURE(conn->initial != NULL, S2N_ERR_BAD_MESSAGE);
+        conn->client = conn->initial;
+        conn->server = conn->initial;
     }
 
     uint8_t *sequence_number = conn->server->server_sequence_number;
@@ -221,7 +252,15 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
     const int is_tls13_record = cipher_suite->record_alg->flags & S2N_TLS13_RECORD_AEAD_NONCE;
     s2n_stack_blob(aad, is_tls13_record ? S2N_TLS13_AAD_LEN : S2N_TLS_MAX_AAD_LEN, S2N_TLS_MAX_AAD_LEN);
 
-    S2N_ERROR_IF(s2n_stuffer_data_available(&conn->out), S2N_ERR_RECORD_STUFFER_NEEDS_DRAINING);
+    /* Records are only queued behind each other when the connection has a send buffer configured,
+     * or while the records of a handshake flight are being assembled.
+     * Otherwise the previous record must have been flushed before a new one is written.
+     */
+    S2N_ERROR_IF(s2n_stuffer_data_available(&conn->out) && !conn->config->send_buffer_size_override
+            && !conn->handshake.flight_queued, S2N_ERR_RECORD_STUFFER_NEEDS_DRAINING);
+    if (s2n_stuffer_data_available(&conn->out) == 0) {
+        POSIX_GUARD(s2n_stuffer_rewrite(&conn->out));
+    }
 
     uint8_t mac_digest_size;
     POSIX_GUARD(s2n_hmac_digest_size(mac->alg, &mac_digest_size));
@@ -249,23 +288,32 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
     /* Start the MAC with the sequence number */
     POSIX_GUARD(s2n_hmac_update(mac, sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
 
-    POSIX_GUARD(s2n_stuffer_resize_if_empty(&conn->out, S2N_LARGE_RECORD_LENGTH));
+    POSIX_GUARD_RESULT(s2n_connection_acquire_record_buffer(conn, &conn->out, S2N_LARGE_RECORD_LENGTH));
+    POSIX_GUARD(s2n_stuffer_reserve_space(&conn->out, S2N_TLS_MAX_RECORD_LEN_FOR(data_bytes_to_take)));
+
+    /* The record is assembled in the unused space at the end of conn->out, behind any
+     * records that are still waiting to be flushed.
+     */
+    struct s2n_blob record_blob = { 0 };
+    struct s2n_stuffer record = { 0 };
+    POSIX_GUARD(s2n_blob_slice(&conn->out.blob, &record_blob, conn->out.write_cursor, s2n_stuffer_space_remaining(&conn->out)));
+    POSIX_GUARD(s2n_stuffer_init(&record, &record_blob));
 
     /* Now that we know the length, start writing the record */
-    POSIX_GUARD(s2n_stuffer_write_uint8(&conn->out, is_tls13_record ?
+    POSIX_GUARD(s2n_stuffer_write_uint8(&record, is_tls13_record ?
         /* tls 1.3 opaque type */ TLS_APPLICATION_DATA :
         /* actual content_type */ content_type ));
-    POSIX_GUARD(s2n_record_write_protocol_version(conn));
+    POSIX_GUARD(s2n_record_write_protocol_version(conn, &record));
 
     /* First write a header that has the payload length, this is for the MAC */
-    POSIX_GUARD(s2n_stuffer_write_uint16(&conn->out, data_bytes_to_take));
+    POSIX_GUARD(s2n_stuffer_write_uint16(&record, data_bytes_to_take));
 
     if (conn->actual_protocol_version > S2N_SSLv3) {
-        POSIX_GUARD(s2n_hmac_update(mac, conn->out.blob.data, S2N_TLS_RECORD_HEADER_LENGTH));
+        POSIX_GUARD(s2n_hmac_update(mac, record.blob.data, S2N_TLS_RECORD_HEADER_LENGTH));
     } else {
         /* SSLv3 doesn't include the protocol version in the MAC */
-        POSIX_GUARD(s2n_hmac_update(mac, conn->out.blob.data, 1));
-        POSIX_GUARD(s2n_hmac_update(mac, conn->out.blob.data + 3, 2));
+        POSIX_GUARD(s2n_hmac_update(mac, record.blob.data, 1));
+        POSIX_GUARD(s2n_hmac_update(mac, record.blob.data + 3, 2));
     }
 
     /* Compute non-payload parts of the MAC(seq num, type, proto vers, fragment length) for composite ciphers.
@@ -295,8 +343,8 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
     /* ensure actual_fragment_length + S2N_TLS_RECORD_HEADER_LENGTH <= max record length */
     const uint16_t max_record_length = is_tls13_record ? S2N_TLS13_MAXIMUM_RECORD_LENGTH : S2N_TLS_MAXIMUM_RECORD_LENGTH;
     S2N_ERROR_IF(actual_fragment_length + S2N_TLS_RECORD_HEADER_LENGTH > max_record_length, S2N_ERR_RECORD_LENGTH_TOO_LARGE);
-    POSIX_GUARD(s2n_stuffer_wipe_n(&conn->out, 2));
-    POSIX_GUARD(s2n_stuffer_write_uint16(&conn->out, actual_fragment_length));
+    POSIX_GUARD(s2n_stuffer_wipe_n(&record, 2));
+    POSIX_GUARD(s2n_stuffer_write_uint16(&record, actual_fragment_length));
 
     /* If we're AEAD, write the sequence number as an IV, and generate the AAD */
     if (cipher_suite->record_alg->cipher->type == S2N_AEAD) {
@@ -306,7 +354,7 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
 
         if (cipher_suite->record_alg->flags & S2N_TLS12_AES_GCM_AEAD_NONCE) {
             /* Partially explicit nonce. See RFC 5288 Section 3 */
-            POSIX_GUARD(s2n_stuffer_write_bytes(&conn->out, sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
+            POSIX_GUARD(s2n_stuffer_write_bytes(&record, sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
             POSIX_GUARD(s2n_stuffer_write_bytes(&iv_stuffer, implicit_iv, cipher_suite->record_alg->cipher->io.aead.fixed_iv_size));
             POSIX_GUARD(s2n_stuffer_write_bytes(&iv_stuffer, sequence_number, S2N_TLS_SEQUENCE_NUM_LEN));
         } else if (cipher_suite->record_alg->flags & S2N_TLS12_CHACHA_POLY_AEAD_NONCE || is_tls13_record) {
@@ -355,12 +403,12 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
                 uint8_t zero_block[S2N_TLS_MAX_IV_LEN] = { 0 };
                 POSIX_GUARD(s2n_blob_init(&explicit_iv_placeholder, zero_block, block_size));
                 POSIX_GUARD_RESULT(s2n_get_public_random_data(&explicit_iv_placeholder));
-                POSIX_GUARD(s2n_stuffer_write(&conn->out, &explicit_iv_placeholder));
+                POSIX_GUARD(s2n_stuffer_write(&record, &explicit_iv_placeholder));
             } else {
                 /* We can write the explicit IV directly to the record for non composite CBC because
                  * s2n starts AES *after* the explicit IV.
                  */
-                POSIX_GUARD(s2n_stuffer_write(&conn->out, &iv));
+                POSIX_GUARD(s2n_stuffer_write(&record, &iv));
             }
         }
     }
@@ -369,13 +417,19 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
     struct s2n_blob seq = {.data = sequence_number,.size = S2N_TLS_SEQUENCE_NUM_LEN };
     POSIX_GUARD(s2n_increment_sequence_number(&seq));
 
-    /* Write the plaintext data */
-    POSIX_GUARD(s2n_stuffer_writev_bytes(&conn->out, in, in_count, offs, data_bytes_to_take));
-    void *orig_write_ptr = conn->out.blob.data + conn->out.write_cursor - data_bytes_to_take;
+    /* Write the plaintext data. If the caller already placed the plaintext inside
+     * the record (see s2n_send_reserve), it only needs to be accounted for.
+     */
+    if (in_count == 1 && (uint8_t *) in[0].iov_base + offs == record.blob.data + record.write_cursor) {
+        POSIX_GUARD(s2n_stuffer_skip_write(&record, data_bytes_to_take));
+    } else {
+        POSIX_GUARD(s2n_stuffer_writev_bytes(&record, in, in_count, offs, data_bytes_to_take));
+    }
+    void *orig_write_ptr = record.blob.data + record.write_cursor - data_bytes_to_take;
     POSIX_GUARD(s2n_hmac_update(mac, orig_write_ptr, data_bytes_to_take));
 
     /* Write the digest */
-    uint8_t *digest = s2n_stuffer_raw_write(&conn->out, mac_digest_size);
+    uint8_t *digest = s2n_stuffer_raw_write(&record, mac_digest_size);
     POSIX_ENSURE_REF(digest);
 
     POSIX_GUARD(s2n_hmac_digest(mac, digest, mac_digest_size));
@@ -383,7 +437,7 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
 
     /* Write content type for TLS 1.3 record (RFC 8446 Section 5.2) */
     if (is_tls13_record) {
-        POSIX_GUARD(s2n_stuffer_write_uint8(&conn->out, content_type));
+        POSIX_GUARD(s2n_stuffer_write_uint8(&record, content_type));
     }
 
     if (cipher_suite->record_alg->cipher->type == S2N_CBC) {
@@ -391,20 +445,20 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
          * include an extra padding length byte, also with the value 'p'.
          */
         for (int i = 0; i <= padding; i++) {
-            POSIX_GUARD(s2n_stuffer_write_uint8(&conn->out, padding));
+            POSIX_GUARD(s2n_stuffer_write_uint8(&record, padding));
         }
     }
 
     /* Rewind to rewrite/encrypt the packet */
-    POSIX_GUARD(s2n_stuffer_rewrite(&conn->out));
+    POSIX_GUARD(s2n_stuffer_rewrite(&record));
 
     /* Skip the header */
-    POSIX_GUARD(s2n_stuffer_skip_write(&conn->out, S2N_TLS_RECORD_HEADER_LENGTH));
+    POSIX_GUARD(s2n_stuffer_skip_write(&record, S2N_TLS_RECORD_HEADER_LENGTH));
 
     uint16_t encrypted_length = data_bytes_to_take + mac_digest_size;
     switch (cipher_suite->record_alg->cipher->type) {
     case S2N_AEAD:
-        POSIX_GUARD(s2n_stuffer_skip_write(&conn->out, cipher_suite->record_alg->cipher->io.aead.record_iv_size));
+        POSIX_GUARD(s2n_stuffer_skip_write(&record, cipher_suite->record_alg->cipher->io.aead.record_iv_size));
         encrypted_length += cipher_suite->record_alg->cipher->io.aead.tag_size;
         if (is_tls13_record) {
             /* one extra byte for content type */
@@ -414,7 +468,7 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
     case S2N_CBC:
         if (conn->actual_protocol_version > S2N_TLS10) {
             /* Leave the IV alone and unencrypted */
-            POSIX_GUARD(s2n_stuffer_skip_write(&conn->out, iv.size));
+            POSIX_GUARD(s2n_stuffer_skip_write(&record, iv.size));
         }
         /* Encrypt the padding and the padding length byte too */
         encrypted_length += padding + 1;
@@ -430,12 +484,15 @@ int s2n_record_writev(struct s2n_connection *conn, uint8_t content_type, const s
     }
 
     /* Check that stuffer have enough space to write encrypted record, because raw_write cannot expand tainted stuffer */
-    S2N_ERROR_IF(s2n_stuffer_space_remaining(&conn->out) < encrypted_length, S2N_ERR_RECORD_STUFFER_SIZE);
+    S2N_ERROR_IF(s2n_stuffer_space_remaining(&record) < encrypted_length, S2N_ERR_RECORD_STUFFER_SIZE);
 
     /* Do the encryption */
-    struct s2n_blob en = { .size = encrypted_length, .data = s2n_stuffer_raw_write(&conn->out, encrypted_length) };
+    struct s2n_blob en = { .size = encrypted_length, .data = s2n_stuffer_raw_write(&record, encrypted_length) };
     POSIX_GUARD(s2n_record_encrypt(conn, cipher_suite, session_key, &iv, &aad, &en, implicit_iv, block_size));
 
+    /* The finished record is now ready to be flushed along with anything already pending */
+    POSIX_GUARD(s2n_stuffer_skip_write(&conn->out, s2n_stuffer_data_available(&record)));
+
     if (conn->actual_protocol_version == S2N_TLS13 && content_type == TLS_CHANGE_CIPHER_SPEC) {
         conn->client = current_client_crypto;
         conn->server = current_server_crypto;
@@ -26,6 +26,7 @@
 
 #include "tls/s2n_connection.h"
 #include "tls/s2n_handshake.h"
+#include "tls/s2n_ktls.h"
 #include "tls/s2n_record.h"
 #include "tls/s2n_resume.h"
 #include "tls/s2n_alerts.h"
@@ -43,8 +44,28 @@ S2N_RESULT s2n_read_in_bytes(struct s2n_connection *conn, struct s2n_stuffer *ou
     while (s2n_stuffer_data_available(output) < length) {
         uint32_t remaining = length - s2n_stuffer_data_available(output);
 
+        /* Consume any data that was already read ahead before going back to the network */
+        uint32_t buffered = MIN(s2n_stuffer_data_available(&conn->buffer_in), remaining);
+        if (buffered) {
+            RESULT_GUARD_POSIX(s2n_stuffer_reserve_space(output, buffered));
+            RESULT_GUARD_POSIX(s2n_stuffer_copy(&conn->buffer_in, output, buffered));
+            continue;
+        }
+
+        /* With read-ahead buffering, read as much as the buffer allows so that the following
+         * headers and records can be parsed without another call to recv. Reads that would not
+         * fit in the buffer go directly to the output.
+         */
+        struct s2n_stuffer *read_into = output;
+        uint32_t read_size = remaining;
+        if (conn->recv_buffer_size > remaining) {
+            RESULT_GUARD_POSIX(s2n_stuffer_rewrite(&conn->buffer_in));
+            read_into = &conn->buffer_in;
+            read_size = conn->recv_buffer_size;
+        }
+
         errno = 0;
-        int r = s2n_connection_recv_stuffer(output, conn, remaining);
+        int r = s2n_connection_recv_stuffer(read_into, conn, read_size);
         if (r == 0) {
             conn->closed = 1;
             RESULT_BAIL(S2N_ERR_CLOSED);
@@ -70,7 +91,12 @@ int s2n_read_full_record(struct s2n_connection *conn, uint8_t * record_type, int
         *record_type = TLS_APPLICATION_DATA;
         return S2N_SUCCESS;
     }
-    POSIX_GUARD(s2n_stuffer_resize_if_empty(&conn->in, S2N_LARGE_FRAGMENT_LENGTH));
+    POSIX_GUARD_RESULT(s2n_connection_acquire_record_buffer(conn, &conn->in, S2N_LARGE_FRAGMENT_LENGTH));
+
+    /* With kTLS, the kernel has already parsed and decrypted the record */
+    if (conn->ktls_recv_enabled) {
+        return s2n_ktls_read_full_record(conn, record_type);
+    }
 
     /* Read the record until we at least have a header */
     POSIX_GUARD_RESULT(s2n_read_in_bytes(conn, &conn->header_in, S2N_TLS_RECORD_HEADER_LENGTH));
@@ -117,11 +143,88 @@ int s2n_read_full_record(struct s2n_connection *conn, uint8_t * record_type, int
     return 0;
 }
 
+/* Handles a record that does not carry application data, such as an alert or a post-handshake message */
+static int s2n_recv_process_control_record(struct s2n_connection *conn, uint8_t record_type, s2n_blocked_status *blocked)
+{
+    switch (record_type)
+    {
+        case TLS_ALERT:
+            POSIX_GUARD(s2n_process_alert_fragment(conn));
+            POSIX_GUARD(s2n_flush(conn, blocked));
+            break;
+        case TLS_HANDSHAKE:
+            POSIX_GUARD(s2n_post_handshake_recv(conn));
+            break;
+    }
+    POSIX_GUARD(s2n_stuffer_wipe(&conn->header_in));
+    POSIX_GUARD(s2n_stuffer_wipe(&conn->in));
+    conn->in_status = ENCRYPTED;
+
+    return S2N_SUCCESS;
+}
+
+static void s2n_recv_invalidate_cached_session(struct s2n_connection *conn)
+{
+    if (s2n_errno != S2N_ERR_IO_BLOCKED && s2n_allowed_to_cache_connection(conn) && conn->session_id_len) {
+        s2n_delete_from_cache(conn);
+    }
+}
+
+/* Reports an error that a previous call deferred so that it could return the data it had already read */
+static int s2n_recv_check_deferred_error(struct s2n_connection *conn)
+{
+    int error = conn->recv_deferred_error;
+    if (error) {
+        conn->recv_deferred_error = 0;
+        POSIX_BAIL(error);
+    }
+    return S2N_SUCCESS;
+}
+
+/* Whether a complete record has already been read ahead from the network,
+ * so that it can be parsed without calling recv again */
+static bool s2n_recv_has_buffered_record(struct s2n_connection *conn)
+{
+    uint32_t available = s2n_stuffer_data_available(&conn->buffer_in);
+    if (available < S2N_TLS_RECORD_HEADER_LENGTH) {
+        return false;
+    }
+
+    const uint8_t *header = conn->buffer_in.blob.data + conn->buffer_in.read_cursor;
+    /* SSLv2 records are only valid as the first message of a handshake */
+    if (header[0] & 0x80) {
+        return false;
+    }
+    uint16_t fragment_length = ((uint16_t) header[3] << 8) | header[4];
+    return available - S2N_TLS_RECORD_HEADER_LENGTH >= fragment_length;
+}
+
+/* Reads the next record and handles it if it does not carry application data */
+static int s2n_recv_next_record(struct s2n_connection *conn, uint8_t *record_type, s2n_blocked_status *blocked)
+{
+    int isSSLv2 = 0;
+    if (s2n_read_full_record(conn, record_type, &isSSLv2) < 0) {
+        if (s2n_errno != S2N_ERR_CLOSED) {
+            s2n_recv_invalidate_cached_session(conn);
+        }
+        S2N_ERROR_PRESERVE_ERRNO();
+    }
+
+    POSIX_ENSURE(!isSSLv2, S2N_ERR_BAD_MESSAGE);
+
+    if (*record_type != TLS_APPLICATION_DATA) {
+        POSIX_GUARD(s2n_recv_process_control_record(conn, *record_type, blocked));
+    }
+    return S2N_SUCCESS;
+}
+
 ssize_t s2n_recv_impl(struct s2n_connection * conn, void *buf, ssize_t size, s2n_blocked_status * blocked)
 {
     ssize_t bytes_read = 0;
     struct s2n_blob out = {.data = (uint8_t *) buf };
 
+    POSIX_GUARD(s2n_recv_check_deferred_error(conn));
+
     if (conn->closed) {
         return 0;
     }
@@ -130,49 +233,29 @@ ssize_t s2n_recv_impl(struct s2n_connection * conn, void *buf, ssize_t size, s2n
     S2N_ERROR_IF(conn->config->quic_enabled, S2N_ERR_UNSUPPORTED_WITH_QUIC);
 
     while (size && !conn->closed) {
-        int isSSLv2 = 0;
         uint8_t record_type;
-        int r = s2n_read_full_record(conn, &record_type, &isSSLv2);
-        if (r < 0) {
+        if (s2n_recv_next_record(conn, &record_type, blocked) < 0) {
             if (s2n_errno == S2N_ERR_CLOSED) {
                 *blocked = S2N_NOT_BLOCKED;
-                if (!bytes_read) {
-                    return 0;
-                } else {
-                    return bytes_read;
-                }
-            }
-
-            /* Don't propagate the error if we already read some bytes */
-            if (s2n_errno == S2N_ERR_IO_BLOCKED && bytes_read) {
-                s2n_errno = S2N_ERR_OK;
                 return bytes_read;
             }
 
-            /* If we get here, it's an error condition */
-            if (s2n_errno != S2N_ERR_IO_BLOCKED && s2n_allowed_to_cache_connection(conn) && conn->session_id_len) {
-                conn->config->cache_delete(conn, conn->config->cache_delete_data, conn->session_id, conn->session_id_len);
+            if (!bytes_read) {
+                S2N_ERROR_PRESERVE_ERRNO();
             }
 
-            S2N_ERROR_PRESERVE_ERRNO();
+            /* Don't lose the data we already read. Blocking errors are simply retried by the next
+             * call, but anything else is reported by the next call once this data is returned.
+             */
+            if (!S2N_ERROR_IS_BLOCKING(s2n_errno)) {
+                conn->recv_deferred_error = s2n_errno;
+            }
+            s2n_errno = S2N_ERR_OK;
+            *blocked = S2N_NOT_BLOCKED;
+            return bytes_read;
         }
 
-        S2N_ERROR_IF(isSSLv2, S2N_ERR_BAD_MESSAGE);
-
         if (record_type != TLS_APPLICATION_DATA) {
-            switch (record_type)
-            {
-                case TLS_ALERT:
-                    POSIX_GUARD(s2n_process_alert_fragment(conn));
-                    POSIX_GUARD(s2n_flush(conn, blocked));
-                    break;
-                case TLS_HANDSHAKE:
-                    POSIX_GUARD(s2n_post_handshake_recv(conn));
-                    break;
-            }
-            POSIX_GUARD(s2n_stuffer_wipe(&conn->header_in));
-            POSIX_GUARD(s2n_stuffer_wipe(&conn->in));
-            conn->in_status = ENCRYPTED;
             continue;
         }
 
@@ -191,8 +274,11 @@ ssize_t s2n_recv_impl(struct s2n_connection * conn, void *buf, ssize_t size, s2n
             conn->in_status = ENCRYPTED;
         }
 
-        /* If we've read some data, return it */
-        if (bytes_read) {
+        /* If we've read some data, return it. With multi-record reads enabled, keep going while
+         * the next record has already been read ahead, so that we never wait on the network
+         * while holding data for the caller.
+         */
+        if (bytes_read && !(conn->config->recv_multi_record && s2n_recv_has_buffered_record(conn))) {
             break;
         }
     }
@@ -210,13 +296,106 @@ ssize_t s2n_recv(struct s2n_connection * conn, void *buf, ssize_t size, s2n_bloc
     conn->recv_in_use = true;
     ssize_t result = s2n_recv_impl(conn, buf, size, blocked);
     conn->recv_in_use = false;
+    POSIX_GUARD_RESULT(s2n_connection_release_record_buffers(conn));
     return result;
 }
 
+static int s2n_recv_view_impl(struct s2n_connection *conn, const uint8_t **data, uint32_t *size, s2n_blocked_status *blocked)
+{
+    *data = NULL;
+    *size = 0;
+
+    POSIX_GUARD(s2n_recv_check_deferred_error(conn));
+
+    if (conn->closed) {
+        return S2N_SUCCESS;
+    }
+    *blocked = S2N_BLOCKED_ON_READ;
+
+    S2N_ERROR_IF(conn->config->quic_enabled, S2N_ERR_UNSUPPORTED_WITH_QUIC);
+
+    /* Read records until there is decrypted application data to lend out */
+    while (!conn->closed && (conn->in_status != PLAINTEXT || s2n_stuffer_data_available(&conn->in) == 0)) {
+        int isSSLv2 = 0;
+        uint8_t record_type;
+        if (s2n_read_full_record(conn, &record_type, &isSSLv2) < 0) {
+            if (s2n_errno == S2N_ERR_CLOSED) {
+                *blocked = S2N_NOT_BLOCKED;
+                return S2N_SUCCESS;
+            }
+
+            s2n_recv_invalidate_cached_session(conn);
+            S2N_ERROR_PRESERVE_ERRNO();
+        }
+
+        S2N_ERROR_IF(isSSLv2, S2N_ERR_BAD_MESSAGE);
+
+        /* Empty application data records are discarded like control records */
+        if (record_type != TLS_APPLICATION_DATA || s2n_stuffer_data_available(&conn->in) == 0) {
+            POSIX_GUARD(s2n_recv_process_control_record(conn, record_type, blocked));
+        }
+    }
+
+    *blocked = S2N_NOT_BLOCKED;
+    if (conn->closed) {
+        return S2N_SUCCESS;
+    }
+
+    *data = conn->in.blob.data + conn->in.read_cursor;
+    *size = s2n_stuffer_data_available(&conn->in);
+    return S2N_SUCCESS;
+}
+
+int s2n_recv_view(struct s2n_connection *conn, const uint8_t **data, uint32_t *size, s2n_blocked_status *blocked)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_REF(data);
+    POSIX_ENSURE_REF(size);
+    POSIX_ENSURE_REF(blocked);
+
+    POSIX_ENSURE(!conn->recv_in_use, S2N_ERR_REENTRANCY);
+    conn->recv_in_use = true;
+    int result = s2n_recv_view_impl(conn, data, size, blocked);
+    conn->recv_in_use = false;
+    POSIX_GUARD_RESULT(s2n_connection_release_record_buffers(conn));
+    return result;
+}
+
+int s2n_recv_consume(struct s2n_connection *conn, uint32_t size)
+{
+    POSIX_ENSURE_REF(conn);
+
+    /* Consuming from within a recv callback would modify conn->in while a record is read into it */
+    POSIX_ENSURE(!conn->recv_in_use, S2N_ERR_REENTRANCY);
+    if (size == 0) {
+        return S2N_SUCCESS;
+    }
+
+    /* Only decrypted application data can be consumed */
+    POSIX_ENSURE(conn->in_status == PLAINTEXT, S2N_ERR_INVALID_STATE);
+    POSIX_ENSURE(size <= s2n_stuffer_data_available(&conn->in), S2N_ERR_INVALID_ARGUMENT);
+
+    POSIX_GUARD(s2n_stuffer_skip_read(&conn->in, size));
+
+    /* Once the record is fully consumed, the plaintext is wiped and the next record can be read */
+    if (s2n_stuffer_data_available(&conn->in) == 0) {
+        POSIX_GUARD(s2n_stuffer_wipe(&conn->header_in));
+        POSIX_GUARD(s2n_stuffer_wipe(&conn->in));
+        conn->in_status = ENCRYPTED;
+        POSIX_GUARD_RESULT(s2n_connection_release_record_buffers(conn));
+    }
+
+    return S2N_SUCCESS;
+}
+
 uint32_t s2n_peek(struct s2n_connection *conn) {
     return s2n_stuffer_data_available(&conn->in);
 }
 
+uint32_t s2n_peek_buffered(struct s2n_connection *conn) {
+    return s2n_stuffer_data_available(&conn->buffer_in);
+}
+
 int s2n_recv_close_notify(struct s2n_connection *conn, s2n_blocked_status * blocked)
 {
     uint8_t record_type;
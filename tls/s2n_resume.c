@@ -12,7 +12,7 @@
  * express or implied. See the License for the specific language governing
  * permissions and limitations under the License.
  */
-#include <math.h>
+#include <stdlib.h>
 
 #include <s2n.h>
 
@@ -20,6 +20,7 @@
 #include "stuffer/s2n_stuffer.h"
 #include "utils/s2n_safety.h"
 #include "utils/s2n_blob.h"
+#include "utils/s2n_map.h"
 #include "utils/s2n_random.h"
 #include "utils/s2n_set.h"
 
@@ -27,6 +28,7 @@
 #include "tls/s2n_connection.h"
 #include "tls/s2n_resume.h"
 #include "tls/s2n_crypto.h"
+#include "tls/s2n_session_cache.h"
 #include "tls/s2n_tls.h"
 
 int s2n_allowed_to_cache_connection(struct s2n_connection *conn)
@@ -43,6 +45,11 @@ int s2n_allowed_to_cache_connection(struct s2n_connection *conn)
     return config->use_session_cache;
 }
 
+bool s2n_config_has_session_cache_callbacks(struct s2n_config *config)
+{
+    return config->cache_store && config->cache_retrieve && config->cache_delete;
+}
+
 static int s2n_tls12_serialize_resumption_state(struct s2n_connection *conn, struct s2n_stuffer *to)
 {
     POSIX_ENSURE_REF(conn);
@@ -297,17 +304,38 @@ int s2n_resume_from_cache(struct s2n_connection *conn)
     S2N_ERROR_IF(conn->session_id_len == 0, S2N_ERR_SESSION_ID_TOO_SHORT);
     S2N_ERROR_IF(conn->session_id_len > S2N_TLS_SESSION_ID_MAX_LEN, S2N_ERR_SESSION_ID_TOO_LONG);
 
+    struct s2n_config *config = conn->config;
+    POSIX_ENSURE_REF(config);
+
     uint8_t data[S2N_TLS12_TICKET_SIZE_IN_BYTES] = { 0 };
     struct s2n_blob entry = {0};
     POSIX_GUARD(s2n_blob_init(&entry, data, S2N_TLS12_TICKET_SIZE_IN_BYTES));
-    uint64_t size = entry.size;
-    int result = conn->config->cache_retrieve(conn, conn->config->cache_retrieve_data, conn->session_id, conn->session_id_len, entry.data, &size);
-    if (result == S2N_CALLBACK_BLOCKED) {
-        POSIX_BAIL(S2N_ERR_ASYNC_BLOCKED);
+
+    /* The built-in cache answers first; the callbacks only see the sessions it misses */
+    bool found = false;
+    uint64_t now = 0;
+    if (config->session_cache) {
+        POSIX_GUARD(config->wall_clock(config->sys_clock_ctx, &now));
+        POSIX_GUARD_RESULT(s2n_session_cache_retrieve(config->session_cache, now, conn->session_id, conn->session_id_len, &entry, &found));
     }
-    POSIX_GUARD(result);
 
-    S2N_ERROR_IF(size != entry.size, S2N_ERR_SIZE_MISMATCH);
+    if (!found) {
+        POSIX_ENSURE(s2n_config_has_session_cache_callbacks(config), S2N_ERR_SESSION_NOT_CACHED);
+
+        uint64_t size = entry.size;
+        int result = config->cache_retrieve(conn, config->cache_retrieve_data, conn->session_id, conn->session_id_len, entry.data, &size);
+        if (result == S2N_CALLBACK_BLOCKED) {
+            POSIX_BAIL(S2N_ERR_ASYNC_BLOCKED);
+        }
+        POSIX_GUARD(result);
+
+        S2N_ERROR_IF(size != entry.size, S2N_ERR_SIZE_MISMATCH);
+
+        if (config->session_cache) {
+            POSIX_GUARD_RESULT(s2n_session_cache_store(config->session_cache, now, config->session_state_lifetime_in_nanos,
+                    conn->session_id, conn->session_id_len, &entry));
+        }
+    }
 
     struct s2n_stuffer from = {0};
     POSIX_GUARD(s2n_stuffer_init(&from, &entry));
@@ -333,7 +361,32 @@ int s2n_store_to_cache(struct s2n_connection *conn)
     POSIX_GUARD(s2n_encrypt_session_cache(conn, &to));
 
     /* Store to the cache */
-    conn->config->cache_store(conn, conn->config->cache_store_data, S2N_TLS_SESSION_CACHE_TTL, conn->session_id, conn->session_id_len, entry.data, entry.size);
+    struct s2n_config *config = conn->config;
+    if (config->session_cache) {
+        uint64_t now = 0;
+        POSIX_GUARD(config->wall_clock(config->sys_clock_ctx, &now));
+        POSIX_GUARD_RESULT(s2n_session_cache_store(config->session_cache, now, config->session_state_lifetime_in_nanos,
+                conn->session_id, conn->session_id_len, &entry));
+    }
+    if (s2n_config_has_session_cache_callbacks(config)) {
+        config->cache_store(conn, config->cache_store_data, S2N_TLS_SESSION_CACHE_TTL, conn->session_id, conn->session_id_len, entry.data, entry.size);
+    }
+
+    return 0;
+}
+
+int s2n_delete_from_cache(struct s2n_connection *conn)
+{
+    POSIX_ENSURE_REF(conn);
+    struct s2n_config *config = conn->config;
+    POSIX_ENSURE_REF(config);
+
+    if (config->session_cache) {
+        POSIX_GUARD_RESULT(s2n_session_cache_delete(config->session_cache, conn->session_id, conn->session_id_len));
+    }
+    if (s2n_config_has_session_cache_callbacks(config)) {
+        config->cache_delete(conn, config->cache_delete_data, conn->session_id, conn->session_id_len);
+    }
 
     return 0;
 }
@@ -417,81 +470,184 @@ int s2n_connection_is_ocsp_stapled(struct s2n_connection *conn)
     }
 }
 
-int s2n_config_is_encrypt_decrypt_key_available(struct s2n_config *config)
+static int s2n_ticket_key_epoch_start_comparator(const void *a, const void *b)
 {
-    uint64_t now;
-    struct s2n_ticket_key *ticket_key = NULL;
-    POSIX_GUARD(config->wall_clock(config->sys_clock_ctx, &now));
-    POSIX_ENSURE_REF(config->ticket_keys);
+    const uint64_t start_a = *(const uint64_t *) a;
+    const uint64_t start_b = *(const uint64_t *) b;
+
+    if (start_a < start_b) {
+        return -1;
+    }
+    return start_a > start_b;
+}
+
+/* Rebuilds the name index and the encrypt-decrypt epochs of config->ticket_keys, so
+ * that handshakes can find a key without scanning every key in the config.
+ *
+ * The index is freed and reallocated, so it is only rebuilt by the config APIs that
+ * change the ticket keys or their lifetimes. Handshakes only read it.
+ */
+S2N_RESULT s2n_config_update_ticket_key_index(struct s2n_config *config)
+{
+    RESULT_ENSURE_REF(config);
+
+    if (config->ticket_key_names != NULL) {
+        RESULT_GUARD(s2n_map_free(config->ticket_key_names));
+        config->ticket_key_names = NULL;
+    }
+    config->ticket_key_epoch_count = 0;
+
+    if (config->ticket_keys == NULL) {
+        return S2N_RESULT_OK;
+    }
 
     uint32_t ticket_keys_len = 0;
-    POSIX_GUARD_RESULT(s2n_set_len(config->ticket_keys, &ticket_keys_len));
+    RESULT_GUARD(s2n_set_len(config->ticket_keys, &ticket_keys_len));
+    RESULT_ENSURE_LTE(ticket_keys_len, S2N_MAX_TICKET_KEYS);
+
+    RESULT_ENSURE_REF(config->ticket_key_names = s2n_map_new_with_initial_capacity(S2N_MAX_TICKET_KEYS * 2));
 
-    for (uint32_t i = ticket_keys_len; i > 0; i--) {
-        uint32_t idx = i - 1;
-        POSIX_GUARD_RESULT(s2n_set_get(config->ticket_keys, idx, (void **)&ticket_key));
-        uint64_t key_intro_time = ticket_key->intro_timestamp;
+    /* A key is in encrypt-decrypt state while intro_timestamp < now < intro_timestamp + lifetime,
+     * so the set of encrypt-decrypt keys only changes at those two points in time.
+     */
+    uint64_t epoch_starts[S2N_MAX_TICKET_KEY_EPOCHS] = { 0 };
+    uint32_t epoch_starts_len = 1;
 
-        if (key_intro_time < now
-                && now < key_intro_time + config->encrypt_decrypt_key_lifetime_in_nanos) {
-            return 1;
+    for (uint32_t i = 0; i < ticket_keys_len; i++) {
+        struct s2n_ticket_key *ticket_key = NULL;
+        RESULT_GUARD(s2n_set_get(config->ticket_keys, i, (void **)&ticket_key));
+
+        uint8_t index = i;
+        struct s2n_blob name = { 0 };
+        struct s2n_blob value = { 0 };
+        RESULT_GUARD_POSIX(s2n_blob_init(&name, ticket_key->key_name, S2N_TICKET_KEY_NAME_LEN));
+        RESULT_GUARD_POSIX(s2n_blob_init(&value, &index, sizeof(index)));
+        RESULT_GUARD(s2n_map_add(config->ticket_key_names, &name, &value));
+
+        epoch_starts[epoch_starts_len++] = ticket_key->intro_timestamp + 1;
+        epoch_starts[epoch_starts_len++] = ticket_key->intro_timestamp + config->encrypt_decrypt_key_lifetime_in_nanos;
+    }
+    RESULT_GUARD(s2n_map_complete(config->ticket_key_names));
+
+    qsort(epoch_starts, epoch_starts_len, sizeof(epoch_starts[0]), s2n_ticket_key_epoch_start_comparator);
+
+    for (uint32_t i = 0; i < epoch_starts_len; i++) {
+        const uint64_t start = epoch_starts[i];
+        struct s2n_ticket_key_epoch epoch = { .start = start };
+
+        for (uint32_t j = 0; j < ticket_keys_len; j++) {
+            struct s2n_ticket_key *ticket_key = NULL;
+            RESULT_GUARD(s2n_set_get(config->ticket_keys, j, (void **)&ticket_key));
+
+            if (ticket_key->intro_timestamp < start
+                    && start < ticket_key->intro_timestamp + config->encrypt_decrypt_key_lifetime_in_nanos) {
+                if (epoch.key_count == 0) {
+                    epoch.first_key = j;
+                }
+                epoch.key_count++;
+            }
         }
+
+        /* Merge epochs that have the same keys */
+        if (config->ticket_key_epoch_count > 0) {
+            struct s2n_ticket_key_epoch *last = &config->ticket_key_epochs[config->ticket_key_epoch_count - 1];
+            if (last->first_key == epoch.first_key && last->key_count == epoch.key_count) {
+                continue;
+            }
+        }
+
+        config->ticket_key_epochs[config->ticket_key_epoch_count++] = epoch;
     }
 
-    return 0;
+    return S2N_RESULT_OK;
+}
+
+static S2N_RESULT s2n_config_get_ticket_key_epoch(struct s2n_config *config, uint64_t now, struct s2n_ticket_key_epoch *epoch)
+{
+    RESULT_ENSURE_REF(config);
+    RESULT_ENSURE_REF(epoch);
+
+    *epoch = (struct s2n_ticket_key_epoch) { 0 };
+
+    /* Find the last epoch that starts at or before now. The first epoch starts at 0. */
+    uint32_t low = 0;
+    uint32_t high = config->ticket_key_epoch_count;
+    while (high - low > 1) {
+        uint32_t mid = low + (high - low) / 2;
+        if (config->ticket_key_epochs[mid].start <= now) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (config->ticket_key_epoch_count > 0) {
+        *epoch = config->ticket_key_epochs[low];
+    }
+
+    return S2N_RESULT_OK;
+}
+
+int s2n_config_is_encrypt_decrypt_key_available(struct s2n_config *config)
+{
+    uint64_t now;
+    POSIX_GUARD(config->wall_clock(config->sys_clock_ctx, &now));
+
+    struct s2n_ticket_key_epoch epoch = { 0 };
+    POSIX_GUARD_RESULT(s2n_config_get_ticket_key_epoch(config, now, &epoch));
+
+    return epoch.key_count > 0;
 }
 
 /* This function is used in s2n_get_ticket_encrypt_decrypt_key to compute the weight
  * of the keys and to choose a single key from all of the encrypt-decrypt keys.
  * Higher the weight of the key, higher the probability of being picked.
  */
-int s2n_compute_weight_of_encrypt_decrypt_keys(struct s2n_config *config,
-                                               uint8_t *encrypt_decrypt_keys_index,
-                                               uint8_t num_encrypt_decrypt_keys,
-                                               uint64_t now)
+static S2N_RESULT s2n_compute_weight_of_encrypt_decrypt_keys(struct s2n_config *config,
+                                                             struct s2n_ticket_key_epoch *epoch,
+                                                             uint64_t now,
+                                                             uint8_t *key_index)
 {
-    double total_weight = 0;
-    struct s2n_ticket_key_weight ticket_keys_weight[S2N_MAX_TICKET_KEYS];
+    uint64_t key_weights[S2N_MAX_TICKET_KEYS] = { 0 };
+    uint64_t total_weight = 0;
     struct s2n_ticket_key *ticket_key = NULL;
+    const uint64_t half_lifetime = config->encrypt_decrypt_key_lifetime_in_nanos / 2;
+
+    RESULT_ENSURE_LTE(epoch->key_count, S2N_MAX_TICKET_KEYS);
 
     /* Compute weight of encrypt-decrypt keys */
-    for (int i = 0; i < num_encrypt_decrypt_keys; i++) {
-        POSIX_GUARD_RESULT(s2n_set_get(config->ticket_keys, encrypt_decrypt_keys_index[i], (void **)&ticket_key));
+    for (uint8_t i = 0; i < epoch->key_count; i++) {
+        RESULT_GUARD(s2n_set_get(config->ticket_keys, epoch->first_key + i, (void **)&ticket_key));
 
-        uint64_t key_intro_time = ticket_key->intro_timestamp;
-        uint64_t key_encryption_peak_time = key_intro_time + (config->encrypt_decrypt_key_lifetime_in_nanos / 2);
+        uint64_t key_age = now - ticket_key->intro_timestamp;
 
-        /* The % of encryption using this key is linearly increasing */
-        if (now < key_encryption_peak_time) {
-            ticket_keys_weight[i].key_weight = now - key_intro_time;
+        if (key_age < half_lifetime) {
+            /* The % of encryption using this key is linearly increasing */
+            key_weights[i] = key_age;
         } else {
             /* The % of encryption using this key is linearly decreasing */
-            ticket_keys_weight[i].key_weight = (config->encrypt_decrypt_key_lifetime_in_nanos / 2) - (now - key_encryption_peak_time);
+            key_weights[i] = half_lifetime - (key_age - half_lifetime);
         }
 
-        ticket_keys_weight[i].key_index = encrypt_decrypt_keys_index[i];
-        total_weight += ticket_keys_weight[i].key_weight;
+        RESULT_ENSURE(total_weight + key_weights[i] >= total_weight, S2N_ERR_INTEGER_OVERFLOW);
+        total_weight += key_weights[i];
     }
 
-    /* Pick a random number in [0, 1). Using 53 bits (IEEE 754 double-precision floats). */
-    uint64_t random_int = 0;
-    POSIX_GUARD_RESULT(s2n_public_random(pow(2, 53), &random_int));
-    double random = (double)random_int / (double)pow(2, 53);
+    RESULT_ENSURE(total_weight > 0 && total_weight <= INT64_MAX, S2N_ERR_ENCRYPT_DECRYPT_KEY_SELECTION_FAILED);
 
-    /* Compute cumulative weight of encrypt-decrypt keys */
-    for (int i = 0; i < num_encrypt_decrypt_keys; i++) {
-        ticket_keys_weight[i].key_weight = ticket_keys_weight[i].key_weight / total_weight;
+    /* Pick a random point in [0, total_weight) and find the key whose weight covers it */
+    uint64_t random = 0;
+    RESULT_GUARD(s2n_public_random(total_weight, &random));
 
-        if (i > 0) {
-            ticket_keys_weight[i].key_weight += ticket_keys_weight[i - 1].key_weight;
-        }
-
-        if (ticket_keys_weight[i].key_weight > random) {
-            return ticket_keys_weight[i].key_index;
+    for (uint8_t i = 0; i < epoch->key_count; i++) {
+        if (random < key_weights[i]) {
+            *key_index = epoch->first_key + i;
+            return S2N_RESULT_OK;
         }
+        random -= key_weights[i];
     }
 
-    POSIX_BAIL(S2N_ERR_ENCRYPT_DECRYPT_KEY_SELECTION_FAILED);
+    RESULT_BAIL(S2N_ERR_ENCRYPT_DECRYPT_KEY_SELECTION_FAILED);
 }
 
 /* This function is used in s2n_encrypt_session_ticket in order for s2n to
@@ -499,41 +655,24 @@ int s2n_compute_weight_of_encrypt_decrypt_keys(struct s2n_config *config,
  */
 struct s2n_ticket_key *s2n_get_ticket_encrypt_decrypt_key(struct s2n_config *config)
 {
-    uint8_t num_encrypt_decrypt_keys = 0;
-    uint8_t encrypt_decrypt_keys_index[S2N_MAX_TICKET_KEYS] = { 0 };
     struct s2n_ticket_key *ticket_key = NULL;
 
     uint64_t now;
     PTR_GUARD_POSIX(config->wall_clock(config->sys_clock_ctx, &now));
     PTR_ENSURE_REF(config->ticket_keys);
 
-    uint32_t ticket_keys_len = 0;
-    PTR_GUARD_RESULT(s2n_set_len(config->ticket_keys, &ticket_keys_len));
-
-    for (uint32_t i = ticket_keys_len; i > 0; i--) {
-        uint32_t idx = i - 1;
-        PTR_GUARD_RESULT(s2n_set_get(config->ticket_keys, idx, (void **)&ticket_key));
-        uint64_t key_intro_time = ticket_key->intro_timestamp;
+    struct s2n_ticket_key_epoch epoch = { 0 };
+    PTR_GUARD_RESULT(s2n_config_get_ticket_key_epoch(config, now, &epoch));
 
-        if (key_intro_time < now
-                && now < key_intro_time + config->encrypt_decrypt_key_lifetime_in_nanos) {
-            encrypt_decrypt_keys_index[num_encrypt_decrypt_keys] = idx;
-            num_encrypt_decrypt_keys++;
-        }
-    }
-
-    if (num_encrypt_decrypt_keys == 0) {
+    if (epoch.key_count == 0) {
         PTR_BAIL(S2N_ERR_NO_TICKET_ENCRYPT_DECRYPT_KEY);
     }
 
-    if (num_encrypt_decrypt_keys == 1) {
-        PTR_GUARD_RESULT(s2n_set_get(config->ticket_keys, encrypt_decrypt_keys_index[0], (void **)&ticket_key));
-        return ticket_key;
+    uint8_t idx = epoch.first_key;
+    if (epoch.key_count > 1) {
+        PTR_GUARD_RESULT(s2n_compute_weight_of_encrypt_decrypt_keys(config, &epoch, now, &idx));
     }
 
-    int8_t idx;
-    PTR_GUARD_POSIX(idx = s2n_compute_weight_of_encrypt_decrypt_keys(config, encrypt_decrypt_keys_index, num_encrypt_decrypt_keys, now));
-
     PTR_GUARD_RESULT(s2n_set_get(config->ticket_keys, idx, (void **)&ticket_key));
     return ticket_key;
 }
@@ -548,34 +687,99 @@ struct s2n_ticket_key *s2n_find_ticket_key(struct s2n_config *config, const uint
     PTR_GUARD_POSIX(config->wall_clock(config->sys_clock_ctx, &now));
     PTR_ENSURE_REF(config->ticket_keys);
 
-    uint32_t ticket_keys_len = 0;
-    PTR_GUARD_RESULT(s2n_set_len(config->ticket_keys, &ticket_keys_len));
+    if (config->ticket_key_names == NULL) {
+        return NULL;
+    }
 
-    for (uint32_t i = 0; i < ticket_keys_len; i++) {
-        PTR_GUARD_RESULT(s2n_set_get(config->ticket_keys, i, (void **)&ticket_key));
+    struct s2n_blob key_name = { 0 };
+    struct s2n_blob value = { 0 };
+    bool key_found = false;
+    PTR_GUARD_POSIX(s2n_blob_init(&key_name, (uint8_t *) (uintptr_t) name, S2N_TICKET_KEY_NAME_LEN));
+    PTR_GUARD_RESULT(s2n_map_lookup(config->ticket_key_names, &key_name, &value, &key_found));
+    if (!key_found) {
+        return NULL;
+    }
+
+    PTR_ENSURE_EQ(value.size, sizeof(uint8_t));
+    const uint8_t idx = value.data[0];
+    PTR_GUARD_RESULT(s2n_set_get(config->ticket_keys, idx, (void **)&ticket_key));
+
+    /* Check to see if the key has expired. Other connections may still be using the
+     * key's session keys, so it is only removed by s2n_config_add_ticket_crypto_key,
+     * never from a handshake.
+     */
+    if (now >= ticket_key->intro_timestamp +
+                        config->encrypt_decrypt_key_lifetime_in_nanos + config->decrypt_key_lifetime_in_nanos) {
+        return NULL;
+    }
 
-        if (memcmp(ticket_key->key_name, name, S2N_TICKET_KEY_NAME_LEN) == 0) {
+    return ticket_key;
+}
 
-            /* Check to see if the key has expired */
-            if (now >= ticket_key->intro_timestamp +
-                                config->encrypt_decrypt_key_lifetime_in_nanos + config->decrypt_key_lifetime_in_nanos) {
-                s2n_config_wipe_expired_ticket_crypto_keys(config, i);
+/* The AEAD API contexts are not modified by seal or open, so every connection can
+ * use the ticket key's context directly. An EVP_CIPHER_CTX carries the IV, tag and
+ * GHASH state of the operation in progress, so each connection works on its own
+ * copy of the keyed context instead; copying skips the key schedule and the GHASH
+ * table setup.
+ */
+static S2N_RESULT s2n_ticket_key_get_session_key(struct s2n_session_key *keyed, struct s2n_session_key *scratch,
+        struct s2n_session_key **session_key)
+{
+    RESULT_ENSURE_REF(keyed);
+    RESULT_ENSURE_REF(scratch);
+    RESULT_ENSURE_REF(session_key);
+
+#if defined(S2N_CIPHER_AEAD_API_AVAILABLE)
+    *session_key = keyed;
+#else
+    RESULT_GUARD_POSIX(s2n_session_key_alloc(scratch));
+    RESULT_GUARD_OSSL(EVP_CIPHER_CTX_copy(scratch->evp_cipher_ctx, keyed->evp_cipher_ctx), S2N_ERR_KEY_INIT);
+    *session_key = scratch;
+#endif
 
-                return NULL;
-            }
+    return S2N_RESULT_OK;
+}
 
-            return ticket_key;
-        }
+S2N_RESULT s2n_ticket_key_init_session_keys(struct s2n_ticket_key *key)
+{
+    RESULT_ENSURE_REF(key);
+
+    struct s2n_blob aes_key_blob = { 0 };
+    RESULT_GUARD_POSIX(s2n_blob_init(&aes_key_blob, key->aes_key, S2N_AES256_KEY_LEN));
+
+    RESULT_GUARD_POSIX(s2n_session_key_alloc(&key->encrypt_key));
+    RESULT_GUARD_POSIX(s2n_aes256_gcm.init(&key->encrypt_key));
+    RESULT_GUARD_POSIX(s2n_aes256_gcm.set_encryption_key(&key->encrypt_key, &aes_key_blob));
+
+    RESULT_GUARD_POSIX(s2n_session_key_alloc(&key->decrypt_key));
+    RESULT_GUARD_POSIX(s2n_aes256_gcm.init(&key->decrypt_key));
+    RESULT_GUARD_POSIX(s2n_aes256_gcm.set_decryption_key(&key->decrypt_key, &aes_key_blob));
+
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_ticket_key_free_session_keys(struct s2n_ticket_key *key)
+{
+    RESULT_ENSURE_REF(key);
+
+    if (key->encrypt_key.evp_cipher_ctx != NULL) {
+        RESULT_GUARD_POSIX(s2n_aes256_gcm.destroy_key(&key->encrypt_key));
     }
+    RESULT_GUARD_POSIX(s2n_session_key_free(&key->encrypt_key));
 
-    return NULL;
+    if (key->decrypt_key.evp_cipher_ctx != NULL) {
+        RESULT_GUARD_POSIX(s2n_aes256_gcm.destroy_key(&key->decrypt_key));
+    }
+    RESULT_GUARD_POSIX(s2n_session_key_free(&key->decrypt_key));
+
+    return S2N_RESULT_OK;
 }
 
 int s2n_encrypt_session_ticket(struct s2n_connection *conn, struct s2n_ticket_fields *ticket_fields, struct s2n_stuffer *to)
 {
     struct s2n_ticket_key *key;
-    struct s2n_session_key aes_ticket_key = {0};
-    struct s2n_blob aes_key_blob = {0};
+    DEFER_CLEANUP(struct s2n_session_key scratch_key = {0}, s2n_session_key_free);
+    struct s2n_session_key *aes_ticket_key = NULL;
 
     uint8_t iv_data[S2N_TLS_GCM_IV_LEN] = { 0 };
     struct s2n_blob iv = {0};
@@ -596,10 +800,7 @@ int s2n_encrypt_session_ticket(struct s2n_connection *conn, struct s2n_ticket_fi
     POSIX_GUARD_RESULT(s2n_get_public_random_data(&iv));
     POSIX_GUARD(s2n_stuffer_write(to, &iv));
 
-    POSIX_GUARD(s2n_blob_init(&aes_key_blob, key->aes_key, S2N_AES256_KEY_LEN));
-    POSIX_GUARD(s2n_session_key_alloc(&aes_ticket_key));
-    POSIX_GUARD(s2n_aes256_gcm.init(&aes_ticket_key));
-    POSIX_GUARD(s2n_aes256_gcm.set_encryption_key(&aes_ticket_key, &aes_key_blob));
+    POSIX_GUARD_RESULT(s2n_ticket_key_get_session_key(&key->encrypt_key, &scratch_key, &aes_ticket_key));
 
     POSIX_GUARD(s2n_stuffer_init(&aad, &aad_blob));
     POSIX_GUARD(s2n_stuffer_write_bytes(&aad, key->implicit_aad, S2N_TICKET_AAD_IMPLICIT_LEN));
@@ -616,21 +817,18 @@ int s2n_encrypt_session_ticket(struct s2n_connection *conn, struct s2n_ticket_fi
     /* Get the correct session resumption ticket size */
     state_blob.size = s2n_stuffer_data_available(&state) + S2N_TLS_GCM_TAG_LEN;
 
-    POSIX_GUARD(s2n_aes256_gcm.io.aead.encrypt(&aes_ticket_key, &iv, &aad_blob, &state_blob, &state_blob));
+    POSIX_GUARD(s2n_aes256_gcm.io.aead.encrypt(aes_ticket_key, &iv, &aad_blob, &state_blob, &state_blob));
 
     POSIX_GUARD(s2n_stuffer_write(to, &state_blob));
 
-    POSIX_GUARD(s2n_aes256_gcm.destroy_key(&aes_ticket_key));
-    POSIX_GUARD(s2n_session_key_free(&aes_ticket_key));
-
     return 0;
 }
 
 int s2n_decrypt_session_ticket(struct s2n_connection *conn)
 {
     struct s2n_ticket_key *key;
-    DEFER_CLEANUP(struct s2n_session_key aes_ticket_key = {0}, s2n_session_key_free);
-    struct s2n_blob aes_key_blob = {0};
+    DEFER_CLEANUP(struct s2n_session_key scratch_key = {0}, s2n_session_key_free);
+    struct s2n_session_key *aes_ticket_key = NULL;
     struct s2n_stuffer *from;
 
     uint8_t key_name[S2N_TICKET_KEY_NAME_LEN];
@@ -663,10 +861,7 @@ int s2n_decrypt_session_ticket(struct s2n_connection *conn)
 
     POSIX_GUARD(s2n_stuffer_read(from, &iv));
 
-    s2n_blob_init(&aes_key_blob, key->aes_key, S2N_AES256_KEY_LEN);
-    POSIX_GUARD(s2n_session_key_alloc(&aes_ticket_key));
-    POSIX_GUARD(s2n_aes256_gcm.init(&aes_ticket_key));
-    POSIX_GUARD(s2n_aes256_gcm.set_decryption_key(&aes_ticket_key, &aes_key_blob));
+    POSIX_GUARD_RESULT(s2n_ticket_key_get_session_key(&key->decrypt_key, &scratch_key, &aes_ticket_key));
 
     POSIX_GUARD(s2n_stuffer_init(&aad, &aad_blob));
     POSIX_GUARD(s2n_stuffer_write_bytes(&aad, key->implicit_aad, S2N_TICKET_AAD_IMPLICIT_LEN));
@@ -674,7 +869,7 @@ int s2n_decrypt_session_ticket(struct s2n_connection *conn)
 
     POSIX_GUARD(s2n_stuffer_read(from, &en_blob));
 
-    POSIX_GUARD(s2n_aes256_gcm.io.aead.decrypt(&aes_ticket_key, &iv, &aad_blob, &en_blob, &en_blob));
+    POSIX_GUARD(s2n_aes256_gcm.io.aead.decrypt(aes_ticket_key, &iv, &aad_blob, &en_blob, &en_blob));
 
     POSIX_GUARD(s2n_stuffer_init(&state, &state_blob));
     POSIX_GUARD(s2n_stuffer_write_bytes(&state, en_data, S2N_STATE_SIZE_IN_BYTES));
@@ -707,8 +902,8 @@ int s2n_encrypt_session_cache(struct s2n_connection *conn, struct s2n_stuffer *t
 int s2n_decrypt_session_cache(struct s2n_connection *conn, struct s2n_stuffer *from)
 {
     struct s2n_ticket_key *key;
-    struct s2n_session_key aes_ticket_key = {0};
-    struct s2n_blob aes_key_blob = {0};
+    DEFER_CLEANUP(struct s2n_session_key scratch_key = {0}, s2n_session_key_free);
+    struct s2n_session_key *aes_ticket_key = NULL;
 
     uint8_t key_name[S2N_TICKET_KEY_NAME_LEN] = {0};
 
@@ -739,10 +934,7 @@ int s2n_decrypt_session_cache(struct s2n_connection *conn, struct s2n_stuffer *f
 
     POSIX_GUARD(s2n_stuffer_read(from, &iv));
 
-    s2n_blob_init(&aes_key_blob, key->aes_key, S2N_AES256_KEY_LEN);
-    POSIX_GUARD(s2n_session_key_alloc(&aes_ticket_key));
-    POSIX_GUARD(s2n_aes256_gcm.init(&aes_ticket_key));
-    POSIX_GUARD(s2n_aes256_gcm.set_decryption_key(&aes_ticket_key, &aes_key_blob));
+    POSIX_GUARD_RESULT(s2n_ticket_key_get_session_key(&key->decrypt_key, &scratch_key, &aes_ticket_key));
 
     POSIX_GUARD(s2n_stuffer_init(&aad, &aad_blob));
     POSIX_GUARD(s2n_stuffer_write_bytes(&aad, key->implicit_aad, S2N_TICKET_AAD_IMPLICIT_LEN));
@@ -750,33 +942,26 @@ int s2n_decrypt_session_cache(struct s2n_connection *conn, struct s2n_stuffer *f
 
     POSIX_GUARD(s2n_stuffer_read(from, &en_blob));
 
-    POSIX_GUARD(s2n_aes256_gcm.io.aead.decrypt(&aes_ticket_key, &iv, &aad_blob, &en_blob, &en_blob));
+    POSIX_GUARD(s2n_aes256_gcm.io.aead.decrypt(aes_ticket_key, &iv, &aad_blob, &en_blob, &en_blob));
 
     POSIX_GUARD(s2n_stuffer_init(&state, &state_blob));
     POSIX_GUARD(s2n_stuffer_write_bytes(&state, en_data, S2N_STATE_SIZE_IN_BYTES));
 
     POSIX_GUARD(s2n_deserialize_resumption_state(conn, &state));
 
-    POSIX_GUARD(s2n_aes256_gcm.destroy_key(&aes_ticket_key));
-    POSIX_GUARD(s2n_session_key_free(&aes_ticket_key));
-
     return 0;
 }
 
-/* This function is used to remove all or just one expired key from server config */
-int s2n_config_wipe_expired_ticket_crypto_keys(struct s2n_config *config, int8_t expired_key_index)
+/* This function is used to remove all expired keys from server config. It frees the
+ * keys and rebuilds the ticket key index, so like the other config setters it must not
+ * be called while connections are using the config.
+ */
+int s2n_config_wipe_expired_ticket_crypto_keys(struct s2n_config *config)
 {
     int num_of_expired_keys = 0;
     int expired_keys_index[S2N_MAX_TICKET_KEYS];
     struct s2n_ticket_key *ticket_key = NULL;
 
-    if (expired_key_index != -1) {
-        expired_keys_index[num_of_expired_keys] = expired_key_index;
-        num_of_expired_keys++;
-
-        goto end;
-    }
-
     uint64_t now;
     POSIX_GUARD(config->wall_clock(config->sys_clock_ctx, &now));
     POSIX_ENSURE_REF(config->ticket_keys);
@@ -793,11 +978,16 @@ int s2n_config_wipe_expired_ticket_crypto_keys(struct s2n_config *config, int8_t
         }
     }
 
-end:
     for (int j = 0; j < num_of_expired_keys; j++) {
+        POSIX_GUARD_RESULT(s2n_set_get(config->ticket_keys, expired_keys_index[j] - j, (void **)&ticket_key));
+        POSIX_GUARD_RESULT(s2n_ticket_key_free_session_keys(ticket_key));
         POSIX_GUARD_RESULT(s2n_set_remove(config->ticket_keys, expired_keys_index[j] - j));
     }
 
+    if (num_of_expired_keys > 0) {
+        POSIX_GUARD_RESULT(s2n_config_update_ticket_key_index(config));
+    }
+
     return 0;
 }
 
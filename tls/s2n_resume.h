@@ -15,6 +15,8 @@
 
 #pragma once
 
+#include "crypto/s2n_cipher.h"
+
 #include "utils/s2n_blob.h"
 
 #include "stuffer/s2n_stuffer.h"
@@ -64,11 +66,20 @@ struct s2n_ticket_key {
     uint8_t aes_key[S2N_AES256_KEY_LEN];
     uint8_t implicit_aad[S2N_TICKET_AAD_IMPLICIT_LEN];
     uint64_t intro_timestamp;
+    /* AES-256-GCM contexts keyed with aes_key when the key is added to the config,
+     * so that tickets never pay for the key schedule. */
+    struct s2n_session_key encrypt_key;
+    struct s2n_session_key decrypt_key;
 };
 
-struct s2n_ticket_key_weight {
-    double key_weight;
-    uint8_t key_index;
+/* Keys are stored from oldest to newest, so the keys in encrypt-decrypt state at any
+ * point in time are a contiguous range of config->ticket_keys.
+ */
+struct s2n_ticket_key_epoch {
+    /* Wall clock time, in nanoseconds, at which this epoch starts */
+    uint64_t start;
+    uint8_t first_key;
+    uint8_t key_count;
 };
 
 struct s2n_ticket_fields {
@@ -82,14 +93,18 @@ struct s2n_session_ticket {
 };
 
 extern struct s2n_ticket_key *s2n_find_ticket_key(struct s2n_config *config, const uint8_t *name);
+extern struct s2n_ticket_key *s2n_get_ticket_encrypt_decrypt_key(struct s2n_config *config);
 extern int s2n_encrypt_session_ticket(struct s2n_connection *conn, struct s2n_ticket_fields *ticket_fields, struct s2n_stuffer *to);
 extern int s2n_decrypt_session_ticket(struct s2n_connection *conn);
 extern int s2n_encrypt_session_cache(struct s2n_connection *conn, struct s2n_stuffer *to); 
 extern int s2n_decrypt_session_cache(struct s2n_connection *conn, struct s2n_stuffer *from); 
 extern int s2n_config_is_encrypt_decrypt_key_available(struct s2n_config *config);
 extern int s2n_verify_unique_ticket_key(struct s2n_config *config, uint8_t *hash, uint16_t *insert_index);
-extern int s2n_config_wipe_expired_ticket_crypto_keys(struct s2n_config *config, int8_t expired_key_index);
+extern int s2n_config_wipe_expired_ticket_crypto_keys(struct s2n_config *config);
 extern int s2n_config_store_ticket_key(struct s2n_config *config, struct s2n_ticket_key *key);
+extern S2N_RESULT s2n_config_update_ticket_key_index(struct s2n_config *config);
+extern S2N_RESULT s2n_ticket_key_init_session_keys(struct s2n_ticket_key *key);
+extern S2N_RESULT s2n_ticket_key_free_session_keys(struct s2n_ticket_key *key);
 
 typedef enum {
     S2N_STATE_WITH_SESSION_ID = 0,
@@ -104,6 +119,8 @@ typedef enum {
 extern int s2n_allowed_to_cache_connection(struct s2n_connection *conn);
 extern int s2n_resume_from_cache(struct s2n_connection *conn);
 extern int s2n_store_to_cache(struct s2n_connection *conn);
+extern int s2n_delete_from_cache(struct s2n_connection *conn);
+extern bool s2n_config_has_session_cache_callbacks(struct s2n_config *config);
 int s2n_client_serialize_resumption_state(struct s2n_connection *conn, struct s2n_ticket_fields *ticket_fields, struct s2n_stuffer *to);
 
 /* These functions will be labeled S2N_API and become a publicly visible api 
@@ -15,13 +15,17 @@
 
 #include <sys/param.h>
 #include <errno.h>
+#include <limits.h>
+#include <unistd.h>
 #include <s2n.h>
 
 #include "error/s2n_errno.h"
 
+#include "tls/s2n_buffer_pool.h"
 #include "tls/s2n_cipher_suites.h"
 #include "tls/s2n_connection.h"
 #include "tls/s2n_handshake.h"
+#include "tls/s2n_ktls.h"
 #include "tls/s2n_post_handshake.h"
 #include "tls/s2n_record.h"
 
@@ -32,17 +36,31 @@
 #include "utils/s2n_safety.h"
 #include "utils/s2n_blob.h"
 
+/* A region of a file to be sent by s2n_sendfile */
+struct s2n_send_file {
+    int fd;
+    off_t offset;
+    ssize_t count;
+};
+
 int s2n_flush(struct s2n_connection *conn, s2n_blocked_status * blocked)
 {
     int w;
 
     *blocked = S2N_BLOCKED_ON_WRITE;
 
+    /* Any space handed out by s2n_send_reserve is about to be reused */
+    conn->send_reserved = 0;
+
     /* Write any data that's already pending */
   WRITE:
     while (s2n_stuffer_data_available(&conn->out)) {
         errno = 0;
-        w = s2n_connection_send_stuffer(&conn->out, conn, s2n_stuffer_data_available(&conn->out));
+        if (conn->ktls_send_enabled) {
+            w = s2n_ktls_send_stuffer(&conn->out, conn, s2n_stuffer_data_available(&conn->out));
+        } else {
+            w = s2n_connection_send_stuffer(&conn->out, conn, s2n_stuffer_data_available(&conn->out));
+        }
         if (w < 0) {
             if (errno == EWOULDBLOCK || errno == EAGAIN) {
                 POSIX_BAIL(S2N_ERR_IO_BLOCKED);
@@ -52,6 +70,12 @@ int s2n_flush(struct s2n_connection *conn, s2n_blocked_status * blocked)
         conn->wire_bytes_out += w;
     }
 
+    /* A KeyUpdate message has reached the kernel, so later records must use the new keys */
+    if (conn->ktls_send_key_update_pending) {
+        POSIX_GUARD_RESULT(s2n_ktls_update_keys(conn, conn->mode));
+        conn->ktls_send_key_update_pending = 0;
+    }
+
     if (conn->closing) {
         conn->closed = 1;
     }
@@ -83,12 +107,62 @@ int s2n_flush(struct s2n_connection *conn, s2n_blocked_status * blocked)
         goto WRITE;
     }
 
+    /* Everything has been written, so a connection with dynamic buffers gives up its output buffer */
+    if (conn->config->dynamic_buffers) {
+        POSIX_GUARD_RESULT(s2n_buffer_pool_release(&conn->out));
+    }
+
     *blocked = S2N_NOT_BLOCKED;
 
     return 0;
 }
 
-ssize_t s2n_sendv_with_offset_impl(struct s2n_connection *conn, const struct iovec *bufs, ssize_t count, ssize_t offs, s2n_blocked_status *blocked)
+/* Returns the location inside conn->out where the plaintext of the next record starts */
+static S2N_RESULT s2n_send_reserved_buffer(struct s2n_connection *conn, uint8_t **buffer, uint16_t *size)
+{
+    uint16_t explicit_iv_size = 0;
+    RESULT_GUARD(s2n_record_explicit_iv_size(conn, &explicit_iv_size));
+    RESULT_GUARD(s2n_record_max_write_payload_size(conn, size));
+
+    RESULT_ENSURE_GTE(s2n_stuffer_space_remaining(&conn->out), S2N_TLS_MAX_RECORD_LEN_FOR(*size));
+    *buffer = conn->out.blob.data + conn->out.write_cursor + S2N_TLS_RECORD_HEADER_LENGTH + explicit_iv_size;
+
+    return S2N_RESULT_OK;
+}
+
+/* Reads the next chunk of a file directly into the plaintext slot of the next record in conn->out,
+ * so that s2n_record_writev can encrypt it in place.
+ */
+static S2N_RESULT s2n_send_read_file(struct s2n_connection *conn, const struct s2n_send_file *file, ssize_t file_offset,
+        ssize_t to_read, struct iovec *plaintext)
+{
+    if (s2n_stuffer_data_available(&conn->out) == 0) {
+        RESULT_GUARD_POSIX(s2n_stuffer_rewrite(&conn->out));
+    }
+    RESULT_GUARD(s2n_connection_acquire_record_buffer(conn, &conn->out, S2N_LARGE_RECORD_LENGTH));
+    RESULT_GUARD_POSIX(s2n_stuffer_reserve_space(&conn->out, S2N_TLS_MAX_RECORD_LEN_FOR(to_read)));
+
+    uint8_t *buffer = NULL;
+    uint16_t size = 0;
+    RESULT_GUARD(s2n_send_reserved_buffer(conn, &buffer, &size));
+    to_read = MIN(to_read, size);
+
+    ssize_t r = 0;
+    do {
+        errno = 0;
+        r = pread(file->fd, buffer, to_read, file->offset + file_offset);
+    } while (r < 0 && errno == EINTR);
+    RESULT_ENSURE(r >= 0, S2N_ERR_IO);
+    /* The file is shorter than the caller claimed */
+    RESULT_ENSURE(r > 0, S2N_ERR_INVALID_ARGUMENT);
+
+    plaintext->iov_base = buffer;
+    plaintext->iov_len = r;
+    return S2N_RESULT_OK;
+}
+
+static ssize_t s2n_send_impl(struct s2n_connection *conn, const struct iovec *bufs, ssize_t count, ssize_t offs,
+        const struct s2n_send_file *file, s2n_blocked_status *blocked)
 {
     ssize_t user_data_sent, total_size = 0;
 
@@ -98,6 +172,15 @@ ssize_t s2n_sendv_with_offset_impl(struct s2n_connection *conn, const struct iov
     /* Flush any pending I/O */
     POSIX_GUARD(s2n_flush(conn, blocked));
 
+    /* With kTLS, the plaintext is written straight to the socket */
+    if (conn->ktls_send_enabled) {
+        POSIX_GUARD(s2n_post_handshake_send(conn, blocked));
+        if (file) {
+            return s2n_ktls_sendfile(conn, file->fd, file->offset, file->count, blocked);
+        }
+        return s2n_ktls_sendv_with_offset(conn, bufs, count, offs, blocked);
+    }
+
     /* Acknowledge consumed and flushed user data as sent */
     user_data_sent = conn->current_user_data_consumed;
 
@@ -118,7 +201,9 @@ ssize_t s2n_sendv_with_offset_impl(struct s2n_connection *conn, const struct iov
     }
 
     /* Defensive check against an invalid retry */
-    if (offs) {
+    if (file) {
+        total_size = file->count;
+    } else if (offs) {
         const struct iovec* _bufs = bufs;
         ssize_t _count = count;
         while (offs >= _bufs->iov_len && _count > 0) {
@@ -145,6 +230,14 @@ ssize_t s2n_sendv_with_offset_impl(struct s2n_connection *conn, const struct iov
         conn->last_write_elapsed = elapsed;
     }
 
+    /* If a send buffer is configured, grow the output stuffer so that multiple records
+     * can be queued behind each other and written to the network in a single flush.
+     */
+    const uint32_t send_buffer_size = conn->config->send_buffer_size_override;
+    if (send_buffer_size && conn->out.blob.size < send_buffer_size) {
+        POSIX_GUARD(s2n_stuffer_resize(&conn->out, send_buffer_size));
+    }
+
     /* Now write the data we were asked to send this round */
     while (total_size - conn->current_user_data_consumed) {
         ssize_t to_write = MIN(total_size - conn->current_user_data_consumed, max_payload_size);
@@ -167,17 +260,28 @@ ssize_t s2n_sendv_with_offset_impl(struct s2n_connection *conn, const struct iov
                 cbcHackUsed = 1;
             }
         }
-    
-        POSIX_GUARD(s2n_stuffer_rewrite(&conn->out));
 
         POSIX_GUARD(s2n_post_handshake_send(conn, blocked));
     
         /* Write and encrypt the record */
-        POSIX_GUARD(s2n_record_writev(conn, TLS_APPLICATION_DATA, bufs, count, 
-            conn->current_user_data_consumed + offs, to_write));
+        if (file) {
+            struct iovec plaintext = { 0 };
+            POSIX_GUARD_RESULT(s2n_send_read_file(conn, file, conn->current_user_data_consumed, to_write, &plaintext));
+            to_write = plaintext.iov_len;
+            POSIX_GUARD(s2n_record_writev(conn, TLS_APPLICATION_DATA, &plaintext, 1, 0, to_write));
+        } else {
+            POSIX_GUARD(s2n_record_writev(conn, TLS_APPLICATION_DATA, bufs, count, 
+                conn->current_user_data_consumed + offs, to_write));
+        }
         conn->current_user_data_consumed += to_write;
         conn->active_application_bytes_consumed += to_write;
 
+        /* Keep filling the send buffer while there is more data and room for another full record */
+        if (send_buffer_size && (total_size - conn->current_user_data_consumed)
+                && s2n_stuffer_space_remaining(&conn->out) >= S2N_TLS_MAX_RECORD_LEN_FOR(max_payload_size)) {
+            continue;
+        }
+
         /* Send it */
         if (s2n_flush(conn, blocked) < 0) {
             if (s2n_errno == S2N_ERR_IO_BLOCKED && user_data_sent > 0) {
@@ -203,6 +307,74 @@ ssize_t s2n_sendv_with_offset_impl(struct s2n_connection *conn, const struct iov
     return total_size;
 }
 
+int s2n_send_reserve(struct s2n_connection *conn, uint8_t **buffer, uint32_t *size, s2n_blocked_status *blocked)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_REF(buffer);
+    POSIX_ENSURE_REF(size);
+    POSIX_ENSURE_REF(blocked);
+    POSIX_ENSURE(!conn->send_in_use, S2N_ERR_REENTRANCY);
+    S2N_ERROR_IF(conn->closed, S2N_ERR_CLOSED);
+    S2N_ERROR_IF(conn->config->quic_enabled, S2N_ERR_UNSUPPORTED_WITH_QUIC);
+    /* Records sealed in userspace would be encrypted a second time by the kernel */
+    POSIX_ENSURE(!conn->ktls_send_enabled, S2N_ERR_KTLS_UNSUPPORTED);
+
+    /* The record must not be split to work around the BEAST attack, which s2n_send does for clients */
+    struct s2n_crypto_parameters *writer = conn->mode == S2N_CLIENT ? conn->client : conn->server;
+    S2N_ERROR_IF(conn->actual_protocol_version < S2N_TLS11 && writer->cipher_suite->record_alg->cipher->type == S2N_CBC
+            && conn->mode != S2N_SERVER, S2N_ERR_INVALID_STATE);
+
+    /* Anything still pending, including post-handshake messages, goes out through the connection's I/O first */
+    POSIX_GUARD(s2n_flush(conn, blocked));
+    POSIX_GUARD(s2n_post_handshake_send(conn, blocked));
+
+    uint16_t max_payload_size = 0;
+    POSIX_GUARD_RESULT(s2n_record_max_write_payload_size(conn, &max_payload_size));
+    POSIX_GUARD(s2n_stuffer_rewrite(&conn->out));
+    POSIX_GUARD_RESULT(s2n_connection_acquire_record_buffer(conn, &conn->out, S2N_LARGE_RECORD_LENGTH));
+    POSIX_GUARD(s2n_stuffer_reserve_space(&conn->out, S2N_TLS_MAX_RECORD_LEN_FOR(max_payload_size)));
+
+    uint16_t reserved_size = 0;
+    POSIX_GUARD_RESULT(s2n_send_reserved_buffer(conn, buffer, &reserved_size));
+    *size = reserved_size;
+    conn->send_reserved = 1;
+
+    *blocked = S2N_NOT_BLOCKED;
+    return S2N_SUCCESS;
+}
+
+int s2n_send_seal(struct s2n_connection *conn, uint32_t size, const uint8_t **wire, uint32_t *wire_size)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_REF(wire);
+    POSIX_ENSURE_REF(wire_size);
+    POSIX_ENSURE(!conn->send_in_use, S2N_ERR_REENTRANCY);
+    POSIX_ENSURE(conn->send_reserved, S2N_ERR_INVALID_STATE);
+
+    uint8_t *buffer = NULL;
+    uint16_t reserved_size = 0;
+    POSIX_GUARD_RESULT(s2n_send_reserved_buffer(conn, &buffer, &reserved_size));
+    POSIX_ENSURE(size > 0 && size <= reserved_size, S2N_ERR_INVALID_ARGUMENT);
+
+    /* The plaintext is already in place, so the record is encrypted without copying it */
+    conn->send_reserved = 0;
+    struct iovec plaintext = { .iov_base = buffer, .iov_len = size };
+    POSIX_GUARD(s2n_record_writev(conn, TLS_APPLICATION_DATA, &plaintext, 1, 0, size));
+    conn->active_application_bytes_consumed += size;
+
+    /* Hand the record over to the caller. It is no longer pending on the connection. */
+    *wire = conn->out.blob.data + conn->out.read_cursor;
+    *wire_size = s2n_stuffer_data_available(&conn->out);
+    POSIX_GUARD(s2n_stuffer_skip_read(&conn->out, *wire_size));
+
+    return S2N_SUCCESS;
+}
+
+ssize_t s2n_sendv_with_offset_impl(struct s2n_connection *conn, const struct iovec *bufs, ssize_t count, ssize_t offs, s2n_blocked_status *blocked)
+{
+    return s2n_send_impl(conn, bufs, count, offs, NULL, blocked);
+}
+
 ssize_t s2n_sendv_with_offset(struct s2n_connection *conn, const struct iovec *bufs, ssize_t count, ssize_t offs, s2n_blocked_status *blocked)
 {
     POSIX_ENSURE(!conn->send_in_use, S2N_ERR_REENTRANCY);
@@ -212,6 +384,22 @@ ssize_t s2n_sendv_with_offset(struct s2n_connection *conn, const struct iovec *b
     return result;
 }
 
+ssize_t s2n_sendfile(struct s2n_connection *conn, int fd, off_t offset, size_t count, s2n_blocked_status *blocked)
+{
+    POSIX_ENSURE_REF(conn);
+    POSIX_ENSURE_REF(blocked);
+    POSIX_ENSURE(fd >= 0 && offset >= 0, S2N_ERR_INVALID_ARGUMENT);
+    POSIX_ENSURE(count <= SSIZE_MAX, S2N_ERR_INVALID_ARGUMENT);
+
+    const struct s2n_send_file file = { .fd = fd, .offset = offset, .count = count };
+
+    POSIX_ENSURE(!conn->send_in_use, S2N_ERR_REENTRANCY);
+    conn->send_in_use = true;
+    ssize_t result = s2n_send_impl(conn, NULL, 0, 0, &file, blocked);
+    conn->send_in_use = false;
+    return result;
+}
+
 ssize_t s2n_sendv(struct s2n_connection *conn, const struct iovec *bufs, ssize_t count, s2n_blocked_status *blocked)
 {
     return s2n_sendv_with_offset(conn, bufs, count, 0, blocked);
@@ -21,6 +21,7 @@
 #include "tls/s2n_tls_digest_preferences.h"
 #include "tls/s2n_kem.h"
 #include "tls/s2n_kex.h"
+#include "tls/s2n_key_share_pool.h"
 #include "tls/s2n_cipher_suites.h"
 #include "tls/s2n_connection.h"
 #include "tls/s2n_signature_algorithms.h"
@@ -264,7 +265,7 @@ int s2n_ecdhe_server_key_send(struct s2n_connection *conn, struct s2n_blob *data
     struct s2n_stuffer *out = &conn->handshake.io;
 
     /* Generate an ephemeral key and  */
-    POSIX_GUARD(s2n_ecc_evp_generate_ephemeral_key(&conn->secure.server_ecc_evp_params));
+    POSIX_GUARD(s2n_key_share_pool_generate_key(conn->config, &conn->secure.server_ecc_evp_params));
 
     /* Write it out and calculate the data to sign later */
     POSIX_GUARD(s2n_ecc_evp_write_params(&conn->secure.server_ecc_evp_params, out, data_to_sign));
@@ -0,0 +1,262 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "tls/s2n_session_cache.h"
+
+#include <sys/param.h>
+#include <string.h>
+
+#include "tls/s2n_config.h"
+#include "utils/s2n_mem.h"
+#include "utils/s2n_random.h"
+#include "utils/s2n_safety.h"
+
+static S2N_RESULT s2n_session_cache_find_bucket(struct s2n_session_cache *cache, const uint8_t *session_id, uint8_t session_id_len,
+        uint64_t *hash, struct s2n_session_cache_shard **shard, struct s2n_session_cache_entry **bucket)
+{
+    RESULT_ENSURE_REF(cache);
+    RESULT_ENSURE_REF(session_id);
+    RESULT_ENSURE(session_id_len > 0, S2N_ERR_SESSION_ID_TOO_SHORT);
+    RESULT_ENSURE(session_id_len <= S2N_TLS_SESSION_ID_MAX_LEN, S2N_ERR_SESSION_ID_TOO_LONG);
+
+    /* Clients choose the session id they send, so the hash is keyed to keep them from
+     * crowding a single bucket. */
+    *hash = s2n_siphash13(cache->hash_key, session_id, session_id_len);
+    *shard = &cache->shards[*hash % cache->shard_count];
+
+    const uint64_t bucket_index = (*hash / cache->shard_count) % (*shard)->bucket_count;
+    *bucket = &(*shard)->entries[bucket_index * S2N_SESSION_CACHE_BUCKET_WAYS];
+
+    return S2N_RESULT_OK;
+}
+
+static bool s2n_session_cache_entry_matches(const struct s2n_session_cache_entry *entry, uint64_t hash,
+        const uint8_t *session_id, uint8_t session_id_len)
+{
+    return entry->expiration != 0 && entry->hash == hash && entry->session_id_len == session_id_len
+            && memcmp(entry->session_id, session_id, session_id_len) == 0;
+}
+
+static void s2n_session_cache_entry_wipe(struct s2n_session_cache_shard *shard, struct s2n_session_cache_entry *entry)
+{
+    if (entry->expiration != 0) {
+        shard->stats.entries--;
+    }
+    *entry = (struct s2n_session_cache_entry) { 0 };
+}
+
+struct s2n_session_cache *s2n_session_cache_new(uint64_t max_memory_in_bytes)
+{
+    const uint64_t max_entries = max_memory_in_bytes / sizeof(struct s2n_session_cache_entry);
+    PTR_ENSURE(max_entries >= S2N_SESSION_CACHE_BUCKET_WAYS, S2N_ERR_INVALID_ARGUMENT);
+
+    const uint64_t max_buckets = max_entries / S2N_SESSION_CACHE_BUCKET_WAYS;
+    const uint32_t shard_count = MIN(max_buckets, S2N_SESSION_CACHE_MAX_SHARDS);
+    const uint64_t buckets_per_shard = max_buckets / shard_count;
+    PTR_ENSURE(buckets_per_shard <= S2N_SESSION_CACHE_MAX_BUCKETS_PER_SHARD, S2N_ERR_INVALID_ARGUMENT);
+
+    uint32_t entries_size = 0;
+    PTR_GUARD_POSIX(s2n_mul_overflow(buckets_per_shard, S2N_SESSION_CACHE_BUCKET_WAYS * sizeof(struct s2n_session_cache_entry),
+            &entries_size));
+
+    struct s2n_blob mem = { 0 };
+    PTR_GUARD_POSIX(s2n_alloc(&mem, sizeof(struct s2n_session_cache)));
+    PTR_GUARD_POSIX(s2n_blob_zero(&mem));
+    struct s2n_session_cache *cache = (struct s2n_session_cache *)(void *) mem.data;
+
+    struct s2n_blob hash_key = { 0 };
+    if (s2n_blob_init(&hash_key, cache->hash_key, sizeof(cache->hash_key)) != S2N_SUCCESS
+            || s2n_result_is_error(s2n_get_public_random_data(&hash_key))) {
+        s2n_session_cache_free(cache);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < shard_count; i++) {
+        struct s2n_session_cache_shard *shard = &cache->shards[i];
+
+        struct s2n_blob entries = { 0 };
+        if (s2n_alloc(&entries, entries_size) != S2N_SUCCESS) {
+            s2n_session_cache_free(cache);
+            return NULL;
+        }
+        if (s2n_blob_zero(&entries) != S2N_SUCCESS || pthread_mutex_init(&shard->lock, NULL) != 0) {
+            s2n_free(&entries);
+            s2n_session_cache_free(cache);
+            PTR_BAIL(S2N_ERR_LOCK);
+        }
+
+        /* Only fully initialized shards are counted, so that they are the only ones freed */
+        shard->entries = (struct s2n_session_cache_entry *)(void *) entries.data;
+        shard->bucket_count = buckets_per_shard;
+        cache->shard_count++;
+    }
+
+    return cache;
+}
+
+int s2n_session_cache_free(struct s2n_session_cache *cache)
+{
+    POSIX_ENSURE_REF(cache);
+
+    for (uint32_t i = 0; i < cache->shard_count; i++) {
+        struct s2n_session_cache_shard *shard = &cache->shards[i];
+        uint32_t size = 0;
+        POSIX_GUARD(s2n_mul_overflow(shard->bucket_count, S2N_SESSION_CACHE_BUCKET_WAYS * sizeof(struct s2n_session_cache_entry), &size));
+
+        POSIX_ENSURE(pthread_mutex_destroy(&shard->lock) == 0, S2N_ERR_LOCK);
+
+        /* s2n_free_object wipes the stored sessions */
+        POSIX_GUARD(s2n_free_object((uint8_t **) &shard->entries, size));
+    }
+
+    POSIX_GUARD(s2n_free_object((uint8_t **) &cache, sizeof(struct s2n_session_cache)));
+    return S2N_SUCCESS;
+}
+
+int s2n_session_cache_get_stats(struct s2n_session_cache *cache, struct s2n_session_cache_stats *stats)
+{
+    POSIX_ENSURE_REF(cache);
+    POSIX_ENSURE_MUT(stats);
+
+    *stats = (struct s2n_session_cache_stats) { 0 };
+    for (uint32_t i = 0; i < cache->shard_count; i++) {
+        struct s2n_session_cache_shard *shard = &cache->shards[i];
+        POSIX_ENSURE(pthread_mutex_lock(&shard->lock) == 0, S2N_ERR_LOCK);
+        stats->hits += shard->stats.hits;
+        stats->misses += shard->stats.misses;
+        stats->stores += shard->stats.stores;
+        stats->deletes += shard->stats.deletes;
+        stats->evictions += shard->stats.evictions;
+        stats->expirations += shard->stats.expirations;
+        stats->entries += shard->stats.entries;
+        POSIX_ENSURE(pthread_mutex_unlock(&shard->lock) == 0, S2N_ERR_LOCK);
+    }
+
+    return S2N_SUCCESS;
+}
+
+S2N_RESULT s2n_session_cache_store(struct s2n_session_cache *cache, uint64_t now, uint64_t lifetime_in_nanos,
+        const uint8_t *session_id, uint8_t session_id_len, const struct s2n_blob *state)
+{
+    RESULT_ENSURE_REF(state);
+    RESULT_ENSURE_EQ(state->size, S2N_TLS12_TICKET_SIZE_IN_BYTES);
+    RESULT_ENSURE(lifetime_in_nanos > 0 && now + lifetime_in_nanos > now, S2N_ERR_INVALID_ARGUMENT);
+
+    uint64_t hash = 0;
+    struct s2n_session_cache_shard *shard = NULL;
+    struct s2n_session_cache_entry *bucket = NULL;
+    RESULT_GUARD(s2n_session_cache_find_bucket(cache, session_id, session_id_len, &hash, &shard, &bucket));
+
+    RESULT_ENSURE(pthread_mutex_lock(&shard->lock) == 0, S2N_ERR_LOCK);
+
+    /* Replace the session if it is already cached. Otherwise use a free slot, then an
+     * expired one, and as a last resort evict the session closest to expiring. */
+    struct s2n_session_cache_entry *slot = &bucket[0];
+    for (uint32_t i = 0; i < S2N_SESSION_CACHE_BUCKET_WAYS; i++) {
+        struct s2n_session_cache_entry *entry = &bucket[i];
+        if (s2n_session_cache_entry_matches(entry, hash, session_id, session_id_len)) {
+            slot = entry;
+            break;
+        }
+        if (entry->expiration < slot->expiration) {
+            slot = entry;
+        }
+    }
+
+    if (slot->expiration != 0 && !s2n_session_cache_entry_matches(slot, hash, session_id, session_id_len)) {
+        if (slot->expiration <= now) {
+            shard->stats.expirations++;
+        } else {
+            shard->stats.evictions++;
+        }
+    }
+    s2n_session_cache_entry_wipe(shard, slot);
+
+    slot->hash = hash;
+    slot->expiration = now + lifetime_in_nanos;
+    slot->session_id_len = session_id_len;
+    memcpy(slot->session_id, session_id, session_id_len);
+    memcpy(slot->state, state->data, state->size);
+    shard->stats.entries++;
+    shard->stats.stores++;
+
+    RESULT_ENSURE(pthread_mutex_unlock(&shard->lock) == 0, S2N_ERR_LOCK);
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_session_cache_retrieve(struct s2n_session_cache *cache, uint64_t now,
+        const uint8_t *session_id, uint8_t session_id_len, struct s2n_blob *state, bool *found)
+{
+    RESULT_ENSURE_REF(state);
+    RESULT_ENSURE_REF(found);
+    RESULT_ENSURE_GTE(state->size, S2N_TLS12_TICKET_SIZE_IN_BYTES);
+    *found = false;
+
+    uint64_t hash = 0;
+    struct s2n_session_cache_shard *shard = NULL;
+    struct s2n_session_cache_entry *bucket = NULL;
+    RESULT_GUARD(s2n_session_cache_find_bucket(cache, session_id, session_id_len, &hash, &shard, &bucket));
+
+    RESULT_ENSURE(pthread_mutex_lock(&shard->lock) == 0, S2N_ERR_LOCK);
+
+    for (uint32_t i = 0; i < S2N_SESSION_CACHE_BUCKET_WAYS; i++) {
+        struct s2n_session_cache_entry *entry = &bucket[i];
+        if (!s2n_session_cache_entry_matches(entry, hash, session_id, session_id_len)) {
+            continue;
+        }
+
+        if (entry->expiration <= now) {
+            shard->stats.expirations++;
+            s2n_session_cache_entry_wipe(shard, entry);
+            break;
+        }
+
+        memcpy(state->data, entry->state, S2N_TLS12_TICKET_SIZE_IN_BYTES);
+        state->size = S2N_TLS12_TICKET_SIZE_IN_BYTES;
+        *found = true;
+        break;
+    }
+
+    if (*found) {
+        shard->stats.hits++;
+    } else {
+        shard->stats.misses++;
+    }
+
+    RESULT_ENSURE(pthread_mutex_unlock(&shard->lock) == 0, S2N_ERR_LOCK);
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_session_cache_delete(struct s2n_session_cache *cache, const uint8_t *session_id, uint8_t session_id_len)
+{
+    uint64_t hash = 0;
+    struct s2n_session_cache_shard *shard = NULL;
+    struct s2n_session_cache_entry *bucket = NULL;
+    RESULT_GUARD(s2n_session_cache_find_bucket(cache, session_id, session_id_len, &hash, &shard, &bucket));
+
+    RESULT_ENSURE(pthread_mutex_lock(&shard->lock) == 0, S2N_ERR_LOCK);
+
+    for (uint32_t i = 0; i < S2N_SESSION_CACHE_BUCKET_WAYS; i++) {
+        struct s2n_session_cache_entry *entry = &bucket[i];
+        if (s2n_session_cache_entry_matches(entry, hash, session_id, session_id_len)) {
+            s2n_session_cache_entry_wipe(shard, entry);
+            shard->stats.deletes++;
+            break;
+        }
+    }
+
+    RESULT_ENSURE(pthread_mutex_unlock(&shard->lock) == 0, S2N_ERR_LOCK);
+    return S2N_RESULT_OK;
+}
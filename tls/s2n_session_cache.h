@@ -0,0 +1,64 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <s2n.h>
+
+#include "tls/s2n_crypto_constants.h"
+#include "tls/s2n_resume.h"
+#include "utils/s2n_blob.h"
+#include "utils/s2n_result.h"
+#include "utils/s2n_siphash.h"
+
+/* Sessions are spread across shards by the hash of their id, and each shard has its own lock */
+#define S2N_SESSION_CACHE_MAX_SHARDS 16
+
+/* A session can only live in one small bucket of its shard, so a lookup compares at most this
+ * many entries. Storing into a full bucket evicts the entry that expires first. */
+#define S2N_SESSION_CACHE_BUCKET_WAYS 4
+
+struct s2n_session_cache_entry {
+    uint64_t hash;
+    /* Wall clock time, in nanoseconds, at which the entry expires. 0 for an unused entry. */
+    uint64_t expiration;
+    uint8_t session_id[S2N_TLS_SESSION_ID_MAX_LEN];
+    uint8_t session_id_len;
+    uint8_t state[S2N_TLS12_TICKET_SIZE_IN_BYTES];
+};
+
+/* Each shard's entries are a single allocation, whose size must fit in a uint32_t */
+#define S2N_SESSION_CACHE_MAX_BUCKETS_PER_SHARD \
+    (UINT32_MAX / (S2N_SESSION_CACHE_BUCKET_WAYS * sizeof(struct s2n_session_cache_entry)))
+
+struct s2n_session_cache_shard {
+    pthread_mutex_t lock;
+    struct s2n_session_cache_entry *entries;
+    uint32_t bucket_count;
+    struct s2n_session_cache_stats stats;
+};
+
+struct s2n_session_cache {
+    uint8_t hash_key[S2N_SIPHASH_KEY_LEN];
+    struct s2n_session_cache_shard shards[S2N_SESSION_CACHE_MAX_SHARDS];
+    uint32_t shard_count;
+};
+
+extern S2N_RESULT s2n_session_cache_store(struct s2n_session_cache *cache, uint64_t now, uint64_t lifetime_in_nanos,
+        const uint8_t *session_id, uint8_t session_id_len, const struct s2n_blob *state);
+extern S2N_RESULT s2n_session_cache_retrieve(struct s2n_session_cache *cache, uint64_t now,
+        const uint8_t *session_id, uint8_t session_id_len, struct s2n_blob *state, bool *found);
+extern S2N_RESULT s2n_session_cache_delete(struct s2n_session_cache *cache, const uint8_t *session_id, uint8_t session_id_len);
@@ -162,7 +162,7 @@ int s2n_tls13_cert_verify_recv(struct s2n_connection *conn)
 int s2n_tls13_cert_read_and_verify_signature(struct s2n_connection *conn, struct s2n_signature_scheme *chosen_sig_scheme)
 {
     struct s2n_stuffer *in = &conn->handshake.io;
-    DEFER_CLEANUP(struct s2n_blob signed_content = {0}, s2n_free);
+    struct s2n_blob signed_content = {0};
     DEFER_CLEANUP(struct s2n_stuffer unsigned_content = {0}, s2n_stuffer_free);
     DEFER_CLEANUP(struct s2n_hash_state message_hash = {0}, s2n_hash_free);
     POSIX_GUARD(s2n_hash_new(&message_hash));
@@ -173,8 +173,7 @@ int s2n_tls13_cert_read_and_verify_signature(struct s2n_connection *conn, struct
     S2N_ERROR_IF(signature_size > s2n_stuffer_data_available(in), S2N_ERR_BAD_MESSAGE);
 
     /* Get wire signature */
-    POSIX_GUARD(s2n_alloc(&signed_content, signature_size));
-    signed_content.size = signature_size;
+    POSIX_GUARD_RESULT(s2n_arena_alloc(&conn->handshake_arena, &signed_content, signature_size));
     POSIX_GUARD(s2n_stuffer_read_bytes(in, signed_content.data, signature_size));
 
     /* Verify signature. We send the opposite mode as we are trying to verify what was sent to us */
@@ -87,6 +87,7 @@ int s2n_tls13_compute_ecc_shared_secret(struct s2n_connection *conn, struct s2n_
 
     POSIX_ENSURE(client_key != NULL, S2N_ERR_BAD_KEY_SHARE);
 
+    POSIX_GUARD_RESULT(s2n_arena_alloc(&conn->handshake_arena, shared_secret, S2N_ECC_EVP_MAX_SHARED_SECRET_SIZE));
     if (conn->mode == S2N_CLIENT) {
         POSIX_GUARD(s2n_ecc_evp_compute_shared_secret_from_params(client_key, server_key, shared_secret));
     } else {
@@ -117,6 +118,7 @@ int s2n_tls13_compute_pq_hybrid_shared_secret(struct s2n_connection *conn, struc
     POSIX_ENSURE_REF(client_ecc_params);
 
     DEFER_CLEANUP(struct s2n_blob ecdhe_shared_secret = { 0 }, s2n_blob_zeroize_free);
+    POSIX_GUARD_RESULT(s2n_arena_alloc(&conn->handshake_arena, &ecdhe_shared_secret, S2N_ECC_EVP_MAX_SHARED_SECRET_SIZE));
 
     /* Compute the ECDHE shared secret, and retrieve the PQ shared secret. */
     if (conn->mode == S2N_CLIENT) {
@@ -137,7 +139,7 @@ int s2n_tls13_compute_pq_hybrid_shared_secret(struct s2n_connection *conn, struc
 
     /* Construct the concatenated/hybrid shared secret */
     uint32_t hybrid_shared_secret_size = ecdhe_shared_secret.size + negotiated_kem_group->kem->shared_secret_key_length;
-    POSIX_GUARD(s2n_alloc(shared_secret, hybrid_shared_secret_size));
+    POSIX_GUARD_RESULT(s2n_arena_alloc(&conn->handshake_arena, shared_secret, hybrid_shared_secret_size));
     struct s2n_stuffer stuffer_combiner = { 0 };
     POSIX_GUARD(s2n_stuffer_init(&stuffer_combiner, shared_secret));
     POSIX_GUARD(s2n_stuffer_write(&stuffer_combiner, &ecdhe_shared_secret));
@@ -258,7 +260,7 @@ int s2n_tls13_handle_handshake_master_secret(struct s2n_connection *conn)
     s2n_tls13_connection_keys(secrets, conn);
 
     /* get shared secret */
-    DEFER_CLEANUP(struct s2n_blob shared_secret = { 0 }, s2n_free);
+    DEFER_CLEANUP(struct s2n_blob shared_secret = { 0 }, s2n_blob_zeroize_free);
     POSIX_GUARD(s2n_tls13_compute_shared_secret(conn, &shared_secret));
 
     POSIX_GUARD(s2n_tls13_extract_handshake_secret(&secrets, &shared_secret));
@@ -299,7 +301,8 @@ int s2n_tls13_handle_handshake_traffic_secret(struct s2n_connection *conn, s2n_m
         conn->server = &conn->secure;
     }
 
-    POSIX_GUARD(s2n_tls13_derive_handshake_traffic_secret(&secrets, &conn->handshake.server_hello_copy, &hs_secret, mode));
+    POSIX_ENSURE_REF(conn->handshake.hashes);
+    POSIX_GUARD(s2n_tls13_derive_handshake_traffic_secret(&secrets, &conn->handshake.hashes->server_hello_copy, &hs_secret, mode));
 
     /* trigger secret callbacks */
     if (conn->secret_cb && conn->config->quic_enabled) {
@@ -358,8 +361,9 @@ static int s2n_tls13_handle_application_secret(struct s2n_connection *conn, s2n_
     }
 
     /* use frozen hashes during the server finished state */
+    POSIX_ENSURE_REF(conn->handshake.hashes);
     struct s2n_hash_state *hash_state;
-    POSIX_GUARD_PTR(hash_state = &conn->handshake.server_finished_copy);
+    POSIX_GUARD_PTR(hash_state = &conn->handshake.hashes->server_finished_copy);
 
     /* calculate secret */
     struct s2n_blob app_secret = { .data = app_secret_data, .size = keys.size };
@@ -430,7 +434,7 @@ int s2n_tls13_client_handle_secrets(struct s2n_connection *conn)
             }
             break;
         case HELLO_RETRY_MSG:
-            conn->client = &conn->initial;
+            conn->client = conn->initial;
             break;
         case SERVER_HELLO:
             POSIX_GUARD(s2n_tls13_handle_early_secret(conn));
@@ -471,7 +475,7 @@ static int s2n_tls13_server_handle_secrets(struct s2n_connection *conn)
             }
             break;
         case HELLO_RETRY_MSG:
-            conn->client = &conn->initial;
+            conn->client = conn->initial;
             break;
         case SERVER_HELLO:
             POSIX_GUARD(s2n_tls13_handle_handshake_master_secret(conn));
@@ -514,6 +518,31 @@ int s2n_tls13_handle_secrets(struct s2n_connection *conn)
     }
 }
 
+/* Returns true if s2n_tls13_handle_secrets may change the record keys after the current message.
+ * Must cover every message handled by s2n_tls13_client_handle_secrets and s2n_tls13_server_handle_secrets.
+ */
+bool s2n_tls13_secrets_may_change(struct s2n_connection *conn)
+{
+    if (conn->actual_protocol_version < S2N_TLS13) {
+        return false;
+    }
+
+    switch(s2n_conn_get_current_message_type(conn)) {
+        case CLIENT_HELLO:
+        case HELLO_RETRY_MSG:
+        case SERVER_HELLO:
+        case END_OF_EARLY_DATA:
+        case SERVER_FINISHED:
+        case CLIENT_FINISHED:
+            return true;
+        case ENCRYPTED_EXTENSIONS:
+            /* Only the client reacts to EncryptedExtensions */
+            return conn->mode == S2N_CLIENT;
+        default:
+            return false;
+    }
+}
+
 int s2n_update_application_traffic_keys(struct s2n_connection *conn, s2n_mode mode, keyupdate_status status)
 {
     POSIX_ENSURE_REF(conn);
@@ -0,0 +1,84 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "utils/s2n_arena.h"
+
+#include "error/s2n_errno.h"
+#include "utils/s2n_mem.h"
+#include "utils/s2n_safety.h"
+
+struct s2n_arena_block {
+    struct s2n_arena_block *next;
+    uint32_t capacity;
+    uint32_t used;
+    uint8_t data[];
+};
+
+#define S2N_ARENA_BLOCK_CAPACITY (S2N_ARENA_BLOCK_SIZE - sizeof(struct s2n_arena_block))
+
+static S2N_RESULT s2n_arena_add_block(struct s2n_arena *arena, uint32_t capacity)
+{
+    uint32_t allocation_size = 0;
+    RESULT_GUARD_POSIX(s2n_add_overflow(sizeof(struct s2n_arena_block), capacity, &allocation_size));
+
+    DEFER_CLEANUP(struct s2n_blob mem = { 0 }, s2n_free);
+    RESULT_GUARD_POSIX(s2n_alloc(&mem, allocation_size));
+    RESULT_GUARD_POSIX(s2n_blob_zero(&mem));
+
+    struct s2n_arena_block *block = (struct s2n_arena_block *)(void *) mem.data;
+    block->capacity = capacity;
+    block->used = 0;
+    block->next = arena->blocks;
+    arena->blocks = block;
+
+    ZERO_TO_DISABLE_DEFER_CLEANUP(mem);
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_arena_alloc(struct s2n_arena *arena, struct s2n_blob *out, uint32_t size)
+{
+    RESULT_ENSURE_REF(arena);
+    RESULT_ENSURE_REF(out);
+    RESULT_ENSURE(size > 0, S2N_ERR_SAFETY);
+
+    uint32_t aligned_size = 0;
+    RESULT_GUARD_POSIX(s2n_align_to(size, S2N_ARENA_ALIGNMENT, &aligned_size));
+
+    struct s2n_arena_block *block = arena->blocks;
+    if (block == NULL || block->capacity - block->used < aligned_size) {
+        /* The rest of the current block is abandoned until the arena is freed */
+        const uint32_t capacity = aligned_size > S2N_ARENA_BLOCK_CAPACITY ? aligned_size : S2N_ARENA_BLOCK_CAPACITY;
+        RESULT_GUARD(s2n_arena_add_block(arena, capacity));
+        block = arena->blocks;
+    }
+
+    RESULT_GUARD_POSIX(s2n_blob_init(out, block->data + block->used, size));
+    block->used += aligned_size;
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_arena_free(struct s2n_arena *arena)
+{
+    RESULT_ENSURE_REF(arena);
+
+    while (arena->blocks) {
+        struct s2n_arena_block *block = arena->blocks;
+        arena->blocks = block->next;
+
+        /* s2n_free_object wipes the whole block before releasing it */
+        RESULT_GUARD_POSIX(s2n_free_object((uint8_t **) &block, sizeof(struct s2n_arena_block) + block->capacity));
+    }
+    return S2N_RESULT_OK;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "utils/s2n_blob.h"
+#include "utils/s2n_result.h"
+
+/* A block, header included, fits the largest slab class, so a typical handshake
+ * needs a single small allocation. Larger requests get a block of their own. */
+#define S2N_ARENA_BLOCK_SIZE    2048
+#define S2N_ARENA_ALIGNMENT     8
+
+struct s2n_arena_block;
+
+/* A bump pointer allocator for short lived memory. Blobs handed out by the arena are
+ * static: they can't be resized or passed to s2n_free, and all of them are wiped and
+ * released together by s2n_arena_free. */
+struct s2n_arena {
+    /* Newest first; only the newest block is allocated from */
+    struct s2n_arena_block *blocks;
+};
+
+extern S2N_RESULT s2n_arena_alloc(struct s2n_arena *arena, struct s2n_blob *out, uint32_t size);
+extern S2N_RESULT s2n_arena_free(struct s2n_arena *arena);
@@ -16,6 +16,7 @@
 
 #include "error/s2n_errno.h"
 
+#include "tls/s2n_buffer_pool.h"
 #include "tls/s2n_cipher_suites.h"
 #include "tls/extensions/s2n_extension_type.h"
 #include "tls/s2n_security_policies.h"
@@ -60,7 +61,9 @@ int s2n_cleanup(void)
 {
     /* s2n_cleanup is supposed to be called from each thread before exiting,
      * so ensure that whatever clean ups we have here are thread safe */
+    POSIX_GUARD_RESULT(s2n_buffer_pool_cleanup_thread());
     POSIX_GUARD_RESULT(s2n_rand_cleanup_thread());
+    POSIX_GUARD(s2n_mem_cleanup_thread());
     return 0;
 }
 
@@ -70,10 +73,12 @@ static bool s2n_cleanup_atexit_impl(void)
      * values to need to be consumed to prevent warnings */
     bool a = s2n_result_is_ok(s2n_rand_cleanup_thread());
     bool b = s2n_result_is_ok(s2n_rand_cleanup());
-    bool c = s2n_mem_cleanup() == 0;
+    bool e = s2n_result_is_ok(s2n_buffer_pool_cleanup_thread());
+    bool c = s2n_mem_cleanup_thread() == 0;
+    bool d = s2n_mem_cleanup() == 0;
     s2n_wipe_static_configs();
 
-    return a && b && c;
+    return a && b && c && d && e;
 }
 
 static void s2n_cleanup_atexit(void)
@@ -18,65 +18,104 @@
 
 #include "error/s2n_errno.h"
 
-#include "crypto/s2n_hash.h"
-
 #include "utils/s2n_safety.h"
 #include "utils/s2n_result.h"
 #include "utils/s2n_blob.h"
 #include "utils/s2n_mem.h"
 #include "utils/s2n_map.h"
 #include "utils/s2n_map_internal.h"
+#include "utils/s2n_random.h"
+#include "utils/s2n_siphash.h"
 
 #include <s2n.h>
 
 #define S2N_INITIAL_TABLE_SIZE 1024
 
-static S2N_RESULT s2n_map_slot(const struct s2n_map *map, struct s2n_blob *key, uint32_t *slot)
+static uint64_t s2n_map_hash(const struct s2n_map *map, const struct s2n_blob *key)
+{
+    return s2n_siphash13(map->hash_key, key->data, key->size);
+}
+
+static uint32_t s2n_map_slot(const struct s2n_map *map, uint64_t hash)
+{
+    return (uint32_t) hash & (map->capacity - 1);
+}
+
+static bool s2n_map_entry_matches(const struct s2n_map_entry *entry, const struct s2n_blob *key, uint64_t hash)
+{
+    return entry->hash == hash && entry->key.size == key->size
+            && memcmp(entry->key.data, key->data, key->size) == 0;
+}
+
+static bool s2n_map_entry_key_is_inline(const struct s2n_map_entry *entry)
+{
+    return entry->key.data == entry->inline_key;
+}
+
+static S2N_RESULT s2n_map_entry_set(struct s2n_map_entry *entry, struct s2n_blob *key, struct s2n_blob *value, uint64_t hash)
+{
+    RESULT_ENSURE_NE(key->size, 0);
+    RESULT_ENSURE_REF(key->data);
+
+    if (key->size <= S2N_MAP_INLINE_KEY_SIZE) {
+        RESULT_CHECKED_MEMCPY(entry->inline_key, key->data, key->size);
+        RESULT_GUARD_POSIX(s2n_blob_init(&entry->key, entry->inline_key, key->size));
+    } else {
+        RESULT_GUARD_POSIX(s2n_dup(key, &entry->key));
+    }
+    RESULT_GUARD_POSIX(s2n_dup(value, &entry->value));
+    entry->hash = hash;
+
+    return S2N_RESULT_OK;
+}
+
+static S2N_RESULT s2n_map_entry_free(struct s2n_map_entry *entry)
 {
-    union {
-        uint8_t u8[32];
-        uint32_t u32[8];
-    } digest;
-
-    DEFER_CLEANUP(struct s2n_hash_state sha256 = {0}, s2n_hash_free);
-    RESULT_GUARD_POSIX(s2n_hash_new(&sha256));
-    RESULT_GUARD_POSIX(s2n_hash_init(&sha256, S2N_HASH_SHA256));
-    RESULT_GUARD_POSIX(s2n_hash_update(&sha256, key->data, key->size));
-    RESULT_GUARD_POSIX(s2n_hash_digest(&sha256, digest.u8, sizeof(digest)));
-
-    *slot = digest.u32[0] % map->capacity;
+    if (!s2n_map_entry_key_is_inline(entry)) {
+        RESULT_GUARD_POSIX(s2n_free(&entry->key));
+    }
+    RESULT_GUARD_POSIX(s2n_free(&entry->value));
+    *entry = (struct s2n_map_entry) { 0 };
+
     return S2N_RESULT_OK;
 }
 
 static S2N_RESULT s2n_map_embiggen(struct s2n_map *map, uint32_t capacity)
 {
     struct s2n_blob mem = {0};
-    struct s2n_map tmp = {0};
 
     RESULT_ENSURE(!map->immutable, S2N_ERR_MAP_IMMUTABLE);
 
     RESULT_GUARD_POSIX(s2n_alloc(&mem, (capacity * sizeof(struct s2n_map_entry))));
     RESULT_GUARD_POSIX(s2n_blob_zero(&mem));
 
-    tmp.capacity = capacity;
-    tmp.size = 0;
-    tmp.table = (void *) mem.data;
-    tmp.immutable = 0;
+    struct s2n_map_entry *table = (void *) mem.data;
+    const uint32_t old_capacity = map->capacity;
+    struct s2n_map_entry *old_table = map->table;
+    map->capacity = capacity;
+    map->table = table;
 
-    for (int i = 0; i < map->capacity; i++) {
-        if (map->table[i].key.size) {
-            RESULT_GUARD(s2n_map_add(&tmp, &map->table[i].key, &map->table[i].value));
-            RESULT_GUARD_POSIX(s2n_free(&map->table[i].key));
-            RESULT_GUARD_POSIX(s2n_free(&map->table[i].value));
+    /* Move the entries over. Their hashes are stored, so nothing is rehashed or copied. */
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        struct s2n_map_entry *entry = &old_table[i];
+        if (entry->key.size == 0) {
+            continue;
+        }
+
+        uint32_t slot = s2n_map_slot(map, entry->hash);
+        while (table[slot].key.size) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        table[slot] = *entry;
+        if (s2n_map_entry_key_is_inline(entry)) {
+            table[slot].key.data = table[slot].inline_key;
         }
     }
-    RESULT_GUARD_POSIX(s2n_free_object((uint8_t **)&map->table, map->capacity * sizeof(struct s2n_map_entry)));
 
-    /* Clone the temporary map */
-    map->capacity = tmp.capacity;
-    map->size = tmp.size;
-    map->table = tmp.table;
-    map->immutable = 0;
+    if (old_table) {
+        RESULT_GUARD_POSIX(s2n_free_object((uint8_t **)&old_table, old_capacity * sizeof(struct s2n_map_entry)));
+    }
 
     return S2N_RESULT_OK;
 }
@@ -89,10 +128,12 @@ struct s2n_map *s2n_map_new()
 struct s2n_map *s2n_map_new_with_initial_capacity(uint32_t capacity)
 {
     PTR_ENSURE(capacity != 0, S2N_ERR_MAP_INVALID_MAP_SIZE);
+    PTR_ENSURE(capacity <= (UINT32_MAX / 2) + 1, S2N_ERR_MAP_INVALID_MAP_SIZE);
     struct s2n_blob mem = {0};
     struct s2n_map *map;
 
     PTR_GUARD_POSIX(s2n_alloc(&mem, sizeof(struct s2n_map)));
+    PTR_GUARD_POSIX(s2n_blob_zero(&mem));
 
     map = (void *) mem.data;
     map->capacity = 0;
@@ -100,7 +141,16 @@ struct s2n_map *s2n_map_new_with_initial_capacity(uint32_t capacity)
     map->immutable = 0;
     map->table = NULL;
 
-    PTR_GUARD_RESULT(s2n_map_embiggen(map, capacity));
+    struct s2n_blob hash_key = {0};
+    PTR_GUARD_POSIX(s2n_blob_init(&hash_key, map->hash_key, sizeof(map->hash_key)));
+    PTR_GUARD_RESULT(s2n_get_public_random_data(&hash_key));
+
+    /* Slots are picked by masking the hash, so the capacity is kept a power of two */
+    uint32_t table_capacity = 1;
+    while (table_capacity < capacity) {
+        table_capacity <<= 1;
+    }
+    PTR_GUARD_RESULT(s2n_map_embiggen(map, table_capacity));
 
     return map;
 }
@@ -114,15 +164,13 @@ S2N_RESULT s2n_map_add(struct s2n_map *map, struct s2n_blob *key, struct s2n_blo
         RESULT_GUARD(s2n_map_embiggen(map, map->capacity * 2));
     }
 
-    uint32_t slot = 0;
-    RESULT_GUARD(s2n_map_slot(map, key, &slot));
+    const uint64_t hash = s2n_map_hash(map, key);
+    uint32_t slot = s2n_map_slot(map, hash);
 
     /* Linear probing until we find an empty slot */
     while(map->table[slot].key.size) {
-        if (key->size != map->table[slot].key.size ||
-            memcmp(key->data,  map->table[slot].key.data, key->size)) {
-            slot++;
-            slot %= map->capacity;
+        if (!s2n_map_entry_matches(&map->table[slot], key, hash)) {
+            slot = (slot + 1) & (map->capacity - 1);
             continue;
         }
 
@@ -130,8 +178,7 @@ S2N_RESULT s2n_map_add(struct s2n_map *map, struct s2n_blob *key, struct s2n_blo
         RESULT_BAIL(S2N_ERR_MAP_DUPLICATE);
     }
 
-    RESULT_GUARD_POSIX(s2n_dup(key, &map->table[slot].key));
-    RESULT_GUARD_POSIX(s2n_dup(value, &map->table[slot].value));
+    RESULT_GUARD(s2n_map_entry_set(&map->table[slot], key, value, hash));
     map->size++;
 
     return S2N_RESULT_OK;
@@ -146,27 +193,23 @@ S2N_RESULT s2n_map_put(struct s2n_map *map, struct s2n_blob *key, struct s2n_blo
         RESULT_GUARD(s2n_map_embiggen(map, map->capacity * 2));
     }
 
-    uint32_t slot = 0;
-    RESULT_GUARD(s2n_map_slot(map, key, &slot));
+    const uint64_t hash = s2n_map_hash(map, key);
+    uint32_t slot = s2n_map_slot(map, hash);
 
     /* Linear probing until we find an empty slot */
     while(map->table[slot].key.size) {
-        if (key->size != map->table[slot].key.size ||
-            memcmp(key->data,  map->table[slot].key.data, key->size)) {
-            slot++;
-            slot %= map->capacity;
+        if (!s2n_map_entry_matches(&map->table[slot], key, hash)) {
+            slot = (slot + 1) & (map->capacity - 1);
             continue;
         }
 
         /* We found a duplicate key that will be overwritten */
-        RESULT_GUARD_POSIX(s2n_free(&map->table[slot].key));
-        RESULT_GUARD_POSIX(s2n_free(&map->table[slot].value));
+        RESULT_GUARD(s2n_map_entry_free(&map->table[slot]));
         map->size--;
         break;
     }
 
-    RESULT_GUARD_POSIX(s2n_dup(key, &map->table[slot].key));
-    RESULT_GUARD_POSIX(s2n_dup(value, &map->table[slot].value));
+    RESULT_GUARD(s2n_map_entry_set(&map->table[slot], key, value, hash));
     map->size++;
 
     return S2N_RESULT_OK;
@@ -190,15 +233,13 @@ S2N_RESULT s2n_map_lookup(const struct s2n_map *map, struct s2n_blob *key, struc
 {
     RESULT_ENSURE(map->immutable, S2N_ERR_MAP_MUTABLE);
 
-    uint32_t slot = 0;
-    RESULT_GUARD(s2n_map_slot(map, key, &slot));
+    const uint64_t hash = s2n_map_hash(map, key);
+    uint32_t slot = s2n_map_slot(map, hash);
     const uint32_t initial_slot = slot;
 
     while(map->table[slot].key.size) {
-        if (key->size != map->table[slot].key.size ||
-            memcmp(key->data,  map->table[slot].key.data, key->size)) {
-            slot++;
-            slot %= map->capacity;
+        if (!s2n_map_entry_matches(&map->table[slot], key, hash)) {
+            slot = (slot + 1) & (map->capacity - 1);
             /* We went over all the slots but found no match */
             if (slot == initial_slot) {
                 break;
@@ -223,10 +264,9 @@ S2N_RESULT s2n_map_lookup(const struct s2n_map *map, struct s2n_blob *key, struc
 S2N_RESULT s2n_map_free(struct s2n_map *map)
 {
     /* Free the keys and values */
-    for (int i = 0; i < map->capacity; i++) {
+    for (uint32_t i = 0; i < map->capacity; i++) {
         if (map->table[i].key.size) {
-            RESULT_GUARD_POSIX(s2n_free(&map->table[i].key));
-            RESULT_GUARD_POSIX(s2n_free(&map->table[i].value));
+            RESULT_GUARD(s2n_map_entry_free(&map->table[i]));
         }
     }
 
@@ -16,13 +16,22 @@
 
 #include "utils/s2n_map.h"
 
+#include "utils/s2n_siphash.h"
+
+/* Keys up to this size are stored in the entry itself instead of a separate allocation */
+#define S2N_MAP_INLINE_KEY_SIZE 32
+
 struct s2n_map_entry {
+    /* Hash of the key, kept to skip most key comparisons and to resize without rehashing */
+    uint64_t hash;
+    /* Points at inline_key for short keys */
     struct s2n_blob key;
     struct s2n_blob value;
+    uint8_t inline_key[S2N_MAP_INLINE_KEY_SIZE];
 };
 
 struct s2n_map {
-    /* The total capacity of the table, in number of elements. */
+    /* The total capacity of the table, in number of elements. Always a power of two. */
     uint32_t capacity;
 
     /* The total number of elements currently in the table. Used for measuring the load factor */
@@ -31,6 +40,9 @@ struct s2n_map {
     /* Once a map has been looked up, it is considered immutable */
     int immutable;
 
+    /* Random per-map key for the slot hash, so that slots cannot be predicted from the keys alone */
+    uint8_t hash_key[S2N_SIPHASH_KEY_LEN];
+
     /* Pointer to the hash-table, should be capacity * sizeof(struct s2n_map_entry) */
     struct s2n_map_entry *table;
 };
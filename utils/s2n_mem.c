@@ -27,10 +27,12 @@
 
 #include "utils/s2n_blob.h"
 #include "utils/s2n_mem.h"
+#include "utils/s2n_mem_slab.h"
 #include "utils/s2n_safety.h"
 
 static uint32_t page_size = 4096;
 static bool initialized = false;
+static bool use_slab = true;
 
 static int s2n_mem_init_impl(void);
 static int s2n_mem_cleanup_impl(void);
@@ -56,6 +58,9 @@ static int s2n_mem_init_impl(void)
 
     page_size = (uint32_t) sysconf_rc;
 
+    /* Lock small allocations a page at a time, as before the slab existed. Mostly useful for comparisons. */
+    use_slab = getenv("S2N_MLOCK_PER_PAGE") == NULL;
+
     if (getenv("S2N_DONT_MLOCK")) {
         s2n_mem_malloc_cb = s2n_mem_malloc_no_mlock_impl;
         s2n_mem_free_cb = s2n_mem_free_no_mlock_impl;
@@ -71,8 +76,21 @@ static int s2n_mem_cleanup_impl(void)
     return S2N_SUCCESS;
 }
 
+/* While the slab is in use, every allocation of up to S2N_MEM_SLAB_MAX_SIZE comes from it.
+ * Frees may pass the requested size rather than the allocated one (see s2n_free_object),
+ * but both are within the same limit, so the size says which path owns a pointer. */
+static bool s2n_mem_is_slab_size(uint32_t size)
+{
+    return use_slab && size <= S2N_MEM_SLAB_MAX_SIZE && S2N_MEM_SLAB_MAX_SIZE < page_size;
+}
+
 static int s2n_mem_free_mlock_impl(void *ptr, uint32_t size)
 {
+    if (ptr && s2n_mem_is_slab_size(size)) {
+        POSIX_GUARD_RESULT(s2n_mem_slab_free(ptr, size));
+        return S2N_SUCCESS;
+    }
+
     int munlock_rc = munlock(ptr, size);
     free(ptr);
     POSIX_GUARD(munlock_rc);
@@ -91,6 +109,13 @@ static int s2n_mem_malloc_mlock_impl(void **ptr, uint32_t requested, uint32_t *a
 {
     POSIX_ENSURE_REF(ptr);
 
+    /* Small allocations share slab regions that were locked when they were mapped,
+     * rather than each locking a whole page of their own */
+    if (s2n_mem_is_slab_size(requested)) {
+        POSIX_GUARD_RESULT(s2n_mem_slab_alloc(requested, ptr, allocated));
+        return S2N_SUCCESS;
+    }
+
     /* Page aligned allocation required for mlock */
     uint32_t allocate;
 
@@ -262,6 +287,12 @@ uint32_t s2n_mem_get_page_size(void)
     return page_size;
 }
 
+int s2n_mem_cleanup_thread(void)
+{
+    POSIX_GUARD_RESULT(s2n_mem_slab_cleanup_thread());
+    return S2N_SUCCESS;
+}
+
 int s2n_mem_cleanup(void)
 {
     POSIX_ENSURE(initialized, S2N_ERR_NOT_INITIALIZED);
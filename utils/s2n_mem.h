@@ -22,6 +22,7 @@
 int s2n_mem_init(void);
 bool s2n_mem_is_init(void);
 uint32_t s2n_mem_get_page_size(void);
+int s2n_mem_cleanup_thread(void);
 int s2n_mem_cleanup(void);
 int s2n_alloc(struct s2n_blob *b, uint32_t size);
 int s2n_realloc(struct s2n_blob *b, uint32_t size);
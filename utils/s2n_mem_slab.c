@@ -0,0 +1,294 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#define  _DEFAULT_SOURCE 1
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+#include <features.h>
+#endif
+
+#include "utils/s2n_mem_slab.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "error/s2n_errno.h"
+#include "utils/s2n_safety.h"
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Free chunks in the depot are linked through their first bytes */
+struct s2n_mem_slab_chunk {
+    struct s2n_mem_slab_chunk *next;
+};
+
+struct s2n_mem_slab_depot {
+    pthread_mutex_t lock;
+    struct s2n_mem_slab_chunk *free_list;
+};
+
+struct s2n_mem_slab_magazine {
+    void *chunks[S2N_MEM_SLAB_MAGAZINE_SIZE];
+    uint32_t count;
+};
+
+/* Every region starts with a link to the previously mapped one, so that they can all
+ * be locked again in a forked child. The link takes the space of the smallest chunk,
+ * which keeps the chunks aligned. */
+struct s2n_mem_slab_region {
+    struct s2n_mem_slab_region *next;
+};
+
+#define S2N_MEM_SLAB_DEPOT_INIT { .lock = PTHREAD_MUTEX_INITIALIZER, .free_list = NULL }
+
+static struct s2n_mem_slab_depot depots[S2N_MEM_SLAB_CLASS_COUNT] = {
+    S2N_MEM_SLAB_DEPOT_INIT, S2N_MEM_SLAB_DEPOT_INIT, S2N_MEM_SLAB_DEPOT_INIT, S2N_MEM_SLAB_DEPOT_INIT,
+    S2N_MEM_SLAB_DEPOT_INIT, S2N_MEM_SLAB_DEPOT_INIT, S2N_MEM_SLAB_DEPOT_INIT, S2N_MEM_SLAB_DEPOT_INIT,
+};
+
+/* Regions are carved from the front and never unmapped: chunks freed after s2n_cleanup
+ * must still point at valid memory, and a later s2n_init reuses them. */
+static pthread_mutex_t region_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct s2n_mem_slab_region *regions = NULL;
+static uint8_t *region_cursor = NULL;
+static uint8_t *region_end = NULL;
+
+/* Memory locks are not inherited across fork. Set in a child that failed to lock the
+ * regions again, so that no more secrets are stored in memory that could be swapped out. */
+static bool regions_unlocked = false;
+
+static pthread_once_t slab_once = PTHREAD_ONCE_INIT;
+static int slab_once_result = 0;
+
+/* Set in every thread that may hold chunks in its magazines, so that they are returned
+ * to the depot when the thread exits, even if it never calls s2n_cleanup_thread. */
+static pthread_key_t slab_thread_key;
+static __thread bool slab_thread_registered = false;
+
+static __thread struct s2n_mem_slab_magazine magazines[S2N_MEM_SLAB_CLASS_COUNT];
+
+static void s2n_mem_slab_thread_exit(void *unused)
+{
+    s2n_result_ignore(s2n_mem_slab_cleanup_thread());
+}
+
+/* Holding every lock across fork keeps the child from inheriting a depot or the regions
+ * in the middle of an update. Depot locks are taken before region_lock, as in refill. */
+static void s2n_mem_slab_prepare_fork(void)
+{
+    for (uint32_t i = 0; i < S2N_MEM_SLAB_CLASS_COUNT; i++) {
+        pthread_mutex_lock(&depots[i].lock);
+    }
+    pthread_mutex_lock(&region_lock);
+}
+
+static void s2n_mem_slab_parent_fork(void)
+{
+    pthread_mutex_unlock(&region_lock);
+    for (uint32_t i = 0; i < S2N_MEM_SLAB_CLASS_COUNT; i++) {
+        pthread_mutex_unlock(&depots[i].lock);
+    }
+}
+
+/* MADV_DONTDUMP is inherited, but mlock is not. Chunks held in the magazines of the
+ * parent's other threads are never returned in the child, which has no such threads. */
+static void s2n_mem_slab_child_fork(void)
+{
+    for (struct s2n_mem_slab_region *region = regions; region; region = region->next) {
+        if (mlock(region, S2N_MEM_SLAB_REGION_SIZE) != 0) {
+            regions_unlocked = true;
+        }
+    }
+    s2n_mem_slab_parent_fork();
+}
+
+static void s2n_mem_slab_init(void)
+{
+    slab_once_result = pthread_key_create(&slab_thread_key, s2n_mem_slab_thread_exit);
+    if (slab_once_result == 0) {
+        slab_once_result = pthread_atfork(s2n_mem_slab_prepare_fork, s2n_mem_slab_parent_fork, s2n_mem_slab_child_fork);
+    }
+}
+
+static S2N_RESULT s2n_mem_slab_register_thread(void)
+{
+    if (!slab_thread_registered) {
+        /* Every region is mapped by a thread that registered first, so the fork handlers
+         * are also installed before any region exists */
+        RESULT_ENSURE(pthread_once(&slab_once, s2n_mem_slab_init) == 0, S2N_ERR_THREAD);
+        RESULT_ENSURE(slab_once_result == 0, S2N_ERR_THREAD);
+        RESULT_ENSURE(pthread_setspecific(slab_thread_key, magazines) == 0, S2N_ERR_THREAD);
+        slab_thread_registered = true;
+    }
+    return S2N_RESULT_OK;
+}
+
+static S2N_RESULT s2n_mem_slab_class(uint32_t size, uint32_t *class_index, uint32_t *class_size)
+{
+    RESULT_ENSURE(size <= S2N_MEM_SLAB_MAX_SIZE, S2N_ERR_ALLOC);
+
+    *class_index = 0;
+    *class_size = S2N_MEM_SLAB_MIN_SIZE;
+    while (*class_size < size) {
+        *class_size <<= 1;
+        (*class_index)++;
+    }
+    return S2N_RESULT_OK;
+}
+
+/* Must be called with region_lock held */
+static S2N_RESULT s2n_mem_slab_map_region(void)
+{
+    void *region = mmap(NULL, S2N_MEM_SLAB_REGION_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    RESULT_ENSURE(region != MAP_FAILED, S2N_ERR_ALLOC);
+
+/*
+** We disable MAD_DONTDUMP when fuzz-testing or using the address sanitizer because
+** both need to be able to dump pages to function. It's how they map heap output.
+*/
+#if defined(MADV_DONTDUMP) && !defined(S2N_ADDRESS_SANITIZER) && !defined(S2N_FUZZ_TESTING)
+    if (madvise(region, S2N_MEM_SLAB_REGION_SIZE, MADV_DONTDUMP) != 0) {
+        munmap(region, S2N_MEM_SLAB_REGION_SIZE);
+        RESULT_BAIL(S2N_ERR_MADVISE);
+    }
+#endif
+
+    if (mlock(region, S2N_MEM_SLAB_REGION_SIZE) != 0) {
+        munmap(region, S2N_MEM_SLAB_REGION_SIZE);
+        RESULT_BAIL(S2N_ERR_MLOCK);
+    }
+
+    struct s2n_mem_slab_region *header = region;
+    header->next = regions;
+    regions = header;
+
+    region_cursor = (uint8_t *) region + S2N_MEM_SLAB_MIN_SIZE;
+    region_end = (uint8_t *) region + S2N_MEM_SLAB_REGION_SIZE;
+    return S2N_RESULT_OK;
+}
+
+/* Must be called with the depot's lock held */
+static S2N_RESULT s2n_mem_slab_refill(struct s2n_mem_slab_depot *depot, struct s2n_mem_slab_magazine *magazine, uint32_t class_size)
+{
+    const uint32_t target = S2N_MEM_SLAB_MAGAZINE_SIZE / 2;
+
+    while (magazine->count < target && depot->free_list) {
+        struct s2n_mem_slab_chunk *chunk = depot->free_list;
+        depot->free_list = chunk->next;
+        chunk->next = NULL;
+        magazine->chunks[magazine->count++] = chunk;
+    }
+    if (magazine->count > 0) {
+        return S2N_RESULT_OK;
+    }
+
+    RESULT_ENSURE(pthread_mutex_lock(&region_lock) == 0, S2N_ERR_LOCK);
+    if (region_cursor == NULL || (uint32_t) (region_end - region_cursor) < class_size) {
+        /* The tail of the old region is too small for this class and is left unused */
+        if (s2n_result_is_error(s2n_mem_slab_map_region())) {
+            pthread_mutex_unlock(&region_lock);
+            return S2N_RESULT_ERROR;
+        }
+    }
+    while (magazine->count < target && (uint32_t) (region_end - region_cursor) >= class_size) {
+        magazine->chunks[magazine->count++] = region_cursor;
+        region_cursor += class_size;
+    }
+    RESULT_ENSURE(pthread_mutex_unlock(&region_lock) == 0, S2N_ERR_LOCK);
+
+    return S2N_RESULT_OK;
+}
+
+/* Must be called with the depot's lock held */
+static void s2n_mem_slab_drain(struct s2n_mem_slab_depot *depot, struct s2n_mem_slab_magazine *magazine, uint32_t keep)
+{
+    while (magazine->count > keep) {
+        struct s2n_mem_slab_chunk *chunk = magazine->chunks[--magazine->count];
+        chunk->next = depot->free_list;
+        depot->free_list = chunk;
+    }
+}
+
+S2N_RESULT s2n_mem_slab_alloc(uint32_t requested, void **ptr, uint32_t *allocated)
+{
+    RESULT_ENSURE_REF(ptr);
+    RESULT_ENSURE_REF(allocated);
+
+    uint32_t class_index = 0, class_size = 0;
+    RESULT_GUARD(s2n_mem_slab_class(requested, &class_index, &class_size));
+
+    RESULT_ENSURE(!regions_unlocked, S2N_ERR_MLOCK);
+
+    struct s2n_mem_slab_magazine *magazine = &magazines[class_index];
+    if (magazine->count == 0) {
+        RESULT_GUARD(s2n_mem_slab_register_thread());
+
+        struct s2n_mem_slab_depot *depot = &depots[class_index];
+        RESULT_ENSURE(pthread_mutex_lock(&depot->lock) == 0, S2N_ERR_LOCK);
+        const s2n_result result = s2n_mem_slab_refill(depot, magazine, class_size);
+        RESULT_ENSURE(pthread_mutex_unlock(&depot->lock) == 0, S2N_ERR_LOCK);
+        RESULT_GUARD(result);
+    }
+
+    *ptr = magazine->chunks[--magazine->count];
+    *allocated = class_size;
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_mem_slab_free(void *ptr, uint32_t size)
+{
+    RESULT_ENSURE_REF(ptr);
+
+    /* Callers may pass the size they requested, which is in the same class as the chunk */
+    uint32_t class_index = 0, class_size = 0;
+    RESULT_GUARD(s2n_mem_slab_class(size, &class_index, &class_size));
+
+    /* Chunks are handed out again without being cleared, so they must not carry secrets */
+    memset(ptr, 0, class_size);
+
+    struct s2n_mem_slab_magazine *magazine = &magazines[class_index];
+    if (magazine->count == 0) {
+        RESULT_GUARD(s2n_mem_slab_register_thread());
+    } else if (magazine->count == S2N_MEM_SLAB_MAGAZINE_SIZE) {
+        struct s2n_mem_slab_depot *depot = &depots[class_index];
+        RESULT_ENSURE(pthread_mutex_lock(&depot->lock) == 0, S2N_ERR_LOCK);
+        s2n_mem_slab_drain(depot, magazine, S2N_MEM_SLAB_MAGAZINE_SIZE / 2);
+        RESULT_ENSURE(pthread_mutex_unlock(&depot->lock) == 0, S2N_ERR_LOCK);
+    }
+
+    magazine->chunks[magazine->count++] = ptr;
+    return S2N_RESULT_OK;
+}
+
+S2N_RESULT s2n_mem_slab_cleanup_thread(void)
+{
+    /* Return this thread's chunks to the depot, so other threads can use them once it exits.
+     * Also called by the thread key's destructor for threads that exit without calling it. */
+    for (uint32_t i = 0; i < S2N_MEM_SLAB_CLASS_COUNT; i++) {
+        struct s2n_mem_slab_magazine *magazine = &magazines[i];
+        if (magazine->count == 0) {
+            continue;
+        }
+
+        struct s2n_mem_slab_depot *depot = &depots[i];
+        RESULT_ENSURE(pthread_mutex_lock(&depot->lock) == 0, S2N_ERR_LOCK);
+        s2n_mem_slab_drain(depot, magazine, 0);
+        RESULT_ENSURE(pthread_mutex_unlock(&depot->lock) == 0, S2N_ERR_LOCK);
+    }
+    return S2N_RESULT_OK;
+}
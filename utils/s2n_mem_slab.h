@@ -0,0 +1,38 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "utils/s2n_result.h"
+
+/* Small allocations are rounded up to a power of two size class between
+ * S2N_MEM_SLAB_MIN_SIZE and S2N_MEM_SLAB_MAX_SIZE, and carved out of regions
+ * that are locked and excluded from core dumps once, when they are mapped. Forked
+ * children lock the regions again, since memory locks are not inherited. */
+#define S2N_MEM_SLAB_MIN_SIZE       16
+#define S2N_MEM_SLAB_CLASS_COUNT    8
+#define S2N_MEM_SLAB_MAX_SIZE       (S2N_MEM_SLAB_MIN_SIZE << (S2N_MEM_SLAB_CLASS_COUNT - 1))
+#define S2N_MEM_SLAB_REGION_SIZE    (64 * 1024)
+
+/* Each thread keeps up to this many free chunks of each class, so most allocations
+ * and frees take no lock. Chunks move to and from the shared depot in half magazines,
+ * and all of them return to the depot when the thread exits. */
+#define S2N_MEM_SLAB_MAGAZINE_SIZE  32
+
+extern S2N_RESULT s2n_mem_slab_alloc(uint32_t requested, void **ptr, uint32_t *allocated);
+extern S2N_RESULT s2n_mem_slab_free(void *ptr, uint32_t size);
+extern S2N_RESULT s2n_mem_slab_cleanup_thread(void);
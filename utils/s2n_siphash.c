@@ -0,0 +1,101 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "utils/s2n_safety.h"
+#include "utils/s2n_siphash.h"
+
+#define S2N_SIPHASH_ROTL(x, b) (uint64_t) (((x) << (b)) | ((x) >> (64 - (b))))
+
+#define S2N_SIPHASH_ROUND(v0, v1, v2, v3) \
+    do {                                  \
+        v0 += v1;                         \
+        v1 = S2N_SIPHASH_ROTL(v1, 13);    \
+        v1 ^= v0;                         \
+        v0 = S2N_SIPHASH_ROTL(v0, 32);    \
+        v2 += v3;                         \
+        v3 = S2N_SIPHASH_ROTL(v3, 16);    \
+        v3 ^= v2;                         \
+        v0 += v3;                         \
+        v3 = S2N_SIPHASH_ROTL(v3, 21);    \
+        v3 ^= v0;                         \
+        v2 += v1;                         \
+        v1 = S2N_SIPHASH_ROTL(v1, 17);    \
+        v1 ^= v2;                         \
+        v2 = S2N_SIPHASH_ROTL(v2, 32);    \
+    } while (0)
+
+static uint64_t s2n_siphash_read_u64_le(const uint8_t *p)
+{
+    return ((uint64_t) p[0]) | ((uint64_t) p[1] << 8) | ((uint64_t) p[2] << 16) | ((uint64_t) p[3] << 24)
+         | ((uint64_t) p[4] << 32) | ((uint64_t) p[5] << 40) | ((uint64_t) p[6] << 48) | ((uint64_t) p[7] << 56);
+}
+
+uint64_t s2n_siphash13(const uint8_t key[S2N_SIPHASH_KEY_LEN], const uint8_t *in, uint32_t len)
+{
+    const uint64_t k0 = s2n_siphash_read_u64_le(key);
+    const uint64_t k1 = s2n_siphash_read_u64_le(key + 8);
+
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+    const uint8_t *end = in + (len - (len % 8));
+    for (; in != end; in += 8) {
+        uint64_t m = s2n_siphash_read_u64_le(in);
+        v3 ^= m;
+        S2N_SIPHASH_ROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    /* The last block holds the remaining bytes and the input length */
+    uint64_t b = ((uint64_t) len) << 56;
+    switch (len % 8) {
+    case 7:
+        b |= ((uint64_t) in[6]) << 48;
+        FALL_THROUGH;
+    case 6:
+        b |= ((uint64_t) in[5]) << 40;
+        FALL_THROUGH;
+    case 5:
+        b |= ((uint64_t) in[4]) << 32;
+        FALL_THROUGH;
+    case 4:
+        b |= ((uint64_t) in[3]) << 24;
+        FALL_THROUGH;
+    case 3:
+        b |= ((uint64_t) in[2]) << 16;
+        FALL_THROUGH;
+    case 2:
+        b |= ((uint64_t) in[1]) << 8;
+        FALL_THROUGH;
+    case 1:
+        b |= ((uint64_t) in[0]);
+        break;
+    default:
+        break;
+    }
+
+    v3 ^= b;
+    S2N_SIPHASH_ROUND(v0, v1, v2, v3);
+    v0 ^= b;
+
+    v2 ^= 0xff;
+    S2N_SIPHASH_ROUND(v0, v1, v2, v3);
+    S2N_SIPHASH_ROUND(v0, v1, v2, v3);
+    S2N_SIPHASH_ROUND(v0, v1, v2, v3);
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
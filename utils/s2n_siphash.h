@@ -0,0 +1,28 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define S2N_SIPHASH_KEY_LEN 16
+
+/**
+ * Computes SipHash-1-3 of in using a secret 128-bit key.
+ *
+ * SipHash is a keyed PRF for short inputs, suitable for hash tables keyed by
+ * attacker-controlled data. It is not a substitute for a cryptographic hash.
+ */
+extern uint64_t s2n_siphash13(const uint8_t key[S2N_SIPHASH_KEY_LEN], const uint8_t *in, uint32_t len);